@@ -0,0 +1,72 @@
+#!/bin/bash
+# Download reset history + core dump over WiFi and symbolize against the build's ELF
+# Usage: ./coredump.sh [host] [--erase]
+#   host     Controller address (default 192.168.4.1, the access point)
+#   --erase  Clear the dump on the controller after a successful download
+set -e
+
+SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
+HOST="192.168.4.1"
+ERASE=0
+for arg in "$@"; do
+    case "$arg" in
+        --erase) ERASE=1 ;;
+        *) HOST="$arg" ;;
+    esac
+done
+
+ELF="$SCRIPT_DIR/.pio/build/esp32s3/firmware.elf"
+if [ ! -f "$ELF" ]; then
+    echo "ERROR: $ELF not found. Build the firmware that is on the car first (pio run)."
+    exit 1
+fi
+
+OUT_DIR="${TMPDIR:-/tmp}/airride-crash-$(date +%Y%m%d-%H%M%S)"
+mkdir -p "$OUT_DIR"
+
+echo "==============================="
+echo "  Reset history ($HOST)"
+echo "==============================="
+curl -sf "http://$HOST/diag" -o "$OUT_DIR/diag.json"
+python3 - "$OUT_DIR/diag.json" <<'PY'
+import json, sys
+d = json.load(open(sys.argv[1]))
+print(f"Boots: {d['boots']}   uptime: {d['uptimeS']} s   dead-man trips: {d['deadmanTrips']}")
+for r in d["resets"]:
+    print(f"  boot {r['boot']:>5}  {r['reason']:<20} during {r['stage']:<8} after {r['uptimeMin']} min")
+print("Loop stages (worst / budget, overruns):")
+for name, s in d["stages"].items():
+    print(f"  {name:<8} {s['worstMs']:>6} / {s['budgetMs']} ms  {s['overruns']}")
+PY
+
+echo ""
+echo "==============================="
+echo "  Core dump"
+echo "==============================="
+STATUS=$(curl -s -o "$OUT_DIR/airride.coredump" -w "%{http_code}" "http://$HOST/coredump")
+if [ "$STATUS" = "404" ]; then
+    echo "No core dump stored."
+    rm -f "$OUT_DIR/airride.coredump"
+    exit 0
+elif [ "$STATUS" != "200" ]; then
+    echo "ERROR: download failed (HTTP $STATUS)"
+    exit 1
+fi
+echo "Saved $(wc -c < "$OUT_DIR/airride.coredump") bytes to $OUT_DIR/airride.coredump"
+
+# esp-coredump (pip install esp-coredump) needs the Xtensa GDB from PlatformIO
+GDB=$(ls "$HOME"/.platformio/packages/tool-xtensa-esp-elf-gdb/bin/xtensa-esp32s3-elf-gdb 2>/dev/null | head -1)
+GDB_ARG=()
+[ -n "$GDB" ] && GDB_ARG=(--gdb "$GDB")
+
+python3 -m esp_coredump --chip esp32s3 info_corefile "${GDB_ARG[@]}" \
+    --core-format raw --core "$OUT_DIR/airride.coredump" "$ELF" | tee "$OUT_DIR/report.txt"
+
+if [ "$ERASE" = "1" ]; then
+    curl -sf "http://$HOST/coredump?erase=1" > /dev/null && echo "Core dump erased on controller"
+fi
+
+echo ""
+echo "==============================="
+echo "  Report: $OUT_DIR/report.txt"
+echo "==============================="
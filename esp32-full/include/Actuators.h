@@ -0,0 +1,68 @@
+#ifndef ACTUATORS_H
+#define ACTUATORS_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// ============================================
+// SOLENOID / PUMP OUTPUT LATCH
+// ============================================
+// AirBag and Compressor stage their relay states here instead of writing
+// pins one by one. commit() drives every changed output in two register
+// writes through Hal::writePins(): first every relay that releases, then
+// every relay that energises. A preset that moves all four corners or a
+// bag that reverses from inflate to deflate therefore switches in a
+// single instant, still break-before-make.
+//
+// RideController commits at the end of each tick and each command, so a
+// staged state never outlives the call that produced it.
+//
+// Guarded outputs (the solenoids) arm SolenoidGuard while any is open.
+//
+// Motor outputs (the pumps) draw a large inrush for the first moments
+// after their relay closes, enough to sag the supply and every sensor on
+// it. A motor start never shares a commit with solenoids opening (it goes
+// one commit later), and isSettling() tells the sensor readers when a
+// start is recent enough that their samples are suspect. Spacing between
+// the two pumps is Compressor's job (PUMP_START_SPACING_MS).
+
+class Actuators {
+  public:
+    Actuators();
+
+    // Configure a relay output and drive it off immediately
+    void attach(uint8_t pin, bool guarded = false);
+    void attachMotor(uint8_t pin);
+
+    void set(uint8_t pin, bool on);
+    bool isOn(uint8_t pin) const { return (desired >> pin) & 1; }
+
+    // Write every output whose staged state differs from the pins
+    void commit();
+    bool isPending() const { return desired != committed; }
+
+    // The dead-man released the guarded outputs behind our back
+    void markGuardedReleased() { committed &= ~guardedMask; }
+
+    uint64_t getAttachedMask() const { return attachedMask; }
+
+    // A motor started within INRUSH_SETTLE_MS: hold pressure samples
+    bool isSettling() const { return motorStarts > 0 && millis() - motorStartMs < INRUSH_SETTLE_MS; }
+    uint32_t getMotorStarts() const { return motorStarts; }
+    uint32_t getDeferredStarts() const { return deferredStarts; }   // Waited for solenoids
+
+  private:
+    uint64_t desired;       // Bit n = GPIO n energised (independent of RELAY_ACTIVE_LOW)
+    uint64_t committed;     // What the pins currently show
+    uint64_t guardedMask;   // Outputs the dead-man closes
+    uint64_t attachedMask;  // Every relay output (held through light sleep)
+    uint64_t motorMask;     // Outputs with inrush (the pumps)
+    bool motorHeld;         // A motor start was held back last commit
+    unsigned long motorStartMs;
+    uint32_t motorStarts;
+    uint32_t deferredStarts;
+};
+
+extern Actuators actuators;
+
+#endif // ACTUATORS_H
@@ -3,6 +3,7 @@
 
 #include <Arduino.h>
 #include "config.h"
+#include "Hal.h"
 
 // RideTech Big Red valve states
 enum ValveState {
@@ -39,7 +40,7 @@ class AirBag {
     // Target pressure control
     void setTargetPressure(float psi);
     float getTargetPressure() const { return targetPressure; }
-    bool isAtTarget(float tolerance = 2.0) const;
+    bool isAtTarget(float tolerance = TARGET_TOLERANCE_PSI) const;
 
     // Solenoid timeout protection
     bool isSolenoidTimedOut() const { return solenoidTimedOut; }
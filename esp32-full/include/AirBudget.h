@@ -0,0 +1,122 @@
+#ifndef AIR_BUDGET_H
+#define AIR_BUDGET_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "AirBag.h"
+#include "Deadband.h"
+#include "TransitionPlanner.h"
+
+// ============================================
+// AIR BUDGET
+// ============================================
+// Nothing used to check whether the tank holds enough air for a move: a
+// preset from a low tank ran into the tank lockout halfway and the car sat
+// there, unlevel, until the pumps caught up.
+//
+// Every preset and bag target is now predicted before the valves open,
+// with the planner's flow model (see TransitionPlanner.h) and the air
+// volumes: will every corner get there, how long it takes, the tank
+// pressure left and the air it costs in SCF (standard cubic feet). If the
+// move will take the tank below AIR_PRESTART_BELOW_PSI the pumps start
+// with it rather than once the tank has dropped.
+//
+// Volumes: the tank is PLAN_TANK_VOLUME_L. Without a flow meter only the
+// bag-to-tank ratio is observable, so each corner's volume (bag + line,
+// per PSI of bag pressure) is learned from inflates it makes with the
+// pumps off and no other corner filling: the tank drop over the bag rise, AIR_SETTLE_MS after the
+// valve closes. Until then PLAN_BAG_VOLUME_L applies.
+//
+// Every inflate, measured the same way, is booked as air drawn: per
+// corner since boot and against the move in progress, which ends once all
+// its corners hold on target (or have held short of it for
+// AIR_GIVE_UP_MS). Nothing is persisted.
+
+// What a move was predicted to cost
+struct AirEstimate {
+    uint8_t corners;            // Bit n = bag n moves (0 = nothing predicted yet)
+    bool feasible;              // Every corner gets there
+    bool prestart;              // Pumps started with the move
+    unsigned long ms;           // Predicted duration
+    float tankStart;
+    float tankEnd;              // Predicted tank pressure left
+    float scf;                  // Predicted air drawn from the tank
+    uint8_t pauses;             // Waits for the pumps on the way
+};
+
+enum AirMoveState {
+    AIR_MOVE_NONE,
+    AIR_MOVE_RUNNING,
+    AIR_MOVE_COMPLETE,          // Every corner on target
+    AIR_MOVE_SHORT,             // Corners stopped short of target
+    AIR_MOVE_REPLACED           // A new command came first
+};
+
+// ...and what it actually cost
+struct AirMove {
+    AirEstimate estimate;
+    AirMoveState state;
+    unsigned long startedMs;
+    unsigned long achievedMs;   // Duration (so far while running)
+    float tankEnd;              // Tank pressure at the end (latest while running)
+    float scf;                  // Air drawn (so far while running)
+};
+
+class AirBudget {
+  public:
+    AirBudget();
+
+    // Every tick, after the bags have read their pressures
+    void update(const AirBag* bags, const DeadbandEstimator& deadband, float tankPressure, bool pumping);
+
+    // A command set new targets for the candidate corners (bit n = bag n):
+    // predict the move from here, corners already inside their band left
+    // out. It becomes the move in progress (false = nothing to move).
+    // rampRates as for TransitionPlanner::predict.
+    bool estimate(const AirBag* bags, const DeadbandEstimator& deadband, const TransitionPlanner& planner,
+                  uint8_t candidates, float tankPressure, bool pumpsAvailable, bool pumping,
+                  const float rampRates[NUM_BAGS]);
+
+    const AirEstimate& getEstimate() const { return move.estimate; }
+    const MovePrediction& getPrediction() const { return prediction; }
+    const AirMove& getMove() const { return move; }
+    uint32_t getFinishedMoves() const { return finishedMoves; }
+    static const char* stateName(AirMoveState state);
+
+    float getTankVolumeL() const { return PLAN_TANK_VOLUME_L; }
+    float getBagVolumeL(int bag) const { return bagVolumeL[bag]; }
+    bool isVolumeLearned(int bag) const { return volumeFills[bag] > 0; }
+    float getCornerScf(int bag) const { return cornerScf[bag]; }   // Drawn since boot
+    float getTotalScf() const;
+    float getUsableScf(float tankPressure) const;  // Tank air above the lockout
+
+    static float toScf(float liters, float psi) { return liters * psi / AIR_ATM_PSI / AIR_LITERS_PER_CUFT; }
+    static float toTankPsi(float scf) { return scf * AIR_LITERS_PER_CUFT * AIR_ATM_PSI / PLAN_TANK_VOLUME_L; }
+
+  private:
+    float bagVolumeL[NUM_BAGS];
+    uint16_t volumeFills[NUM_BAGS];     // Observations behind the volume (saturates)
+    float cornerScf[NUM_BAGS];
+
+    MovePrediction prediction;
+    AirMove move;
+    uint32_t finishedMoves;
+    unsigned long heldSinceMs;          // Every corner of the move holding since
+
+    // One inflate: valve open until AIR_SETTLE_MS after it closes
+    ValveState lastState[NUM_BAGS];
+    bool metering[NUM_BAGS];
+    bool settling[NUM_BAGS];
+    bool alone[NUM_BAGS];               // No pump and no other corner inflating the whole time
+    float startPsi[NUM_BAGS];
+    float startTank[NUM_BAGS];
+    unsigned long closedAtMs[NUM_BAGS];
+
+    void meter(const AirBag* bags, int i, float tankPressure, bool pumping, unsigned long now);
+    void book(int i, float bagRise, float tankDrop);
+    void track(const AirBag* bags, const DeadbandEstimator& deadband, float tankPressure, unsigned long now);
+    void finish(AirMoveState state);
+    static void printCorners(const AirBag* bags, uint8_t corners);
+};
+
+#endif // AIR_BUDGET_H
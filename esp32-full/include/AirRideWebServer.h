@@ -8,81 +8,50 @@
 #include "config.h"
 #include "AirBag.h"
 #include "Compressor.h"
-
-// Preset definitions (PSI values)
-struct Preset {
-    const char* name;
-    float frontLeft;
-    float frontRight;
-    float rearLeft;
-    float rearRight;
-};
-
-// Default presets: Lay, Cruise, Max
-const Preset DEFAULT_PRESETS[] = {
-    {"Lay",    0.0,   0.0,  0.0,  0.0},   // All the way down
-    {"Cruise", 80.0, 80.0, 50.0, 50.0},   // Front 80, Rear 50
-    {"Max",   100.0, 100.0, 80.0, 80.0}   // Front 100, Rear 80
-};
-const int NUM_PRESETS = 3;
-
-// Level mode options
-enum LevelMode {
-    LEVEL_OFF,
-    LEVEL_FRONT,    // Match front left and right
-    LEVEL_REAR,     // Match rear left and right
-    LEVEL_ALL       // Match all four (front avg = rear avg)
-};
+#include "RideController.h"
 
 class AirRideWebServer {
   public:
-    AirRideWebServer(AirBag* bags, Compressor* comp, float* tankPressure);
+    AirRideWebServer(AirBag* bags, Compressor* comp, RideController* controller);
 
-    void begin();
+    void loadSettings();    // Presets, calibration, leak/tank state from EEPROM (before control starts)
+    void begin();           // WiFi AP and routes (after control is running)
     void update();
 
+    // Parked mode: AP and server off, leak snapshot kept as the park baseline
+    void suspend();
+    void resume();
+    int getClientCount() const { return wifiReady ? WiFi.softAPgetStationNum() : 0; }
+
     bool isConnected() const { return wifiReady; }
+    bool isTimeSynced() const { return timeSynced; }
     IPAddress getIP() const { return WiFi.softAPIP(); }
 
-    // Level mode
-    void setLevelMode(LevelMode mode) { levelMode = mode; }
-    LevelMode getLevelMode() const { return levelMode; }
-    void updateLevelMode();
-
-    // Tank lockout with hysteresis
-    bool isTankLockout() const { return tankLockout; }
-    void updateTankLockout(float tankPressure);
-
-    // Pump enable/disable override
-    bool isPumpEnabled() const { return pumpEnabled; }
-    void setPumpEnabled(bool enabled) { pumpEnabled = enabled; }
-
     // Tank maintenance timer
     bool isTankMaintDue() const;
     int getTankMaintDaysRemaining() const;
 
-    // Actions callable from both web and serial
-    void applyPreset(int presetNum);
+    // Actions callable from web, serial and the binary link
+    void applyPreset(int presetNum, RampProfile profile = (RampProfile)RAMP_DEFAULT_PROFILE);
     const char* getPresetName(int presetNum) const;
+    bool savePreset(int presetNum, const float psi[NUM_BAGS]);     // Clamped, saved to EEPROM
+    bool syncTime(long epoch);                                     // false if implausible
+    void resetLeakSnapshot();
+    int checkLeaks();                           // Worst leak status now: 0 ok, 1 warn, 2 leak (-1 = no snapshot/time)
+    bool resetTankMaint();                      // Service done now (false if time not synced)
+    bool setTankMaint(uint32_t epoch);
+    bool setCalibration(int sensor, const SensorCalibration& cal); // Validated, saved to EEPROM
+    bool resetCalibration(int sensor);          // -1 = all sensors
+    bool restartTrace();                        // false while /trace is downloading (see TraceRecorder.h)
 
   private:
     AirBag* bags;
     Compressor* compressor;
-    float* tankPressure;
+    RideController* controller;
 
     WebServer server;
     bool wifiReady;
 
-    // Level mode
-    LevelMode levelMode;
-    unsigned long lastLevelAdjust;
-
-    // Tank lockout hysteresis
-    bool tankLockout;
-
-    // Pump enable/disable
-    bool pumpEnabled;
-
     // Time sync from browser
     bool timeSynced;
 
@@ -96,6 +65,16 @@ class AirRideWebServer {
     uint32_t tankMaintLastService;
     bool tankMaintValid;
 
+    // /trace or /coredump body still being sent, one chunk per update()
+    enum DownloadKind { DOWNLOAD_NONE, DOWNLOAD_TRACE, DOWNLOAD_COREDUMP };
+    DownloadKind downloadKind;
+    WiFiClient downloadClient;
+    size_t downloadOffset;
+    size_t downloadSize;
+    void startDownload(DownloadKind kind, size_t size);
+    void sendDownloadChunk();
+    void endDownload(const char* result);
+
     // Mutable presets (loaded from EEPROM, fall back to DEFAULT_PRESETS)
     float currentPresets[NUM_PRESETS][4]; // [preset][FL, FR, RL, RR]
     void loadPresetsFromEEPROM();
@@ -106,23 +85,32 @@ class AirRideWebServer {
     void handleStatus();
     void handleBag();
     void handleBagHold();    // Hold button release
-    void handleBagTarget();  // Set target for single bag: /bt?n=<bag>&t=<psi>
-    void handlePreset();
+    void handleBagTarget();  // Set target for single bag: /bt?n=<bag>&t=<psi>[&r=<ramp>]
+    void handlePreset();     // Apply preset: /p?n=<preset>[&r=fast|comfort|show]
+    RampProfile rampArg();   // Optional r= argument, default profile if absent
     void handleSavePreset(); // Save current pressures to preset: /sp?n=<preset>&fl=&fr=&rl=&rr=
     void handleLevel();
     void handlePumpOverride();
     void handleTimeSync();
     void handleDemoToggle();
     void handleLeakStatus();
+    int leakStatus(int sensor, float current, float elapsedHours) const;
+    void readLeakSensors(float current[NUM_BAGS + 1]) const;
     void loadLeakSnapshot();
     void saveLeakSnapshot();
     void updateLeakSnapshot();
     void handleTankMaint();
+    void handlePumpHealth(); // Fill-rate curves and projected service: /pump[?reset=1|2]
     void loadTankMaintFromEEPROM();
     void saveTankMaintToEEPROM(uint32_t epoch);
     void handleSimLeak();
     void handleCalibration();
     void handleCalibrationReset();
+    void handleTrace();      // Session trace download (binary, see TraceRecorder.h), ?start=1 restarts it
+    void handleDiag();       // Reset history and loop stage budgets (see Diagnostics.h)
+    void handleCoreDump();   // Core dump download / erase
+    void handlePark();       // Enter parked low-power mode (see PowerManager.h)
+    void startAccessPoint();
     void loadCalibrationFromEEPROM();
     void saveCalibrationToEEPROM();
     bool validateCalibration(const SensorCalibration& cal);
@@ -3,6 +3,9 @@
 
 #include <Arduino.h>
 #include "config.h"
+#include "Hal.h"
+#include "PumpScheduler.h"
+#include "PumpHealth.h"
 
 // Pump operation modes
 enum PumpMode {
@@ -24,6 +27,18 @@ class Compressor {
     void setMode(PumpMode mode);
     PumpMode getMode() const { return currentMode; }
 
+    // Auto mode: start a fill cycle now instead of at TANK_MIN_PSI (a
+    // move is about to draw the tank down)
+    void startFill();
+
+    // Auto mode: corners are waiting for air (see InflateQueue.h). Holds
+    // the fill cycle on, with both pumps if QUEUE_BOTH_PUMPS.
+    void setDemand(bool waiting) { demand = waiting; }
+    bool hasDemand() const { return demand; }
+
+    // A corner is inflating from the tank (fill-rate windows don't count)
+    void setTankDraw(bool drawing) { tankDraw = drawing; }
+
     // Set target pressure (for auto mode)
     void setTargetPressure(float psi);
     float getTargetPressure() const { return targetPressure; }
@@ -32,6 +47,19 @@ class Compressor {
     bool isPump1Running() const { return pump1On; }
     bool isPump2Running() const { return pump2On; }
     bool isRunning() const { return pump1On || pump2On; }
+    bool isFilling() const { return filling; }      // Auto mode fill cycle open (pumps may be resting)
+
+    // Scheduling (see PumpScheduler.h): a move drew this much tank PSI
+    void noteDraw(float tankPsi) { scheduler.noteDraw(tankPsi); }
+    const PumpScheduler& getScheduler() const { return scheduler; }
+
+    // Seconds to targetPressure with the pumps auto mode would run, at
+    // their learned fill rates (NAN while both pumps rest)
+    float getTimeToFullS(float tankPressure) const;
+
+    // Fill-rate curves, flow trend, projected service (see PumpHealth.h)
+    const PumpHealth& getHealth() const { return health; }
+    float getServiceHours(int pump) const;
 
     // Get string representation of mode
     const char* getModeString() const;
@@ -43,6 +71,7 @@ class Compressor {
     float getPump2RuntimeHours() const { return pump2RuntimeMs / 3600000.0; }
     void loadRuntimeFromEEPROM();
     void saveRuntimeToEEPROM();
+    void restoreRuntime(int pump, unsigned long runtimeMs, uint32_t starts);  // Trace replay: snapshot values
 
     // Maintenance status
     bool isPump1MaintenanceDue() const { return getPump1RuntimeHours() >= PUMP_MAINTENANCE_HOURS; }
@@ -60,15 +89,21 @@ class Compressor {
     PumpMode currentMode;
     float targetPressure;
 
-    bool pump1On;
+    bool pump1On;                // Relay states (what the pins show)
     bool pump2On;
+    bool wantPump1;              // What the mode asks for
+    bool wantPump2;
+    unsigned long pumpChangedMs[2];  // Last start or stop of each relay
+    unsigned long lastStartMs;       // Last start of either
 
-    // Alternating pump logic
-    bool alternatePump;          // Which pump to use when alternating (false=pump1, true=pump2)
-    unsigned long lastSwitchTime;
+    // Which pump runs: wear, heat, demand forecast
+    PumpScheduler scheduler;
+    PumpHealth health;
 
     // Fill cycle hysteresis: true while actively filling, prevents rapid on/off cycling
     bool filling;
+    bool demand;                 // Corners waiting for air
+    bool tankDraw;               // A corner inflating from the tank
 
     // Runtime tracking
     unsigned long pump1RuntimeMs;
@@ -78,6 +113,7 @@ class Compressor {
 
     void setPump1(bool on);
     void setPump2(bool on);
+    void applyPumps(bool stopNow);
     void runAutoMode(float tankPressure);
     void updateRuntime();
 };
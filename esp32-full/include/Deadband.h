@@ -0,0 +1,70 @@
+#ifndef DEADBAND_H
+#define DEADBAND_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "AirBag.h"
+
+// ============================================
+// NOISE-ADAPTIVE DEADBAND
+// ============================================
+// Tracking holds a corner once it is within a band of its target, and a
+// holding corner reopens only a little further out. With one fixed band
+// for every corner, a noisy sender chatters its valves at the band edge
+// while a clean one settles further from target than it needs to.
+//
+// Each corner's band is learned instead, from two things:
+// - Noise: the spread of the smoothed reading while every valve has been
+//   closed for DEADBAND_QUIET_MS. The reopen margin covers
+//   DEADBAND_NOISE_SIGMAS of it, so noise alone can't reopen the valve.
+// - Valve response: how far the reading moves in the
+//   DEADBAND_RESPONSE_SETTLE_MS after the valve closes. Coasting on in
+//   the travel direction (overshoot) widens the band, so a corner stopped
+//   at the near edge doesn't land past the far one; falling back widens
+//   the reopen margin, so it doesn't refill straight away.
+//
+// Until DEADBAND_MIN_SAMPLES quiet readings are in, a corner uses
+// TARGET_TOLERANCE_PSI / TARGET_REOPEN_HYSTERESIS_PSI. Published values
+// only change by DEADBAND_HYSTERESIS_PSI or more, so the band doesn't
+// wander with every sample. Nothing is persisted: the estimate rebuilds
+// within a minute of holding after boot.
+
+class DeadbandEstimator {
+  public:
+    DeadbandEstimator();
+
+    // Every tick, after the bags have read their pressures
+    void update(const AirBag* bags);
+
+    float getBand(int bag) const { return band[bag]; }        // Hold within this of target (PSI)
+    float getReopen(int bag) const { return reopen[bag]; }    // A holding corner reopens this far past the band
+    float getNoise(int bag) const { return sqrtf(variance[bag]); }  // Smoothed reading, 1 sigma (PSI)
+    float getOvershoot(int bag) const { return overshoot[bag]; }
+    float getDropback(int bag) const { return dropback[bag]; }
+    bool isLearned(int bag) const { return samples[bag] >= DEADBAND_MIN_SAMPLES; }
+
+  private:
+    // Noise while everything holds
+    float mean[NUM_BAGS];
+    float variance[NUM_BAGS];
+    uint16_t samples[NUM_BAGS];
+    bool quiet;                         // Sampling noise (means are seeded)
+    unsigned long quietSinceMs;
+
+    // Valve response: reading at close vs after settling
+    float overshoot[NUM_BAGS];          // Kept moving in the travel direction (PSI)
+    float dropback[NUM_BAGS];           // Moved back against it (PSI)
+    ValveState lastState[NUM_BAGS];
+    int closedDir[NUM_BAGS];            // +1 inflate, -1 dump, 0 = not waiting
+    float closedPsi[NUM_BAGS];
+    unsigned long closedAtMs[NUM_BAGS];
+
+    float band[NUM_BAGS];
+    float reopen[NUM_BAGS];
+
+    void sampleNoise(const AirBag* bags, unsigned long now);
+    void sampleResponse(const AirBag& bag, int i, unsigned long now);
+    void publish(const AirBag& bag, int i);
+};
+
+#endif // DEADBAND_H
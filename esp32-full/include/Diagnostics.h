@@ -0,0 +1,90 @@
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// ============================================
+// STALL DIAGNOSTICS
+// ============================================
+// Answers "why did it reboot, and what was it doing":
+//   - Boot count and the last DIAG_HISTORY_SIZE reset reasons (EEPROM),
+//     each with the loop stage that was running and the uptime reached.
+//     Stage and uptime live in RTC memory, which survives panics and
+//     watchdog resets but not power loss.
+//   - Per-stage budgets for loop(): the firmware is one Arduino task, so
+//     OTA, web, control, console and link each get a soft watchdog
+//     budget here instead of a task of their own (as do the deferred
+//     WiFi/OTA boot steps); the hardware task watchdog
+//     (WATCHDOG_TIMEOUT_S) still backs the whole loop.
+//   - The ESP-IDF core dump the panic handler writes to the "coredump"
+//     flash partition (default Arduino partition table).
+// Served by AirRideWebServer at GET /diag and GET /coredump.
+
+enum LoopStage {
+    STAGE_NONE,         // Between loop() stages (or before the first)
+    STAGE_OTA,
+    STAGE_WEB,
+    STAGE_CONTROL,
+    STAGE_CONSOLE,
+    STAGE_LINK,
+    STAGE_BOOT,         // Deferred bring-up step (WiFi, OTA) run after control is live
+    NUM_LOOP_STAGES
+};
+
+// One remembered reset (8 bytes in EEPROM)
+struct ResetRecord {
+    uint32_t boot;          // Boot number that started after this reset
+    uint8_t reason;         // esp_reset_reason_t
+    uint8_t stage;          // LoopStage running when it happened (STAGE_NONE if unknown)
+    uint16_t uptimeMin;     // How long the previous session ran (0 if unknown)
+};
+
+struct StageStats {
+    uint32_t overruns;      // Times the stage exceeded its budget
+    uint32_t worstMs;       // Longest single run
+};
+
+class Diagnostics {
+  public:
+    Diagnostics();
+
+    // Record this boot's reset reason (call once, after EEPROM.begin())
+    void begin();
+
+    // End the running stage and start the next (STAGE_NONE just ends)
+    void stage(LoopStage next);
+
+    // Boot milestones (millis() since reset, 0 until reached)
+    void markControlReady();
+    void markBootComplete();
+    uint32_t getControlReadyMs() const { return controlReadyMs; }
+    uint32_t getBootCompleteMs() const { return bootCompleteMs; }
+
+    uint32_t getBootCount() const { return bootCount; }
+    const ResetRecord& getLastReset() const { return lastReset; }
+    int getResetHistory(ResetRecord* out, int max) const;   // Newest first
+    const StageStats& getStageStats(int stage) const { return stats[stage]; }
+
+    static const char* resetReasonName(uint8_t reason);
+    static const char* stageName(uint8_t stage);
+    static uint32_t stageBudgetMs(uint8_t stage);
+
+    // Core dump partition (size 0 when empty or unsupported)
+    size_t getCoreDumpSize() const;
+    bool readCoreDump(size_t offset, uint8_t* buf, size_t length) const;
+    bool eraseCoreDump();
+
+  private:
+    uint32_t bootCount;
+    ResetRecord lastReset;
+    StageStats stats[NUM_LOOP_STAGES];
+    uint8_t currentStage;
+    unsigned long stageStartMs;
+    uint32_t controlReadyMs;
+    uint32_t bootCompleteMs;
+};
+
+extern Diagnostics diagnostics;
+
+#endif // DIAGNOSTICS_H
@@ -0,0 +1,63 @@
+#ifndef FILL_SCHEDULE_H
+#define FILL_SCHEDULE_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "AirBag.h"
+
+// ============================================
+// INFLATE GAIN SCHEDULE
+// ============================================
+// A bag fills at roughly k * sqrt(tank - bag): at a full tank a corner
+// fills several times faster than near the cutoff. The reading lags the
+// bag (smoothing, line volume), so after the inflate valve closes the
+// reading keeps climbing - further the faster the fill was. Closing at a
+// fixed point overshoots with a full tank and stops short with a low one.
+//
+// Tracking instead closes an inflating corner once it is within the
+// predicted coast of its target. The coast comes from a per-corner table
+// over tank-minus-bag pressure (points from 15 to 130 PSI dP), with a
+// separate row for fills while a pump runs, since the tank then recovers
+// during the fill and the line stays fuller. Points start from the flow
+// model (PLAN_INFLATE_K * sqrt(dP) * FILL_LATENCY_S) and are refined from
+// every inflate of at least FILL_LEARN_MIN_MS (shorter pulses never reach
+// full flow): FILL_COAST_SETTLE_MS after the valve closes, the rise
+// since closing is the observed coast, blended into the two points that
+// bracket the fill's dP.
+//
+// Nothing is persisted: a few fills after boot are enough to re-learn.
+
+class FillSchedule {
+  public:
+    FillSchedule();
+
+    // Every tick, after the bags have read their pressures
+    void update(const AirBag* bags, float tankPressure, bool pumping);
+
+    // Predicted rise after closing the inflate valve now, for a fill at
+    // deltaPsi tank minus bag (PSI)
+    float getLead(int bag, float deltaPsi, bool pumping) const;
+
+    float getPoint(int bag, bool pumping, int point) const { return lead[bag][pumping ? 1 : 0][point]; }
+    uint16_t getFills(int bag) const { return fills[bag]; }
+    static float pointDeltaPsi(int point) { return DELTA_PSI[point]; }
+
+  private:
+    static const float DELTA_PSI[FILL_SCHEDULE_POINTS];
+
+    float lead[NUM_BAGS][2][FILL_SCHEDULE_POINTS];  // [bag][pumping][dP point]
+    uint16_t fills[NUM_BAGS];                       // Observed fills (saturates)
+
+    // Coast observation: from the inflate valve closing until it settles
+    ValveState lastState[NUM_BAGS];
+    unsigned long openedAtMs[NUM_BAGS];
+    bool coasting[NUM_BAGS];
+    bool coastPumping[NUM_BAGS];
+    float closedPsi[NUM_BAGS];
+    float closedDeltaPsi[NUM_BAGS];
+    unsigned long closedAtMs[NUM_BAGS];
+
+    static void bracket(float deltaPsi, int& lo, float& weight);
+};
+
+#endif // FILL_SCHEDULE_H
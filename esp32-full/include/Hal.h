@@ -0,0 +1,139 @@
+#ifndef HAL_H
+#define HAL_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "TraceRecorder.h"
+
+#if !defined(AIRRIDE_NATIVE)
+#include <soc/gpio_reg.h>
+#endif
+
+// ============================================
+// HARDWARE ACCESS POLICY
+// ============================================
+// Every pressure sample and solenoid/pump write goes through Hal::,
+// resolved at compile time so the production image has no simulation
+// branches in the sensor path:
+//   AdcHal   (default)            - analogRead/digitalWrite only
+//   SimHal   (-DAIRRIDE_HAL_SIM)   - sensors answered by the simulated plant
+//   BenchHal (-DAIRRIDE_HAL_BENCH) - demoMode selects plant or ADC at runtime
+// The native host build uses AdcHal too: its shim routes the Arduino
+// pin calls to whatever PlantModel the tool attached.
+// The selected policy is wrapped in TracedHal so the session trace sees
+// every sample and output (no-op until traceRecorder.begin()).
+//
+// writePins() drives every pin in a 64-bit mask (bit n = GPIO n) to the
+// same level. On the ESP32 that is one W1TS/W1TC register write per bank
+// (GPIO0-31, GPIO32-48), so all masked pins in a bank switch together.
+
+// Calls fn(pin) for each set bit, lowest pin first
+template <class Fn>
+static inline void forEachPin(uint64_t mask, Fn fn) {
+    while (mask) {
+        uint8_t pin = (uint8_t)__builtin_ctzll(mask);
+        mask &= mask - 1;
+        fn(pin);
+    }
+}
+
+struct AdcHal {
+    static const bool SIMULATED = false;
+
+    static inline void sync() {}
+    static inline int readAdc(uint8_t pin) { return analogRead(pin); }
+    static inline void writePin(uint8_t pin, uint8_t level) { digitalWrite(pin, level); }
+
+    static inline void writePins(uint64_t mask, uint8_t level) {
+#if defined(AIRRIDE_NATIVE)
+        forEachPin(mask, [level](uint8_t pin) { digitalWrite(pin, level); });
+#else
+        uint32_t low = (uint32_t)mask;
+        uint32_t high = (uint32_t)(mask >> 32);
+        if (level == HIGH) {
+            if (low) REG_WRITE(GPIO_OUT_W1TS_REG, low);
+            if (high) REG_WRITE(GPIO_OUT1_W1TS_REG, high);
+        } else {
+            if (low) REG_WRITE(GPIO_OUT_W1TC_REG, low);
+            if (high) REG_WRITE(GPIO_OUT1_W1TC_REG, high);
+        }
+#endif
+    }
+};
+
+#if defined(AIRRIDE_HAL_SIM) || defined(AIRRIDE_HAL_BENCH)
+#include "PneumaticPlant.h"
+
+extern PneumaticPlant simPlant;  // Defined in PneumaticPlant.cpp
+
+struct SimHal {
+    static const bool SIMULATED = true;
+
+    // Integrate the plant up to now (called once per control tick)
+    static inline void sync() {
+        static unsigned long lastMicros = micros();
+        unsigned long now = micros();
+        simPlant.advance((now - lastMicros) / 1000000.0f);
+        lastMicros = now;
+    }
+    static inline int readAdc(uint8_t pin) { return simPlant.readAdc(pin); }
+
+    // Outputs still drive the pins so bench LEDs/valves follow the simulation
+    static inline void writePin(uint8_t pin, uint8_t level) {
+        digitalWrite(pin, level);
+        simPlant.writePin(pin, level);
+    }
+    static inline void writePins(uint64_t mask, uint8_t level) {
+        AdcHal::writePins(mask, level);
+        forEachPin(mask, [level](uint8_t pin) { simPlant.writePin(pin, level); });
+    }
+};
+
+struct BenchHal {
+    static const bool SIMULATED = true;
+
+    static inline void sync() { SimHal::sync(); }
+    static inline int readAdc(uint8_t pin) {
+        return demoMode ? SimHal::readAdc(pin) : AdcHal::readAdc(pin);
+    }
+    // Plant always sees the valves so toggling demo mode is seamless
+    static inline void writePin(uint8_t pin, uint8_t level) { SimHal::writePin(pin, level); }
+    static inline void writePins(uint64_t mask, uint8_t level) { SimHal::writePins(mask, level); }
+};
+#endif
+
+template <class Base>
+struct TracedHal {
+    static const bool SIMULATED = Base::SIMULATED;
+
+    static inline void sync() { Base::sync(); }
+    static inline int readAdc(uint8_t pin) {
+        int counts = Base::readAdc(pin);
+        traceRecorder.recordAdc(pin, counts);
+        return counts;
+    }
+    static inline void writePin(uint8_t pin, uint8_t level) {
+        traceRecorder.recordOutput(pin, level);
+        Base::writePin(pin, level);
+    }
+    static inline void writePins(uint64_t mask, uint8_t level) {
+        forEachPin(mask, [level](uint8_t pin) { traceRecorder.recordOutput(pin, level); });
+        Base::writePins(mask, level);
+    }
+};
+
+#if defined(AIRRIDE_HAL_SIM)
+typedef SimHal HalBackend;
+#elif defined(AIRRIDE_HAL_BENCH)
+typedef BenchHal HalBackend;
+#else
+typedef AdcHal HalBackend;
+#endif
+
+#if defined(AIRRIDE_NO_TRACE)
+typedef HalBackend Hal;
+#else
+typedef TracedHal<HalBackend> Hal;
+#endif
+
+#endif // HAL_H
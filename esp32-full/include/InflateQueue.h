@@ -0,0 +1,67 @@
+#ifndef INFLATE_QUEUE_H
+#define INFLATE_QUEUE_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "AirBag.h"
+#include "Deadband.h"
+#include "AirBudget.h"
+
+// ============================================
+// DEFERRED INFLATION
+// ============================================
+// Below TANK_CUTOFF_PSI every inflate valve closes and commands can't
+// open one. Tracking used to pick the starved corners up again the moment
+// the tank passed TANK_RESUME_PSI - all of them at once, which drew the
+// tank straight back into lockout, twisted the car on the way and left
+// the pumps on their slow single-pump top-off.
+//
+// Now a corner that wants air during a lockout (target above it by more
+// than its band plus reopen margin) is queued. While anything is queued
+// the fill cycle is held on (both pumps with QUEUE_BOTH_PUMPS). Once the
+// lockout clears, queued corners are released a priority level at a time
+// (QUEUE_PRIORITY_*, lower first, both corners of a level together so the
+// car stays level across): a level goes as soon as the air the released
+// corners still need, at their learned volumes (see AirBudget.h), leaves
+// the tank above QUEUE_RELEASE_FLOOR_PSI. The first level always goes, so
+// a move bigger than the tank still makes progress. A corner leaves the
+// queue once it no longer wants air; a new lockout puts every waiting
+// corner back in line.
+//
+// Coordinated preset moves stage before the lockout (see
+// TransitionPlanner.h), so the queue mostly serves single-corner targets,
+// ramps and moves that started from a low tank. Corners in a coordinated
+// move are released together: the planner keeps them in step and would
+// otherwise hold the released ones back for the ones still queued.
+
+class InflateQueue {
+  public:
+    InflateQueue();
+
+    // Every tick, after the bags have read their pressures. coordinated:
+    // corners the planner is moving (bit n = bag n).
+    void update(const AirBag* bags, const DeadbandEstimator& deadband, const AirBudget& budget,
+                float tankPressure, bool lockout, uint8_t coordinated);
+
+    // false = this corner waits its turn (it may still dump)
+    bool mayInflate(int bag) const { return !(queued & (1 << bag)) || (released & (1 << bag)); }
+
+    bool isEmpty() const { return queued == 0; }
+    uint8_t getQueued() const { return queued; }        // Bit n = bag n waiting for air
+    uint8_t getReleased() const { return released; }    // ...and allowed to take it
+    unsigned long getWaitMs(int bag) const;             // Time in the queue (0 = not queued)
+    float getNeedPsi(int bag) const { return need[bag]; }
+    uint32_t getDeferrals() const { return deferrals; } // Corners queued since boot
+    static uint8_t priorityOf(int bag);
+
+  private:
+    uint8_t queued;
+    uint8_t released;
+    unsigned long queuedAtMs[NUM_BAGS];
+    float need[NUM_BAGS];               // PSI short of target
+    uint32_t deferrals;
+
+    void release(const AirBag* bags, const AirBudget& budget, float tankPressure, uint8_t coordinated);
+};
+
+#endif // INFLATE_QUEUE_H
@@ -0,0 +1,111 @@
+#ifndef LEVEL_CONTROLLER_H
+#define LEVEL_CONTROLLER_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "AirBag.h"
+#include "Deadband.h"
+
+// ============================================
+// CROSS-COUPLED LEVELLING
+// ============================================
+// The car body is one stiff piece on four bags: filling one corner lifts
+// it, twists the body and moves load onto that corner's diagonal and off
+// the other two. Levelling each pair on its own (both bags to the pair
+// average, re-aimed every step) ignores that, so on uneven ground the
+// correction on one corner undoes the others and level mode keeps
+// cycling valves.
+//
+// This controller keeps a 4x4 coupling matrix: coupling[i][j] is how many
+// PSI corner i moves per PSI corner j is moved by its own valve (1 on the
+// diagonal). It starts from the LEVEL_COUPLING_* guesses and is learned
+// from every single-corner step the car makes (level corrections, bag
+// targets, manual buttons).
+//
+// Level is a set of pressure relations: front pair equal, rear pair equal
+// and, in LEVEL_ALL, front average minus rear average equal to the pitch
+// target. When a relation is off by more than LEVEL_TOLERANCE_PSI (scaled
+// by the widest deadband of the corners in it, see Deadband.h) and the
+// car has been still for LEVEL_SETTLE_MS, the controller solves for one
+// coordinated correction through the coupling matrix, picking the
+// smallest set of corners that fixes every relation at once (fewest valve
+// events, then least departure from the ride height), and gives every
+// corner its predicted end pressure as target so tracking doesn't fight
+// the load transfer. It then waits for the air to settle before judging
+// again.
+
+enum LevelMode {
+    LEVEL_OFF,
+    LEVEL_FRONT,    // Match front left and right
+    LEVEL_REAR,     // Match rear left and right
+    LEVEL_ALL       // Match each pair and hold the front/rear pitch
+};
+
+enum LevelPhase {
+    LEVEL_IDLE,         // Level, or waiting for the car to be still
+    LEVEL_CORRECTING,   // Corners moving to a correction
+    LEVEL_SETTLING      // Correction landed, letting the body settle
+};
+
+class LevelController {
+  public:
+    LevelController();
+
+    // Level mode switched on/changed: the current stance is the reference
+    void engage(const AirBag* bags);
+
+    // New targets from a preset or command: they become the reference
+    // (and the held pitch), any correction in flight is dropped
+    void rebase(const AirBag* bags);
+
+    // Every tick, after the bags have read their pressures: learns the
+    // coupling and, when allowed, corrects. Returns the corners whose
+    // targets it moved (bit n = bag n).
+    uint8_t update(AirBag* bags, const DeadbandEstimator& deadband, LevelMode mode,
+                   bool mayCorrect, bool canInflate);
+
+    // Front average minus rear average PSI for LEVEL_ALL; NAN = hold the
+    // pitch the reference had
+    void setPitchTarget(float psi);
+    float getPitchTarget() const { return pitchHeld ? heldPitch : pitchTarget; }
+    bool isPitchHeld() const { return pitchHeld; }
+
+    LevelPhase getPhase() const { return phase; }
+    float getResidual() const { return residual; }      // Worst relation error at the last check (PSI)
+    uint32_t getCorrections() const { return corrections; }
+    uint32_t getCornerMoves() const { return cornerMoves; }
+    float getCoupling(int affected, int moved) const { return coupling[affected][moved]; }
+    static const char* phaseName(LevelPhase phase);
+
+  private:
+    friend struct RideControllerProbe;  // native/tools/microbench.cpp times a full level check
+
+    float coupling[NUM_BAGS][NUM_BAGS];
+    float reference[NUM_BAGS];      // Ride height: the commanded stance
+    float pitchTarget;
+    float heldPitch;
+    bool pitchHeld;
+
+    LevelPhase phase;
+    uint8_t movers;                 // Corners driven by the current correction
+    unsigned long phaseSinceMs;
+    unsigned long lastCheckMs;
+    unsigned long quietSinceMs;     // Every valve closed since
+    float residual;
+    uint32_t corrections;
+    uint32_t cornerMoves;
+
+    // Coupling learning: one step = one corner moving alone
+    int stepBag;                    // -1 = none
+    float stepStartPsi[NUM_BAGS];
+    float restPsi[NUM_BAGS];        // Pressures once the body settled
+    bool restValid;                 // Nothing has moved since restPsi
+
+    void learn(const AirBag* bags, unsigned long now);
+    int relations(LevelMode mode, const float psi[NUM_BAGS], float rows[][NUM_BAGS], float error[]) const;
+    bool plan(LevelMode mode, const float psi[NUM_BAGS], bool canInflate, float move[NUM_BAGS]) const;
+    uint8_t correct(AirBag* bags, const DeadbandEstimator& deadband, LevelMode mode,
+                    const float psi[NUM_BAGS], const float move[NUM_BAGS]);
+};
+
+#endif // LEVEL_CONTROLLER_H
@@ -0,0 +1,131 @@
+#ifndef LINK_PROTOCOL_H
+#define LINK_PROTOCOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ============================================
+// BINARY SERIAL LINK PROTOCOL
+// ============================================
+// Framed request/response and state streaming over the USB serial port,
+// alongside the text console. Shared by the firmware (SerialLink) and the
+// host client library (native/client), so it has no Arduino dependencies.
+//
+// Frame on the wire:   0x00 | COBS( type seq payload... crc16 ) | 0x00
+//   type     LinkMessage
+//   seq      Chosen by the host, echoed in the response (streamed frames
+//            carry a running counter instead)
+//   payload  Little-endian fields, at most LINK_MAX_PAYLOAD bytes
+//   crc16    CRC-16/CCITT-FALSE over type, seq and payload (little-endian)
+// COBS leaves no zero bytes inside a frame and console text never
+// contains one, so a receiver treats bytes between two zeros as a frame
+// and everything else as text.
+
+#define LINK_MAX_PAYLOAD    64
+#define LINK_MAX_FRAME      (2 + LINK_MAX_PAYLOAD + 2)
+#define LINK_MAX_ENCODED    (LINK_MAX_FRAME + LINK_MAX_FRAME / 254 + 1)
+#define LINK_MAX_WIRE       (LINK_MAX_ENCODED + 2)     // With both delimiters
+
+enum LinkMessage {
+    // Host -> device (answered with LINK_ACK unless noted)
+    LINK_PING = 0x01,
+    LINK_GET_STATE = 0x02,      // Answered with LINK_STATE
+    LINK_BAG_MOVE = 0x10,       // u8 bag, i8 direction (>0 inflate, <=0 deflate)
+    LINK_BAG_HOLD,              // u8 bag
+    LINK_BAG_TARGET,            // u8 bag, f32 psi [, u8 RampProfile]
+    LINK_STOP_ALL,
+    LINK_PRESET_APPLY,          // u8 preset [, u8 RampProfile]
+    LINK_PRESET_SAVE,           // u8 preset, f32 fl, fr, rl, rr
+    LINK_LEVEL_MODE,            // u8 LevelMode
+    LINK_PUMP_ENABLE,           // u8 0/1
+    LINK_PUMP_MODE,             // u8 PumpMode
+    LINK_TANK_TARGET,           // f32 psi
+    LINK_TIME_SYNC,             // u32 epoch
+    LINK_DEMO_MODE,             // u8 0/1
+    LINK_LEAK_RESET,
+    LINK_TANK_MAINT,            // u32 epoch of last service (0 = now)
+    LINK_CAL_SET,               // u8 sensor (0=tank, 1-4=bags), f32 offset, gain, refResistor
+    LINK_CAL_RESET,             // u8 sensor (0xFF = all)
+    LINK_SIM_LEAK,              // i8 target (-1 = stop, 0-4), f32 rate PSI/tick (0 = default)
+    LINK_STREAM,                // u16 interval ms (0 = stop)
+    LINK_PARK,                  // Parked low-power mode from the next loop() (see PowerManager.h)
+    LINK_LEVEL_PITCH,           // f32 front minus rear PSI for LEVEL_ALL (NAN = hold the stance's own)
+    LINK_TRACE_RESTART,         // Session trace starts over from a snapshot (see TraceRecorder.h)
+
+    // Device -> host
+    LINK_ACK = 0x80,            // u8 request type, u8 LinkStatus
+    LINK_STATE = 0x81,          // LinkState, reply to LINK_GET_STATE
+    LINK_STATE_STREAM = 0x82    // LinkState, streamed (seq counts frames so drops show)
+};
+
+enum LinkStatus {
+    LINK_OK = 0,
+    LINK_BAD_ARGUMENT,          // Out of range or wrong payload length
+    LINK_REJECTED,              // Valid but refused (tank lockout, time not synced)
+    LINK_UNSUPPORTED,           // Unknown type or not available in this build
+    LINK_BAD_FRAME              // CRC or COBS error (seq is unknown, sent as 0)
+};
+
+// Controller snapshot carried by LINK_STATE
+#define LINK_STATE_LOCKOUT      0x01
+#define LINK_STATE_PUMP_ENABLED 0x02
+#define LINK_STATE_DEMO         0x04
+#define LINK_STATE_TIME_SYNCED  0x08
+
+struct LinkState {
+    uint32_t ms;            // millis() when the frame was built
+    uint32_t tickMs;        // millis() of the control tick that produced the pressures
+    float tank;
+    float bags[4];          // FL, FR, RL, RR
+    float targets[4];
+    uint8_t valves;         // Bit 2n = bag n inflating, bit 2n+1 = bag n deflating
+    uint8_t pumps;          // Bit 0 = pump 1, bit 1 = pump 2
+    uint8_t timeouts;       // Bit n = bag n solenoid timed out
+    uint8_t flags;          // LINK_STATE_*
+    uint8_t levelMode;
+    uint8_t pumpMode;
+};
+
+#define LINK_STATE_SIZE     (4 + 4 + 4 + 16 + 16 + 6)
+
+// One decoded frame with little-endian payload accessors
+class LinkPacket {
+  public:
+    uint8_t type;
+    uint8_t seq;
+    uint8_t payload[LINK_MAX_PAYLOAD];
+    size_t length;
+
+    LinkPacket(uint8_t type = 0, uint8_t seq = 0);
+
+    // Writers return false once the payload is full
+    bool putU8(uint8_t v);
+    bool putU16(uint16_t v);
+    bool putU32(uint32_t v);
+    bool putFloat(float v);
+
+    // Readers walk the payload from the start; false if past the end
+    bool getU8(uint8_t& v);
+    bool getI8(int8_t& v);
+    bool getU16(uint16_t& v);
+    bool getU32(uint32_t& v);
+    bool getFloat(float& v);
+    bool atEnd() const { return readPos == length; }
+
+    void putState(const LinkState& s);
+    bool getState(LinkState& s);
+
+  private:
+    size_t readPos;
+};
+
+// Whole frame including both 0x00 delimiters; returns bytes written to out
+// (out must hold LINK_MAX_WIRE)
+size_t linkEncode(const LinkPacket& packet, uint8_t* out);
+
+// Bytes between the delimiters; false on COBS, length or CRC error
+bool linkDecode(const uint8_t* encoded, size_t length, LinkPacket& packet);
+
+uint16_t linkCrc16(const uint8_t* data, size_t length);
+
+#endif // LINK_PROTOCOL_H
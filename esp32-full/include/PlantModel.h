@@ -0,0 +1,36 @@
+#ifndef PLANT_MODEL_H
+#define PLANT_MODEL_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Simulated hardware for SimHal/BenchHal and the native host shim.
+// The plant sees every solenoid and pump relay write and answers every
+// pressure sensor read in raw ADC counts, so the firmware's own
+// voltage-divider and calibration math is exercised.
+// advance() integrates the physics; implementations choose their own
+// internal step size independent of the control tick.
+class PlantModel {
+  public:
+    virtual ~PlantModel() {}
+
+    virtual void writePin(uint8_t pin, uint8_t level) = 0;
+    virtual int readAdc(uint8_t pin) = 0;
+    virtual void advance(float seconds) = 0;
+
+    // Current physical pressures (for reporting, not seen by the firmware)
+    virtual float getBagPressure(int bag) const = 0;
+    virtual float getTankPressure() const = 0;
+
+  protected:
+    // Inverse of the firmware conversion: PSI -> VDO ohms -> divider volts -> counts
+    static int psiToAdcCounts(float psi) {
+        if (psi < 0) psi = 0;
+        if (psi > SENSOR_MAX_PSI) psi = SENSOR_MAX_PSI;
+        float ohms = SENSOR_MIN_OHMS + (psi / SENSOR_MAX_PSI) * (SENSOR_MAX_OHMS - SENSOR_MIN_OHMS);
+        float volts = ADC_REFERENCE_VOLTAGE * ohms / (REFERENCE_RESISTOR + ohms);
+        return (int)lroundf((volts / ADC_REFERENCE_VOLTAGE) * ADC_RESOLUTION);
+    }
+};
+
+#endif // PLANT_MODEL_H
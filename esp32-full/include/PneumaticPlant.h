@@ -0,0 +1,116 @@
+#ifndef PNEUMATIC_PLANT_H
+#define PNEUMATIC_PLANT_H
+
+#include "PlantModel.h"
+
+// Physical parameters of the air system. Defaults come from the PLANT_*
+// constants in config.h; the native fit_plant tool refines them from
+// recorded telemetry and prints replacement #defines.
+struct PlantParams {
+    float tankVolumeL;                 // Tank volume (liters)
+    float ambientC;                    // Ambient / bag air temperature
+    float loadLbf[NUM_BAGS];           // Load carried by each bag
+    float areaIn2[NUM_BAGS];           // Bag effective area at bump stop
+    float areaLoss;                    // Fraction of effective area lost over full stroke
+    float minVolumeIn3;                // Bag + line volume at bump stop
+    float strokeIn;                    // Bump stop to full extension
+    float warpLbfPerIn;                // Body twist stiffness: load moved onto a diagonal per inch
+    float groundTwistIn;               // Wheels out of plane (uneven driveway), FL+RR high
+    float inflateCdAmm2[NUM_BAGS];     // Effective orifice tank -> bag
+    float deflateCdAmm2[NUM_BAGS];     // Effective orifice bag -> atmosphere
+    float pumpFreeCfm;                 // Per pump, free air delivered at 0 PSI
+    float pumpMaxPsi;                  // Back-pressure where pump flow reaches zero
+    float pumpDischargeC;              // Temperature of air entering the tank
+    float tankCoolingS;                // Tank air -> ambient time constant
+    float tankLeakCdAmm2;              // Tank leak to atmosphere
+    float noisePsi;                    // Sensor noise (1 sigma)
+    float inrushSagPsi;                // Sensors read low by this per pump starting
+    float stepS;                       // Integration step
+
+    void setDefaults();
+};
+
+// Cumulative actuator and air accounting since the last resetStats()
+struct PlantStats {
+    unsigned long valveTransitions;    // Solenoid open/close edges
+    float solenoidOnS;                 // Summed over all solenoids
+    float pumpOnS;                     // Summed over both pumps
+    float tankDrawnKg;                 // Air moved tank -> bags
+    float ventedKg;                    // Air dumped bags -> atmosphere
+    float pumpedKg;                    // Air delivered by the pumps
+};
+
+// Lumped-parameter model of the compressor, tank, valves and bags:
+//  - air mass per volume, ideal gas (bags at ambient, tank temperature
+//    tracks hot pump discharge and cools toward ambient)
+//  - compressible orifice flow through each solenoid, choked or subsonic
+//    depending on the pressure ratio
+//  - pump delivery falling off linearly with tank back-pressure
+//  - bag height found from the force balance against the corner load, so
+//    bag volume (and therefore fill rate) changes as the car lifts
+//  - load transfer between corners: raising one corner twists the body,
+//    loading that corner and its diagonal and unloading the other two
+//  - pump inrush: for PLANT_INRUSH_MS after a pump relay closes every
+//    sensor reads low (two pumps starting together, twice as low)
+// Valves and pumps follow the real pin map and relay polarity from
+// config.h. Backs SimHal / BenchHal on the device and the native tools.
+class PneumaticPlant : public PlantModel {
+  public:
+    PneumaticPlant();
+
+    void writePin(uint8_t pin, uint8_t level) override;
+    int readAdc(uint8_t pin) override;
+    void advance(float seconds) override;
+
+    float getBagPressure(int bag) const override;
+    float getTankPressure() const override;
+
+    void setBagPressure(int bag, float psi);
+    void setTankPressure(float psi);
+    void setNoise(float psi) { params.noisePsi = psi; }
+    void setAmbient(float celsius);
+
+    // Seed all five pressures (entering demo mode from live readings)
+    void seed(const float bagPressures[NUM_BAGS], float tankPressure);
+
+    // Parameters (changing volumes/loads keeps the current pressures)
+    const PlantParams& getParams() const { return params; }
+    void setParams(const PlantParams& p);
+
+    const PlantStats& getStats() const { return stats; }
+    void resetStats();
+
+    float getBagHeight(int bag) const { return bagHeightIn[bag]; }  // Inches above bump stop
+    float getTankTemperature() const;                               // Celsius
+
+  private:
+    PlantParams params;
+    PlantStats stats;
+
+    float tankMassKg;
+    float tankTempK;
+    float bagMassKg[NUM_BAGS];
+    float bagHeightIn[NUM_BAGS];
+    float bagVolumeM3[NUM_BAGS];
+    float warpLoadLbf[NUM_BAGS];       // Load moved onto (+) or off (-) each corner by body twist
+    bool inflateOpen[NUM_BAGS];
+    bool deflateOpen[NUM_BAGS];
+    bool pump1On;
+    bool pump2On;
+    float inrushLeftS[2];              // Each pump's starting inrush still sagging the supply
+    bool warpStale;                    // Pressures or parameters were set directly
+    float pendingSeconds;
+
+    void step(float dt);
+    void solveBag(int bag);
+    void solveWarp();
+    float warpResidual(float twistLbf);
+    float cornerLoadLbf(int bag) const { return params.loadLbf[bag] + warpLoadLbf[bag]; }
+    float bagVolumeAt(int bag, float heightIn) const;
+    float bagAbsPa(int bag) const;
+    float tankAbsPa() const;
+    float ambientK() const { return params.ambientC + 273.15f; }
+    float tankVolumeM3() const { return params.tankVolumeL * 0.001f; }
+};
+
+#endif // PNEUMATIC_PLANT_H
@@ -0,0 +1,84 @@
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "AirBag.h"
+#include "RideController.h"
+#include "AirRideWebServer.h"
+
+// ============================================
+// PARKED LOW-POWER MODE
+// ============================================
+// Parking shuts the soft-AP down, holds the pumps off and stops target
+// tracking (RideController::setParked), then light-sleeps between leak
+// checks. Each timer wake primes all five sensors with a burst of
+// control ticks and compares them against the leak snapshot taken when
+// it parked; the wake button brings everything back.
+//
+// Light sleep keeps RAM and the relay levels (held with gpio_hold_en),
+// so a wake is a few milliseconds of work rather than a reboot. The
+// ESP32-S3 ULP could sample the ADC without waking the main core, but it
+// needs an ESP-IDF ULP toolchain the Arduino build doesn't have.
+//
+// Current draw is estimated from the POWER_*_MA figures and the time
+// spent in each state; it is not measured.
+
+enum PowerState {
+    POWER_AWAKE,
+    POWER_PARKED
+};
+
+struct PowerStats {
+    uint32_t parks;
+    uint32_t timerWakes;        // Leak-check wakes
+    uint32_t buttonWakes;       // Wake button (ends the park)
+    unsigned long sleptMs;      // In light sleep, all parks
+    unsigned long parkedAwakeMs;// Awake while parked (wake sampling), all parks
+    int worstLeakStatus;        // Worst leak check result this park (-1 = not checked)
+};
+
+class PowerManager {
+  public:
+    PowerManager();
+
+    // After control and the web server exist (the AP may still be coming up)
+    void begin(AirBag* bags, RideController* controller, AirRideWebServer* web);
+
+    // Call at the end of every loop(): auto-park countdown while awake,
+    // otherwise sleep until the next leak check or the wake button
+    void update();
+
+    // Park on the next update() (lets a web reply go out first)
+    void requestPark(const char* reason);
+    void wake(const char* reason);
+
+    PowerState getState() const { return state; }
+    bool isParked() const { return state == POWER_PARKED; }
+    const PowerStats& getStats() const { return stats; }
+
+    float getCurrentMa() const;     // Estimate for the current state
+    float getParkedMah() const;     // Estimated charge used while parked (all parks)
+    float getParkedAverageMa() const;
+    unsigned long getIdleRemainingMs() const;   // Until auto-park (0 = due or disabled)
+
+  private:
+    AirBag* bags;
+    RideController* controller;
+    AirRideWebServer* web;
+
+    PowerState state;
+    PowerStats stats;
+    const char* pendingPark;        // Reason of a requested park
+    unsigned long parkedSince;
+    unsigned long lastClientSeen;   // A phone on the AP keeps us awake
+    unsigned long awakeSince;       // Last wake while parked
+
+    void park(const char* reason);
+    bool sleepUntilWake();          // true = timer wake, false = button
+    void sampleAndCheckLeaks();
+};
+
+extern PowerManager powerManager;
+
+#endif // POWER_MANAGER_H
@@ -0,0 +1,96 @@
+#ifndef PUMP_HEALTH_H
+#define PUMP_HEALTH_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// ============================================
+// PUMP HEALTH
+// ============================================
+// Runtime hours say when a pump is due for service, not whether it is
+// wearing out. A compressor on its way out fills slower first: worn rings
+// and a tired check valve cost flow at high tank pressure long before the
+// pump stops.
+//
+// - Curve: whenever exactly one pump runs (past PUMP_CURVE_SETTLE_MS) and
+//   no corner draws from the tank, the tank rise over a window is that
+//   pump's fill rate (PSI/min) in the tank band it ran in. The first
+//   PUMP_CURVE_BASELINE_FILLS windows of a band are its as-new rate; later
+//   ones move the current rate by PUMP_CURVE_GAIN.
+// - Flow: the current curve over the as-new one, averaged over the bands
+//   that have both. A record (runtime hours, flow %, wall clock if synced)
+//   goes into a PUMP_HISTORY_SIZE ring every PUMP_HISTORY_STEP_HOURS.
+// - Projection: the trend of those records gives the runtime hours at
+//   which flow reaches PUMP_FLOW_SERVICE_PCT; service is due at that or
+//   PUMP_MAINTENANCE_HOURS, whichever comes first. With records far
+//   enough apart in calendar time the hours become a date.
+//
+// Curves and history are persisted by Compressor with the runtime. Reset
+// after service (resetPumpNRuntime), so the pump is measured as new again.
+
+// One flow record (8 bytes, persisted)
+struct PumpFlowRecord {
+    uint32_t epoch;         // Wall clock when recorded (0 = time not synced)
+    uint16_t hoursX10;      // Pump runtime, tenths of an hour
+    uint8_t flowPct;        // Current curve vs as-new (0 = unused slot)
+    uint8_t reserved;
+};
+
+// Per-pump curve and history (96 bytes, persisted)
+struct PumpCurve {
+    float baseline[PUMP_CURVE_BINS];        // As-new PSI/min per band
+    float current[PUMP_CURVE_BINS];         // Recent PSI/min per band
+    uint8_t fills[PUMP_CURVE_BINS];         // Windows behind each band (saturates)
+    uint8_t historyHead;                    // Next record slot
+    uint8_t reserved[2];
+    PumpFlowRecord history[PUMP_HISTORY_SIZE];
+};
+
+class PumpHealth {
+  public:
+    PumpHealth();
+
+    // Every compressor update with the relay states just applied.
+    // tankDraw: a corner is inflating (the tank rise isn't the pump's).
+    void update(float tankPressure, bool pump1On, bool pump2On, bool tankDraw,
+                const unsigned long runtimeMs[2]);
+
+    // Seconds for the pumps in mask (bit 0 = pump 1) to take the tank from
+    // one pressure to another, at the learned rates (PLAN_PUMP_PSI_PER_S
+    // where a band isn't learned yet)
+    float fillSeconds(float fromPsi, float toPsi, uint8_t pumps) const;
+    float getRatePsiPerMin(int pump, float tankPressure) const;
+
+    int getFlowPct(int pump) const;         // -1 until a band has its baseline
+    int getScore(int pump) const;           // 0-100, -1 unknown
+    float getTrendPctPerHour(int pump) const;   // NAN with too little history
+    float getServiceHours(int pump, float runtimeHours) const;  // Runtime at which service is due
+    long getServiceEpoch(int pump, float runtimeHours) const;   // -1 unless time and usage are known
+    bool isDegraded(int pump) const;        // Flow below PUMP_FLOW_SERVICE_PCT
+
+    const PumpCurve& getCurve(int pump) const { return curves[pump]; }
+    int getHistory(int pump, PumpFlowRecord* out, int max) const;   // Newest first
+
+    void reset(int pump);
+    void load(int pump, const PumpCurve& curve);
+
+  private:
+    PumpCurve curves[2];
+    bool degraded[2];
+
+    // Measurement window (one pump at a time)
+    int windowPump;                 // -1 = none
+    unsigned long windowStartMs;
+    float windowStartPsi;
+    unsigned long windowLastMs;     // Last sample with the window still clean
+    float windowLastPsi;
+    unsigned long pumpOnSinceMs[2];
+    bool wasOn[2];
+
+    void closeWindow();
+    void learn(int pump, int bin, float psiPerMin);
+    void record(int pump, float runtimeHours);
+    static int binOf(float tankPressure);
+};
+
+#endif // PUMP_HEALTH_H
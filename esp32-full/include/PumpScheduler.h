@@ -0,0 +1,67 @@
+#ifndef PUMP_SCHEDULER_H
+#define PUMP_SCHEDULER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// ============================================
+// PUMP SCHEDULING
+// ============================================
+// Auto mode used to swap the single topping-off pump every 30 s of wall
+// clock, whatever either pump had done: every swap was two more relay
+// operations and a motor start, and a pump that had just run a long fill
+// was as likely to be picked as a cold one. Filling only started below
+// TANK_MIN_PSI, so a move made right after another one often found the
+// tank half empty.
+//
+// - Wear: a pump's wear is its runtime plus PUMP_START_WEAR_HOURS per
+//   start. A single-pump fill runs the least-worn pump and keeps it for the
+//   whole fill; when both were running and one is enough, the more-worn one
+//   stops.
+// - Heat: each pump has a first-order temperature estimate (rising toward
+//   PUMP_HEAT_RISE_C while it runs, decaying while it rests). A pump
+//   reaching PUMP_HOT_C rests until it is back at PUMP_RESUME_C; the other
+//   takes over. The duty cycle over PUMP_DUTY_WINDOW_S is kept for display.
+// - Demand: every move that drew air teaches a forecast of the next one
+//   (tank PSI). It fades with PUMP_FORECAST_HALF_LIFE_S, so a car that sits
+//   stops expecting moves. When the tank minus the forecast is below
+//   TANK_MIN_PSI, the fill starts now rather than after the next move.
+//
+// Compressor persists runtime and start counts; heat isn't persisted (a
+// reboot is a cold start anyway).
+
+class PumpScheduler {
+  public:
+    PumpScheduler();
+
+    // Every compressor update, with the pump states just applied
+    void update(bool pump1On, bool pump2On);
+
+    // Pumps a fill should run now: wanted 1 or 2, running bit 0 = pump 1,
+    // bit 1 = pump 2. Returns the same kind of mask (0 = both resting).
+    uint8_t choose(int wanted, uint8_t running, const unsigned long runtimeMs[2]) const;
+
+    // A move drew this much tank pressure
+    void noteDraw(float tankPsi);
+    float getForecastPsi() const;       // Next move's expected draw (faded)
+
+    uint32_t getStarts(int pump) const { return starts[pump]; }
+    void restoreStarts(int pump, uint32_t count) { starts[pump] = count; }
+    float getHeatC(int pump) const { return heatC[pump]; }      // Estimated rise above ambient
+    float getDuty(int pump) const { return duty[pump]; }        // 0-1
+    bool isResting(int pump) const { return resting[pump]; }
+    static float wearHours(unsigned long runtimeMs, uint32_t starts);
+
+  private:
+    uint32_t starts[2];
+    float heatC[2];
+    float duty[2];
+    bool resting[2];
+    bool wasOn[2];
+    unsigned long lastUpdateMs;
+
+    float forecastPsi;
+    unsigned long forecastAtMs;
+};
+
+#endif // PUMP_SCHEDULER_H
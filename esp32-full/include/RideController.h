@@ -0,0 +1,196 @@
+#ifndef RIDE_CONTROLLER_H
+#define RIDE_CONTROLLER_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "AirBag.h"
+#include "Compressor.h"
+#include "TransitionPlanner.h"
+#include "Trajectory.h"
+#include "LevelController.h"
+#include "Deadband.h"
+#include "FillSchedule.h"
+#include "AirBudget.h"
+#include "InflateQueue.h"
+
+// Preset definitions (PSI values)
+struct Preset {
+    const char* name;
+    float frontLeft;
+    float frontRight;
+    float rearLeft;
+    float rearRight;
+};
+
+// Default presets: Lay, Cruise, Max
+const Preset DEFAULT_PRESETS[] = {
+    {"Lay",    0.0,   0.0,  0.0,  0.0},   // All the way down
+    {"Cruise", 80.0, 80.0, 50.0, 50.0},   // Front 80, Rear 50
+    {"Max",   100.0, 100.0, 80.0, 80.0}   // Front 100, Rear 80
+};
+const int NUM_PRESETS = 3;
+
+// Control/sampling rate (see CONTROL_INTERVAL_* in config.h)
+enum ControlRate {
+    RATE_IDLE,      // Everything holding: slow ticks
+    RATE_ACTIVE,    // Valve or pump on, or a command within CONTROL_ACTIVE_HOLD_MS
+    NUM_CONTROL_RATES
+};
+
+// Control core: tank sensing, compressor, tank lockout, level mode and
+// target tracking. Only talks to hardware through AirBag/Compressor and
+// analogRead(), so it builds unchanged in the native host environment.
+class RideController {
+  public:
+    RideController(AirBag* bags, Compressor* comp);
+
+    void begin();   // Prime the tank buffer and re-apply the saved targets (control is live on return)
+    bool update();  // Call every loop() - runs tick() at the current control rate (true if it ran)
+    void tick();    // One control cycle: sense, lockout, pumps, bags, level, tracking
+
+    // Tank pressure (smoothed)
+    float getTankPressure() const { return tankPressure; }
+    unsigned long getLastTickMs() const { return lastPressureRead; }
+
+    // Multi-rate scheduling: fast while air is moving, slow while parked
+    ControlRate getControlRate() const { return controlRate; }
+    unsigned long getControlIntervalMs() const;
+    unsigned long getTimeAtRateMs(ControlRate rate) const;
+    uint32_t getRateSwitches() const { return rateSwitches; }
+    static const char* rateName(ControlRate rate);
+
+    // Actuator snapshot (telemetry, binary link state)
+    uint8_t getValveBits() const;   // Bit 2n = bag n inflating, bit 2n+1 = bag n deflating
+    uint8_t getPumpBits() const;    // Bit 0 = pump 1, bit 1 = pump 2
+    unsigned long getValveRestMs() const;   // Every valve closed this long (0 while one is open)
+
+    // Commands (shared by web and serial, recorded in the session trace)
+    // Moves ramp with the given profile (see Trajectory.h)
+    void setBagTarget(int bagNum, float psi,
+                      RampProfile profile = (RampProfile)RAMP_DEFAULT_PROFILE);    // Set target and start moving
+    void applyTargets(const float targets[NUM_BAGS],
+                      RampProfile profile = (RampProfile)RAMP_DEFAULT_PROFILE);    // Preset: all four corners
+    bool manualInflate(int bagNum);   // Hold-button press (false if tank lockout)
+    void manualDeflate(int bagNum);
+    void holdBag(int bagNum);         // Hold-button release: lock at current pressure
+    void stopAll();
+
+    // Coordinated preset moves (see TransitionPlanner.h)
+    const TransitionPlanner& getPlanner() const { return planner; }
+    const TrajectoryGenerator& getTrajectory() const { return trajectory; }
+
+    // Per-corner target band (see Deadband.h)
+    const DeadbandEstimator& getDeadband() const { return deadband; }
+
+    // Inflate close lead by tank pressure (see FillSchedule.h)
+    const FillSchedule& getFillSchedule() const { return fillSchedule; }
+    float getFillLead(int bagNum) const;    // At the current tank pressure
+
+    // Move prediction and air drawn (see AirBudget.h)
+    const AirBudget& getAirBudget() const { return airBudget; }
+
+    // Level mode (see LevelController.h)
+    void setLevelMode(LevelMode mode);
+    LevelMode getLevelMode() const { return levelMode; }
+    void setLevelPitch(float psi);      // Front minus rear average PSI (LEVEL_ALL), NAN = hold
+    const LevelController& getLeveler() const { return leveler; }
+
+    // Tank lockout with hysteresis
+    bool isTankLockout() const { return tankLockout; }
+
+    // Corners waiting out a lockout (see InflateQueue.h)
+    const InflateQueue& getInflateQueue() const { return inflateQueue; }
+    uint32_t getHeldSamples() const { return heldSamples; }
+
+    // Pump enable/disable override
+    bool isPumpEnabled() const { return pumpEnabled; }
+    void setPumpEnabled(bool enabled);
+    void setPumpMode(PumpMode mode);      // Manual override (serial P commands)
+    void setTankTarget(float psi);
+
+    // Parked (see PowerManager.h): pumps off, no level mode or target
+    // tracking, bags hold whatever they have
+    void setParked(bool parked);
+    bool isParked() const { return parked; }
+    unsigned long getIdleMs() const { return millis() - lastActivity; }
+
+    // Sensor calibration: 0 = tank, 1-4 = bags
+    void setSensorCalibration(int sensor, const SensorCalibration& cal);
+
+    // Demo / simulation mode
+    void setDemoMode(bool enabled);
+
+    // Session trace (see TraceRecorder.h): start recording over from a
+    // snapshot, at the next tick with every valve closed and no fill cycle
+    void requestTraceRestart() { traceRestartPending = true; }
+    bool isTraceRestartPending() const { return traceRestartPending; }
+
+    // Telemetry: one CSV row per tick on Serial while enabled (plant fitting)
+    //   ms,tank,fl,fr,rl,rr,valves,pumps
+    //   valves: bit 2n = bag n inflating, bit 2n+1 = bag n deflating
+    //   pumps:  bit 0 = pump 1, bit 1 = pump 2
+    void setTelemetry(bool enabled) { telemetryEnabled = enabled; }
+    bool isTelemetryEnabled() const { return telemetryEnabled; }
+    int formatTelemetry(char* buf, size_t size) const;
+
+  private:
+    friend struct RideControllerProbe;  // native/tools/microbench.cpp times the private stages
+
+    AirBag* bags;
+    Compressor* compressor;
+    TransitionPlanner planner;
+    TrajectoryGenerator trajectory;
+    LevelController leveler;
+    DeadbandEstimator deadband;
+    FillSchedule fillSchedule;
+    AirBudget airBudget;
+    InflateQueue inflateQueue;
+    uint32_t airMovesSeen;          // Finished moves already passed to the compressor
+    uint32_t heldSamples;           // Ticks whose pressure samples a pump start blanked
+
+    // Commanded targets waiting for their flash write (see saveTargets)
+    float commandedTargets[NUM_BAGS];
+    bool targetsDirty;
+    unsigned long targetsChangedMs; // Last command that set them
+    unsigned long valvesClosedMs;   // Every valve closed since
+
+    float tankPressure;
+    unsigned long lastPressureRead;
+
+    // Control rate
+    ControlRate controlRate;
+    unsigned long lastActivity;     // Last valve/pump on or command
+    unsigned long rateSince;        // When controlRate was entered
+    unsigned long rateTimeMs[NUM_CONTROL_RATES];    // Completed time at each rate
+    uint32_t rateSwitches;
+
+    // Tank pressure smoothing
+    float tankPressureBuffer[PRESSURE_SAMPLES];
+    int tankBufferIndex;
+    bool tankBufferFilled;
+
+    LevelMode levelMode;
+    bool tankLockout;
+    bool pumpEnabled;
+    bool parked;
+    bool telemetryEnabled;
+    bool traceRestartPending;
+
+    float readTankPressure();
+    float readTankPressureSmoothed();
+    void moveTowardTarget(int bagNum);
+    bool mayInflate(int bagNum) const { return !tankLockout && inflateQueue.mayInflate(bagNum); }
+    void estimateAir(uint8_t corners, const float rampRates[NUM_BAGS]);
+    void followSetpoint(int bagNum);
+    void updateTankLockout();
+    void updateLevelMode();
+    void updateTargetTracking();
+    void noteActivity() { lastActivity = millis(); }
+    void updateControlRate(unsigned long now);
+    bool restoreTargets();
+    void saveTargets();
+    void updateSavedTargets(unsigned long now);
+    void restartTrace();
+};
+
+#endif // RIDE_CONTROLLER_H
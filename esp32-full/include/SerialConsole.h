@@ -0,0 +1,58 @@
+#ifndef SERIAL_CONSOLE_H
+#define SERIAL_CONSOLE_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "LinkProtocol.h"
+
+// ============================================
+// SERIAL CONSOLE
+// ============================================
+// Non-blocking line reader and command dispatcher for the USB serial
+// console. poll() consumes whatever bytes are already buffered (at most
+// SERIAL_POLL_MAX_BYTES) and returns; a complete line is split into
+// tokens on ';' and whitespace and each token is dispatched through the
+// command table. A half-typed command just sits in the line buffer.
+// Bytes between two 0x00 delimiters are a binary link frame (see
+// LinkProtocol.h) and go to the frame handler instead. A frame that goes
+// quiet for LINK_FRAME_GAP_MS or outgrows LINK_MAX_ENCODED is dropped and
+// the console is back to text.
+
+typedef void (*FrameHandler)(const uint8_t* encoded, size_t length);
+
+struct ConsoleCommand {
+    const char* name;                   // Matched case-insensitively; longest matching name wins
+    void (*handler)(const char* arg);   // Rest of the token after the name (may be empty)
+};
+
+class SerialConsole {
+  public:
+    SerialConsole(const ConsoleCommand* commands, int count);
+
+    void poll();    // Call every loop()
+    void setFrameHandler(FrameHandler handler) { frameHandler = handler; }
+
+    // Argument helpers for handlers: false if arg is not a whole number in [min, max]
+    static bool parseInt(const char* arg, int minValue, int maxValue, int& value);
+
+  private:
+    const ConsoleCommand* commands;
+    int numCommands;
+
+    char line[SERIAL_LINE_SIZE];
+    int lineLength;
+    bool overflow;      // Discarding the rest of an over-long line
+
+    FrameHandler frameHandler;
+    uint8_t frame[LINK_MAX_ENCODED];
+    int frameLength;
+    unsigned long frameByteMs;  // Last byte of the open frame
+    bool inFrame;
+
+    void handleText(char c);
+    void handleFrameByte(uint8_t b);
+    void runLine();
+    void dispatch(const char* token);
+};
+
+#endif // SERIAL_CONSOLE_H
@@ -0,0 +1,46 @@
+#ifndef SERIAL_LINK_H
+#define SERIAL_LINK_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "AirBag.h"
+#include "Compressor.h"
+#include "RideController.h"
+#include "AirRideWebServer.h"
+#include "LinkProtocol.h"
+
+// ============================================
+// BINARY SERIAL LINK
+// ============================================
+// Device side of LinkProtocol.h. SerialConsole hands over each frame it
+// finds between 0x00 bytes; requests run the same actions as the web
+// API and are answered immediately. While a host has asked for it,
+// update() streams LINK_STATE frames at the requested interval.
+
+class SerialLink {
+  public:
+    SerialLink(AirBag* bags, Compressor* comp, RideController* controller, AirRideWebServer* web);
+
+    void handleFrame(const uint8_t* encoded, size_t length);
+    void update();      // Call every loop()
+
+    bool isStreaming() const { return streamIntervalMs > 0; }
+
+  private:
+    AirBag* bags;
+    Compressor* compressor;
+    RideController* controller;
+    AirRideWebServer* web;
+
+    uint16_t streamIntervalMs;
+    unsigned long lastStream;
+    uint8_t streamSeq;
+
+    LinkStatus execute(LinkPacket& request);
+    void fillState(LinkState& state) const;
+    void sendState(uint8_t type, uint8_t seq);
+    void sendAck(uint8_t type, uint8_t seq, LinkStatus status);
+    void send(const LinkPacket& packet);
+};
+
+#endif // SERIAL_LINK_H
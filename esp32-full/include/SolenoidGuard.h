@@ -0,0 +1,52 @@
+#ifndef SOLENOID_GUARD_H
+#define SOLENOID_GUARD_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// ============================================
+// SOLENOID DEAD-MAN TIMER
+// ============================================
+// Closes every solenoid from a hardware-timer interrupt if the control
+// loop stops ticking while a valve is open. AirBag's 30 s solenoid
+// timeout and the 10 s task watchdog both need loop() to run; this does
+// not, so a blocked web request, OTA write or flash erase can hold an
+// inflate valve open for at most SOLENOID_GUARD_MS.
+//
+// Actuators arms the timer when the first solenoid opens and disarms it
+// when the last one closes; RideController feeds it after every tick and
+// handles a trip on the next tick (checkTripped()). Until then a command
+// that opens a valve re-arms the spent alarm, and checkTripped() drives
+// every guarded pin off again, so the pins match what the software
+// believes once the trip has been handled.
+//
+// The native build has no timer: an overdue deadline is detected and
+// acted on when the firmware next calls checkTripped().
+
+class SolenoidGuard {
+  public:
+    SolenoidGuard();
+
+    void begin();
+
+    void arm(uint64_t solenoidMask);    // No-op if already armed (and not yet tripped)
+    void disarm();
+    void feed();                        // Restart the deadline (control tick completed)
+    bool isArmed() const { return armed; }
+
+    // True once per trip, after the interrupt forced the solenoids closed
+    bool checkTripped();
+    unsigned long getTripCount() const { return tripCount; }
+
+  private:
+    bool armed;
+    unsigned long tripCount;
+    uint64_t mask;
+#if defined(AIRRIDE_NATIVE)
+    unsigned long deadline;
+#endif
+};
+
+extern SolenoidGuard solenoidGuard;
+
+#endif // SOLENOID_GUARD_H
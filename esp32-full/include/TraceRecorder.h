@@ -0,0 +1,114 @@
+#ifndef TRACE_RECORDER_H
+#define TRACE_RECORDER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// ============================================
+// SESSION TRACE
+// ============================================
+// Records everything the control core consumes and produces from boot:
+// raw ADC samples, solenoid/pump writes, control tick times and every
+// command issued through RideController (web and serial alike). The
+// native replay tool feeds the inputs back through the same control code
+// and reports the first output that differs.
+//
+// Fixed 4-byte records in RAM; recording stops when the buffer is full.
+// Download with GET /trace. To record a later stretch, restart the trace
+// (/trace?start=1, console TR, LINK_TRACE_RESTART): at the next tick with
+// every valve closed and no fill cycle the buffer starts over with TRACE_SNAPSHOT
+// and the controller's configuration as commands (targets, level and
+// pump modes, calibration, pump runtimes), which replay seeds from.
+
+enum TraceRecordType {
+    TRACE_BOOT = 1,     // value = millis() low 16 bits, control core bring-up starts
+    TRACE_TICK,         // value = millis() low 16 bits at start of RideController::tick()
+    TRACE_TIME,         // value = millis() low 16 bits, precedes each command
+    TRACE_ADC,          // arg = pin, value = raw counts
+    TRACE_OUTPUT,       // arg = pin, value = level written
+    TRACE_COMMAND,      // arg = TraceCommand, value = bag/sensor/mode
+    TRACE_ARG,          // arg = float index, value = 16 bits of the float (high half first)
+    TRACE_SNAPSHOT      // value = millis() low 16 bits, restarted mid-session; snapshot commands follow
+};
+
+enum TraceCommand {
+    TRACE_CMD_SET_TARGET = 1,   // value = bag | RampProfile << 8, 1 float
+    TRACE_CMD_APPLY_TARGETS,    // value = RampProfile, NUM_BAGS floats
+    TRACE_CMD_INFLATE,          // value = bag
+    TRACE_CMD_DEFLATE,          // value = bag
+    TRACE_CMD_HOLD,             // value = bag
+    TRACE_CMD_STOP_ALL,
+    TRACE_CMD_LEVEL_MODE,       // value = LevelMode
+    TRACE_CMD_PUMP_ENABLED,     // value = 0/1
+    TRACE_CMD_PUMP_MODE,        // value = PumpMode
+    TRACE_CMD_TANK_TARGET,      // 1 float
+    TRACE_CMD_CALIBRATION,      // value = sensor (0=tank, 1-4=bags), 3 floats
+    TRACE_CMD_PARKED,           // value = 0/1
+    TRACE_CMD_LEVEL_PITCH,      // 1 float (NAN = hold)
+    TRACE_CMD_TARGETS,          // Snapshot: NUM_BAGS floats, targets without starting a move
+    TRACE_CMD_PUMP_RUNTIME      // Snapshot: value = pump, 2 args: runtime ms, starts (uint32 bits)
+};
+
+struct TraceRecord {
+    uint8_t type;
+    uint8_t arg;
+    uint16_t value;
+};
+
+// Download header (little-endian, followed by count records)
+struct TraceHeader {
+    char magic[4];          // "ARTR"
+    uint16_t version;
+    uint16_t recordSize;
+    uint32_t count;
+    uint32_t flags;         // TRACE_FLAG_*
+};
+
+#define TRACE_MAGIC         "ARTR"
+#define TRACE_VERSION       2       // 2: outputs recorded only when a relay changes state
+#define TRACE_FLAG_FULL     0x01    // Buffer filled; session continued unrecorded
+
+class TraceRecorder {
+  public:
+    TraceRecorder();
+
+    // Start recording (call once in setup() before the control core begins)
+    void begin();
+    bool isActive() const { return active; }
+
+    // Start over mid-session with TRACE_SNAPSHOT (RideController writes
+    // the snapshot commands after it)
+    void restart();
+
+    void recordTick();
+    void recordAdc(uint8_t pin, int counts) { append(TRACE_ADC, pin, (uint16_t)counts); }
+    void recordOutput(uint8_t pin, uint8_t level) { append(TRACE_OUTPUT, pin, level); }
+    void recordCommand(TraceCommand cmd, uint16_t value, const float* args = NULL, int argCount = 0);
+
+    const TraceRecord* getRecords() const { return records; }
+    uint32_t getCount() const { return count; }
+    bool isFull() const { return full; }
+    TraceHeader getHeader() const;
+
+  private:
+    TraceRecord records[TRACE_BUFFER_RECORDS];
+    uint32_t count;
+    bool active;
+    bool full;
+
+    inline void append(uint8_t type, uint8_t arg, uint16_t value) {
+        if (!active) return;
+        if (count >= TRACE_BUFFER_RECORDS) {
+            full = true;
+            return;
+        }
+        records[count].type = type;
+        records[count].arg = arg;
+        records[count].value = value;
+        count++;
+    }
+};
+
+extern TraceRecorder traceRecorder;  // Defined in TraceRecorder.cpp
+
+#endif // TRACE_RECORDER_H
@@ -0,0 +1,86 @@
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "AirBag.h"
+#include "Deadband.h"
+
+// ============================================
+// STANCE RAMPS
+// ============================================
+// A target change used to be a step: the valve opened fully until the
+// bag was inside its band. A ramp instead moves a per-corner setpoint
+// from the current pressure to the target at a limited rate, with an
+// acceleration limit so the move eases in and out, and target tracking
+// follows the setpoint. The valve duty-cycles to keep up, so peak flow
+// (and tank sag when several corners move) is lower.
+//
+// Corners started together get their rates scaled by their travel, so
+// every setpoint arrives at the same moment. Inside pulseZonePsi of the
+// target the solenoid opens in short RAMP_PULSE_ON_MS bursts, so the
+// last few PSI come in gently instead of overshooting.
+
+enum RampProfile {
+    RAMP_FAST,          // Step (no ramp, no pulsing) - dumps and quick lifts, the default
+    RAMP_COMFORT,       // Brisk but smooth
+    RAMP_SHOW,          // Slow, for the crowd
+    NUM_RAMP_PROFILES
+};
+
+struct RampProfileDef {
+    const char* name;
+    float ratePsiS;         // Setpoint slope (0 = step)
+    float accelPsiS2;       // Slope change limit (0 = none)
+    float pulseZonePsi;     // Pulse the solenoid this close to target (0 = never)
+};
+
+const RampProfileDef RAMP_PROFILES[NUM_RAMP_PROFILES] = {
+    {"fast",    0.0,                  0.0,                    0.0},
+    {"comfort", RAMP_COMFORT_RATE_PSI_S, RAMP_COMFORT_ACCEL_PSI_S2, RAMP_COMFORT_PULSE_PSI},
+    {"show",    RAMP_SHOW_RATE_PSI_S, RAMP_SHOW_ACCEL_PSI_S2, RAMP_SHOW_PULSE_PSI}
+};
+
+class TrajectoryGenerator {
+  public:
+    TrajectoryGenerator();
+
+    // Ramp one corner from its current pressure to its target (a move
+    // inside the corner's deadband steps instead)
+    void start(const AirBag& bag, int bagNum, const DeadbandEstimator& deadband, RampProfile profile);
+
+    // Ramp every corner; rates scale with travel so all arrive together
+    void startAll(const AirBag* bags, const DeadbandEstimator& deadband, RampProfile profile);
+
+    // Advance the setpoints (every tick)
+    void update();
+
+    // Manual control or a hold takes the corner off its ramp
+    void release(int bagNum);
+
+    bool isRamping(int bagNum) const { return ramping[bagNum]; }
+    float getSetpoint(int bagNum) const { return setpoint[bagNum]; }
+    float getRate(int bagNum) const { return rate[bagNum]; }    // PSI/s, signed
+    float getMaxRate(int bagNum) const { return maxRate[bagNum]; }
+    RampProfile getProfile(int bagNum) const { return profile[bagNum]; }
+
+    // false = the solenoid is in the closed part of its final-approach pulse
+    bool pulseAllows(int bagNum, float errorPsi) const;
+
+    static const char* profileName(RampProfile profile);
+    static bool parseProfile(const char* text, RampProfile& profile);  // Name, first letter or index
+
+  private:
+    bool ramping[NUM_BAGS];
+    float setpoint[NUM_BAGS];
+    float goal[NUM_BAGS];
+    float rate[NUM_BAGS];
+    float maxRate[NUM_BAGS];
+    float accel[NUM_BAGS];
+    RampProfile profile[NUM_BAGS];
+    unsigned long lastUpdate;       // Previous update() (every tick)
+
+    void begin(int bagNum, float from, float to, float band, RampProfile p, float scale);
+};
+
+#endif // TRAJECTORY_H
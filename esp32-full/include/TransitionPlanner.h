@@ -0,0 +1,136 @@
+#ifndef TRANSITION_PLANNER_H
+#define TRANSITION_PLANNER_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "AirBag.h"
+#include "Deadband.h"
+
+// ============================================
+// COORDINATED MULTI-CORNER TRANSITIONS
+// ============================================
+// A preset sets four targets at once. Left alone, every corner runs at
+// its own rate: the fronts (bigger pressure change) lag, the car pitches
+// and rolls on the way, and a tank that can't supply the whole move runs
+// into lockout halfway.
+//
+// The planner keeps all moving corners at the same fraction of their own
+// travel. Each tick it finds the corner that is furthest behind; corners
+// more than PLAN_SYNC_LEAD ahead of it hold until it catches up, so the
+// slowest corner sets the pace and the stance stays level on the way.
+//
+// Before the valves open the move is predicted with a simple flow model
+// (rate = k * sqrt(dP), k learned per corner from every fill and dump) and
+// the bag and tank volumes (see AirBudget.h): completion time, air needed
+// and the tank pressure left.
+// If inflation would take the tank to PLAN_STAGE_FLOOR_PSI, the move
+// pauses there (level, thanks to the sync) until the pumps bring the tank
+// back to PLAN_STAGE_RESUME_PSI, instead of tripping the tank lockout.
+
+enum PlanOutcome {
+    PLAN_NONE,          // Nothing planned yet
+    PLAN_RUNNING,
+    PLAN_COMPLETE,      // Every corner reached its target band
+    PLAN_CANCELLED,     // Replaced, stopped or parked
+    PLAN_STALLED        // No progress (lockout, solenoid timeout, tank never recovered)
+};
+
+struct PlanReport {
+    PlanOutcome outcome;
+    uint8_t corners;            // Bit n = bag n is part of the move
+    unsigned long startedMs;
+    unsigned long plannedMs;    // Predicted duration
+    unsigned long achievedMs;   // Actual duration (so far while running)
+    float tankStart;
+    float tankPredicted;        // Predicted tank pressure at the end
+    float tankEnd;              // Tank pressure when it finished (latest while running)
+    float airPsi;               // Predicted tank PSI drawn by the inflating corners
+    uint8_t stagesPredicted;    // Pauses for tank recovery the prediction needed
+    uint8_t stages;             // Pauses that happened
+    float worstSpread;          // Largest progress difference between corners (0-1)
+};
+
+// Flow-model prediction of a move (TransitionPlanner::predict)
+struct MovePrediction {
+    unsigned long ms;           // Until the last corner arrives (PLAN_PREDICT_MAX_MS = never)
+    float tankEnd;              // Tank pressure left
+    float airPsi;               // Tank PSI drawn by the inflating corners
+    float bagPsi[NUM_BAGS];     // Bag PSI each corner takes from the tank
+    uint8_t pauses;             // Waits for the tank to recover
+    unsigned long longestPauseMs;
+};
+
+class TransitionPlanner {
+  public:
+    TransitionPlanner();
+
+    // Plan a move of every corner from its pressure to its target. Corners
+    // already inside their band are left out; fewer than two moving corners
+    // needs no coordination (returns false). prediction is the move as
+    // predict() saw it (planned time, tank left).
+    bool start(const AirBag* bags, const DeadbandEstimator& deadband, float tankPressure,
+               const MovePrediction& prediction);
+
+    // Every tick, after the bags have read their pressures: learns the flow
+    // coefficients and, while a plan runs, decides which corners may move
+    void update(const AirBag* bags, const DeadbandEstimator& deadband, float tankPressure);
+
+    // false = hold this corner this tick (ahead of the others, or staged)
+    bool mayMove(int bag) const { return !active || !(corners & (1 << bag)) || (gates & (1 << bag)); }
+
+    bool isMoving(int bag) const { return active && (corners & (1 << bag)); }
+    void release(int bag);              // A single-corner command takes over this corner
+    void cancel(const char* reason);
+
+    bool isActive() const { return active; }
+    bool isStaged() const { return staged; }
+    const PlanReport& getReport() const { return report; }
+    float getProgress() const { return minProgress; }   // Slowest corner, 0-1
+    static const char* outcomeName(PlanOutcome outcome);
+
+    // Learned flow coefficients (PSI/s per sqrt(PSI))
+    float getInflateK(int bag) const { return inflateK[bag]; }
+    float getDeflateK(int bag) const { return deflateK[bag]; }
+
+    // Flow-model prediction of moving the given corners from fromPsi to
+    // toPsi, each done within its deadband. rampRates caps each corner's
+    // rate (PSI/s, 0 = valve-limited), tankPerBag is the tank PSI drawn
+    // per PSI a corner gains. coordinated:
+    // inflation pauses at PLAN_STAGE_FLOOR_PSI (else at the tank lockout).
+    // fillNow: the pumps run from the start instead of from TANK_MIN_PSI.
+    MovePrediction predict(const DeadbandEstimator& deadband,
+                           const float fromPsi[NUM_BAGS], const float toPsi[NUM_BAGS], uint8_t moving,
+                           const float rampRates[NUM_BAGS], const float tankPerBag[NUM_BAGS],
+                           float tankPressure, bool pumpsAvailable, bool fillNow, bool coordinated) const;
+
+  private:
+    bool active;
+    bool staged;
+    uint8_t corners;            // Moving corners in the current plan
+    uint8_t done;               // Reached their band (latched)
+    uint8_t gates;              // Allowed to move this tick
+    uint8_t waiting;            // Holding because ahead of the slowest corner
+    float startPsi[NUM_BAGS];
+    float goalPsi[NUM_BAGS];
+    float minProgress;
+    float lastProgress;         // Stall detection
+    unsigned long lastProgressMs;
+    unsigned long stagedSinceMs;
+    PlanReport report;
+
+    // Flow learning: one segment per continuous inflate or dump
+    float inflateK[NUM_BAGS];
+    float deflateK[NUM_BAGS];
+    ValveState segState[NUM_BAGS];
+    unsigned long segStartMs[NUM_BAGS];
+    float segStartPsi[NUM_BAGS];
+    float segStartTank[NUM_BAGS];
+
+    void learn(const AirBag* bags, float tankPressure, unsigned long now);
+    float progressOf(int bag, float psi) const;
+    void step(const AirBag* bags, const DeadbandEstimator& deadband, float tankPressure,
+              unsigned long now);
+    void finish(PlanOutcome outcome, const char* reason);
+};
+
+#endif // TRANSITION_PLANNER_H
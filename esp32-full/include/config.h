@@ -89,7 +89,7 @@
 
 // Pressure smoothing (averaging)
 #define PRESSURE_SAMPLES        5      // Number of samples to average
-#define PRESSURE_SAMPLE_DELAY   2      // ms between samples
+#define BOOT_SAMPLE_DELAY_US    200    // Spacing of the samples that prime the buffers at boot
 
 // ============================================
 // TANK PRESSURE & COMPRESSOR SETTINGS
@@ -100,8 +100,28 @@
 #define TANK_MAX_PSI            150.0  // Pumps turn OFF at this
 
 // Pump operation thresholds
-#define PUMP_BOTH_ON_THRESHOLD  70.0   // Both pumps run below this PSI
-#define PUMP_ALTERNATE_ABOVE    70.0   // Single pump alternates above this PSI
+#define PUMP_BOTH_ON_THRESHOLD  70.0   // Both pumps run below this PSI (one above)
+
+// Pump scheduling (see PumpScheduler.h): a single-pump fill runs the
+// least-worn pump, a pump the thermal estimate calls hot rests, and the
+// tank is pre-filled for the air recent moves suggest is coming
+#define PUMP_START_WEAR_HOURS   0.01   // Wear of one start, in runtime hours (36 s)
+#define PUMP_HEAT_RISE_C        100.0  // Estimated rise above ambient if run continuously
+#define PUMP_HEAT_TAU_S         600.0  // Heating time constant
+#define PUMP_COOL_TAU_S         900.0  // Cooling time constant
+#define PUMP_HOT_C              70.0   // Rest a pump at this estimated rise...
+#define PUMP_RESUME_C           40.0   // ...until it has cooled to this
+#define PUMP_DUTY_WINDOW_S      600.0  // Duty cycle averaging window
+#define PUMP_FORECAST_GAIN      0.4    // Weight of the newest move in the demand forecast
+#define PUMP_FORECAST_MIN_PSI   5.0    // Moves drawing less don't count, smaller forecasts don't pre-fill
+#define PUMP_FORECAST_HALF_LIFE_S 1800.0 // The forecast fades while the car sits
+
+// Relay sequencing: two compressors starting together draw enough inrush
+// to sag the supply (and every sensor reading with it)
+#define PUMP_START_SPACING_MS   1500   // A second pump starts at least this long after the first
+#define PUMP_MIN_ON_MS          5000   // A started pump runs this long before auto mode stops it
+#define PUMP_MIN_OFF_MS         3000   // A stopped pump stays off this long before restarting
+#define INRUSH_SETTLE_MS        150    // Pressure samples are held this long after a pump starts
 
 // Tank safety with hysteresis
 #define TANK_CUTOFF_PSI         60.0   // Stop bag inflation if tank below this
@@ -121,19 +141,144 @@
 #define SOLENOID_TIMEOUT_MS     30000  // Max continuous solenoid on time (30 sec)
 #define SOLENOID_COOLDOWN_MS    5000   // Cooldown after timeout (5 sec)
 
+// Dead-man: a hardware timer closes every solenoid if no control tick
+// completes within this bound while any solenoid is open (see SolenoidGuard.h)
+#define SOLENOID_GUARD_MS       300    // Solenoids open means active rate: 30 missed ticks
+#define SOLENOID_GUARD_TIMER    0      // Hardware timer group/index used by the guard
+
 // ============================================
 // LEVEL MODE SETTINGS
 // ============================================
 
-#define LEVEL_TOLERANCE_PSI     2.0    // Acceptable difference for "level"
-#define LEVEL_ADJUST_STEP_MS    200    // Time between level adjustments
+#define LEVEL_TOLERANCE_PSI     2.0    // Acceptable difference for "level" (at the default deadband)
+#define LEVEL_ADJUST_STEP_MS    200    // Time between level checks
+#define LEVEL_SETTLE_MS         1000   // Air must have been still this long before judging level
+#define LEVEL_CORRECTION_TIMEOUT_MS 15000 // Give up on a correction that never lands
+#define LEVEL_MIN_MOVE_PSI      1.0    // Corners needing less aren't worth a valve event
+#define LEVEL_MOVE_COST_PSI     4.0    // Planner: another corner moved must save this much
+#define LEVEL_COUPLING_SIDE     -0.10  // Initial coupling (PSI per PSI): other corner, same axle
+#define LEVEL_COUPLING_AXLE     -0.10  // ...same side, other axle
+#define LEVEL_COUPLING_DIAG     0.10   // ...diagonal
+#define LEVEL_COUPLING_MAX      0.8    // Learned coupling is clamped to +/- this
+#define LEVEL_LEARN_MIN_PSI     3.0    // A single-corner step must move this much to teach coupling
+#define LEVEL_LEARN_SETTLE_MS   500    // Read the other corners this long after the step ends
+#define LEVEL_LEARN_GAIN        0.3    // Weight of the newest observation
+
+// ============================================
+// TARGET TRACKING SETTINGS
+// ============================================
+
+#define TARGET_TOLERANCE_PSI    2.0    // Hold when within this band of target
+#define TARGET_REOPEN_HYSTERESIS_PSI 0.5 // A holding bag reopens only this far outside the band
+
+// Per-corner deadband learned from sensor noise and valve response (see
+// Deadband.h); the two values above apply until a corner has been learned
+#define DEADBAND_MIN_PSI        1.0    // Band limits
+#define DEADBAND_MAX_PSI        4.0
+#define DEADBAND_REOPEN_MIN_PSI 0.5    // Reopen margin limits
+#define DEADBAND_REOPEN_MAX_PSI 3.0
+#define DEADBAND_BAND_SIGMAS    3.0    // Band covers this much reading noise
+#define DEADBAND_NOISE_SIGMAS   4.0    // Reopen margin covers this much
+#define DEADBAND_OVERSHOOT_GAIN 0.75   // Band per PSI of coasting after the valve closes
+#define DEADBAND_QUIET_MS       2000   // Every valve closed this long before sampling noise
+#define DEADBAND_MIN_SAMPLES    40     // Quiet readings before a corner's band is learned
+#define DEADBAND_NOISE_ALPHA    0.02   // Noise average weight per reading
+#define DEADBAND_RESPONSE_SETTLE_MS 500 // Read the valve response this long after closing
+#define DEADBAND_RESPONSE_ALPHA 0.3    // Response average weight per valve close
+#define DEADBAND_HYSTERESIS_PSI 0.25   // Published band changes only by this much or more
+
+// Inflate gain schedule (see FillSchedule.h): close early by the coast
+// predicted for the tank-minus-bag pressure
+#define FILL_SCHEDULE_POINTS    5      // dP points per corner (15-130 PSI)
+#define FILL_LATENCY_S          0.03   // Initial reading lag behind the bag
+#define FILL_LEAD_MAX_PSI       3.0    // Coast observations are clamped to this
+#define FILL_LEARN_MIN_MS       200    // Shorter inflates don't update the schedule
+#define FILL_COAST_SETTLE_MS    300    // Read the coast this long after the valve closes
+#define FILL_LEARN_GAIN         0.3    // Weight of the newest fill
+
+// Targets from presets, /bt and hold-button release are saved and re-applied
+// at boot, so a brownout or crank dip returns the car to its stance
+#define RESTORE_TARGETS_ON_BOOT true
+#define TARGETS_VALID_FLAG      0xEE
+#define TARGET_SAVE_DELTA_PSI   1.0    // Smaller changes don't cost a flash write
+#define TARGET_SAVE_SETTLE_MS   3000   // Written from the tick once targets and valves rest this long
+#define BOOT_BRINGUP_REST_MS    1000   // WiFi/OTA bring-up (longer than SOLENOID_GUARD_MS) waits for the restore to rest this long
+
+// ============================================
+// TRANSITION PLANNER (see TransitionPlanner.h)
+// ============================================
+
+#define PLAN_ENABLED            true   // Presets move all corners in step (false = each at its own rate)
+#define PLAN_SYNC_LEAD          0.08   // A corner this far ahead of the slowest (fraction of travel) holds
+#define PLAN_SYNC_RESUME        0.03   // ...and reopens once the slowest is within this
+#define PLAN_STAGE_FLOOR_PSI    (TANK_CUTOFF_PSI + 5.0)  // Pause inflation here, before lockout
+#define PLAN_STAGE_RESUME_PSI   TANK_RESUME_PSI          // Continue once the pumps have refilled to this
+#define PLAN_STAGE_WAIT_MS      180000 // Give up on a staged move if the tank never recovers
+#define PLAN_STALL_MS           15000  // Give up if the slowest corner makes no progress this long
+
+// Prediction model: rate (PSI/s) = k * sqrt(dP), k learned from every move
+#define PLAN_INFLATE_K          1.7    // Initial tank -> bag coefficient
+#define PLAN_DEFLATE_K          1.9    // Initial bag -> atmosphere coefficient
+#define PLAN_LEARN_MIN_MS       500    // Shorter valve openings don't update k
+#define PLAN_LEARN_MIN_PSI      3.0    // ...nor do smaller pressure changes
+#define PLAN_LEARN_GAIN         0.25   // Weight of the newest observation
+#define PLAN_TANK_VOLUME_L      18.9   // 5 gallon tank
+#define PLAN_BAG_VOLUME_L       2.6    // Bag + line at ride height, until learned (see AirBudget.h)
+#define PLAN_PUMP_PSI_PER_S     0.45   // Tank recovery per running pump
+#define PLAN_PREDICT_STEP_MS    50     // Prediction integration step
+#define PLAN_PREDICT_MAX_MS     600000 // Longest move the prediction follows
+
+// ============================================
+// AIR BUDGET (see AirBudget.h)
+// ============================================
+
+#define AIR_ATM_PSI             14.696 // Standard atmosphere (SCF reference)
+#define AIR_LITERS_PER_CUFT     28.317
+#define AIR_BAG_VOLUME_MIN_L    1.0    // Learned bag volume limits (bag + line, per PSI)
+#define AIR_BAG_VOLUME_MAX_L    12.0
+#define AIR_LEARN_MIN_PSI       5.0    // A lone pumps-off inflate must move the bag this much to teach its volume
+#define AIR_SETTLE_MS           500    // Read bag and tank this long after the inflate valve closes
+#define AIR_LEARN_GAIN          0.3    // Weight of the newest volume observation
+#define AIR_PRESTART_ENABLED    true   // Start the pumps with a move that will need them anyway...
+#define AIR_PRESTART_BELOW_PSI  TANK_MIN_PSI  // ...i.e. predicted to leave the tank below this
+#define AIR_GIVE_UP_MS          PLAN_STAGE_WAIT_MS  // A move whose corners all hold this long short of target has ended
+
+// ============================================
+// INFLATION QUEUE (see InflateQueue.h)
+// ============================================
+
+#define QUEUE_PRIORITY_FRONT    1      // Lower goes first after a lockout: rears lift the car off the stops
+#define QUEUE_PRIORITY_REAR     0
+#define QUEUE_RELEASE_FLOOR_PSI PLAN_STAGE_FLOOR_PSI  // Release corners while their draw leaves the tank above this
+#define QUEUE_BOTH_PUMPS        true   // Run both pumps while corners wait (else the normal fill cycle)
+
+// ============================================
+// STANCE RAMPS (see Trajectory.h)
+// ============================================
+
+#define RAMP_DEFAULT_PROFILE      0      // Commands that don't name one: 0=fast, 1=comfort, 2=show (opt-in)
+#define RAMP_COMFORT_RATE_PSI_S   20.0   // Comfort: setpoint slope for the longest corner
+#define RAMP_COMFORT_ACCEL_PSI_S2 40.0   // Comfort: slope change limit (eases in and out)
+#define RAMP_COMFORT_PULSE_PSI    3.0    // Comfort: pulse the solenoid this close to target
+#define RAMP_SHOW_RATE_PSI_S      5.0    // Show: slow enough to watch
+#define RAMP_SHOW_ACCEL_PSI_S2    5.0
+#define RAMP_SHOW_PULSE_PSI       3.0
+#define RAMP_FOLLOW_BAND_PSI      2.0    // Valve opens when the bag is this far behind the setpoint...
+#define RAMP_FOLLOW_LEAD_PSI      1.0    // ...and closes once it is this far ahead
+#define RAMP_PULSE_ON_MS          100    // Final-approach pulse: open...
+#define RAMP_PULSE_OFF_MS         150    // ...then closed (relay cycles, keep these coarse)
 
 // ============================================
 // TIMING CONSTANTS
 // ============================================
 
-#define PRESSURE_READ_INTERVAL  100    // Read pressure every 100ms
-#define PUMP_SWITCH_INTERVAL    30000  // Alternate pumps every 30 seconds when topping off
+// Multi-rate control: every tick samples all five sensors and runs the
+// whole pipeline, so the sensing rate follows the control rate. Any valve
+// or pump on, or any command, switches to the active rate; after
+// CONTROL_ACTIVE_HOLD_MS of everything holding it drops back to idle.
+#define CONTROL_INTERVAL_ACTIVE_MS  10     // Transients: 100 Hz sense + control
+#define CONTROL_INTERVAL_IDLE_MS    250    // Parked/holding: 4 Hz (leaks, tank, level checks)
+#define CONTROL_ACTIVE_HOLD_MS      2000   // Stay fast while a move settles
 #define SERIAL_BAUD_RATE        115200 // ESP32 typically uses higher baud
 #define WATCHDOG_TIMEOUT_S      10     // Watchdog timer in seconds
 
@@ -141,6 +286,22 @@
 #define PUMP_MAINTENANCE_HOURS  50.0   // Warn when pump exceeds this runtime
 #define PUMP_OVERDUE_HOURS      100.0  // Critical warning at this runtime
 
+// Pump health (see PumpHealth.h): fill rate per tank band, learned in
+// single-pump windows and compared against the pump when new
+#define PUMP_CURVE_BINS         5      // Tank bands...
+#define PUMP_CURVE_BIN_PSI      30.0   // ...this wide (0-150 PSI)
+#define PUMP_CURVE_SETTLE_MS    2000   // Ignore a pump's first moments after it starts
+#define PUMP_CURVE_WINDOW_MS    10000  // One rate sample per window...
+#define PUMP_CURVE_MIN_WINDOW_MS 5000  // ...shorter (interrupted) windows don't count
+#define PUMP_CURVE_BASELINE_FILLS 20   // Windows averaged into the as-new curve per band (several fills)
+#define PUMP_CURVE_GAIN         0.1    // Weight of a new window in the current curve
+#define PUMP_HISTORY_SIZE       6      // Flow records kept per pump
+#define PUMP_HISTORY_STEP_HOURS 2.5    // Pump runtime between records
+#define PUMP_FLOW_SERVICE_PCT   80     // Service when the curve is down to this % of new
+#define PUMP_FLOW_FAIL_PCT      60     // Health score 0 here
+#define PUMP_USAGE_MIN_DAYS     1.0    // Calendar span needed to turn pump hours into a date
+#define PUMP_HEALTH_VALID_FLAG  0xA5   // EEPROM flag value
+
 // ============================================
 // EEPROM CONFIGURATION
 // ============================================
@@ -175,6 +336,22 @@
 // Each sensor: 12 bytes (offset + gain + refResistor)
 // Total: 105 + 60 = 165 bytes (within 512 EEPROM)
 
+// Reset history EEPROM (1 flag + 4 boot count + 1 head + 8 records x 8 bytes = 70 bytes)
+#define EEPROM_ADDR_DIAG_FLAG        168 // Valid flag (1 byte, 0xDD)
+#define EEPROM_ADDR_DIAG_BOOTS       169 // Boot count (uint32_t, 4 bytes)
+#define EEPROM_ADDR_DIAG_HEAD        173 // Next history slot (1 byte)
+#define EEPROM_ADDR_DIAG_HISTORY     174 // ResetRecord ring (ends at 238)
+
+// Last commanded bag targets (1 flag + 4 floats = 17 bytes)
+#define EEPROM_ADDR_TARGETS_FLAG     240 // Valid flag (1 byte, 0xEE)
+#define EEPROM_ADDR_TARGETS          241 // FL,FR,RL,RR (4 floats, ends at 257)
+
+// Pump runtime, starts and health (1 flag + 8 + 8 + 2 x 96 bytes = 209 bytes)
+#define EEPROM_ADDR_PUMP_FLAG        258 // Valid flag (1 byte, 0xA5)
+#define EEPROM_ADDR_PUMP_RUNTIME     259 // P1,P2 runtime hours (2 floats)
+#define EEPROM_ADDR_PUMP_STARTS      267 // P1,P2 relay starts (2 x uint32_t)
+#define EEPROM_ADDR_PUMP_CURVES      275 // P1,P2 PumpCurve (ends at 467)
+
 // ============================================
 // SENSOR CALIBRATION SETTINGS
 // ============================================
@@ -212,6 +389,25 @@ struct SensorCalibration {
 #define LEAK_ALERT_DROP_PSI     5.0         // Red: total PSI drop
 #define LEAK_ALERT_RATE_PSI_HR  0.25        // Red: AND rate exceeds (PSI/hr)
 
+// ============================================
+// PARKED LOW-POWER MODE
+// ============================================
+// After PARK_IDLE_MS with no air moving, no command and no phone on the
+// AP (or on the Z command / GET /park) the AP goes off, the pumps are
+// held off and the ESP32 light-sleeps, waking every PARK_WAKE_INTERVAL_S
+// to sample the sensors against the leak snapshot (see PowerManager.h).
+// WAKE_BUTTON_PIN pulled low ends the park.
+
+#define PARK_ENABLED            true
+#define PARK_IDLE_MS            1800000UL   // Auto-park after 30 min idle (0 = command only)
+#define PARK_WAKE_INTERVAL_S    300         // Leak check every 5 min while parked
+#define WAKE_BUTTON_PIN         0           // BOOT button (active low)
+
+// Current estimates for the power report (not measured)
+#define POWER_AWAKE_MA          110.0       // 240 MHz CPU + soft-AP beaconing
+#define POWER_PARKED_WAKE_MA    40.0        // Wake sampling, radio off
+#define POWER_SLEEP_MA          1.5         // Light sleep + sensor dividers + regulator quiescent
+
 // ============================================
 // TANK MAINTENANCE TIMER SETTINGS
 // ============================================
@@ -246,34 +442,104 @@ struct SensorCalibration {
 #define REAR_RIGHT  3
 #define NUM_BAGS    4
 
+// ============================================
+// SERIAL CONSOLE
+// ============================================
+// Line-oriented: a line runs when Enter is pressed; ';' or spaces
+// separate batched commands (e.g. "R1;L3"). Never waits inside loop().
+#define SERIAL_LINE_SIZE        64     // Longest accepted line (longer lines are discarded)
+#define SERIAL_POLL_MAX_BYTES   80     // Bytes consumed per loop() (one full binary frame)
+
+// Binary link (LinkProtocol.h) shares the port: frames sit between 0x00 bytes
+#define LINK_STREAM_MIN_MS      5      // Fastest state stream the host may request
+#define LINK_FRAME_GAP_MS       50     // An open frame this long without a byte was cut off
+
+// ============================================
+// SESSION TRACE
+// ============================================
+// RAM trace of ADC samples, outputs and commands since boot or the last
+// restart (GET /trace; /trace?start=1 starts over)
+// 4 bytes per record, ~6 records per control tick: ~600/s at the active
+// rate, ~24/s idle. 40960 records (160 KB) = ~68 s of moving air or ~28
+// minutes holding - room for the longest preset move in sim (a staged
+// Lay to Max lift on a low tank, ~38000 records with its lead-in)
+// Build with -DAIRRIDE_NO_TRACE to compile the recording hooks out
+#define TRACE_BUFFER_RECORDS    40960
+#define TRACE_SEND_CHUNK        1024   // Bytes written per loop() pass when downloading (valves closed)
+
+// ============================================
+// STALL DIAGNOSTICS
+// ============================================
+// Reset reason + boot history in EEPROM, per-stage loop budgets and the
+// core dump partition, downloadable via GET /diag and GET /coredump
+// (symbolize with coredump.sh). A stage that overruns its budget is
+// logged; the stage running at a watchdog reset or panic is recorded.
+#define DIAG_VALID_FLAG         0xDD
+#define DIAG_HISTORY_SIZE       8      // Resets remembered
+#define DIAG_BUDGET_OTA_MS      50     // ArduinoOTA.handle() (uploads run far longer; pumps/valves are stopped first)
+#define DIAG_BUDGET_WEB_MS      100    // One HTTP request
+#define DIAG_BUDGET_CONTROL_MS  20     // Control tick incl. telemetry print
+#define DIAG_BUDGET_CONSOLE_MS  10     // Serial command parsing and replies
+#define DIAG_BUDGET_LINK_MS     10     // Binary link streaming
+#define DIAG_BUDGET_BOOT_MS     250    // One deferred boot step (softAP bring-up, OTA/mDNS)
+#if DIAG_BUDGET_BOOT_MS >= SOLENOID_GUARD_MS
+  #error "DIAG_BUDGET_BOOT_MS must stay under SOLENOID_GUARD_MS"
+#endif
+#define DIAG_COREDUMP_CHUNK     1024   // Bytes written per loop() pass when downloading the dump (valves closed)
+
 // ============================================
 // DEMO / BENCH TEST MODE
 // ============================================
-// Runtime-toggled via /demo endpoint (no recompile needed)
+// Sensor backend is chosen at compile time (see Hal.h):
+//   default             - real ADC only, no simulation code in the image
+//   -DAIRRIDE_HAL_SIM   - sensors always answered by the simulated plant
+//   -DAIRRIDE_HAL_BENCH - runtime-toggled via /demo endpoint
+#if defined(AIRRIDE_HAL_SIM) || defined(AIRRIDE_HAL_BENCH) || defined(AIRRIDE_NATIVE)
+  #define AIRRIDE_HAS_SIM_PLANT 1
+#else
+  #define AIRRIDE_HAS_SIM_PLANT 0
+#endif
+
 // Default initial values when simulation is active
 #define DEMO_BAG_PSI            66.0   // Default bag pressure in demo mode
 #define DEMO_TANK_PSI           150.0  // Default tank pressure in demo mode
 
-// Simulation physics rates (tuned for PRESSURE_READ_INTERVAL = 100ms)
-#define SIM_TANK_DECAY_RATE     0.06   // PSI lost per tick from natural leakage
-#define SIM_PUMP_FILL_RATE      0.38   // Base pump fill rate per tick
-#define SIM_BAG_INFLATE_RATE    0.30   // Bag fill rate multiplier * sqrt(deltaP)
-#define SIM_BAG_DEFLATE_RATE    0.25   // Bag dump rate multiplier * sqrt(pressure)
-#define SIM_BAG_TANK_DRAIN      0.12   // Tank drain per inflating bag * sqrt(deltaP)
-#define SIM_JITTER_RANGE        50     // Random jitter ±0.005 PSI (value/10000)
+// Simulated plant (PneumaticPlant) - default parameters
+// Fit to a real car with the native fit_plant tool from recorded telemetry
+#define PLANT_TANK_VOLUME_L         18.9   // 5 gallon tank
+#define PLANT_AMBIENT_C             20.0   // Ambient / bag air temperature
+#define PLANT_FRONT_LOAD_LBF        1200.0 // Load on each front bag (incl. lever ratio)
+#define PLANT_REAR_LOAD_LBF         800.0  // Load on each rear bag
+#define PLANT_FRONT_AREA_IN2        30.0   // Bag effective area at bump stop
+#define PLANT_REAR_AREA_IN2         32.0
+#define PLANT_BAG_AREA_LOSS         0.65   // Fraction of effective area lost over full stroke
+#define PLANT_BAG_MIN_VOLUME_IN3    40.0   // Bag + line volume at bump stop
+#define PLANT_BAG_STROKE_IN         6.0    // Bump stop to full extension
+#define PLANT_WARP_LBF_PER_IN       1000.0 // Body twist stiffness (load moved onto a diagonal per inch)
+#define PLANT_INFLATE_CDA_MM2       1.6    // Effective orifice tank -> bag (Cd * A)
+#define PLANT_DEFLATE_CDA_MM2       2.2    // Effective orifice bag -> atmosphere
+#define PLANT_PUMP_FREE_CFM         1.8    // Per pump, free air at 0 PSI
+#define PLANT_PUMP_MAX_PSI          250.0  // Pump flow falls to zero at this back-pressure
+#define PLANT_PUMP_DISCHARGE_C      90.0   // Air temperature entering the tank
+#define PLANT_TANK_COOLING_S        300.0  // Tank air cooling time constant
+#define PLANT_TANK_LEAK_CDA_MM2     0.0005 // Fittings/drain valve leak to atmosphere
+#define PLANT_SENSOR_NOISE_PSI      0.1    // Gaussian sensor noise (1 sigma)
+#define PLANT_INRUSH_SAG_PSI        2.0    // Sensors read low by this per pump starting...
+#define PLANT_INRUSH_MS             100    // ...for this long after its relay closes
+#define PLANT_STEP_MS               5      // Integration step, independent of control tick
+#define TELEMETRY_ROW_SIZE          64     // Serial 'G' telemetry CSV row buffer
 
 // Simulated leak for testing leak detection (toggled via /simleak endpoint)
 // simLeakTarget: -1=none, 0=FL, 1=FR, 2=RL, 3=RR, 4=tank, 5=random
-#define SIM_LEAK_RATE_PSI_TICK  0.15   // Aggressive: ~1.5 PSI/sec (at 100ms ticks)
+#define SIM_LEAK_RATE_PSI_TICK  0.15   // Aggressive: ~1.5 PSI/sec (per SIM_LEAK_TICK_MS)
+#define SIM_LEAK_TICK_MS        100    // Leak rates are per this interval, whatever the control rate
 
-// Runtime demo mode globals (defined in main.ino)
-extern bool demoMode;
-extern float simTankPressure;
+// Runtime demo mode globals (defined in RideController.cpp)
+extern bool demoMode;               // Always false in production builds
 extern int simLeakTarget;           // Which sensor is leaking (-1=none)
-extern float simLeakRate;           // PSI per tick to subtract
-void setDemoMode(bool enabled);
+extern float simLeakRate;           // PSI per SIM_LEAK_TICK_MS to subtract
 
-// Tank sensor calibration (defined in main.ino)
+// Tank sensor calibration (defined in RideController.cpp)
 extern SensorCalibration tankCalibration;
 extern bool tankCalibrated;
 
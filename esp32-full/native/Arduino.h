@@ -0,0 +1,104 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// ============================================
+// HOST ARDUINO SHIM
+// ============================================
+// Minimal stand-in for the Arduino core so the control core
+// (AirBag, Compressor, RideController) compiles on Linux.
+// Pin I/O is routed to the attached PlantModel, time comes
+// from a virtual clock advanced by HostBoard (see HostBoard.h).
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <cmath>
+#include <algorithm>
+#include "WString.h"
+#include "IPAddress.h"
+
+using std::abs;
+using std::isnan;
+using std::isinf;
+using std::min;
+using std::max;
+
+typedef uint8_t byte;
+
+#define HIGH    0x1
+#define LOW     0x0
+#define INPUT   0x01
+#define OUTPUT  0x03
+
+#define PROGMEM
+#define PGM_P const char*
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// Time (virtual clock)
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+// Pin I/O (routed to the attached PlantModel)
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+
+// Deterministic PRNG (seeded per run)
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+// Serial console: output optionally echoed to stdout, input injected by tools
+class HostSerial {
+  public:
+    HostSerial();
+
+    void begin(unsigned long baud) { (void)baud; }
+    void setEcho(bool enabled) { echo = enabled; }
+    void inject(const char* text);
+    void inject(const uint8_t* data, size_t length);
+    void setOutput(FILE* out) { output = out; }     // Overrides echo (e.g. a pty for host tools)
+
+    int available();
+    int read();
+    int peek();
+
+    size_t write(uint8_t c);
+    size_t write(const uint8_t* data, size_t length);
+    size_t print(const char* s);
+    size_t print(char c);
+    size_t print(int n, int base = 10);
+    size_t print(unsigned int n, int base = 10);
+    size_t print(long n, int base = 10);
+    size_t print(unsigned long n, int base = 10);
+    size_t print(double n, int digits = 2);
+    size_t print(const String& s) { return print(s.c_str()); }
+    size_t print(const IPAddress& ip) { return print(ip.toString()); }
+    size_t println();
+    size_t println(const char* s);
+    size_t println(char c);
+    size_t println(int n, int base = 10);
+    size_t println(unsigned int n, int base = 10);
+    size_t println(long n, int base = 10);
+    size_t println(unsigned long n, int base = 10);
+    size_t println(double n, int digits = 2);
+    size_t println(const String& s) { return println(s.c_str()); }
+    size_t println(const IPAddress& ip) { return println(ip.toString()); }
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+  private:
+    bool echo;
+    FILE* output;
+    char input[256];
+    int inputHead;
+    int inputTail;
+};
+
+extern HostSerial Serial;
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,49 @@
+#ifndef HOST_EEPROM_H
+#define HOST_EEPROM_H
+
+// ============================================
+// HOST EEPROM SHIM
+// ============================================
+// RAM-backed stand-in for the ESP32 EEPROM emulation.
+// Starts erased (0xFF) like a fresh flash page.
+
+#include <Arduino.h>
+
+class EEPROMClass {
+  public:
+    EEPROMClass();
+
+    bool begin(size_t size);
+    uint8_t read(int address) const;
+    void write(int address, uint8_t value);
+    bool commit() { commits++; return true; }
+    size_t length() const { return size; }
+
+    // Erase all contents (fresh device)
+    void clear();
+    unsigned long getCommitCount() const { return commits; }
+
+    template <typename T> T& get(int address, T& t) const {
+        if (address >= 0 && address + sizeof(T) <= size) {
+            memcpy(&t, data + address, sizeof(T));
+        }
+        return t;
+    }
+
+    template <typename T> const T& put(int address, const T& t) {
+        if (address >= 0 && address + sizeof(T) <= size) {
+            memcpy(data + address, &t, sizeof(T));
+        }
+        return t;
+    }
+
+  private:
+    static const size_t MAX_SIZE = 4096;
+    uint8_t data[MAX_SIZE];
+    size_t size;
+    unsigned long commits;
+};
+
+extern EEPROMClass EEPROM;
+
+#endif // HOST_EEPROM_H
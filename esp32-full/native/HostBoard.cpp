@@ -0,0 +1,279 @@
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <stdarg.h>
+#include <sys/time.h>
+#include "HostBoard.h"
+
+HostSerial Serial;
+EEPROMClass EEPROM;
+
+static uint64_t clockUs = 0;
+static PlantModel* attachedPlant = NULL;
+static uint8_t pinLevels[256];
+static uint32_t prngState = 1;
+static time_t epochAtZero = 0;     // Wall clock at virtual time 0 (unset, like a fresh ESP32)
+
+// ============================================
+// HOST BOARD
+// ============================================
+
+void HostBoard::attachPlant(PlantModel* plant) {
+    attachedPlant = plant;
+}
+
+PlantModel* HostBoard::getPlant() {
+    return attachedPlant;
+}
+
+void HostBoard::advanceMicros(unsigned long us) {
+    clockUs += us;
+    if (attachedPlant) {
+        attachedPlant->advance(us / 1000000.0f);
+    }
+}
+
+void HostBoard::advance(unsigned long ms) {
+    advanceMicros(ms * 1000UL);
+}
+
+void HostBoard::reset() {
+    clockUs = 0;
+    prngState = 1;
+    epochAtZero = 0;
+    memset(pinLevels, 0, sizeof(pinLevels));
+}
+
+void HostBoard::setMillis(unsigned long ms) {
+    clockUs = (uint64_t)ms * 1000;
+}
+
+uint8_t HostBoard::getPinLevel(uint8_t pin) {
+    return pinLevels[pin];
+}
+
+// ============================================
+// ARDUINO CORE
+// ============================================
+
+// Truncated to 32 bits so rollover behaves like the ESP32
+unsigned long millis() {
+    return (uint32_t)(clockUs / 1000);
+}
+
+unsigned long micros() {
+    return (uint32_t)clockUs;
+}
+
+void delay(unsigned long ms) {
+    HostBoard::advance(ms);
+}
+
+void delayMicroseconds(unsigned int us) {
+    HostBoard::advanceMicros(us);
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    (void)pin;
+    (void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+    pinLevels[pin] = val;
+    if (attachedPlant) {
+        attachedPlant->writePin(pin, val);
+    }
+}
+
+int digitalRead(uint8_t pin) {
+    return pinLevels[pin];
+}
+
+int analogRead(uint8_t pin) {
+    return attachedPlant ? attachedPlant->readAdc(pin) : 0;
+}
+
+long random(long howbig) {
+    if (howbig <= 0) return 0;
+    // xorshift32 - deterministic across hosts
+    prngState ^= prngState << 13;
+    prngState ^= prngState >> 17;
+    prngState ^= prngState << 5;
+    return prngState % howbig;
+}
+
+long random(long howsmall, long howbig) {
+    if (howsmall >= howbig) return howsmall;
+    return random(howbig - howsmall) + howsmall;
+}
+
+void randomSeed(unsigned long seed) {
+    if (seed != 0) prngState = (uint32_t)seed;
+}
+
+// ============================================
+// WALL CLOCK
+// ============================================
+// The web server's /time sync calls settimeofday(); on the host that must
+// set a virtual epoch on the board clock, never the machine's clock.
+
+extern "C" int settimeofday(const struct timeval* tv, const struct timezone* tz) noexcept {
+    (void)tz;
+    if (tv) epochAtZero = tv->tv_sec - (time_t)(clockUs / 1000000);
+    return 0;
+}
+
+extern "C" time_t time(time_t* t) noexcept {
+    time_t now = epochAtZero + (time_t)(clockUs / 1000000);
+    if (t) *t = now;
+    return now;
+}
+
+// ============================================
+// SERIAL
+// ============================================
+
+HostSerial::HostSerial() : echo(false), output(NULL), inputHead(0), inputTail(0) {
+}
+
+void HostSerial::inject(const char* text) {
+    inject((const uint8_t*)text, strlen(text));
+}
+
+void HostSerial::inject(const uint8_t* data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        int next = (inputHead + 1) % (int)sizeof(input);
+        if (next == inputTail) break; // Full - drop like a real UART FIFO
+        input[inputHead] = data[i];
+        inputHead = next;
+    }
+}
+
+int HostSerial::available() {
+    return (inputHead - inputTail + (int)sizeof(input)) % (int)sizeof(input);
+}
+
+int HostSerial::read() {
+    if (inputHead == inputTail) return -1;
+    int c = (uint8_t)input[inputTail];
+    inputTail = (inputTail + 1) % (int)sizeof(input);
+    return c;
+}
+
+int HostSerial::peek() {
+    if (inputHead == inputTail) return -1;
+    return (uint8_t)input[inputTail];
+}
+
+size_t HostSerial::write(uint8_t c) {
+    if (output) fputc(c, output);
+    else if (echo) fputc(c, stdout);
+    return 1;
+}
+
+size_t HostSerial::write(const uint8_t* data, size_t length) {
+    if (output) fwrite(data, 1, length, output);
+    else if (echo) fwrite(data, 1, length, stdout);
+    return length;
+}
+
+size_t HostSerial::print(const char* s) {
+    if (output) fputs(s, output);
+    else if (echo) fputs(s, stdout);
+    return strlen(s);
+}
+
+size_t HostSerial::print(char c) {
+    return write((uint8_t)c);
+}
+
+size_t HostSerial::print(int n, int base) {
+    return print((long)n, base);
+}
+
+size_t HostSerial::print(unsigned int n, int base) {
+    return print((unsigned long)n, base);
+}
+
+size_t HostSerial::print(long n, int base) {
+    if (base == 16) return printf("%lX", n);
+    return printf("%ld", n);
+}
+
+size_t HostSerial::print(unsigned long n, int base) {
+    if (base == 16) return printf("%lX", n);
+    return printf("%lu", n);
+}
+
+size_t HostSerial::print(double n, int digits) {
+    return printf("%.*f", digits, n);
+}
+
+size_t HostSerial::println() {
+    return print("\r\n");
+}
+
+size_t HostSerial::println(const char* s) {
+    return print(s) + println();
+}
+
+size_t HostSerial::println(char c) {
+    return print(c) + println();
+}
+
+size_t HostSerial::println(int n, int base) {
+    return print(n, base) + println();
+}
+
+size_t HostSerial::println(unsigned int n, int base) {
+    return print(n, base) + println();
+}
+
+size_t HostSerial::println(long n, int base) {
+    return print(n, base) + println();
+}
+
+size_t HostSerial::println(unsigned long n, int base) {
+    return print(n, base) + println();
+}
+
+size_t HostSerial::println(double n, int digits) {
+    return print(n, digits) + println();
+}
+
+size_t HostSerial::printf(const char* format, ...) {
+    char buf[256];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    print(buf);
+    return len > 0 ? (size_t)len : 0;
+}
+
+// ============================================
+// EEPROM
+// ============================================
+
+EEPROMClass::EEPROMClass() : size(0), commits(0) {
+    clear();
+}
+
+bool EEPROMClass::begin(size_t requested) {
+    size = requested <= MAX_SIZE ? requested : MAX_SIZE;
+    return requested <= MAX_SIZE;
+}
+
+uint8_t EEPROMClass::read(int address) const {
+    if (address < 0 || (size_t)address >= size) return 0xFF;
+    return data[address];
+}
+
+void EEPROMClass::write(int address, uint8_t value) {
+    if (address < 0 || (size_t)address >= size) return;
+    data[address] = value;
+}
+
+void EEPROMClass::clear() {
+    memset(data, 0xFF, sizeof(data));
+    commits = 0;
+}
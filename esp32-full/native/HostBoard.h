@@ -0,0 +1,30 @@
+#ifndef HOST_BOARD_H
+#define HOST_BOARD_H
+
+#include <Arduino.h>
+#include "PlantModel.h"
+
+// ============================================
+// HOST BOARD
+// ============================================
+// Owns the virtual clock and the attached plant for native builds.
+// Time only moves when a tool calls advance() (or firmware calls
+// delay()), so simulations run as fast as the host CPU allows.
+
+namespace HostBoard {
+    void attachPlant(PlantModel* plant);
+    PlantModel* getPlant();
+
+    // Advance virtual time and integrate the plant over the interval
+    void advance(unsigned long ms);
+    void advanceMicros(unsigned long us);
+    void reset();
+
+    // Jump the clock without integrating the plant (trace replay)
+    void setMillis(unsigned long ms);
+
+    // Last level written to each output pin (for tools that inspect actuators)
+    uint8_t getPinLevel(uint8_t pin);
+}
+
+#endif // HOST_BOARD_H
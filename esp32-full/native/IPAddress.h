@@ -0,0 +1,24 @@
+#ifndef HOST_IPADDRESS_H
+#define HOST_IPADDRESS_H
+
+#include <stdint.h>
+#include "WString.h"
+
+class IPAddress {
+  public:
+    IPAddress() : IPAddress(0, 0, 0, 0) {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+        octets[0] = a;
+        octets[1] = b;
+        octets[2] = c;
+        octets[3] = d;
+    }
+
+    uint8_t operator[](int index) const { return octets[index]; }
+    String toString() const;
+
+  private:
+    uint8_t octets[4];
+};
+
+#endif // HOST_IPADDRESS_H
@@ -0,0 +1,63 @@
+#include <Arduino.h>
+#include "TraceFile.h"
+
+static const char* COMMAND_NAMES[] = {
+    "?", "SET_TARGET", "APPLY_TARGETS", "INFLATE", "DEFLATE", "HOLD", "STOP_ALL",
+    "LEVEL_MODE", "PUMP_ENABLED", "PUMP_MODE", "TANK_TARGET", "CALIBRATION",
+    "PARKED", "LEVEL_PITCH", "TARGETS", "PUMP_RUNTIME"
+};
+static const int NUM_COMMAND_NAMES = sizeof(COMMAND_NAMES) / sizeof(COMMAND_NAMES[0]);
+
+bool TraceFile::save(const char* path, const TraceRecorder& recorder) {
+    FILE* f = fopen(path, "wb");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    TraceHeader header = recorder.getHeader();
+    fwrite(&header, sizeof(header), 1, f);
+    fwrite(recorder.getRecords(), sizeof(TraceRecord), header.count, f);
+    fclose(f);
+    return true;
+}
+
+bool TraceFile::load(const char* path, TraceHeader& header, std::vector<TraceRecord>& records) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    bool ok = fread(&header, sizeof(header), 1, f) == 1 &&
+              memcmp(header.magic, TRACE_MAGIC, 4) == 0 &&
+              header.version == TRACE_VERSION &&
+              header.recordSize == sizeof(TraceRecord);
+    if (!ok) {
+        fprintf(stderr, "%s: not a version %d trace\n", path, TRACE_VERSION);
+        fclose(f);
+        return false;
+    }
+    records.resize(header.count);
+    size_t got = header.count ? fread(&records[0], sizeof(TraceRecord), header.count, f) : 0;
+    fclose(f);
+    if (got != header.count) {
+        fprintf(stderr, "%s: truncated (%u of %u records)\n", path, (unsigned)got, (unsigned)header.count);
+        records.resize(got);
+    }
+    return true;
+}
+
+void TraceFile::describe(const TraceRecord& r, char* buf, size_t size) {
+    switch (r.type) {
+        case TRACE_BOOT:   snprintf(buf, size, "BOOT"); break;
+        case TRACE_SNAPSHOT: snprintf(buf, size, "SNAPSHOT"); break;
+        case TRACE_TICK:   snprintf(buf, size, "TICK"); break;
+        case TRACE_TIME:   snprintf(buf, size, "TIME"); break;
+        case TRACE_ADC:    snprintf(buf, size, "ADC pin %u = %u", r.arg, r.value); break;
+        case TRACE_OUTPUT: snprintf(buf, size, "OUT pin %u = %u", r.arg, r.value); break;
+        case TRACE_COMMAND:
+            snprintf(buf, size, "CMD %s %u", r.arg < NUM_COMMAND_NAMES ? COMMAND_NAMES[r.arg] : "?", r.value);
+            break;
+        case TRACE_ARG:    snprintf(buf, size, "ARG %u 0x%04x", r.arg, r.value); break;
+        default:           snprintf(buf, size, "UNKNOWN %u", r.type); break;
+    }
+}
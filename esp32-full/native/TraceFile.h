@@ -0,0 +1,33 @@
+#ifndef TRACE_FILE_H
+#define TRACE_FILE_H
+
+#include <vector>
+#include "TraceRecorder.h"
+
+// ============================================
+// TRACE FILES
+// ============================================
+// Same layout as the /trace download: TraceHeader then raw records.
+
+namespace TraceFile {
+    bool save(const char* path, const TraceRecorder& recorder);
+    bool load(const char* path, TraceHeader& header, std::vector<TraceRecord>& records);
+
+    // Human-readable record, e.g. "OUT pin 6 = 0", "CMD SET_TARGET 2"
+    void describe(const TraceRecord& r, char* buf, size_t size);
+
+    // Expand 16-bit millis() stamps to a running 32-bit time
+    class Clock {
+      public:
+        Clock() : now(0) {}
+        unsigned long unwrap(uint16_t low) {
+            now += (uint16_t)(low - (uint16_t)now);
+            return now;
+        }
+        unsigned long get() const { return now; }
+      private:
+        unsigned long now;
+    };
+}
+
+#endif // TRACE_FILE_H
@@ -0,0 +1,227 @@
+#include <Arduino.h>
+#include <ctype.h>
+#include "WString.h"
+
+unsigned long HostHeap::allocations = 0;
+
+void String::init() {
+    sso[0] = 0;
+    heap = NULL;
+    capacity = SSO_CAPACITY;
+    len = 0;
+}
+
+String::String(const char* cstr) {
+    init();
+    if (cstr) copy(cstr, strlen(cstr));
+}
+
+String::String(const String& str) {
+    init();
+    copy(str.buffer(), str.len);
+}
+
+String::String(String&& rval) {
+    init();
+    move(rval);
+}
+
+String::String(char c) {
+    init();
+    copy(&c, 1);
+}
+
+String::String(unsigned char value, unsigned char base) : String((unsigned long)value, base) {}
+String::String(int value, unsigned char base) : String((long)value, base) {}
+String::String(unsigned int value, unsigned char base) : String((unsigned long)value, base) {}
+
+String::String(long value, unsigned char base) {
+    init();
+    char buf[2 + 8 * sizeof(long)];
+    if (base == 10) {
+        snprintf(buf, sizeof(buf), "%ld", value);
+    } else if (base == 16) {
+        snprintf(buf, sizeof(buf), "%lx", (unsigned long)value);
+    } else {
+        snprintf(buf, sizeof(buf), "%ld", value);
+    }
+    copy(buf, strlen(buf));
+}
+
+String::String(unsigned long value, unsigned char base) {
+    init();
+    char buf[1 + 8 * sizeof(unsigned long)];
+    snprintf(buf, sizeof(buf), base == 16 ? "%lx" : "%lu", value);
+    copy(buf, strlen(buf));
+}
+
+String::String(float value, unsigned int decimalPlaces) : String((double)value, decimalPlaces) {}
+
+String::String(double value, unsigned int decimalPlaces) {
+    init();
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.*f", (int)decimalPlaces, value);
+    copy(buf, strlen(buf));
+}
+
+String::~String() {
+    free(heap);
+}
+
+String& String::operator=(const String& rhs) {
+    if (this != &rhs) copy(rhs.buffer(), rhs.len);
+    return *this;
+}
+
+String& String::operator=(String&& rval) {
+    if (this != &rval) move(rval);
+    return *this;
+}
+
+String& String::operator=(const char* cstr) {
+    if (cstr) copy(cstr, strlen(cstr)); else copy("", 0);
+    return *this;
+}
+
+// Grow to exactly `size` characters, like the ESP32 core's changeBuffer()
+bool String::reserve(unsigned int size) {
+    if (size <= capacity) return true;
+    char* grown = (char*)realloc(heap, size + 1);
+    if (!grown) return false;
+    HostHeap::allocations++;
+    if (!heap) memcpy(grown, sso, len + 1);
+    heap = grown;
+    capacity = size;
+    return true;
+}
+
+void String::copy(const char* cstr, unsigned int length) {
+    if (!reserve(length)) return;
+    memmove(buffer(), cstr, length);
+    len = length;
+    buffer()[len] = 0;
+}
+
+void String::move(String& rhs) {
+    free(heap);
+    if (rhs.heap) {
+        heap = rhs.heap;
+        capacity = rhs.capacity;
+    } else {
+        heap = NULL;
+        capacity = SSO_CAPACITY;
+        memcpy(sso, rhs.sso, rhs.len + 1);
+    }
+    len = rhs.len;
+    rhs.init();
+}
+
+bool String::concat(const char* cstr) {
+    return cstr ? concat(cstr, strlen(cstr)) : false;
+}
+
+bool String::concat(const char* cstr, unsigned int length) {
+    if (!cstr) return false;
+    if (length == 0) return true;
+    if (!reserve(len + length)) return false;
+    memmove(buffer() + len, cstr, length);
+    len += length;
+    buffer()[len] = 0;
+    return true;
+}
+
+bool String::equals(const String& s) const {
+    return len == s.len && memcmp(buffer(), s.buffer(), len) == 0;
+}
+
+bool String::equals(const char* cstr) const {
+    return strcmp(buffer(), cstr ? cstr : "") == 0;
+}
+
+bool String::startsWith(const String& prefix) const {
+    return prefix.len <= len && memcmp(buffer(), prefix.buffer(), prefix.len) == 0;
+}
+
+bool String::endsWith(const String& suffix) const {
+    return suffix.len <= len && memcmp(buffer() + len - suffix.len, suffix.buffer(), suffix.len) == 0;
+}
+
+int String::indexOf(char ch, unsigned int fromIndex) const {
+    if (fromIndex >= len) return -1;
+    const char* p = strchr(buffer() + fromIndex, ch);
+    return p ? (int)(p - buffer()) : -1;
+}
+
+int String::indexOf(const char* str, unsigned int fromIndex) const {
+    if (fromIndex >= len) return -1;
+    const char* p = strstr(buffer() + fromIndex, str);
+    return p ? (int)(p - buffer()) : -1;
+}
+
+String String::substring(unsigned int beginIndex, unsigned int endIndex) const {
+    if (beginIndex > endIndex) {
+        unsigned int t = beginIndex;
+        beginIndex = endIndex;
+        endIndex = t;
+    }
+    String out;
+    if (beginIndex >= len) return out;
+    if (endIndex > len) endIndex = len;
+    out.copy(buffer() + beginIndex, endIndex - beginIndex);
+    return out;
+}
+
+void String::toLowerCase() {
+    for (char* p = buffer(); *p; p++) *p = tolower((unsigned char)*p);
+}
+
+void String::toUpperCase() {
+    for (char* p = buffer(); *p; p++) *p = toupper((unsigned char)*p);
+}
+
+void String::trim() {
+    char* buf = buffer();
+    unsigned int begin = 0;
+    while (begin < len && isspace((unsigned char)buf[begin])) begin++;
+    unsigned int end = len;
+    while (end > begin && isspace((unsigned char)buf[end - 1])) end--;
+    len = end - begin;
+    memmove(buf, buf + begin, len);
+    buf[len] = 0;
+}
+
+long String::toInt() const {
+    return atol(buffer());
+}
+
+float String::toFloat() const {
+    return (float)atof(buffer());
+}
+
+double String::toDouble() const {
+    return atof(buffer());
+}
+
+String operator+(const String& lhs, const String& rhs) {
+    String out(lhs);
+    out.concat(rhs);
+    return out;
+}
+
+String operator+(const String& lhs, const char* rhs) {
+    String out(lhs);
+    out.concat(rhs);
+    return out;
+}
+
+String operator+(const char* lhs, const String& rhs) {
+    String out(lhs);
+    out.concat(rhs);
+    return out;
+}
+
+String operator+(const String& lhs, char rhs) {
+    String out(lhs);
+    out.concat(rhs);
+    return out;
+}
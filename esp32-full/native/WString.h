@@ -0,0 +1,101 @@
+#ifndef HOST_WSTRING_H
+#define HOST_WSTRING_H
+
+// ============================================
+// HOST STRING
+// ============================================
+// Arduino String for the native build, with the ESP32 core's memory
+// behaviour: up to 11 characters inline (no heap), otherwise a heap
+// buffer grown to exactly the length needed on each append. Every heap
+// (re)allocation is counted in HostHeap so tools can report allocs/op.
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace HostHeap {
+    extern unsigned long allocations;   // malloc/realloc calls by String (and tools' operator new)
+}
+
+class String {
+  public:
+    String(const char* cstr = "");
+    String(const String& str);
+    String(String&& rval);
+    explicit String(char c);
+    explicit String(unsigned char value, unsigned char base = 10);
+    explicit String(int value, unsigned char base = 10);
+    explicit String(unsigned int value, unsigned char base = 10);
+    explicit String(long value, unsigned char base = 10);
+    explicit String(unsigned long value, unsigned char base = 10);
+    explicit String(float value, unsigned int decimalPlaces = 2);
+    explicit String(double value, unsigned int decimalPlaces = 2);
+    ~String();
+
+    String& operator=(const String& rhs);
+    String& operator=(String&& rval);
+    String& operator=(const char* cstr);
+
+    bool reserve(unsigned int size);
+    unsigned int length() const { return len; }
+    const char* c_str() const { return buffer(); }
+
+    bool concat(const String& str) { return concat(str.buffer(), str.len); }
+    bool concat(const char* cstr);
+    bool concat(const char* cstr, unsigned int length);
+    bool concat(char c) { return concat(&c, 1); }
+
+    String& operator+=(const String& rhs) { concat(rhs); return *this; }
+    String& operator+=(const char* cstr) { concat(cstr); return *this; }
+    String& operator+=(char c) { concat(c); return *this; }
+    String& operator+=(int num) { concat(String(num)); return *this; }
+    String& operator+=(unsigned int num) { concat(String(num)); return *this; }
+    String& operator+=(long num) { concat(String(num)); return *this; }
+    String& operator+=(unsigned long num) { concat(String(num)); return *this; }
+    String& operator+=(float num) { concat(String(num)); return *this; }
+    String& operator+=(double num) { concat(String(num)); return *this; }
+
+    bool equals(const String& s) const;
+    bool equals(const char* cstr) const;
+    bool operator==(const String& rhs) const { return equals(rhs); }
+    bool operator==(const char* cstr) const { return equals(cstr); }
+    bool operator!=(const String& rhs) const { return !equals(rhs); }
+    bool operator!=(const char* cstr) const { return !equals(cstr); }
+    bool startsWith(const String& prefix) const;
+    bool endsWith(const String& suffix) const;
+
+    char charAt(unsigned int index) const { return index < len ? buffer()[index] : 0; }
+    char operator[](unsigned int index) const { return charAt(index); }
+    int indexOf(char ch, unsigned int fromIndex = 0) const;
+    int indexOf(const char* str, unsigned int fromIndex = 0) const;
+    String substring(unsigned int beginIndex) const { return substring(beginIndex, len); }
+    String substring(unsigned int beginIndex, unsigned int endIndex) const;
+
+    void toLowerCase();
+    void toUpperCase();
+    void trim();
+
+    long toInt() const;
+    float toFloat() const;
+    double toDouble() const;
+
+  private:
+    enum { SSO_CAPACITY = 11 };     // Inline capacity of the ESP32 core's String
+
+    char sso[SSO_CAPACITY + 1];
+    char* heap;
+    unsigned int capacity;
+    unsigned int len;
+
+    char* buffer() { return heap ? heap : sso; }
+    const char* buffer() const { return heap ? heap : sso; }
+    void init();
+    void copy(const char* cstr, unsigned int length);
+    void move(String& rhs);
+};
+
+String operator+(const String& lhs, const String& rhs);
+String operator+(const String& lhs, const char* rhs);
+String operator+(const char* lhs, const String& rhs);
+String operator+(const String& lhs, char rhs);
+
+#endif // HOST_WSTRING_H
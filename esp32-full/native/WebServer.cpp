@@ -0,0 +1,299 @@
+#include "WebServer.h"
+#include <WiFi.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+static const int HTTP_MAX_DATA_WAIT_MS = 5000;  // Same read timeout as the ESP32 library
+static const size_t HTTP_MAX_HEAD = 2048;
+
+static const int MAX_SERVERS = 4;
+static WebServer* servers[MAX_SERVERS];
+
+int WebServer::hostPort = -1;
+
+WiFiClass WiFi;
+
+String IPAddress::toString() const {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u", octets[0], octets[1], octets[2], octets[3]);
+    return String(buf);
+}
+
+// Decode %XX and '+' in a query component
+static String urlDecode(const char* text, size_t length) {
+    String out;
+    out.reserve(length);
+    for (size_t i = 0; i < length; i++) {
+        char c = text[i];
+        if (c == '+') {
+            c = ' ';
+        } else if (c == '%' && i + 2 < length && isxdigit((unsigned char)text[i + 1]) && isxdigit((unsigned char)text[i + 2])) {
+            char hex[3] = { text[i + 1], text[i + 2], 0 };
+            c = (char)strtol(hex, NULL, 16);
+            i += 2;
+        }
+        out += c;
+    }
+    return out;
+}
+
+WebServer::WebServer(int p)
+    : port(p),
+      listenFd(-1),
+      listenPort(-1),
+      currentMethod(HTTP_GET),
+      responseCode(0),
+      responseLength(0),
+      declaredLength(-1) {
+    responseType[0] = 0;
+    for (int i = 0; i < MAX_SERVERS; i++) {
+        if (!servers[i]) {
+            servers[i] = this;
+            break;
+        }
+    }
+}
+
+WebServer::~WebServer() {
+    close();
+    for (int i = 0; i < MAX_SERVERS; i++) {
+        if (servers[i] == this) servers[i] = NULL;
+    }
+}
+
+WebServer* WebServer::findByPort(int p) {
+    for (int i = 0; i < MAX_SERVERS; i++) {
+        if (servers[i] && servers[i]->port == p) return servers[i];
+    }
+    return NULL;
+}
+
+void WebServer::begin() {
+    if (hostPort < 0 || listenFd >= 0) return;
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("WebServer: socket");
+        return;
+    }
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons((uint16_t)hostPort);
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, 16) < 0) {
+        perror("WebServer: bind");
+        ::close(fd);
+        return;
+    }
+    socklen_t len = sizeof(addr);
+    getsockname(fd, (struct sockaddr*)&addr, &len);
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    listenFd = fd;
+    listenPort = ntohs(addr.sin_port);
+}
+
+void WebServer::handleClient() {
+    if (listenFd < 0) return;
+
+    int fd = accept(listenFd, NULL, NULL);
+    if (fd < 0) return;     // Nothing pending (EAGAIN)
+
+    struct timeval tv;
+    tv.tv_sec = HTTP_MAX_DATA_WAIT_MS / 1000;
+    tv.tv_usec = (HTTP_MAX_DATA_WAIT_MS % 1000) * 1000;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    currentClient = WiFiClient(fd);
+    serveClient(fd);
+    currentClient = WiFiClient();   // Closes unless the handler kept a copy
+}
+
+void WebServer::close() {
+    if (listenFd >= 0) {
+        ::close(listenFd);
+        listenFd = -1;
+    }
+}
+
+static bool writeAll(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t n = send(fd, data, length, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        length -= n;
+    }
+    return true;
+}
+
+void WebServer::serveClient(int fd) {
+    // Request line and headers (bodies are not used by any route)
+    char head[HTTP_MAX_HEAD + 1];
+    size_t used = 0;
+    while (used < HTTP_MAX_HEAD) {
+        ssize_t n = recv(fd, head + used, HTTP_MAX_HEAD - used, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return;
+        used += n;
+        head[used] = 0;
+        if (strstr(head, "\r\n\r\n")) break;
+    }
+    head[used] = 0;
+
+    char methodName[8];
+    char target[HTTP_MAX_HEAD];
+    if (sscanf(head, "%7s %2047s", methodName, target) != 2) return;
+
+    HTTPMethod method = HTTP_GET;
+    if (strcmp(methodName, "POST") == 0) method = HTTP_POST;
+    else if (strcmp(methodName, "PUT") == 0) method = HTTP_PUT;
+    else if (strcmp(methodName, "DELETE") == 0) method = HTTP_DELETE;
+    else if (strcmp(methodName, "HEAD") == 0) method = HTTP_HEAD;
+
+    handleRequest(method, target);
+
+    char status[160];
+    int statusLength = snprintf(status, sizeof(status),
+                                "HTTP/1.1 %d %s\r\nContent-Type: %s\r\nContent-Length: %u\r\n",
+                                responseCode, responseCode == 200 ? "OK" : responseCode == 404 ? "Not Found" : "Error",
+                                responseType, (unsigned)(declaredLength >= 0 ? declaredLength : responseLength));
+    if (!writeAll(fd, status, statusLength)) return;
+    if (!writeAll(fd, responseHeaders.c_str(), responseHeaders.length())) return;
+    if (!writeAll(fd, "Connection: close\r\n\r\n", 21)) return;
+    writeAll(fd, getResponseBody(), responseLength);
+}
+
+void WebServer::on(const String& uri, HTTPMethod method, THandlerFunction handler) {
+    Route r;
+    r.uri = uri;
+    r.method = method;
+    r.handler = handler;
+    routes.push_back(r);
+}
+
+WiFiClient::WiFiClient(int fd) : socket(std::make_shared<Socket>(fd)) {}
+
+WiFiClient::Socket::~Socket() {
+    ::close(fd);
+}
+
+bool WiFiClient::connected() const {
+    if (!socket) return false;
+    char c;
+    ssize_t n = recv(socket->fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    return n > 0 || (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
+}
+
+size_t WiFiClient::write(const uint8_t* buf, size_t size) {
+    if (!socket || !writeAll(socket->fd, (const char*)buf, size)) return 0;
+    return size;
+}
+
+String WebServer::arg(const String& name) const {
+    for (size_t i = 0; i < currentArgs.size(); i++) {
+        if (currentArgs[i].name == name) return currentArgs[i].value;
+    }
+    return String();
+}
+
+bool WebServer::hasArg(const String& name) const {
+    for (size_t i = 0; i < currentArgs.size(); i++) {
+        if (currentArgs[i].name == name) return true;
+    }
+    return false;
+}
+
+void WebServer::parseTarget(const char* target) {
+    currentArgs.clear();
+    const char* query = strchr(target, '?');
+    size_t pathLength = query ? (size_t)(query - target) : strlen(target);
+    currentUri = urlDecode(target, pathLength);
+    if (!query) return;
+
+    const char* p = query + 1;
+    while (*p) {
+        const char* end = strchr(p, '&');
+        size_t length = end ? (size_t)(end - p) : strlen(p);
+        const char* eq = (const char*)memchr(p, '=', length);
+        Arg a;
+        if (eq) {
+            a.name = urlDecode(p, eq - p);
+            a.value = urlDecode(eq + 1, length - (eq - p) - 1);
+        } else {
+            a.name = urlDecode(p, length);
+        }
+        if (a.name.length() > 0) currentArgs.push_back(a);
+        p += length;
+        if (*p == '&') p++;
+    }
+}
+
+int WebServer::handleRequest(HTTPMethod method, const char* target) {
+    parseTarget(target);
+    currentMethod = method;
+    responseCode = 0;
+    responseType[0] = 0;
+    responseBody.clear();
+    responseLength = 0;
+    declaredLength = -1;
+    responseHeaders = "";
+
+    for (size_t i = 0; i < routes.size(); i++) {
+        const Route& r = routes[i];
+        if ((r.method == HTTP_ANY || r.method == method) && r.uri == currentUri) {
+            r.handler();
+            return responseCode;
+        }
+    }
+    if (notFoundHandler) {
+        notFoundHandler();
+    } else {
+        send(404, "text/plain", "Not found");
+    }
+    return responseCode;
+}
+
+void WebServer::send(int code, const char* contentType, const String& content) {
+    responseCode = code;
+    snprintf(responseType, sizeof(responseType), "%s", contentType ? contentType : "text/html");
+    appendBody(content.c_str(), content.length());
+}
+
+void WebServer::send_P(int code, PGM_P contentType, PGM_P content, size_t contentLength) {
+    responseCode = code;
+    snprintf(responseType, sizeof(responseType), "%s", contentType ? contentType : "text/html");
+    appendBody(content, contentLength);
+}
+
+void WebServer::sendHeader(const String& name, const String& value, bool first) {
+    String line = name + ": " + value + "\r\n";
+    if (first) {
+        responseHeaders = line + responseHeaders;
+    } else {
+        responseHeaders += line;
+    }
+}
+
+void WebServer::sendContent(const char* content, size_t contentLength) {
+    appendBody(content, contentLength);
+}
+
+void WebServer::appendBody(const char* data, size_t length) {
+    if (!responseBody.empty()) responseBody.pop_back();     // Drop the terminator
+    responseBody.insert(responseBody.end(), data, data + length);
+    responseBody.push_back(0);                              // Keep the body printable
+    responseLength += length;
+}
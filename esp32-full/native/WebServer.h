@@ -0,0 +1,105 @@
+#ifndef HOST_WEBSERVER_H
+#define HOST_WEBSERVER_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <functional>
+#include <vector>
+
+// ============================================
+// HOST WEBSERVER
+// ============================================
+// Stand-in for the ESP32 WebServer library with the API AirRideWebServer
+// uses. Requests are dispatched in-process with handleRequest(); the
+// response (status, type, body) is captured for tools to inspect.
+// After setHostPort(), begin() also listens on a loopback TCP socket and
+// handleClient() serves it like the ESP32 library: at most one connection
+// per call, read and answered synchronously on the caller's thread, then
+// closed (Connection: close) unless the handler kept client() to finish
+// the body later.
+
+enum HTTPMethod { HTTP_ANY, HTTP_GET, HTTP_HEAD, HTTP_POST, HTTP_PUT, HTTP_PATCH, HTTP_DELETE, HTTP_OPTIONS };
+
+class WebServer {
+  public:
+    typedef std::function<void(void)> THandlerFunction;
+
+    WebServer(int port = 80);
+    ~WebServer();
+
+    void begin();
+    void handleClient();
+    void close();
+
+    void on(const String& uri, HTTPMethod method, THandlerFunction handler);
+    void on(const String& uri, THandlerFunction handler) { on(uri, HTTP_ANY, handler); }
+    void onNotFound(THandlerFunction handler) { notFoundHandler = handler; }
+
+    // Current request
+    String uri() const { return currentUri; }
+    HTTPMethod method() const { return currentMethod; }
+    int args() const { return (int)currentArgs.size(); }
+    String arg(const String& name) const;
+    bool hasArg(const String& name) const;
+    WiFiClient client() { return currentClient; }     // Unconnected for in-process requests
+
+    // Response
+    void send(int code, const char* contentType = NULL, const String& content = String());
+    void send(int code, const String& contentType, const String& content) { send(code, contentType.c_str(), content); }
+    void send_P(int code, PGM_P contentType, PGM_P content, size_t contentLength);
+    void sendHeader(const String& name, const String& value, bool first = false);
+    void setContentLength(size_t contentLength) { declaredLength = contentLength; }  // Sent as is; the rest may follow on client()
+    void sendContent(const String& content) { sendContent(content.c_str(), content.length()); }
+    void sendContent(const char* content, size_t contentLength);
+
+    // Host extensions: dispatch "GET /s?x=1" style requests in-process
+    int handleRequest(HTTPMethod method, const char* target);
+    int getResponseCode() const { return responseCode; }
+    const char* getResponseType() const { return responseType; }
+    const char* getResponseBody() const { return responseBody.empty() ? "" : &responseBody[0]; }
+    size_t getResponseLength() const { return responseLength; }
+
+    // The server listening on a port (tools reach the routes registered by AirRideWebServer)
+    static WebServer* findByPort(int port);
+
+    // Serve on 127.0.0.1:<port> from begin() on (0 = any free port, -1 = no socket)
+    static void setHostPort(int port) { hostPort = port; }
+    int getListenPort() const { return listenPort; }
+
+  private:
+    struct Route {
+        String uri;
+        HTTPMethod method;
+        THandlerFunction handler;
+    };
+    struct Arg {
+        String name;
+        String value;
+    };
+
+    static int hostPort;
+
+    int port;
+    int listenFd;
+    int listenPort;
+    std::vector<Route> routes;
+    THandlerFunction notFoundHandler;
+
+    String currentUri;
+    HTTPMethod currentMethod;
+    std::vector<Arg> currentArgs;
+    WiFiClient currentClient;
+
+    int responseCode;
+    char responseType[48];
+    std::vector<char> responseBody;     // Reused between requests (capacity is kept)
+    size_t responseLength;
+    long declaredLength;                // setContentLength(), -1 = length of the buffered body
+    String responseHeaders;             // Extra header lines from sendHeader()
+
+    void parseTarget(const char* target);
+    void appendBody(const char* data, size_t length);
+    void serveClient(int fd);
+};
+
+#endif // HOST_WEBSERVER_H
@@ -0,0 +1,63 @@
+#ifndef HOST_WIFI_H
+#define HOST_WIFI_H
+
+#include <Arduino.h>
+#include <memory>
+
+// ============================================
+// HOST WIFI
+// ============================================
+// Soft-AP calls used by AirRideWebServer. The host build serves on the
+// loopback interface, so the AP always reports 192.168.4.1 like the ESP32.
+
+// Connected socket, shared by copies like the ESP32 WiFiClient: the socket
+// closes when the last copy is stopped or destroyed
+class WiFiClient {
+  public:
+    WiFiClient() {}
+    explicit WiFiClient(int fd);
+
+    bool connected() const;
+    size_t write(const uint8_t* buf, size_t size);
+    void stop() { socket.reset(); }
+    operator bool() const { return socket != nullptr; }
+
+  private:
+    struct Socket {
+        int fd;
+        explicit Socket(int f) : fd(f) {}
+        ~Socket();
+    };
+    std::shared_ptr<Socket> socket;
+};
+
+#define WIFI_OFF    0
+#define WIFI_STA    1
+#define WIFI_AP     2
+
+class WiFiClass {
+  public:
+    WiFiClass() : maxClients(4) {}
+
+    bool mode(int m) { (void)m; return true; }
+    bool softAP(const char* ssid, const char* pass = NULL, int channel = 1, int hidden = 0, int maxConnection = 4) {
+        (void)ssid;
+        (void)pass;
+        (void)channel;
+        (void)hidden;
+        maxClients = maxConnection;
+        return true;
+    }
+    bool softAPdisconnect(bool wifioff = false) { (void)wifioff; return true; }
+    IPAddress softAPIP() const { return IPAddress(192, 168, 4, 1); }
+    uint8_t softAPgetStationNum() const { return 0; }
+
+    int getMaxClients() const { return maxClients; }
+
+  private:
+    int maxClients;
+};
+
+extern WiFiClass WiFi;
+
+#endif // HOST_WIFI_H
@@ -0,0 +1,352 @@
+#include "AirRideClient.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+static long nowMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000L + ts.tv_nsec / 1000000L;
+}
+
+AirRideClient::AirRideClient()
+    : fd(-1),
+      timeoutMs(500),
+      nextSeq(1),
+      logHandler(NULL),
+      logContext(NULL),
+      frameLength(0),
+      inFrame(false),
+      frameOverflow(false),
+      lineLength(0),
+      rxPos(0),
+      rxLength(0),
+      lastStreamSeq(-1),
+      badFrames(0),
+      lostStates(0) {
+}
+
+AirRideClient::~AirRideClient() {
+    close();
+}
+
+bool AirRideClient::open(const char* device) {
+    int port = ::open(device, O_RDWR | O_NOCTTY);
+    if (port < 0) {
+        perror(device);
+        return false;
+    }
+
+    struct termios tio;
+    if (tcgetattr(port, &tio) == 0) {
+        cfmakeraw(&tio);
+        cfsetspeed(&tio, B115200);
+        tio.c_cc[VMIN] = 0;
+        tio.c_cc[VTIME] = 0;
+        tcsetattr(port, TCSANOW, &tio);
+        tcflush(port, TCIFLUSH);
+    }
+    return attach(port);
+}
+
+bool AirRideClient::attach(int descriptor) {
+    close();
+    fd = descriptor;
+    return fd >= 0;
+}
+
+void AirRideClient::close() {
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+}
+
+// ============================================
+// REQUESTS
+// ============================================
+
+int AirRideClient::request(LinkPacket& req, LinkPacket* reply) {
+    if (fd < 0) return CLIENT_IO_ERROR;
+
+    req.seq = nextSeq++;
+    if (nextSeq == 0) nextSeq = 1;      // 0 is used for bad-frame ACKs
+
+    uint8_t wire[LINK_MAX_WIRE];
+    size_t length = linkEncode(req, wire);
+    for (size_t sent = 0; sent < length;) {
+        ssize_t n = write(fd, wire + sent, length - sent);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return CLIENT_IO_ERROR;
+        sent += n;
+    }
+
+    long deadline = nowMs() + timeoutMs;
+    LinkPacket packet;
+    while (true) {
+        long remaining = deadline - nowMs();
+        if (remaining <= 0 || !receive((int)remaining, packet, false)) return CLIENT_TIMEOUT;
+        if (packet.seq != req.seq) continue;    // Late reply to an earlier request
+
+        if (packet.type == LINK_ACK) {
+            uint8_t type, status;
+            if (packet.getU8(type) && packet.getU8(status) && type == req.type) return status;
+        } else if (reply) {
+            *reply = packet;
+            return LINK_OK;
+        }
+    }
+}
+
+int AirRideClient::ping() {
+    LinkPacket req(LINK_PING);
+    return request(req, NULL);
+}
+
+int AirRideClient::getState(LinkState& state) {
+    LinkPacket req(LINK_GET_STATE);
+    LinkPacket reply;
+    int status = request(req, &reply);
+    if (status != LINK_OK) return status;
+    return reply.getState(state) ? LINK_OK : LINK_BAD_FRAME;
+}
+
+int AirRideClient::bagMove(int bag, int direction) {
+    LinkPacket req(LINK_BAG_MOVE);
+    req.putU8(bag);
+    req.putU8((uint8_t)(int8_t)(direction > 0 ? 1 : -1));
+    return request(req, NULL);
+}
+
+int AirRideClient::bagHold(int bag) {
+    LinkPacket req(LINK_BAG_HOLD);
+    req.putU8(bag);
+    return request(req, NULL);
+}
+
+int AirRideClient::bagTarget(int bag, float psi, int ramp) {
+    LinkPacket req(LINK_BAG_TARGET);
+    req.putU8(bag);
+    req.putFloat(psi);
+    if (ramp >= 0) req.putU8(ramp);
+    return request(req, NULL);
+}
+
+int AirRideClient::stopAll() {
+    LinkPacket req(LINK_STOP_ALL);
+    return request(req, NULL);
+}
+
+int AirRideClient::applyPreset(int preset, int ramp) {
+    LinkPacket req(LINK_PRESET_APPLY);
+    req.putU8(preset);
+    if (ramp >= 0) req.putU8(ramp);
+    return request(req, NULL);
+}
+
+int AirRideClient::savePreset(int preset, const float psi[4]) {
+    LinkPacket req(LINK_PRESET_SAVE);
+    req.putU8(preset);
+    for (int i = 0; i < 4; i++) req.putFloat(psi[i]);
+    return request(req, NULL);
+}
+
+int AirRideClient::setLevelMode(int mode) {
+    LinkPacket req(LINK_LEVEL_MODE);
+    req.putU8(mode);
+    return request(req, NULL);
+}
+
+int AirRideClient::setPumpEnabled(bool enabled) {
+    LinkPacket req(LINK_PUMP_ENABLE);
+    req.putU8(enabled ? 1 : 0);
+    return request(req, NULL);
+}
+
+int AirRideClient::setPumpMode(int mode) {
+    LinkPacket req(LINK_PUMP_MODE);
+    req.putU8(mode);
+    return request(req, NULL);
+}
+
+int AirRideClient::setTankTarget(float psi) {
+    LinkPacket req(LINK_TANK_TARGET);
+    req.putFloat(psi);
+    return request(req, NULL);
+}
+
+int AirRideClient::syncTime(uint32_t epoch) {
+    LinkPacket req(LINK_TIME_SYNC);
+    req.putU32(epoch);
+    return request(req, NULL);
+}
+
+int AirRideClient::setDemoMode(bool enabled) {
+    LinkPacket req(LINK_DEMO_MODE);
+    req.putU8(enabled ? 1 : 0);
+    return request(req, NULL);
+}
+
+int AirRideClient::resetLeak() {
+    LinkPacket req(LINK_LEAK_RESET);
+    return request(req, NULL);
+}
+
+int AirRideClient::setTankMaint(uint32_t epoch) {
+    LinkPacket req(LINK_TANK_MAINT);
+    req.putU32(epoch);
+    return request(req, NULL);
+}
+
+int AirRideClient::setCalibration(int sensor, float offset, float gain, float refResistor) {
+    LinkPacket req(LINK_CAL_SET);
+    req.putU8(sensor);
+    req.putFloat(offset);
+    req.putFloat(gain);
+    req.putFloat(refResistor);
+    return request(req, NULL);
+}
+
+int AirRideClient::resetCalibration(int sensor) {
+    LinkPacket req(LINK_CAL_RESET);
+    req.putU8(sensor < 0 ? 0xFF : sensor);
+    return request(req, NULL);
+}
+
+int AirRideClient::simLeak(int target, float ratePsiTick) {
+    LinkPacket req(LINK_SIM_LEAK);
+    req.putU8((uint8_t)(int8_t)target);
+    req.putFloat(ratePsiTick);
+    return request(req, NULL);
+}
+
+int AirRideClient::stream(uint16_t intervalMs) {
+    LinkPacket req(LINK_STREAM);
+    req.putU16(intervalMs);
+    lastStreamSeq = -1;
+    return request(req, NULL);
+}
+
+int AirRideClient::park() {
+    LinkPacket req(LINK_PARK);
+    return request(req, NULL);
+}
+
+int AirRideClient::setLevelPitch(float psi) {
+    LinkPacket req(LINK_LEVEL_PITCH);
+    req.putFloat(psi);
+    return request(req, NULL);
+}
+
+int AirRideClient::restartTrace() {
+    LinkPacket req(LINK_TRACE_RESTART);
+    return request(req, NULL);
+}
+
+bool AirRideClient::readState(LinkState& state, int waitMs) {
+    if (states.empty()) {
+        LinkPacket packet;
+        receive(waitMs, packet, true);
+    }
+    if (states.empty()) return false;
+    state = states.front();
+    states.pop_front();
+    return true;
+}
+
+// ============================================
+// RECEIVE
+// ============================================
+
+// Reads until a reply arrives (or, with streamed=true, until a state
+// frame is queued) or waitMs passes
+bool AirRideClient::receive(int waitMs, LinkPacket& packet, bool streamed) {
+    long deadline = nowMs() + waitMs;
+    while (fd >= 0) {
+        while (rxPos < rxLength) {
+            if (handleByte(rx[rxPos++], packet)) return true;
+            if (streamed && !states.empty()) return true;
+        }
+
+        long remaining = deadline - nowMs();
+        if (remaining <= 0) return false;
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        int ready = poll(&pfd, 1, (int)remaining);
+        if (ready < 0 && errno == EINTR) continue;
+        if (ready <= 0) return false;
+
+        ssize_t n = read(fd, rx, sizeof(rx));
+        if (n < 0 && (errno == EINTR || errno == EAGAIN)) continue;
+        if (n <= 0) {
+            close();
+            return false;
+        }
+        rxPos = 0;
+        rxLength = n;
+    }
+    return false;
+}
+
+bool AirRideClient::handleByte(uint8_t b, LinkPacket& packet) {
+    if (b == 0x00) {
+        bool isReply = false;
+        if (inFrame && frameLength > 0) {
+            if (!frameOverflow && linkDecode(frame, frameLength, packet)) {
+                handleFrame(packet, isReply);
+            } else {
+                badFrames++;
+            }
+            inFrame = false;
+        } else {
+            inFrame = true;
+        }
+        frameLength = 0;
+        frameOverflow = false;
+        return isReply;
+    }
+
+    if (inFrame) {
+        if (frameLength < sizeof(frame)) {
+            frame[frameLength++] = b;
+        } else {
+            frameOverflow = true;
+        }
+        return false;
+    }
+
+    // Console text, delivered a line at a time
+    if (b == '\n' || lineLength == sizeof(line) - 1) {
+        line[lineLength] = '\0';
+        if (lineLength > 0 && line[lineLength - 1] == '\r') line[lineLength - 1] = '\0';
+        if (logHandler) logHandler(line, logContext);
+        lineLength = 0;
+    }
+    if (b != '\n') line[lineLength++] = (char)b;
+    return false;
+}
+
+void AirRideClient::handleFrame(LinkPacket& packet, bool& isReply) {
+    if (packet.type != LINK_STATE_STREAM) {
+        isReply = true;
+        return;
+    }
+
+    LinkState state;
+    if (!packet.getState(state)) {
+        badFrames++;
+        return;
+    }
+    if (lastStreamSeq >= 0) {
+        lostStates += (uint8_t)(packet.seq - lastStreamSeq - 1);
+    }
+    lastStreamSeq = packet.seq;
+
+    if (states.size() >= CLIENT_STATE_QUEUE) {
+        states.pop_front();
+        lostStates++;
+    }
+    states.push_back(state);
+}
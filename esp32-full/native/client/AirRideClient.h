@@ -0,0 +1,99 @@
+#ifndef AIRRIDE_CLIENT_H
+#define AIRRIDE_CLIENT_H
+
+#include <deque>
+#include "LinkProtocol.h"
+
+// ============================================
+// AIR RIDE HOST CLIENT
+// ============================================
+// Host side of the binary serial link (LinkProtocol.h) for bench tools.
+// Opens the controller's USB serial port, sends CRC-checked requests and
+// waits for the matching ACK/STATE by sequence number. Streamed state
+// frames are queued for readState(); console text that shares the port
+// is passed line by line to an optional log handler.
+//
+// Requests return a LinkStatus (LINK_OK...) or a negative CLIENT_* error.
+
+#define CLIENT_TIMEOUT      -1      // No reply within the timeout
+#define CLIENT_IO_ERROR     -2      // Port closed or write failed
+#define CLIENT_STATE_QUEUE  4096    // Streamed frames kept before the oldest is dropped
+
+class AirRideClient {
+  public:
+    typedef void (*LogHandler)(const char* line, void* context);
+
+    AirRideClient();
+    ~AirRideClient();
+
+    bool open(const char* device);      // Raw mode; baud rate is ignored by USB CDC
+    bool attach(int fd);                // Already-open descriptor (pty, socket)
+    void close();
+    bool isOpen() const { return fd >= 0; }
+
+    void setTimeout(int ms) { timeoutMs = ms; }
+    void setLogHandler(LogHandler handler, void* context) { logHandler = handler; logContext = context; }
+
+    // Requests (see LinkMessage for units and ranges)
+    int ping();
+    int getState(LinkState& state);
+    int bagMove(int bag, int direction);
+    int bagHold(int bag);
+    int bagTarget(int bag, float psi, int ramp = -1);    // ramp: RampProfile, -1 = controller default
+    int stopAll();
+    int applyPreset(int preset, int ramp = -1);
+    int savePreset(int preset, const float psi[4]);
+    int setLevelMode(int mode);
+    int setPumpEnabled(bool enabled);
+    int setPumpMode(int mode);
+    int setTankTarget(float psi);
+    int syncTime(uint32_t epoch);
+    int setDemoMode(bool enabled);
+    int resetLeak();
+    int setTankMaint(uint32_t epoch);   // 0 = serviced now
+    int setCalibration(int sensor, float offset, float gain, float refResistor);
+    int resetCalibration(int sensor);   // -1 = all
+    int simLeak(int target, float ratePsiTick);
+    int stream(uint16_t intervalMs);    // 0 = stop
+    int park();
+    int setLevelPitch(float psi);       // NAN = hold the stance's own pitch
+    int restartTrace();
+
+    // Next streamed state frame; false on timeout
+    bool readState(LinkState& state, int waitMs);
+
+    unsigned long getBadFrames() const { return badFrames; }         // CRC/COBS failures
+    unsigned long getLostStates() const { return lostStates; }       // Stream seq gaps + queue overflow
+
+  private:
+    int fd;
+    int timeoutMs;
+    uint8_t nextSeq;
+
+    LogHandler logHandler;
+    void* logContext;
+
+    // Receive parser (same framing rules as SerialConsole)
+    uint8_t frame[LINK_MAX_ENCODED];
+    size_t frameLength;
+    bool inFrame;
+    bool frameOverflow;
+    char line[256];
+    size_t lineLength;
+
+    uint8_t rx[512];
+    size_t rxPos;
+    size_t rxLength;
+
+    std::deque<LinkState> states;
+    int lastStreamSeq;
+    unsigned long badFrames;
+    unsigned long lostStates;
+
+    int request(LinkPacket& req, LinkPacket* reply);
+    bool receive(int waitMs, LinkPacket& packet, bool streamed);
+    bool handleByte(uint8_t b, LinkPacket& packet);     // true when a reply packet completed
+    void handleFrame(LinkPacket& packet, bool& isReply);
+};
+
+#endif // AIRRIDE_CLIENT_H
@@ -0,0 +1,14 @@
+#ifndef HOST_ESP_TASK_WDT_H
+#define HOST_ESP_TASK_WDT_H
+
+#include <stdint.h>
+
+// Task watchdog: nothing to feed on the host
+typedef int esp_err_t;
+#define ESP_OK 0
+
+inline esp_err_t esp_task_wdt_init(uint32_t timeoutSeconds, bool panic) { (void)timeoutSeconds; (void)panic; return ESP_OK; }
+inline esp_err_t esp_task_wdt_add(void* task) { (void)task; return ESP_OK; }
+inline esp_err_t esp_task_wdt_reset() { return ESP_OK; }
+
+#endif // HOST_ESP_TASK_WDT_H
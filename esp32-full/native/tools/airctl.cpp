@@ -0,0 +1,299 @@
+// ============================================
+// AIRCTL - BENCH CLIENT FOR THE BINARY SERIAL LINK
+// ============================================
+// Drives the controller over USB serial with framed, CRC-checked
+// requests (LinkProtocol.h) instead of typing console letters, and logs
+// the state stream at up to 100 Hz.
+//
+// Build & run: pio run -e native-airctl && .pio/build/native-airctl/program <port> <command> [args]
+//   status                          One state snapshot
+//   ping
+//   inflate|deflate|hold <bag>      bag = fl, fr, rl, rr or 0-3
+//   target <bag> <psi> [ramp]       ramp = fast, comfort or show (default: the controller's)
+//   stop
+//   preset <n> [ramp]               Apply preset 0-4
+//   save-preset <n> <fl> <fr> <rl> <rr>
+//   level off|front|rear|all
+//   pitch <psi>|hold                Front minus rear PSI that level all holds
+//   pump on|off
+//   pump-mode auto|off|both|1|2
+//   tank-target <psi>
+//   time [epoch]                    Defaults to the host clock
+//   demo on|off
+//   leak-reset
+//   tank-maint [epoch]              Defaults to now
+//   cal <sensor> <offset> <gain> <refResistor>    sensor 0 = tank, 1-4 = bags
+//   cal-reset [sensor]              All sensors if omitted
+//   simleak <target|-1> [psi/tick]
+//   park                            Parked low-power mode
+//   trace-restart                   Session trace starts over from a snapshot
+//   stream [hz]                     Log the state stream (default 100 Hz)
+//   log                             Print console output until interrupted
+// Options:
+//   --seconds <s>   Stream/log duration (default: until Ctrl-C)
+//   --csv <file>    Write streamed states as CSV
+//   --timeout <ms>  Reply timeout (default 500)
+//   --verbose       Print console text received alongside replies
+//
+// Exit status: 0 = OK, 1 = rejected or bad arguments, 2 = no reply.
+
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include "AirRideClient.h"
+
+static volatile sig_atomic_t interrupted = 0;
+
+static void onSignal(int) {
+    interrupted = 1;
+}
+
+static void printLog(const char* line, void* context) {
+    (void)context;
+    printf("  | %s\n", line);
+}
+
+static const char* statusName(int status) {
+    switch (status) {
+        case LINK_OK:           return "OK";
+        case LINK_BAD_ARGUMENT: return "bad argument";
+        case LINK_REJECTED:     return "rejected";
+        case LINK_UNSUPPORTED:  return "unsupported";
+        case LINK_BAD_FRAME:    return "bad frame";
+        case CLIENT_TIMEOUT:    return "no reply";
+        case CLIENT_IO_ERROR:   return "I/O error";
+        default:                return "unknown";
+    }
+}
+
+static int parseBag(const char* s) {
+    static const char* names[] = { "fl", "fr", "rl", "rr" };
+    for (int i = 0; i < 4; i++) {
+        if (strcasecmp(s, names[i]) == 0) return i;
+    }
+    char* end;
+    long n = strtol(s, &end, 10);
+    return (*end == '\0' && n >= 0 && n < 4) ? (int)n : -1;
+}
+
+static int parseName(const char* s, const char* const* names, int count) {
+    for (int i = 0; i < count; i++) {
+        if (strcasecmp(s, names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+static void printState(const LinkState& s) {
+    static const char* levelNames[] = { "off", "front", "rear", "all" };
+    static const char* pumpNames[] = { "auto", "off", "both", "1", "2" };
+    static const char* bagNames[] = { "FL", "FR", "RL", "RR" };
+
+    printf("Tank: %.1f PSI   Pumps: %s%s   Mode: %s%s\n", s.tank,
+           (s.pumps & 1) ? "1" : "-", (s.pumps & 2) ? "2" : "-",
+           s.pumpMode < 5 ? pumpNames[s.pumpMode] : "?",
+           (s.flags & LINK_STATE_PUMP_ENABLED) ? "" : " (disabled)");
+    for (int i = 0; i < 4; i++) {
+        const char* valve = (s.valves & (1 << (2 * i))) ? "inflating"
+                          : (s.valves & (2 << (2 * i))) ? "deflating" : "";
+        printf("%s: %5.1f PSI  target %5.1f  %s%s\n", bagNames[i], s.bags[i], s.targets[i],
+               valve, (s.timeouts & (1 << i)) ? " TIMEOUT" : "");
+    }
+    printf("Level: %s%s%s%s\n", s.levelMode < 4 ? levelNames[s.levelMode] : "?",
+           (s.flags & LINK_STATE_LOCKOUT) ? "   TANK LOCKOUT" : "",
+           (s.flags & LINK_STATE_DEMO) ? "   DEMO" : "",
+           (s.flags & LINK_STATE_TIME_SYNCED) ? "" : "   (clock not synced)");
+}
+
+static void writeCsvRow(FILE* f, const LinkState& s) {
+    fprintf(f, "%u,%u,%.2f", s.ms, s.tickMs, s.tank);
+    for (int i = 0; i < 4; i++) fprintf(f, ",%.2f", s.bags[i]);
+    for (int i = 0; i < 4; i++) fprintf(f, ",%.2f", s.targets[i]);
+    fprintf(f, ",%u,%u,%u,%u\n", s.valves, s.pumps, s.timeouts, s.flags);
+}
+
+static bool timeUp(const struct timespec& start, double seconds) {
+    if (seconds <= 0) return false;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9 >= seconds;
+}
+
+static int runStream(AirRideClient& client, int hz, double seconds, const char* csvPath) {
+    FILE* csv = NULL;
+    if (csvPath) {
+        csv = fopen(csvPath, "w");
+        if (!csv) {
+            perror(csvPath);
+            return 1;
+        }
+        fprintf(csv, "ms,tick_ms,tank,fl,fr,rl,rr,fl_target,fr_target,rl_target,rr_target,valves,pumps,timeouts,flags\n");
+    }
+
+    int status = client.stream((uint16_t)(1000 / hz));
+    if (status != LINK_OK) {
+        fprintf(stderr, "stream: %s\n", statusName(status));
+        if (csv) fclose(csv);
+        return status < 0 ? 2 : 1;
+    }
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    unsigned long frames = 0;
+    uint32_t firstMs = 0, lastMs = 0;
+    LinkState s;
+    while (!interrupted && !timeUp(start, seconds) && client.isOpen()) {
+        if (!client.readState(s, 200)) continue;
+        if (frames++ == 0) firstMs = s.ms;
+        lastMs = s.ms;
+        if (csv) {
+            writeCsvRow(csv, s);
+        } else {
+            printf("%10u  tank %5.1f  %5.1f %5.1f %5.1f %5.1f  v%02x p%u\n",
+                   s.ms, s.tank, s.bags[0], s.bags[1], s.bags[2], s.bags[3], s.valves, s.pumps);
+        }
+    }
+    client.stream(0);
+    if (csv) fclose(csv);
+
+    double span = (lastMs - firstMs) / 1000.0;
+    fprintf(stderr, "%lu frames", frames);
+    if (span > 0) fprintf(stderr, " (%.1f Hz)", (frames - 1) / span);
+    fprintf(stderr, ", %lu lost, %lu bad\n", client.getLostStates(), client.getBadFrames());
+    return 0;
+}
+
+static int runLog(AirRideClient& client, double seconds) {
+    client.setLogHandler(printLog, NULL);
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    LinkState s;
+    while (!interrupted && !timeUp(start, seconds) && client.isOpen()) {
+        client.readState(s, 200);
+    }
+    return 0;
+}
+
+static void usage(const char* argv0) {
+    fprintf(stderr, "Usage: %s <port> <command> [args] [--seconds <s>] [--csv <file>] [--timeout <ms>] [--verbose]\n", argv0);
+    fprintf(stderr, "Commands: status ping inflate deflate hold target stop preset save-preset level pitch pump\n"
+                    "          pump-mode tank-target time demo leak-reset tank-maint cal cal-reset simleak park\n"
+                    "          trace-restart stream log\n");
+}
+
+int main(int argc, char** argv) {
+    const char* args[8];
+    int argCount = 0;
+    double seconds = 0;
+    const char* csvPath = NULL;
+    int timeoutMs = 500;
+    bool verbose = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+            csvPath = argv[++i];
+        } else if (strcmp(argv[i], "--timeout") == 0 && i + 1 < argc) {
+            timeoutMs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--verbose") == 0) {
+            verbose = true;
+        } else if (argv[i][0] == '-' && argv[i][1] == '-') {
+            usage(argv[0]);
+            return 1;
+        } else if (argCount < 8) {
+            args[argCount++] = argv[i];
+        }
+    }
+    if (argCount < 2) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    AirRideClient client;
+    if (!client.open(args[0])) return 2;
+    client.setTimeout(timeoutMs);
+    if (verbose) client.setLogHandler(printLog, NULL);
+    signal(SIGINT, onSignal);
+
+    const char* cmd = args[1];
+    const char* a1 = argCount > 2 ? args[2] : NULL;
+    const char* a2 = argCount > 3 ? args[3] : NULL;
+    int status = LINK_BAD_ARGUMENT;
+
+    static const char* levelNames[] = { "off", "front", "rear", "all" };
+    static const char* pumpNames[] = { "auto", "off", "both", "1", "2" };
+    static const char* rampNames[] = { "fast", "comfort", "show" };
+    const char* a3 = argCount > 4 ? args[4] : NULL;
+
+    if (strcmp(cmd, "status") == 0) {
+        LinkState s;
+        status = client.getState(s);
+        if (status == LINK_OK) printState(s);
+    } else if (strcmp(cmd, "ping") == 0) {
+        status = client.ping();
+    } else if ((strcmp(cmd, "inflate") == 0 || strcmp(cmd, "deflate") == 0) && a1 && parseBag(a1) >= 0) {
+        status = client.bagMove(parseBag(a1), cmd[0] == 'i' ? 1 : -1);
+    } else if (strcmp(cmd, "hold") == 0 && a1 && parseBag(a1) >= 0) {
+        status = client.bagHold(parseBag(a1));
+    } else if (strcmp(cmd, "target") == 0 && a2 && parseBag(a1) >= 0 && (!a3 || parseName(a3, rampNames, 3) >= 0)) {
+        status = client.bagTarget(parseBag(a1), atof(a2), a3 ? parseName(a3, rampNames, 3) : -1);
+    } else if (strcmp(cmd, "stop") == 0) {
+        status = client.stopAll();
+    } else if (strcmp(cmd, "preset") == 0 && a1 && (!a2 || parseName(a2, rampNames, 3) >= 0)) {
+        status = client.applyPreset(atoi(a1), a2 ? parseName(a2, rampNames, 3) : -1);
+    } else if (strcmp(cmd, "save-preset") == 0 && argCount == 7) {
+        float psi[4];
+        for (int i = 0; i < 4; i++) psi[i] = atof(args[3 + i]);
+        status = client.savePreset(atoi(a1), psi);
+    } else if (strcmp(cmd, "level") == 0 && a1 && parseName(a1, levelNames, 4) >= 0) {
+        status = client.setLevelMode(parseName(a1, levelNames, 4));
+    } else if (strcmp(cmd, "pitch") == 0 && a1) {
+        status = client.setLevelPitch(strcmp(a1, "hold") == 0 ? NAN : atof(a1));
+    } else if (strcmp(cmd, "pump") == 0 && a1 && (strcmp(a1, "on") == 0 || strcmp(a1, "off") == 0)) {
+        status = client.setPumpEnabled(strcmp(a1, "on") == 0);
+    } else if (strcmp(cmd, "pump-mode") == 0 && a1 && parseName(a1, pumpNames, 5) >= 0) {
+        status = client.setPumpMode(parseName(a1, pumpNames, 5));
+    } else if (strcmp(cmd, "tank-target") == 0 && a1) {
+        status = client.setTankTarget(atof(a1));
+    } else if (strcmp(cmd, "time") == 0) {
+        status = client.syncTime(a1 ? (uint32_t)strtoul(a1, NULL, 10) : (uint32_t)time(NULL));
+    } else if (strcmp(cmd, "demo") == 0 && a1 && (strcmp(a1, "on") == 0 || strcmp(a1, "off") == 0)) {
+        status = client.setDemoMode(strcmp(a1, "on") == 0);
+    } else if (strcmp(cmd, "leak-reset") == 0) {
+        status = client.resetLeak();
+    } else if (strcmp(cmd, "tank-maint") == 0) {
+        status = client.setTankMaint(a1 ? (uint32_t)strtoul(a1, NULL, 10) : 0);
+    } else if (strcmp(cmd, "cal") == 0 && argCount == 6) {
+        status = client.setCalibration(atoi(a1), atof(a2), atof(args[4]), atof(args[5]));
+    } else if (strcmp(cmd, "cal-reset") == 0) {
+        status = client.resetCalibration(a1 ? atoi(a1) : -1);
+    } else if (strcmp(cmd, "simleak") == 0 && a1) {
+        status = client.simLeak(atoi(a1), a2 ? atof(a2) : 0);
+    } else if (strcmp(cmd, "park") == 0) {
+        status = client.park();
+    } else if (strcmp(cmd, "trace-restart") == 0) {
+        status = client.restartTrace();
+    } else if (strcmp(cmd, "stream") == 0) {
+        int hz = a1 ? atoi(a1) : 100;
+        if (hz < 1 || hz > 1000) {
+            fprintf(stderr, "stream: rate must be 1-1000 Hz (the controller sets its own maximum)\n");
+            return 1;
+        }
+        return runStream(client, hz, seconds, csvPath);
+    } else if (strcmp(cmd, "log") == 0) {
+        return runLog(client, seconds);
+    } else {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (strcmp(cmd, "status") != 0 || status != LINK_OK) {
+        printf("%s: %s\n", cmd, statusName(status));
+    }
+    if (status < 0) return 2;
+    return status == LINK_OK ? 0 : 1;
+}
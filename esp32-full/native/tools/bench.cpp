@@ -0,0 +1,364 @@
+// ============================================
+// CONTROL BENCHMARK SUITE
+// ============================================
+// Drives the control core through scripted scenarios against the
+// simulated plant and scores each one, so control changes can be judged
+// by numbers rather than feel:
+//   settle_s     Time until every bag stays within SETTLE_BAND_PSI of its
+//                final target (-1 = never settled)
+//   overshoot    Worst excursion past target in the direction of travel (PSI)
+//   valve_edges  Solenoid open/close transitions
+//   solenoid_s   Total solenoid on-time
+//   air_sl       Air drawn from the tank (standard liters)
+//   pump_s       Total pump runtime
+//   spread_pct   Worst difference in progress between moving corners
+//                (how far the car leans on the way; 0 = all in step)
+//
+// Build & run: pio run -e native-bench && .pio/build/native-bench/program [options]
+//   --csv <file>       Write results as CSV (compare across commits)
+//   --baseline <file>  Print deltas against a previous --csv result
+//                      (native/bench_baseline.csv is the committed reference)
+//   --only <name>      Run scenarios whose name contains <name>
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include "config.h"
+#include "AirBag.h"
+#include "Compressor.h"
+#include "RideController.h"
+#include "HostBoard.h"
+#include "PneumaticPlant.h"
+
+AirBag bags[NUM_BAGS] = {
+    AirBag(FRONT_LEFT_PRESSURE_PIN,  FRONT_LEFT_INFLATE_PIN,  FRONT_LEFT_DEFLATE_PIN,  "FL"),
+    AirBag(FRONT_RIGHT_PRESSURE_PIN, FRONT_RIGHT_INFLATE_PIN, FRONT_RIGHT_DEFLATE_PIN, "FR"),
+    AirBag(REAR_LEFT_PRESSURE_PIN,   REAR_LEFT_INFLATE_PIN,   REAR_LEFT_DEFLATE_PIN,   "RL"),
+    AirBag(REAR_RIGHT_PRESSURE_PIN,  REAR_RIGHT_INFLATE_PIN,  REAR_RIGHT_DEFLATE_PIN,  "RR")
+};
+
+Compressor compressor(PUMP_1_PIN, PUMP_2_PIN);
+RideController controller(bags, &compressor);
+
+static const float SETTLE_BAND_PSI = TARGET_TOLERANCE_PSI + 1.0;
+static const float STD_AIR_KG_PER_L = 0.0012041;   // 20 C, 1 atm
+
+static const int PRESET_LAY = 0;
+static const int PRESET_CRUISE = 1;
+static const int PRESET_MAX = 2;
+
+// ============================================
+// SCENARIOS
+// ============================================
+
+struct Scenario {
+    const char* name;
+    unsigned long durationMs;
+    int startPreset;        // Initial bag pressures (-1 = set by setup)
+    float tankPsi;          // Initial tank pressure
+    float noisePsi;         // Sensor noise (1 sigma)
+    void (*setup)(PneumaticPlant& plant);   // Optional extra plant setup
+    void (*command)();                       // Issued at t=0
+};
+
+static void applyPreset(int presetNum) {
+    const Preset& p = DEFAULT_PRESETS[presetNum];
+    float targets[NUM_BAGS] = { p.frontLeft, p.frontRight, p.rearLeft, p.rearRight };
+    controller.applyTargets(targets);
+}
+
+static void toLay()    { applyPreset(PRESET_LAY); }
+static void toCruise() { applyPreset(PRESET_CRUISE); }
+static void toMax()    { applyPreset(PRESET_MAX); }
+
+// Same move with each ramp profile (the plain scenarios use the default)
+static void applyPreset(int presetNum, RampProfile profile) {
+    const Preset& p = DEFAULT_PRESETS[presetNum];
+    float targets[NUM_BAGS] = { p.frontLeft, p.frontRight, p.rearLeft, p.rearRight };
+    controller.applyTargets(targets, profile);
+}
+static void toCruiseComfort() { applyPreset(PRESET_CRUISE, RAMP_COMFORT); }
+static void toCruiseShow()    { applyPreset(PRESET_CRUISE, RAMP_SHOW); }
+static void toLayComfort()    { applyPreset(PRESET_LAY, RAMP_COMFORT); }
+
+// Heavier driver side: same pressure gives different heights left/right
+static void asymmetricLoads(PneumaticPlant& plant) {
+    PlantParams p = plant.getParams();
+    p.loadLbf[FRONT_LEFT] *= 1.15;
+    p.loadLbf[FRONT_RIGHT] *= 0.85;
+    p.loadLbf[REAR_LEFT] *= 1.15;
+    p.loadLbf[REAR_RIGHT] *= 0.85;
+    plant.setParams(p);
+    plant.setBagPressure(FRONT_LEFT, 70);
+    plant.setBagPressure(FRONT_RIGHT, 90);
+    plant.setBagPressure(REAR_LEFT, 42);
+    plant.setBagPressure(REAR_RIGHT, 58);
+}
+
+// Parked across a driveway crown: FL and RR wheels sit high, the body
+// twists and loads that diagonal
+static void driveway(PneumaticPlant& plant) {
+    PlantParams p = plant.getParams();
+    p.groundTwistIn = 2.0;
+    plant.setParams(p);
+}
+
+// Corner by corner (/bt), so no coordinated move stages for the tank
+static void cornersToCruise() {
+    const Preset& p = DEFAULT_PRESETS[PRESET_CRUISE];
+    float targets[NUM_BAGS] = { p.frontLeft, p.frontRight, p.rearLeft, p.rearRight };
+    for (int i = 0; i < NUM_BAGS; i++) {
+        controller.setBagTarget(i, targets[i]);
+    }
+}
+
+static void levelFront() { controller.setLevelMode(LEVEL_FRONT); }
+static void levelAll()   { controller.setLevelMode(LEVEL_ALL); }
+static void holdCurrent() {}
+
+static const Scenario SCENARIOS[] = {
+    // Preset changes
+    {"lay_to_cruise",     60000, PRESET_LAY,    150, PLANT_SENSOR_NOISE_PSI, NULL, toCruise},
+    {"cruise_to_max",     60000, PRESET_CRUISE, 150, PLANT_SENSOR_NOISE_PSI, NULL, toMax},
+    {"max_to_lay",        60000, PRESET_MAX,    150, PLANT_SENSOR_NOISE_PSI, NULL, toLay},
+    {"lay_to_max",        60000, PRESET_LAY,    150, PLANT_SENSOR_NOISE_PSI, NULL, toMax},
+    {"cruise_to_lay",     60000, PRESET_CRUISE, 150, PLANT_SENSOR_NOISE_PSI, NULL, toLay},
+    // Ramp profiles
+    {"lay_to_cruise_comfort", 60000, PRESET_LAY, 150, PLANT_SENSOR_NOISE_PSI, NULL, toCruiseComfort},
+    {"lay_to_cruise_show", 60000, PRESET_LAY,   150, PLANT_SENSOR_NOISE_PSI, NULL, toCruiseShow},
+    {"cruise_to_lay_comfort", 60000, PRESET_CRUISE, 150, PLANT_SENSOR_NOISE_PSI, NULL, toLayComfort},
+    // Same lift from a half-empty tank (slower fill, less coast)
+    {"lay_to_cruise_t100", 60000, PRESET_LAY,   100, PLANT_SENSOR_NOISE_PSI, NULL, toCruise},
+    {"cruise_to_max_t100", 60000, PRESET_CRUISE, 100, PLANT_SENSOR_NOISE_PSI, NULL, toMax},
+    // Tank below TANK_CUTOFF_PSI: lockout, refill, then finish the lift
+    {"lockout_recovery", 600000, PRESET_LAY,     55, PLANT_SENSOR_NOISE_PSI, NULL, toCruise},
+    {"lockout_corners",  600000, PRESET_LAY,     55, PLANT_SENSOR_NOISE_PSI, NULL, cornersToCruise},
+    // Level mode with uneven corner loads
+    {"level_front_asym",  60000, -1,            150, PLANT_SENSOR_NOISE_PSI, asymmetricLoads, levelFront},
+    {"level_all_asym",    60000, -1,            150, PLANT_SENSOR_NOISE_PSI, asymmetricLoads, levelAll},
+    {"level_front_drive", 60000, PRESET_CRUISE, 150, PLANT_SENSOR_NOISE_PSI, driveway, levelFront},
+    {"level_all_drive",   60000, PRESET_CRUISE, 150, PLANT_SENSOR_NOISE_PSI, driveway, levelAll},
+    {"level_all_noisy",  120000, PRESET_CRUISE, 150, 0.6, driveway, levelAll},
+    // Holding Cruise while sensor noise increases (valve chatter)
+    {"noise_0.1_hold",   120000, PRESET_CRUISE, 150, 0.1, NULL, holdCurrent},
+    {"noise_0.3_hold",   120000, PRESET_CRUISE, 150, 0.3, NULL, holdCurrent},
+    {"noise_0.6_hold",   120000, PRESET_CRUISE, 150, 0.6, NULL, holdCurrent},
+    {"noise_1.0_hold",   120000, PRESET_CRUISE, 150, 1.0, NULL, holdCurrent},
+    {"noise_1.0_change",  60000, PRESET_LAY,    150, 1.0, NULL, toCruise}
+};
+static const int NUM_SCENARIOS = sizeof(SCENARIOS) / sizeof(SCENARIOS[0]);
+
+// ============================================
+// RUNNER
+// ============================================
+
+struct Result {
+    char name[32];
+    float settleS;
+    float overshootPsi;
+    unsigned long valveEdges;
+    float solenoidS;
+    float airSl;
+    float pumpS;
+    float spreadPct;
+};
+
+static Result runScenario(const Scenario& sc) {
+    PneumaticPlant plant;
+    HostBoard::reset();
+    HostBoard::attachPlant(&plant);
+    randomSeed(1);
+
+    plant.setNoise(sc.noisePsi);
+    plant.setTankPressure(sc.tankPsi);
+    if (sc.startPreset >= 0) {
+        const Preset& p = DEFAULT_PRESETS[sc.startPreset];
+        plant.setBagPressure(FRONT_LEFT, p.frontLeft);
+        plant.setBagPressure(FRONT_RIGHT, p.frontRight);
+        plant.setBagPressure(REAR_LEFT, p.rearLeft);
+        plant.setBagPressure(REAR_RIGHT, p.rearRight);
+    }
+    if (sc.setup) sc.setup(plant);
+
+    // Fresh control core, same bring-up order as setup()
+    bags[FRONT_LEFT]  = AirBag(FRONT_LEFT_PRESSURE_PIN,  FRONT_LEFT_INFLATE_PIN,  FRONT_LEFT_DEFLATE_PIN,  "FL");
+    bags[FRONT_RIGHT] = AirBag(FRONT_RIGHT_PRESSURE_PIN, FRONT_RIGHT_INFLATE_PIN, FRONT_RIGHT_DEFLATE_PIN, "FR");
+    bags[REAR_LEFT]   = AirBag(REAR_LEFT_PRESSURE_PIN,   REAR_LEFT_INFLATE_PIN,   REAR_LEFT_DEFLATE_PIN,   "RL");
+    bags[REAR_RIGHT]  = AirBag(REAR_RIGHT_PRESSURE_PIN,  REAR_RIGHT_INFLATE_PIN,  REAR_RIGHT_DEFLATE_PIN,  "RR");
+    compressor = Compressor(PUMP_1_PIN, PUMP_2_PIN);
+    controller = RideController(bags, &compressor);
+    EEPROM.clear();     // No targets restored from the previous scenario
+    for (int i = 0; i < NUM_BAGS; i++) {
+        bags[i].begin();
+    }
+    compressor.begin();
+    controller.begin();
+    plant.resetStats();
+
+    float startPsi[NUM_BAGS];
+    for (int i = 0; i < NUM_BAGS; i++) {
+        startPsi[i] = plant.getBagPressure(i);
+    }
+
+    sc.command();
+
+    // Sampled once per control tick on the true (plant) pressures
+    static float history[NUM_BAGS][600000 / CONTROL_INTERVAL_ACTIVE_MS + 1];
+    static unsigned long historyMs[600000 / CONTROL_INTERVAL_ACTIVE_MS + 1];
+    int samples = 0;
+    unsigned long startMs = millis();
+    while (millis() - startMs < sc.durationMs) {
+        HostBoard::advance(1);
+        if (controller.update()) {
+            for (int i = 0; i < NUM_BAGS; i++) {
+                history[i][samples] = plant.getBagPressure(i);
+            }
+            historyMs[samples] = millis() - startMs;
+            samples++;
+        }
+    }
+
+    Result r;
+    snprintf(r.name, sizeof(r.name), "%s", sc.name);
+
+    // Scored against the final targets (level mode moves them)
+    int lastOutside = -1;
+    r.overshootPsi = 0;
+    for (int i = 0; i < NUM_BAGS; i++) {
+        float target = bags[i].getTargetPressure();
+        float dir = (target > startPsi[i] + SETTLE_BAND_PSI) ? 1 : (target < startPsi[i] - SETTLE_BAND_PSI) ? -1 : 0;
+        for (int n = 0; n < samples; n++) {
+            float err = history[i][n] - target;
+            if (abs(err) > SETTLE_BAND_PSI && n > lastOutside) lastOutside = n;
+            // Overshoot past target while travelling; excursion outside the band while holding
+            float over = (dir != 0) ? err * dir : abs(err) - SETTLE_BAND_PSI;
+            if (over > r.overshootPsi) r.overshootPsi = over;
+        }
+    }
+    // Progress of each corner that travels, as a fraction of its own move
+    r.spreadPct = 0;
+    for (int n = 0; n < samples; n++) {
+        float lo = 1, hi = 0;
+        for (int i = 0; i < NUM_BAGS; i++) {
+            float travel = bags[i].getTargetPressure() - startPsi[i];
+            if (abs(travel) <= SETTLE_BAND_PSI) continue;
+            float progress = constrain((history[i][n] - startPsi[i]) / travel, 0.0f, 1.0f);
+            lo = min(lo, progress);
+            hi = max(hi, progress);
+        }
+        if (hi - lo > r.spreadPct) r.spreadPct = hi - lo;
+    }
+    r.spreadPct *= 100;
+
+    if (lastOutside == samples - 1) {
+        r.settleS = -1;
+    } else {
+        r.settleS = (lastOutside >= 0 ? historyMs[lastOutside] : 0) / 1000.0;
+    }
+
+    const PlantStats& st = plant.getStats();
+    r.valveEdges = st.valveTransitions;
+    r.solenoidS = st.solenoidOnS;
+    r.airSl = st.tankDrawnKg / STD_AIR_KG_PER_L;
+    r.pumpS = st.pumpOnS;
+    return r;
+}
+
+// ============================================
+// OUTPUT
+// ============================================
+
+static const char* CSV_HEADER = "scenario,settle_s,overshoot_psi,valve_edges,solenoid_s,air_sl,pump_s,spread_pct";
+
+static void writeCsv(FILE* f, const Result* results, int count) {
+    fprintf(f, "%s\n", CSV_HEADER);
+    for (int n = 0; n < count; n++) {
+        const Result& r = results[n];
+        fprintf(f, "%s,%.1f,%.2f,%lu,%.1f,%.1f,%.1f,%.0f\n",
+                r.name, r.settleS, r.overshootPsi, r.valveEdges, r.solenoidS, r.airSl, r.pumpS, r.spreadPct);
+    }
+}
+
+static int readCsv(const char* path, Result* results, int max) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    char line[256];
+    int count = 0;
+    while (count < max && fgets(line, sizeof(line), f)) {
+        Result& r = results[count];
+        if (sscanf(line, "%31[^,],%f,%f,%lu,%f,%f,%f,%f", r.name, &r.settleS, &r.overshootPsi,
+                   &r.valveEdges, &r.solenoidS, &r.airSl, &r.pumpS, &r.spreadPct) == 8) {
+            count++;
+        }
+    }
+    fclose(f);
+    return count;
+}
+
+static const Result* findResult(const Result* results, int count, const char* name) {
+    for (int n = 0; n < count; n++) {
+        if (strcmp(results[n].name, name) == 0) return &results[n];
+    }
+    return NULL;
+}
+
+int main(int argc, char** argv) {
+    const char* csvPath = NULL;
+    const char* baselinePath = NULL;
+    const char* only = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+            csvPath = argv[++i];
+        } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baselinePath = argv[++i];
+        } else if (strcmp(argv[i], "--only") == 0 && i + 1 < argc) {
+            only = argv[++i];
+        } else {
+            fprintf(stderr, "Usage: %s [--csv <file>] [--baseline <file>] [--only <name>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    Result baseline[NUM_SCENARIOS];
+    int baselineCount = 0;
+    if (baselinePath) {
+        baselineCount = readCsv(baselinePath, baseline, NUM_SCENARIOS);
+        if (baselineCount < 0) return 1;
+    }
+
+    EEPROM.begin(EEPROM_SIZE);
+    Serial.setEcho(false);
+
+    Result results[NUM_SCENARIOS];
+    int count = 0;
+    printf("%-18s %9s %9s %11s %10s %8s %8s %7s\n",
+           "scenario", "settle_s", "overshoot", "valve_edges", "solenoid_s", "air_sl", "pump_s", "spread");
+    for (int n = 0; n < NUM_SCENARIOS; n++) {
+        if (only && !strstr(SCENARIOS[n].name, only)) continue;
+        Result& r = results[count++] = runScenario(SCENARIOS[n]);
+        printf("%-18s %9.1f %9.2f %11lu %10.1f %8.1f %8.1f %6.0f%%\n",
+               r.name, r.settleS, r.overshootPsi, r.valveEdges, r.solenoidS, r.airSl, r.pumpS, r.spreadPct);
+
+        const Result* b = findResult(baseline, baselineCount, r.name);
+        if (b) {
+            printf("%-18s %+9.1f %+9.2f %+11ld %+10.1f %+8.1f %+8.1f %+6.0f%%\n", "  vs baseline",
+                   r.settleS - b->settleS, r.overshootPsi - b->overshootPsi,
+                   (long)r.valveEdges - (long)b->valveEdges, r.solenoidS - b->solenoidS,
+                   r.airSl - b->airSl, r.pumpS - b->pumpS, r.spreadPct - b->spreadPct);
+        }
+    }
+
+    if (csvPath) {
+        FILE* f = fopen(csvPath, "w");
+        if (!f) {
+            perror(csvPath);
+            return 1;
+        }
+        writeCsv(f, results, count);
+        fclose(f);
+    }
+    return 0;
+}
@@ -0,0 +1,198 @@
+// ============================================
+// PLANT PARAMETER FIT
+// ============================================
+// Fits PneumaticPlant parameters to telemetry recorded from the car
+// (serial 'G' command, or sim --telemetry). The recorded valve/pump
+// states are replayed into the plant and the parameters adjusted until
+// its pressures, smoothed like the firmware's, best match the log.
+//
+// Build & run: pio run -e native-fit && .pio/build/native-fit/program <telemetry.csv>
+//   --passes <n>    Maximum coordinate-search passes (default 40)
+//
+// Prints PLANT_* #defines to paste into config.h.
+
+#include <Arduino.h>
+#include <vector>
+#include "config.h"
+#include "PneumaticPlant.h"
+
+struct Row {
+    unsigned long ms;
+    float psi[NUM_BAGS + 1];    // Tank, then FL, FR, RL, RR
+    uint8_t valves;
+    uint8_t pumps;
+};
+
+static const uint8_t INFLATE_PINS[NUM_BAGS] = {
+    FRONT_LEFT_INFLATE_PIN, FRONT_RIGHT_INFLATE_PIN, REAR_LEFT_INFLATE_PIN, REAR_RIGHT_INFLATE_PIN
+};
+static const uint8_t DEFLATE_PINS[NUM_BAGS] = {
+    FRONT_LEFT_DEFLATE_PIN, FRONT_RIGHT_DEFLATE_PIN, REAR_LEFT_DEFLATE_PIN, REAR_RIGHT_DEFLATE_PIN
+};
+static const uint8_t PRESSURE_PINS[NUM_BAGS + 1] = {
+    TANK_PRESSURE_PIN,
+    FRONT_LEFT_PRESSURE_PIN, FRONT_RIGHT_PRESSURE_PIN, REAR_LEFT_PRESSURE_PIN, REAR_RIGHT_PRESSURE_PIN
+};
+
+// Same conversion the firmware applies (uncalibrated sensor)
+static float countsToPsi(int counts) {
+    float voltage = (counts / ADC_RESOLUTION) * ADC_REFERENCE_VOLTAGE;
+    float resistance;
+    if (voltage >= ADC_REFERENCE_VOLTAGE - 0.01) {
+        resistance = SENSOR_MAX_OHMS;
+    } else if (voltage <= 0.01) {
+        resistance = SENSOR_MIN_OHMS;
+    } else {
+        resistance = REFERENCE_RESISTOR * voltage / (ADC_REFERENCE_VOLTAGE - voltage);
+    }
+    resistance = constrain(resistance, (float)SENSOR_MIN_OHMS, (float)SENSOR_MAX_OHMS);
+    return ((resistance - SENSOR_MIN_OHMS) / (SENSOR_MAX_OHMS - SENSOR_MIN_OHMS)) * SENSOR_MAX_PSI;
+}
+
+static bool loadTelemetry(const char* path, std::vector<Row>& rows) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        Row r;
+        unsigned valves, pumps;
+        if (sscanf(line, "%lu,%f,%f,%f,%f,%f,%u,%u", &r.ms, &r.psi[0], &r.psi[1], &r.psi[2],
+                   &r.psi[3], &r.psi[4], &valves, &pumps) == 8) {
+            r.valves = valves;
+            r.pumps = pumps;
+            rows.push_back(r);
+        }
+        // Header, log messages and blank lines are skipped
+    }
+    fclose(f);
+    return true;
+}
+
+// Replay the log through the plant; sum of squared errors of the smoothed readings
+static double replayError(const PlantParams& params, const std::vector<Row>& rows) {
+    PneumaticPlant plant;
+    PlantParams p = params;
+    p.noisePsi = 0;
+    p.inrushSagPsi = 0;
+    plant.setParams(p);
+    plant.setTankPressure(rows[0].psi[0]);
+    for (int i = 0; i < NUM_BAGS; i++) {
+        plant.setBagPressure(i, rows[0].psi[i + 1]);
+    }
+
+    float window[NUM_BAGS + 1][PRESSURE_SAMPLES];
+    for (int s = 0; s <= NUM_BAGS; s++) {
+        for (int k = 0; k < PRESSURE_SAMPLES; k++) window[s][k] = rows[0].psi[s];
+    }
+
+    double error = 0;
+    for (size_t n = 1; n < rows.size(); n++) {
+        const Row& prev = rows[n - 1];
+        for (int i = 0; i < NUM_BAGS; i++) {
+            plant.writePin(INFLATE_PINS[i], (prev.valves & (1 << (2 * i))) ? RELAY_ON : RELAY_OFF);
+            plant.writePin(DEFLATE_PINS[i], (prev.valves & (1 << (2 * i + 1))) ? RELAY_ON : RELAY_OFF);
+        }
+        plant.writePin(PUMP_1_PIN, (prev.pumps & 1) ? RELAY_ON : RELAY_OFF);
+        plant.writePin(PUMP_2_PIN, (prev.pumps & 2) ? RELAY_ON : RELAY_OFF);
+        plant.advance((rows[n].ms - prev.ms) / 1000.0f);
+
+        for (int s = 0; s <= NUM_BAGS; s++) {
+            window[s][n % PRESSURE_SAMPLES] = countsToPsi(plant.readAdc(PRESSURE_PINS[s]));
+            float sum = 0;
+            for (int k = 0; k < PRESSURE_SAMPLES; k++) sum += window[s][k];
+            float e = sum / PRESSURE_SAMPLES - rows[n].psi[s];
+            error += e * e;
+        }
+    }
+    return error;
+}
+
+// Parameters adjusted by the fit (log-scale coordinate search)
+static std::vector<float*> fitted(PlantParams& p) {
+    std::vector<float*> v;
+    v.push_back(&p.tankVolumeL);
+    v.push_back(&p.pumpFreeCfm);
+    for (int i = 0; i < NUM_BAGS; i++) {
+        v.push_back(&p.inflateCdAmm2[i]);
+        v.push_back(&p.deflateCdAmm2[i]);
+        v.push_back(&p.loadLbf[i]);
+    }
+    return v;
+}
+
+int main(int argc, char** argv) {
+    const char* path = NULL;
+    int maxPasses = 40;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--passes") == 0 && i + 1 < argc) {
+            maxPasses = atoi(argv[++i]);
+        } else if (argv[i][0] != '-' && !path) {
+            path = argv[i];
+        } else {
+            fprintf(stderr, "Usage: %s [--passes <n>] <telemetry.csv>\n", argv[0]);
+            return 2;
+        }
+    }
+    if (!path) {
+        fprintf(stderr, "Usage: %s [--passes <n>] <telemetry.csv>\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<Row> rows;
+    if (!loadTelemetry(path, rows)) return 1;
+    if (rows.size() < 2 * PRESSURE_SAMPLES) {
+        fprintf(stderr, "%s: only %u telemetry rows\n", path, (unsigned)rows.size());
+        return 1;
+    }
+
+    PlantParams best;
+    best.setDefaults();
+    double bestError = replayError(best, rows);
+    double samples = (double)(rows.size() - 1) * (NUM_BAGS + 1);
+    printf("Loaded %u rows (%.1f min), default RMS error %.2f PSI\n",
+           (unsigned)rows.size(), (rows.back().ms - rows[0].ms) / 60000.0, sqrt(bestError / samples));
+
+    float scale = 0.5;
+    for (int pass = 0; pass < maxPasses && scale > 0.002; pass++) {
+        bool improved = false;
+        int count = (int)fitted(best).size();
+        for (int k = 0; k < count; k++) {
+            for (int dir = -1; dir <= 1; dir += 2) {
+                PlantParams trial = best;
+                float* value = fitted(trial)[k];
+                *value *= (dir > 0) ? (1.0f + scale) : 1.0f / (1.0f + scale);
+                double e = replayError(trial, rows);
+                if (e < bestError) {
+                    best = trial;
+                    bestError = e;
+                    improved = true;
+                    break;
+                }
+            }
+        }
+        if (!improved) scale *= 0.5f;
+        printf("Pass %d: RMS %.3f PSI (step %.1f%%)\n", pass + 1, sqrt(bestError / samples), scale * 100);
+    }
+
+    printf("\n// Fitted from %s\n", path);
+    printf("#define PLANT_TANK_VOLUME_L         %.1f\n", best.tankVolumeL);
+    printf("#define PLANT_FRONT_LOAD_LBF        %.0f\n", (best.loadLbf[FRONT_LEFT] + best.loadLbf[FRONT_RIGHT]) / 2);
+    printf("#define PLANT_REAR_LOAD_LBF         %.0f\n", (best.loadLbf[REAR_LEFT] + best.loadLbf[REAR_RIGHT]) / 2);
+    printf("#define PLANT_INFLATE_CDA_MM2       %.2f\n",
+           (best.inflateCdAmm2[0] + best.inflateCdAmm2[1] + best.inflateCdAmm2[2] + best.inflateCdAmm2[3]) / 4);
+    printf("#define PLANT_DEFLATE_CDA_MM2       %.2f\n",
+           (best.deflateCdAmm2[0] + best.deflateCdAmm2[1] + best.deflateCdAmm2[2] + best.deflateCdAmm2[3]) / 4);
+    printf("#define PLANT_PUMP_FREE_CFM         %.2f\n", best.pumpFreeCfm);
+    printf("\n// Per corner (FL, FR, RL, RR)\n");
+    printf("//   load    %.0f %.0f %.0f %.0f lbf\n",
+           best.loadLbf[0], best.loadLbf[1], best.loadLbf[2], best.loadLbf[3]);
+    printf("//   inflate %.2f %.2f %.2f %.2f mm2\n",
+           best.inflateCdAmm2[0], best.inflateCdAmm2[1], best.inflateCdAmm2[2], best.inflateCdAmm2[3]);
+    printf("//   deflate %.2f %.2f %.2f %.2f mm2\n",
+           best.deflateCdAmm2[0], best.deflateCdAmm2[1], best.deflateCdAmm2[2], best.deflateCdAmm2[3]);
+    return 0;
+}
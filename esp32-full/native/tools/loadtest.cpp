@@ -0,0 +1,464 @@
+// ============================================
+// HTTP LOAD HARNESS
+// ============================================
+// Serves AirRideWebServer's real route table on a loopback socket while
+// the control core runs against the simulated plant in real time, and
+// drives it with the client mix the phone UI produces:
+//   every phone   /s every 400 ms, /leak every 5 s
+//   phone 1       hold-button bursts: /b press, /bh release 600 ms later
+//   phone 2       preset storms: five /p requests 150 ms apart
+//   phone 3       calibration page open: /cal every second
+// Phones beyond MAX_WIFI_CLIENTS are refused by the soft-AP, as on the
+// car. The firmware side runs single-threaded like loop(), so slow
+// handlers show up both as request latency and as control-tick delay.
+// The serial console is polled in the same loop while a host feeds it a
+// stray 0x00, a frame cut off mid-way and an over-long frame, each
+// followed by a text command that must still run.
+//
+// Build & run: pio run -e native-loadtest && .pio/build/native-loadtest/program [options]
+//   --seconds <s>      Test duration (default 30)
+//   --phones <n>       Connected UIs (default MAX_WIFI_CLIENTS)
+//   --ignore-ap-limit  Let phones beyond MAX_WIFI_CLIENTS connect
+//   --slowdown <x>     Stretch firmware work x times to approximate the
+//                      ESP32's slower CPU (default 1 = host speed)
+//   --csv <file>       Write per-route results as CSV
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <WiFi.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include "config.h"
+#include "AirBag.h"
+#include "Compressor.h"
+#include "RideController.h"
+#include "AirRideWebServer.h"
+#include "SolenoidGuard.h"
+#include "SerialConsole.h"
+#include "HostBoard.h"
+#include "PneumaticPlant.h"
+
+AirBag bags[NUM_BAGS] = {
+    AirBag(FRONT_LEFT_PRESSURE_PIN,  FRONT_LEFT_INFLATE_PIN,  FRONT_LEFT_DEFLATE_PIN,  "FL"),
+    AirBag(FRONT_RIGHT_PRESSURE_PIN, FRONT_RIGHT_INFLATE_PIN, FRONT_RIGHT_DEFLATE_PIN, "FR"),
+    AirBag(REAR_LEFT_PRESSURE_PIN,   REAR_LEFT_INFLATE_PIN,   REAR_LEFT_DEFLATE_PIN,   "RL"),
+    AirBag(REAR_RIGHT_PRESSURE_PIN,  REAR_RIGHT_INFLATE_PIN,  REAR_RIGHT_DEFLATE_PIN,  "RR")
+};
+
+Compressor compressor(PUMP_1_PIN, PUMP_2_PIN);
+RideController controller(bags, &compressor);
+AirRideWebServer webServer(bags, &compressor, &controller);
+
+// Console with one probe command: counts the lines that got through
+static int consoleCommandsRun = 0;
+static void cmdProbe(const char* arg) { consoleCommandsRun++; }
+static const ConsoleCommand PROBE_COMMANDS[] = { {"S", cmdProbe} };
+SerialConsole console(PROBE_COMMANDS, 1);
+
+static const unsigned long UI_TIMEOUT_MS = 1000;    // fetch() AbortSignal.timeout in airService.ts
+static const unsigned long STATUS_POLL_MS = 400;
+static const unsigned long LEAK_POLL_MS = 5000;
+static const unsigned long HOLD_PERIOD_MS = 4000;
+static const unsigned long HOLD_PRESS_MS = 600;
+static const unsigned long STORM_PERIOD_MS = 6000;
+static const unsigned long STORM_GAP_MS = 150;
+static const int STORM_REQUESTS = 5;
+static const unsigned long CAL_POLL_MS = 1000;
+static const float LATE_TICK_MS = 50;               // Ticks this late are counted separately
+
+typedef std::chrono::steady_clock WallClock;
+static WallClock::time_point wallStart;
+
+static double wallMs() {
+    return std::chrono::duration<double, std::milli>(WallClock::now() - wallStart).count();
+}
+
+static void sleepMs(double ms) {
+    if (ms > 0) std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(ms));
+}
+
+// ============================================
+// RESULTS
+// ============================================
+
+struct RouteStats {
+    char route[16];
+    std::vector<double> latencyMs;
+    unsigned long errors;       // Refused, reset or non-200
+    unsigned long timeouts;     // Slower than the UI's fetch timeout
+};
+
+static std::mutex statsMutex;
+static std::vector<RouteStats> routeStats;
+
+static void record(const char* target, double ms, bool ok) {
+    char route[16];
+    size_t n = strcspn(target, "?");
+    if (n >= sizeof(route)) n = sizeof(route) - 1;
+    memcpy(route, target, n);
+    route[n] = 0;
+
+    std::lock_guard<std::mutex> lock(statsMutex);
+    RouteStats* s = NULL;
+    for (size_t i = 0; i < routeStats.size(); i++) {
+        if (strcmp(routeStats[i].route, route) == 0) s = &routeStats[i];
+    }
+    if (!s) {
+        routeStats.push_back(RouteStats());
+        s = &routeStats.back();
+        snprintf(s->route, sizeof(s->route), "%s", route);
+        s->errors = 0;
+        s->timeouts = 0;
+    }
+    if (!ok) {
+        s->errors++;
+        return;
+    }
+    s->latencyMs.push_back(ms);
+    if (ms > UI_TIMEOUT_MS) s->timeouts++;
+}
+
+static double percentile(std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t index = (size_t)(p * (sorted.size() - 1) + 0.5);
+    return sorted[index];
+}
+
+// ============================================
+// CLIENTS
+// ============================================
+
+static int serverPort;
+static std::atomic<bool> stopping(false);
+static std::atomic<int> activeClients(0);
+
+// One request on its own connection, as the browser does against the
+// ESP32 (the server closes after every response)
+static void get(const char* target) {
+    double start = wallMs();
+    bool ok = false;
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons((uint16_t)serverPort);
+    if (fd >= 0) {
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+
+    if (fd >= 0 && connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0) {
+        char request[256];
+        int length = snprintf(request, sizeof(request),
+                              "GET %s HTTP/1.1\r\nHost: 192.168.4.1\r\nConnection: close\r\n\r\n", target);
+        if (send(fd, request, length, MSG_NOSIGNAL) == length) {
+            char buf[4096];
+            char status[16] = {0};
+            size_t total = 0;
+            ssize_t n;
+            while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) {
+                if (total == 0) memcpy(status, buf, n < 15 ? n : 15);
+                total += n;
+            }
+            ok = strncmp(status, "HTTP/1.1 200", 12) == 0;
+        }
+    }
+    if (fd >= 0) close(fd);
+    record(target, wallMs() - start, ok);
+}
+
+// Fires each periodic request when due; the role adds its own pattern
+struct Schedule {
+    double next;
+    unsigned long period;
+};
+
+static void runPhone(int phone) {
+    // Stagger phones so they don't all poll in the same millisecond
+    double offset = phone * 97.0;
+    Schedule status = { offset, STATUS_POLL_MS };
+    Schedule leak = { offset + 50, LEAK_POLL_MS };
+    Schedule hold = { offset + 1000, HOLD_PERIOD_MS };
+    Schedule storm = { offset + 2000, STORM_PERIOD_MS };
+    Schedule cal = { offset + 300, CAL_POLL_MS };
+    int holdBag = 0;
+    int stormPreset = 0;
+    char target[64];
+
+    while (!stopping) {
+        double now = wallMs();
+        if (now >= status.next) {
+            get("/s");
+            status.next += status.period;
+        }
+        if (now >= leak.next) {
+            get("/leak");
+            leak.next += leak.period;
+        }
+        if (phone == 1 && now >= hold.next) {
+            int dir = (holdBag & 1) ? -1 : 1;
+            snprintf(target, sizeof(target), "/b?n=%d&d=%d&h=1", holdBag % NUM_BAGS, dir);
+            get(target);
+            sleepMs(HOLD_PRESS_MS);
+            snprintf(target, sizeof(target), "/bh?n=%d", holdBag % NUM_BAGS);
+            get(target);
+            holdBag++;
+            hold.next += hold.period;
+        }
+        if (phone == 2 && now >= storm.next) {
+            for (int i = 0; i < STORM_REQUESTS; i++) {
+                snprintf(target, sizeof(target), "/p?n=%d", stormPreset++ % NUM_PRESETS);
+                get(target);
+                sleepMs(STORM_GAP_MS);
+            }
+            storm.next += storm.period;
+        }
+        if (phone == 3 && now >= cal.next) {
+            get("/cal");
+            cal.next += cal.period;
+        }
+        sleepMs(5);
+    }
+    activeClients--;
+}
+
+// ============================================
+// FIRMWARE LOOP
+// ============================================
+
+// Run fn, then spin so it takes `slowdown` times as long
+static double runStretched(void (*fn)(), double slowdown) {
+    double start = wallMs();
+    fn();
+    double spent = wallMs() - start;
+    double until = start + spent * slowdown;
+    while (wallMs() < until) {
+    }
+    return spent * slowdown;
+}
+
+// ============================================
+// SERIAL HOST
+// ============================================
+
+// Link garbage, then a text command LINK_FRAME_GAP_MS+ later
+struct SerialStep {
+    double atMs;
+    const char* what;
+    uint8_t bytes[LINK_MAX_WIRE + 8];
+    size_t length;
+};
+static SerialStep serialSteps[3];
+static int serialStepsSent = 0;
+static double serialProbeAtMs = -1;
+
+static void buildSerialSteps() {
+    SerialStep& noise = serialSteps[0];         // USB attach or a terminal's NUL
+    noise.atMs = 500;
+    noise.what = "stray 0x00";
+    noise.bytes[0] = 0x00;
+    noise.length = 1;
+
+    SerialStep& cut = serialSteps[1];           // Host killed mid-frame
+    cut.atMs = 1500;
+    cut.what = "cut-off frame";
+    cut.bytes[0] = 0x00;
+    for (int i = 1; i <= 12; i++) cut.bytes[i] = (uint8_t)(0x40 + i);
+    cut.length = 13;
+
+    SerialStep& longFrame = serialSteps[2];     // No closing delimiter in reach
+    longFrame.atMs = 2500;
+    longFrame.what = "over-long frame";
+    longFrame.bytes[0] = 0x00;
+    for (int i = 1; i <= LINK_MAX_ENCODED + 4; i++) longFrame.bytes[i] = 'x';
+    longFrame.bytes[LINK_MAX_ENCODED + 5] = '\n';
+    longFrame.length = LINK_MAX_ENCODED + 6;
+}
+
+// Runs on the firmware thread (the serial shim isn't shared)
+static void feedSerial(double now) {
+    if (serialProbeAtMs >= 0 && now >= serialProbeAtMs) {
+        Serial.inject("S\n");
+        serialProbeAtMs = -1;
+    }
+    if (serialStepsSent < 3 && now >= serialSteps[serialStepsSent].atMs) {
+        SerialStep& step = serialSteps[serialStepsSent++];
+        Serial.inject(step.bytes, step.length);
+        serialProbeAtMs = now + 2 * LINK_FRAME_GAP_MS;
+    }
+}
+
+static bool tickRan;
+static ControlRate tickRate;       // Control rate the tick was due at
+static void serveWeb() { webServer.update(); }
+static void pollConsole() { console.poll(); }
+static void runControl() {
+    tickRan = controller.update();
+    tickRate = controller.getControlRate();
+}
+
+int main(int argc, char** argv) {
+    double seconds = 30;
+    int phones = MAX_WIFI_CLIENTS;
+    bool ignoreApLimit = false;
+    double slowdown = 1;
+    const char* csvPath = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--phones") == 0 && i + 1 < argc) {
+            phones = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--ignore-ap-limit") == 0) {
+            ignoreApLimit = true;
+        } else if (strcmp(argv[i], "--slowdown") == 0 && i + 1 < argc) {
+            slowdown = atof(argv[++i]);
+            if (slowdown < 1) slowdown = 1;
+        } else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+            csvPath = argv[++i];
+        } else {
+            fprintf(stderr, "Usage: %s [--seconds <s>] [--phones <n>] [--ignore-ap-limit] [--slowdown <x>] [--csv <file>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    PneumaticPlant plant;
+    HostBoard::reset();
+    HostBoard::attachPlant(&plant);
+    Serial.setEcho(false);
+    demoMode = false;
+
+    // Same bring-up order as setup(), minus OTA/watchdog
+    EEPROM.begin(EEPROM_SIZE);
+    webServer.loadSettings();
+    for (int i = 0; i < NUM_BAGS; i++) {
+        bags[i].begin();
+    }
+    compressor.begin();
+    controller.begin();
+    WebServer::setHostPort(0);
+    webServer.begin();
+    WebServer* server = WebServer::findByPort(80);
+    serverPort = server ? server->getListenPort() : -1;
+    if (serverPort < 0) {
+        fprintf(stderr, "Could not open a loopback socket\n");
+        return 1;
+    }
+    webServer.applyPreset(1);
+    console.setFrameHandler([](const uint8_t*, size_t) {});
+    buildSerialSteps();
+
+    int associated = phones;
+    if (!ignoreApLimit && associated > WiFi.getMaxClients()) {
+        associated = WiFi.getMaxClients();
+        printf("%d phone(s) refused by the soft-AP (MAX_WIFI_CLIENTS = %d)\n",
+               phones - associated, WiFi.getMaxClients());
+    }
+    printf("Serving on 127.0.0.1:%d, %d phone(s), %.0f s, slowdown %.1fx\n",
+           serverPort, associated, seconds, slowdown);
+
+    wallStart = WallClock::now();
+    std::vector<std::thread> clients;
+    activeClients = associated;
+    for (int phone = 0; phone < associated; phone++) {
+        clients.push_back(std::thread(runPhone, phone));
+    }
+
+    // loop(): web, then control, with the virtual clock following the wall
+    std::vector<double> tickLateMs;
+    double lastTick = -1;
+    ControlRate lastTickRate = RATE_IDLE;
+    double busyMs = 0;
+    uint64_t syncedUs = 0;
+    while (activeClients > 0) {
+        if (!stopping && wallMs() >= seconds * 1000.0) stopping = true;
+
+        uint64_t nowUs = (uint64_t)(wallMs() * 1000.0);
+        if (nowUs > syncedUs) {
+            HostBoard::advanceMicros((unsigned long)(nowUs - syncedUs));
+            syncedUs = nowUs;
+        }
+
+        feedSerial(wallMs());
+        busyMs += runStretched(serveWeb, slowdown);
+        busyMs += runStretched(runControl, slowdown);
+        busyMs += runStretched(pollConsole, slowdown);
+        if (tickRan) {
+            double now = wallMs();
+            // Ticks across a rate switch have no fixed due time
+            if (lastTick >= 0 && tickRate == lastTickRate) {
+                tickLateMs.push_back(now - lastTick - controller.getControlIntervalMs());
+            }
+            lastTick = now;
+            lastTickRate = tickRate;
+        }
+        sleepMs(0.1);
+    }
+    for (size_t i = 0; i < clients.size(); i++) {
+        clients[i].join();
+    }
+    double elapsedS = wallMs() / 1000.0;
+
+    // Report
+    unsigned long completed = 0;
+    printf("\n%-8s %7s %6s %8s %8s %8s %8s %8s\n",
+           "route", "count", "errors", "timeouts", "p50_ms", "p90_ms", "p99_ms", "max_ms");
+    for (size_t i = 0; i < routeStats.size(); i++) {
+        RouteStats& s = routeStats[i];
+        std::sort(s.latencyMs.begin(), s.latencyMs.end());
+        completed += s.latencyMs.size();
+        printf("%-8s %7zu %6lu %8lu %8.2f %8.2f %8.2f %8.2f\n",
+               s.route, s.latencyMs.size(), s.errors, s.timeouts,
+               percentile(s.latencyMs, 0.50), percentile(s.latencyMs, 0.90),
+               percentile(s.latencyMs, 0.99), s.latencyMs.empty() ? 0.0 : s.latencyMs.back());
+    }
+    printf("\nThroughput: %.1f req/s, firmware busy %.1f%% of wall time\n",
+           completed / elapsedS, busyMs / (elapsedS * 10.0));
+
+    std::sort(tickLateMs.begin(), tickLateMs.end());
+    unsigned long lateTicks = 0;
+    for (size_t i = 0; i < tickLateMs.size(); i++) {
+        if (tickLateMs[i] > LATE_TICK_MS) lateTicks++;
+    }
+    printf("Control tick delay: p50 %.2f ms, p99 %.2f ms, max %.2f ms, %lu of %zu ticks > %.0f ms late\n",
+           percentile(tickLateMs, 0.50), percentile(tickLateMs, 0.99),
+           tickLateMs.empty() ? 0.0 : tickLateMs.back(), lateTicks, tickLateMs.size(), LATE_TICK_MS);
+    printf("Solenoid dead-man trips (> %d ms without a tick): %lu\n",
+           SOLENOID_GUARD_MS, solenoidGuard.getTripCount());
+    printf("Serial console after");
+    for (int i = 0; i < serialStepsSent; i++) {
+        printf("%s %s", i == 0 ? "" : (i == serialStepsSent - 1 ? " and" : ","), serialSteps[i].what);
+    }
+    printf(": %d of %d text commands ran\n", consoleCommandsRun, serialStepsSent);
+
+    if (csvPath) {
+        FILE* f = fopen(csvPath, "w");
+        if (!f) {
+            perror(csvPath);
+            return 1;
+        }
+        fprintf(f, "route,count,errors,timeouts,p50_ms,p90_ms,p99_ms,max_ms\n");
+        for (size_t i = 0; i < routeStats.size(); i++) {
+            RouteStats& s = routeStats[i];
+            fprintf(f, "%s,%zu,%lu,%lu,%.2f,%.2f,%.2f,%.2f\n",
+                    s.route, s.latencyMs.size(), s.errors, s.timeouts,
+                    percentile(s.latencyMs, 0.50), percentile(s.latencyMs, 0.90),
+                    percentile(s.latencyMs, 0.99), s.latencyMs.empty() ? 0.0 : s.latencyMs.back());
+        }
+        fprintf(f, "tick_delay,%zu,0,%lu,%.2f,%.2f,%.2f,%.2f\n",
+                tickLateMs.size(), lateTicks, percentile(tickLateMs, 0.50), percentile(tickLateMs, 0.90),
+                percentile(tickLateMs, 0.99), tickLateMs.empty() ? 0.0 : tickLateMs.back());
+        fclose(f);
+    }
+    return 0;
+}
@@ -0,0 +1,379 @@
+// ============================================
+// FIRMWARE MICROBENCHMARKS
+// ============================================
+// Times the per-sample, per-tick and per-request hot paths of the
+// firmware on the host, so a change can be checked for making the 100 ms
+// tick (or a status poll) cheaper or more expensive:
+//   ns_op      Median wall time per call over several timed batches
+//   allocs_op  Heap allocations per call (String buffers + operator new)
+//
+// Sensors read from a fixed plant (no physics or noise generation), so
+// the numbers are the firmware's own cost. Web routes are dispatched
+// in-process through the host WebServer, including argument parsing.
+//
+// Build & run: pio run -e native-microbench && .pio/build/native-microbench/program [options]
+//   --csv <file>       Write results as CSV
+//   --baseline <file>  Compare against a previous --csv result and flag
+//                      regressions (native/microbench_baseline.csv is the
+//                      committed reference; exit status 1 if any).
+//                      ns/op only compares on the same machine - record a
+//                      local baseline first; allocs/op compares anywhere.
+//   --only <name>      Run benchmarks whose name contains <name>
+//   --min-ms <n>       Minimum time per timed batch (default 20)
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <chrono>
+#include <new>
+#include "config.h"
+#include "AirBag.h"
+#include "Compressor.h"
+#include "Actuators.h"
+#include "RideController.h"
+#include "AirRideWebServer.h"
+#include "HostBoard.h"
+#include "PlantModel.h"
+
+AirBag bags[NUM_BAGS] = {
+    AirBag(FRONT_LEFT_PRESSURE_PIN,  FRONT_LEFT_INFLATE_PIN,  FRONT_LEFT_DEFLATE_PIN,  "FL"),
+    AirBag(FRONT_RIGHT_PRESSURE_PIN, FRONT_RIGHT_INFLATE_PIN, FRONT_RIGHT_DEFLATE_PIN, "FR"),
+    AirBag(REAR_LEFT_PRESSURE_PIN,   REAR_LEFT_INFLATE_PIN,   REAR_LEFT_DEFLATE_PIN,   "RL"),
+    AirBag(REAR_RIGHT_PRESSURE_PIN,  REAR_RIGHT_INFLATE_PIN,  REAR_RIGHT_DEFLATE_PIN,  "RR")
+};
+
+Compressor compressor(PUMP_1_PIN, PUMP_2_PIN);
+RideController controller(bags, &compressor);
+AirRideWebServer webServer(bags, &compressor, &controller);
+
+static const float REGRESSION_RATIO = 1.25;   // Flag ns/op more than 25% over baseline
+static const int TIMED_BATCHES = 5;
+
+// Count every operator new alongside String's malloc/realloc calls
+void* operator new(size_t size) {
+    HostHeap::allocations++;
+    void* p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t size) noexcept {
+    (void)size;
+    free(p);
+}
+
+// ============================================
+// FIXED PLANT
+// ============================================
+// Answers every sensor with a steady pressure plus a one-count dither so
+// smoothing buffers see changing values. Writes are ignored.
+
+class FixedPlant : public PlantModel {
+  public:
+    FixedPlant() : dither(0) {
+        for (int i = 0; i < NUM_BAGS; i++) bagPsi[i] = 0;
+        tankPsi = 0;
+    }
+
+    void set(const float bags[NUM_BAGS], float tank) {
+        for (int i = 0; i < NUM_BAGS; i++) bagPsi[i] = bags[i];
+        tankPsi = tank;
+    }
+
+    void writePin(uint8_t pin, uint8_t level) override {
+        (void)pin;
+        (void)level;
+    }
+    int readAdc(uint8_t pin) override {
+        dither ^= 1;
+        float psi = 0;
+        switch (pin) {
+            case TANK_PRESSURE_PIN:        psi = tankPsi; break;
+            case FRONT_LEFT_PRESSURE_PIN:  psi = bagPsi[FRONT_LEFT]; break;
+            case FRONT_RIGHT_PRESSURE_PIN: psi = bagPsi[FRONT_RIGHT]; break;
+            case REAR_LEFT_PRESSURE_PIN:   psi = bagPsi[REAR_LEFT]; break;
+            case REAR_RIGHT_PRESSURE_PIN:  psi = bagPsi[REAR_RIGHT]; break;
+        }
+        return psiToAdcCounts(psi) + dither;
+    }
+    void advance(float seconds) override { (void)seconds; }
+    float getBagPressure(int bag) const override { return bagPsi[bag]; }
+    float getTankPressure() const override { return tankPsi; }
+
+  private:
+    float bagPsi[NUM_BAGS];
+    float tankPsi;
+    int dither;
+};
+
+static FixedPlant plant;
+
+// Private stages of the control tick
+struct RideControllerProbe {
+    static float readTankPressure() { return controller.readTankPressure(); }
+    static void updateTargetTracking() { controller.updateTargetTracking(); }
+    static void updateLevelMode() {
+        // Bypass the check rate limit and settle wait so every call judges
+        // level (the fixed plant never lets tracking close the valves)
+        for (int i = 0; i < NUM_BAGS; i++) {
+            if (!bags[i].isHolding()) bags[i].hold();
+        }
+        controller.leveler.phase = LEVEL_IDLE;
+        controller.leveler.lastCheckMs = millis() - LEVEL_ADJUST_STEP_MS;
+        controller.leveler.quietSinceMs = millis() - LEVEL_SETTLE_MS;
+        controller.updateLevelMode();
+    }
+};
+
+// ============================================
+// BENCHMARKS
+// ============================================
+
+static volatile float sink;     // Keeps results observable to the optimizer
+static WebServer* http;
+
+static void request(const char* target) {
+    if (http->handleRequest(HTTP_GET, target) != 200) {
+        fprintf(stderr, "%s: HTTP %d\n", target, http->getResponseCode());
+        exit(1);
+    }
+}
+
+static void benchReadPressure()         { sink = bags[FRONT_LEFT].readPressure(); }
+static void benchReadPressureSmoothed() { sink = bags[FRONT_LEFT].readPressureSmoothed(); }
+static void benchReadTankPressure()     { sink = RideControllerProbe::readTankPressure(); }
+static void benchUpdateTargetTracking() { RideControllerProbe::updateTargetTracking(); }
+static void benchUpdateLevelMode()      { RideControllerProbe::updateLevelMode(); }
+static void benchCompressorUpdate()     { compressor.update(controller.getTankPressure()); }
+static void benchTick()                 { controller.tick(); }
+
+// All four corners reverse direction in one commit (8 solenoid edges)
+static void benchActuatorCommit() {
+    static const uint8_t inflatePins[NUM_BAGS] = {
+        FRONT_LEFT_INFLATE_PIN, FRONT_RIGHT_INFLATE_PIN, REAR_LEFT_INFLATE_PIN, REAR_RIGHT_INFLATE_PIN
+    };
+    static const uint8_t deflatePins[NUM_BAGS] = {
+        FRONT_LEFT_DEFLATE_PIN, FRONT_RIGHT_DEFLATE_PIN, REAR_LEFT_DEFLATE_PIN, REAR_RIGHT_DEFLATE_PIN
+    };
+    static bool up = false;
+    up = !up;
+    for (int i = 0; i < NUM_BAGS; i++) {
+        actuators.set(inflatePins[i], up);
+        actuators.set(deflatePins[i], !up);
+    }
+    actuators.commit();
+}
+
+static void benchStatus()               { request("/s"); }
+static void benchLeak()                 { request("/leak"); }
+static void benchCalibration()          { request("/cal"); }
+
+struct Benchmark {
+    const char* name;
+    void (*run)();
+};
+
+static const Benchmark BENCHMARKS[] = {
+    {"bag_read_pressure",      benchReadPressure},
+    {"bag_read_smoothed",      benchReadPressureSmoothed},
+    {"tank_read_pressure",     benchReadTankPressure},
+    {"target_tracking",        benchUpdateTargetTracking},
+    {"level_mode_all",         benchUpdateLevelMode},
+    {"compressor_update",      benchCompressorUpdate},
+    {"control_tick",           benchTick},
+    {"actuator_commit",        benchActuatorCommit},
+    {"http_status",            benchStatus},
+    {"http_leak",              benchLeak},
+    {"http_calibration",       benchCalibration}
+};
+static const int NUM_BENCHMARKS = sizeof(BENCHMARKS) / sizeof(BENCHMARKS[0]);
+
+// Steady cruise with a slightly uneven front so level mode has work to do,
+// time synced and a leak snapshot an hour old so /leak renders in full
+static void setupState() {
+    const float cruise[NUM_BAGS] = { 81.0, 78.5, 50.0, 50.0 };
+
+    HostBoard::reset();
+    HostBoard::attachPlant(&plant);
+    plant.set(cruise, 150.0);
+    Serial.setEcho(false);
+    demoMode = false;
+
+    EEPROM.begin(EEPROM_SIZE);
+    EEPROM.clear();
+    webServer.loadSettings();
+    for (int i = 0; i < NUM_BAGS; i++) {
+        bags[i].begin();
+    }
+    compressor.begin();
+    controller.begin();
+    webServer.begin();
+    http = WebServer::findByPort(80);
+
+    const Preset& p = DEFAULT_PRESETS[1];
+    float targets[NUM_BAGS] = { p.frontLeft, p.frontRight, p.rearLeft, p.rearRight };
+    controller.applyTargets(targets);
+    controller.setLevelMode(LEVEL_ALL);
+
+    request("/time?t=1760000000");
+    for (unsigned long t = 0; t <= LEAK_SNAPSHOT_INTERVAL; t += CONTROL_INTERVAL_ACTIVE_MS) {
+        HostBoard::advance(CONTROL_INTERVAL_ACTIVE_MS);
+        controller.update();
+        webServer.update();
+    }
+    HostBoard::setMillis(millis() + 3600000UL);
+}
+
+// ============================================
+// TIMING
+// ============================================
+
+struct Result {
+    char name[32];
+    double nsOp;
+    double allocsOp;
+};
+
+typedef std::chrono::steady_clock BenchClock;
+
+static double timeBatch(void (*run)(), unsigned long iterations) {
+    BenchClock::time_point start = BenchClock::now();
+    for (unsigned long n = 0; n < iterations; n++) {
+        run();
+    }
+    return std::chrono::duration<double, std::nano>(BenchClock::now() - start).count();
+}
+
+static Result runBenchmark(const Benchmark& b, double minNs) {
+    Result r;
+    snprintf(r.name, sizeof(r.name), "%s", b.name);
+
+    // Warm up (first-use allocations, caches), then grow the batch until
+    // it runs for at least minNs
+    unsigned long iterations = 16;
+    timeBatch(b.run, iterations);
+    while (timeBatch(b.run, iterations) < minNs && iterations < (1UL << 30)) {
+        iterations *= 2;
+    }
+
+    double samples[TIMED_BATCHES];
+    unsigned long allocsBefore = HostHeap::allocations;
+    for (int n = 0; n < TIMED_BATCHES; n++) {
+        samples[n] = timeBatch(b.run, iterations) / iterations;
+    }
+    unsigned long allocs = HostHeap::allocations - allocsBefore;
+
+    std::sort(samples, samples + TIMED_BATCHES);
+    r.nsOp = samples[TIMED_BATCHES / 2];
+    r.allocsOp = (double)allocs / ((double)iterations * TIMED_BATCHES);
+    return r;
+}
+
+// ============================================
+// OUTPUT
+// ============================================
+
+static const char* CSV_HEADER = "benchmark,ns_op,allocs_op";
+
+static void writeCsv(FILE* f, const Result* results, int count) {
+    fprintf(f, "%s\n", CSV_HEADER);
+    for (int n = 0; n < count; n++) {
+        fprintf(f, "%s,%.1f,%.2f\n", results[n].name, results[n].nsOp, results[n].allocsOp);
+    }
+}
+
+static int readCsv(const char* path, Result* results, int max) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    char line[128];
+    int count = 0;
+    while (count < max && fgets(line, sizeof(line), f)) {
+        Result& r = results[count];
+        if (sscanf(line, "%31[^,],%lf,%lf", r.name, &r.nsOp, &r.allocsOp) == 3) {
+            count++;
+        }
+    }
+    fclose(f);
+    return count;
+}
+
+static const Result* findResult(const Result* results, int count, const char* name) {
+    for (int n = 0; n < count; n++) {
+        if (strcmp(results[n].name, name) == 0) return &results[n];
+    }
+    return NULL;
+}
+
+int main(int argc, char** argv) {
+    const char* csvPath = NULL;
+    const char* baselinePath = NULL;
+    const char* only = NULL;
+    double minMs = 20;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+            csvPath = argv[++i];
+        } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baselinePath = argv[++i];
+        } else if (strcmp(argv[i], "--only") == 0 && i + 1 < argc) {
+            only = argv[++i];
+        } else if (strcmp(argv[i], "--min-ms") == 0 && i + 1 < argc) {
+            minMs = atof(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s [--csv <file>] [--baseline <file>] [--only <name>] [--min-ms <n>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    Result baseline[NUM_BENCHMARKS];
+    int baselineCount = 0;
+    if (baselinePath) {
+        baselineCount = readCsv(baselinePath, baseline, NUM_BENCHMARKS);
+        if (baselineCount < 0) return 1;
+    }
+
+    setupState();
+
+    Result results[NUM_BENCHMARKS];
+    int count = 0;
+    int regressions = 0;
+    printf("%-20s %10s %10s\n", "benchmark", "ns/op", "allocs/op");
+    for (int n = 0; n < NUM_BENCHMARKS; n++) {
+        if (only && !strstr(BENCHMARKS[n].name, only)) continue;
+        Result& r = results[count++] = runBenchmark(BENCHMARKS[n], minMs * 1e6);
+        printf("%-20s %10.1f %10.2f", r.name, r.nsOp, r.allocsOp);
+
+        const Result* b = findResult(baseline, baselineCount, r.name);
+        if (b) {
+            bool slower = r.nsOp > b->nsOp * REGRESSION_RATIO;
+            bool moreAllocs = r.allocsOp > b->allocsOp + 0.005;
+            printf("   %+6.0f%% %+6.2f%s%s",
+                   b->nsOp > 0 ? (r.nsOp / b->nsOp - 1.0) * 100.0 : 0.0, r.allocsOp - b->allocsOp,
+                   slower ? "  SLOWER" : "", moreAllocs ? "  MORE-ALLOCS" : "");
+            if (slower || moreAllocs) regressions++;
+        }
+        printf("\n");
+    }
+
+    if (csvPath) {
+        FILE* f = fopen(csvPath, "w");
+        if (!f) {
+            perror(csvPath);
+            return 1;
+        }
+        writeCsv(f, results, count);
+        fclose(f);
+    }
+
+    if (regressions > 0) {
+        printf("%d regression(s) against %s\n", regressions, baselinePath);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,352 @@
+// ============================================
+// SESSION TRACE REPLAY
+// ============================================
+// Feeds a recorded session (GET /trace, or sim --trace) back through the
+// control core: recorded ADC samples answer every sensor read, recorded
+// commands are re-issued through RideController at their original
+// times, and each control tick runs at its recorded millis(). The trace
+// this build produces is compared with the original; the first output,
+// tick or command that differs is reported.
+//
+// A trace restarted mid-session (/trace?start=1) opens with a snapshot
+// instead of boot: the control core is brought up on the first recorded
+// samples and seeded from the snapshot commands. State the snapshot
+// doesn't carry (smoothing windows, learned deadbands, fill leads and
+// level coupling, the pump scheduler's draw forecast) starts fresh, so
+// such a replay can part from the recording once that state decides an
+// output; the report then shows where.
+//
+// Build & run: pio run -e native-replay && .pio/build/native-replay/program <trace> [options]
+//   --dump          Print the decoded trace instead of replaying
+//   --verbose       Echo firmware Serial output during replay
+//
+// Exit status: 0 = identical, 1 = diverged or unreadable.
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <vector>
+#include "config.h"
+#include "AirBag.h"
+#include "Compressor.h"
+#include "RideController.h"
+#include "HostBoard.h"
+#include "TraceFile.h"
+
+AirBag bags[NUM_BAGS] = {
+    AirBag(FRONT_LEFT_PRESSURE_PIN,  FRONT_LEFT_INFLATE_PIN,  FRONT_LEFT_DEFLATE_PIN,  "FL"),
+    AirBag(FRONT_RIGHT_PRESSURE_PIN, FRONT_RIGHT_INFLATE_PIN, FRONT_RIGHT_DEFLATE_PIN, "FR"),
+    AirBag(REAR_LEFT_PRESSURE_PIN,   REAR_LEFT_INFLATE_PIN,   REAR_LEFT_DEFLATE_PIN,   "RL"),
+    AirBag(REAR_RIGHT_PRESSURE_PIN,  REAR_RIGHT_INFLATE_PIN,  REAR_RIGHT_DEFLATE_PIN,  "RR")
+};
+
+Compressor compressor(PUMP_1_PIN, PUMP_2_PIN);
+RideController controller(bags, &compressor);
+
+// Answers sensor reads from the recorded samples, in order
+class ReplayPlant : public PlantModel {
+  public:
+    ReplayPlant(const std::vector<TraceRecord>& recs)
+        : records(recs), cursor(0), peeking(false), exhausted(false), mismatch(false), mismatchAt(0) {
+        memset(lastCounts, 0, sizeof(lastCounts));
+    }
+
+    void writePin(uint8_t pin, uint8_t level) override { (void)pin; (void)level; }
+    void advance(float seconds) override { (void)seconds; }
+    float getBagPressure(int bag) const override { (void)bag; return 0; }
+    float getTankPressure() const override { return 0; }
+
+    int readAdc(uint8_t pin) override {
+        if (peeking) {
+            // Bring-up before a snapshot: the pin's next sample, left in place
+            for (size_t i = cursor; i < records.size(); i++) {
+                if (records[i].type == TRACE_ADC && records[i].arg == pin) {
+                    lastCounts[pin] = records[i].value;
+                    break;
+                }
+            }
+            return lastCounts[pin];
+        }
+
+        // Outputs interleave with samples; they are checked after the run
+        while (cursor < records.size() && records[cursor].type == TRACE_OUTPUT) cursor++;
+        if (cursor >= records.size()) {
+            exhausted = true;
+            return lastCounts[pin];
+        }
+        const TraceRecord& r = records[cursor];
+        if (r.type != TRACE_ADC || r.arg != pin) {
+            // Firmware read a sensor the recording didn't
+            if (!mismatch) {
+                mismatch = true;
+                mismatchAt = cursor;
+                mismatchPin = pin;
+            }
+            return lastCounts[pin];
+        }
+        cursor++;
+        lastCounts[pin] = r.value;
+        return r.value;
+    }
+
+    const std::vector<TraceRecord>& records;
+    size_t cursor;
+    bool peeking;
+    bool exhausted;
+    bool mismatch;
+    size_t mismatchAt;
+    uint8_t mismatchPin;
+
+  private:
+    int lastCounts[256];
+};
+
+// ============================================
+// REPLAY
+// ============================================
+
+struct ReplayStats {
+    unsigned long ticks;
+    unsigned long commands;
+    unsigned long offTickSamples;   // Sensor reads outside the control core (e.g. web UI)
+};
+
+static void executeCommand(const TraceRecord& cmd, const float* args) {
+    switch (cmd.arg) {
+        case TRACE_CMD_SET_TARGET:    controller.setBagTarget(cmd.value & 0xFF, args[0], (RampProfile)(cmd.value >> 8)); break;
+        case TRACE_CMD_APPLY_TARGETS: controller.applyTargets(args, (RampProfile)cmd.value); break;
+        case TRACE_CMD_INFLATE:       controller.manualInflate(cmd.value); break;
+        case TRACE_CMD_DEFLATE:       controller.manualDeflate(cmd.value); break;
+        case TRACE_CMD_HOLD:          controller.holdBag(cmd.value); break;
+        case TRACE_CMD_STOP_ALL:      controller.stopAll(); break;
+        case TRACE_CMD_LEVEL_MODE:    controller.setLevelMode((LevelMode)cmd.value); break;
+        case TRACE_CMD_LEVEL_PITCH:   controller.setLevelPitch(args[0]); break;
+        case TRACE_CMD_PUMP_ENABLED:  controller.setPumpEnabled(cmd.value != 0); break;
+        case TRACE_CMD_PUMP_MODE:     controller.setPumpMode((PumpMode)cmd.value); break;
+        case TRACE_CMD_TANK_TARGET:   controller.setTankTarget(args[0]); break;
+        case TRACE_CMD_PARKED:        controller.setParked(cmd.value != 0); break;
+        case TRACE_CMD_CALIBRATION: {
+            SensorCalibration cal = { args[0], args[1], args[2] };
+            controller.setSensorCalibration(cmd.value, cal);
+            break;
+        }
+        case TRACE_CMD_TARGETS:
+            for (int i = 0; i < NUM_BAGS; i++) {
+                bags[i].setTargetPressure(args[i]);
+            }
+            break;
+        case TRACE_CMD_PUMP_RUNTIME: {
+            uint32_t counts[2];
+            memcpy(counts, args, sizeof(counts));
+            compressor.restoreRuntime(cmd.value, counts[0], counts[1]);
+            break;
+        }
+        default:
+            fprintf(stderr, "Unknown command %u in trace\n", cmd.arg);
+            break;
+    }
+}
+
+// Run top-level records (ticks, commands) until the end of the trace, or
+// until the next sensor sample when it belongs to a begin() call
+static void runRecords(ReplayPlant& plant, TraceFile::Clock& clock, ReplayStats& stats, bool stopAtSample) {
+    const std::vector<TraceRecord>& recs = plant.records;
+
+    while (plant.cursor < recs.size() && !plant.mismatch) {
+        const TraceRecord& r = recs[plant.cursor];
+        switch (r.type) {
+            case TRACE_OUTPUT:
+                plant.cursor++;
+                break;
+
+            case TRACE_ADC:
+                if (stopAtSample) return;
+                plant.cursor++;
+                stats.offTickSamples++;
+                break;
+
+            case TRACE_TIME:
+                HostBoard::setMillis(clock.unwrap(r.value));
+                plant.cursor++;
+                break;
+
+            case TRACE_TICK:
+                if (stopAtSample) return;
+                HostBoard::setMillis(clock.unwrap(r.value));
+                plant.cursor++;
+                controller.tick();
+                stats.ticks++;
+                break;
+
+            case TRACE_COMMAND: {
+                float args[NUM_BAGS] = { 0 };
+                plant.cursor++;
+                int n = 0;
+                while (plant.cursor + 1 < recs.size() && recs[plant.cursor].type == TRACE_ARG) {
+                    uint32_t bits = ((uint32_t)recs[plant.cursor].value << 16) | recs[plant.cursor + 1].value;
+                    if (n < NUM_BAGS) memcpy(&args[n++], &bits, sizeof(bits));
+                    plant.cursor += 2;
+                }
+                executeCommand(r, args);
+                stats.commands++;
+                break;
+            }
+
+            default:
+                fprintf(stderr, "Unexpected record type %u at %u\n", r.type, (unsigned)plant.cursor);
+                plant.cursor++;
+                break;
+        }
+    }
+}
+
+// Compare everything except sensor samples (inputs, identical by construction).
+// from: first original record to compare (past a snapshot, which the
+// replay doesn't re-record; both traces then continue after their first)
+static bool compareTraces(const std::vector<TraceRecord>& original, bool originalFull, size_t from) {
+    const TraceRecord* replayed = traceRecorder.getRecords();
+    uint32_t replayedCount = traceRecorder.getCount();
+
+    TraceFile::Clock clock;
+    clock.unwrap(original[0].value);
+    size_t a = from, b = (from > 0) ? 1 : 0;
+    while (true) {
+        while (a < original.size() && original[a].type == TRACE_ADC) a++;
+        while (b < replayedCount && replayed[b].type == TRACE_ADC) b++;
+        if (a >= original.size() || b >= replayedCount) break;
+
+        const TraceRecord& ra = original[a];
+        const TraceRecord& rb = replayed[b];
+        if (ra.type == TRACE_TICK || ra.type == TRACE_TIME) {
+            clock.unwrap(ra.value);
+        }
+        if (ra.type != rb.type || ra.arg != rb.arg || ra.value != rb.value) {
+            char want[48], got[48];
+            TraceFile::describe(ra, want, sizeof(want));
+            TraceFile::describe(rb, got, sizeof(got));
+            printf("DIVERGED at record %u (t=%lu ms): recorded '%s', replay '%s'\n",
+                   (unsigned)a, clock.get(), want, got);
+            return false;
+        }
+        a++;
+        b++;
+    }
+
+    // A full buffer cuts the recording mid-tick; otherwise lengths must match
+    bool recordedLeft = a < original.size();
+    bool replayedLeft = b < replayedCount;
+    if (!originalFull && (recordedLeft || replayedLeft)) {
+        printf("DIVERGED at end: %s has extra records\n", recordedLeft ? "recording" : "replay");
+        return false;
+    }
+    return true;
+}
+
+static void dumpTrace(const std::vector<TraceRecord>& records) {
+    TraceFile::Clock clock;
+    for (size_t i = 0; i < records.size(); i++) {
+        const TraceRecord& r = records[i];
+        if (r.type == TRACE_BOOT || r.type == TRACE_SNAPSHOT || r.type == TRACE_TICK || r.type == TRACE_TIME) {
+            clock.unwrap(r.value);
+        }
+        char text[48];
+        TraceFile::describe(r, text, sizeof(text));
+        printf("%8u %10lu  %s\n", (unsigned)i, clock.get(), text);
+    }
+}
+
+int main(int argc, char** argv) {
+    const char* path = NULL;
+    bool dump = false;
+    bool verbose = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--dump") == 0) {
+            dump = true;
+        } else if (strcmp(argv[i], "--verbose") == 0) {
+            verbose = true;
+        } else if (argv[i][0] != '-' && !path) {
+            path = argv[i];
+        } else {
+            path = NULL;
+            break;
+        }
+    }
+    if (!path) {
+        fprintf(stderr, "Usage: %s <trace> [--dump] [--verbose]\n", argv[0]);
+        return 2;
+    }
+
+    TraceHeader header;
+    std::vector<TraceRecord> records;
+    if (!TraceFile::load(path, header, records)) return 1;
+    if (dump) {
+        dumpTrace(records);
+        return 0;
+    }
+    if (records.empty() || (records[0].type != TRACE_BOOT && records[0].type != TRACE_SNAPSHOT)) {
+        fprintf(stderr, "%s: trace starts neither at boot nor at a snapshot\n", path);
+        return 1;
+    }
+    bool snapshot = records[0].type == TRACE_SNAPSHOT;
+
+    ReplayPlant plant(records);
+    HostBoard::reset();
+    HostBoard::attachPlant(&plant);
+    Serial.setEcho(verbose);
+    demoMode = false;
+    EEPROM.begin(EEPROM_SIZE);
+
+    TraceFile::Clock clock;
+    HostBoard::setMillis(clock.unwrap(records[0].value));
+    plant.cursor = 1;
+    ReplayStats stats = { 0, 0, 0 };
+    size_t compareFrom = 0;
+
+    if (snapshot) {
+        // Bring up unrecorded on the samples ahead, seed from the snapshot
+        // commands, then record from the snapshot on like the controller did
+        plant.peeking = true;
+        for (int i = 0; i < NUM_BAGS; i++) {
+            bags[i].begin();
+        }
+        compressor.begin();
+        controller.begin();
+        plant.peeking = false;
+        ReplayStats seeded = { 0, 0, 0 };
+        runRecords(plant, clock, seeded, true);
+        compareFrom = plant.cursor;
+        traceRecorder.restart();
+    } else {
+        // Mirror setup(): bags and compressor, then whatever configuration
+        // commands ran (stored calibration), then the controller's tank fill
+        traceRecorder.begin();
+        for (int i = 0; i < NUM_BAGS; i++) {
+            bags[i].begin();
+        }
+        compressor.begin();
+        runRecords(plant, clock, stats, true);
+        controller.begin();
+    }
+    runRecords(plant, clock, stats, false);
+
+    if (plant.mismatch) {
+        char want[48];
+        TraceFile::describe(records[plant.mismatchAt], want, sizeof(want));
+        printf("DIVERGED at record %u (t=%lu ms): firmware read pin %u, recording has '%s'\n",
+               (unsigned)plant.mismatchAt, clock.get(), plant.mismatchPin, want);
+        return 1;
+    }
+
+    bool identical = compareTraces(records, header.flags & TRACE_FLAG_FULL, compareFrom);
+    printf("Replayed %lu ticks, %lu commands, %.1f s of session%s%s\n",
+           stats.ticks, stats.commands, (clock.get() - (unsigned long)records[0].value) / 1000.0,
+           snapshot ? " from a snapshot" : "",
+           (header.flags & TRACE_FLAG_FULL) ? " (recording buffer was full)" : "");
+    if (stats.offTickSamples > 0) {
+        printf("Skipped %lu sensor reads made outside the control core\n", stats.offTickSamples);
+    }
+    if (identical) {
+        printf("Outputs identical\n");
+    }
+    return identical ? 0 : 1;
+}
@@ -0,0 +1,165 @@
+// ============================================
+// HOST SIMULATION RUNNER
+// ============================================
+// Runs the control core (AirBag, Compressor, RideController) against a
+// simulated plant on the virtual clock, faster than real time.
+//
+// Build & run: pio run -e native && .pio/build/native/program [options]
+//   --hours <h>     Simulated driving time (default 1)
+//   --seed <n>      PRNG seed for sensor noise (default 1)
+//   --verbose       Echo firmware Serial output
+//   --telemetry <f> Write per-tick telemetry CSV (same format as serial 'G')
+//   --trace <f>     Record a session trace from boot (same format as /trace)
+//   --trace-from <s> With --trace: restart it at this simulated second (/trace?start=1)
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <time.h>
+#include "config.h"
+#include "AirBag.h"
+#include "Compressor.h"
+#include "RideController.h"
+#include "HostBoard.h"
+#include "PneumaticPlant.h"
+#include "TraceFile.h"
+
+AirBag bags[NUM_BAGS] = {
+    AirBag(FRONT_LEFT_PRESSURE_PIN,  FRONT_LEFT_INFLATE_PIN,  FRONT_LEFT_DEFLATE_PIN,  "FL"),
+    AirBag(FRONT_RIGHT_PRESSURE_PIN, FRONT_RIGHT_INFLATE_PIN, FRONT_RIGHT_DEFLATE_PIN, "FR"),
+    AirBag(REAR_LEFT_PRESSURE_PIN,   REAR_LEFT_INFLATE_PIN,   REAR_LEFT_DEFLATE_PIN,   "RL"),
+    AirBag(REAR_RIGHT_PRESSURE_PIN,  REAR_RIGHT_INFLATE_PIN,  REAR_RIGHT_DEFLATE_PIN,  "RR")
+};
+
+Compressor compressor(PUMP_1_PIN, PUMP_2_PIN);
+RideController controller(bags, &compressor);
+
+// Driving script: preset changes as a car sees them on a typical outing
+struct ScriptStep {
+    unsigned long atSeconds;  // Offset within the cycle
+    int preset;               // Index into DEFAULT_PRESETS
+};
+
+static const ScriptStep DRIVE_CYCLE[] = {
+    {0,    1},   // Leave: Cruise
+    {600,  0},   // Parked at the show: Lay
+    {900,  2},   // Driveway / speed bump: Max
+    {960,  1},   // Back to Cruise
+    {1500, 0},   // Stop: Lay
+    {1620, 1}    // Cruise home
+};
+static const int DRIVE_CYCLE_STEPS = sizeof(DRIVE_CYCLE) / sizeof(DRIVE_CYCLE[0]);
+static const unsigned long DRIVE_CYCLE_SECONDS = 1800;
+
+static void applyPreset(int presetNum) {
+    const Preset& p = DEFAULT_PRESETS[presetNum];
+    float targets[NUM_BAGS] = { p.frontLeft, p.frontRight, p.rearLeft, p.rearRight };
+    controller.applyTargets(targets);
+}
+
+int main(int argc, char** argv) {
+    float hours = 1.0;
+    unsigned long seed = 1;
+    bool verbose = false;
+    const char* telemetryPath = NULL;
+    const char* tracePath = NULL;
+    float traceFrom = -1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--hours") == 0 && i + 1 < argc) {
+            hours = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--verbose") == 0) {
+            verbose = true;
+        } else if (strcmp(argv[i], "--telemetry") == 0 && i + 1 < argc) {
+            telemetryPath = argv[++i];
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            tracePath = argv[++i];
+        } else if (strcmp(argv[i], "--trace-from") == 0 && i + 1 < argc) {
+            traceFrom = atof(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s [--hours <h>] [--seed <n>] [--verbose] [--telemetry <file>] [--trace <file> [--trace-from <s>]]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    FILE* telemetry = NULL;
+    if (telemetryPath) {
+        telemetry = fopen(telemetryPath, "w");
+        if (!telemetry) {
+            perror(telemetryPath);
+            return 1;
+        }
+        fprintf(telemetry, "ms,tank,fl,fr,rl,rr,valves,pumps\n");
+    }
+
+    PneumaticPlant plant;
+    HostBoard::reset();
+    HostBoard::attachPlant(&plant);
+    randomSeed(seed);
+    Serial.setEcho(verbose);
+
+    // Same bring-up order as setup(), minus WiFi/OTA/watchdog
+    demoMode = false;
+    EEPROM.begin(EEPROM_SIZE);
+    if (tracePath) traceRecorder.begin();
+    for (int i = 0; i < NUM_BAGS; i++) {
+        bags[i].begin();
+    }
+    compressor.begin();
+    controller.begin();
+
+    unsigned long simMs = (unsigned long)(hours * 3600000.0);
+    unsigned long startMs = millis();
+    float minTank = plant.getTankPressure();
+    unsigned long lockoutTicks = 0;
+    int nextStep = 0;
+    unsigned long cycleStart = 0;
+
+    clock_t wallStart = clock();
+
+    while (millis() - startMs < simMs) {
+        unsigned long elapsed = (millis() - startMs) / 1000;
+        if (elapsed - cycleStart >= DRIVE_CYCLE_SECONDS) {
+            cycleStart += DRIVE_CYCLE_SECONDS;
+            nextStep = 0;
+        }
+        if (nextStep < DRIVE_CYCLE_STEPS && elapsed - cycleStart >= DRIVE_CYCLE[nextStep].atSeconds) {
+            applyPreset(DRIVE_CYCLE[nextStep].preset);
+            nextStep++;
+        }
+
+        if (tracePath && traceFrom >= 0 && millis() - startMs >= (unsigned long)(traceFrom * 1000.0)) {
+            controller.requestTraceRestart();
+            traceFrom = -1;
+        }
+
+        HostBoard::advance(1);
+        if (controller.update() && telemetry) {
+            char row[TELEMETRY_ROW_SIZE];
+            controller.formatTelemetry(row, sizeof(row));
+            fprintf(telemetry, "%s\n", row);
+        }
+
+        if (plant.getTankPressure() < minTank) minTank = plant.getTankPressure();
+        if (controller.isTankLockout()) lockoutTicks++;
+    }
+
+    double wallSeconds = (double)(clock() - wallStart) / CLOCKS_PER_SEC;
+    if (telemetry) fclose(telemetry);
+    if (tracePath && !TraceFile::save(tracePath, traceRecorder)) return 1;
+    double simSeconds = simMs / 1000.0;
+
+    printf("Simulated %.1f s in %.3f s wall (%.0fx real time)\n",
+           simSeconds, wallSeconds, wallSeconds > 0 ? simSeconds / wallSeconds : 0.0);
+    printf("Tank: %.1f PSI (min %.1f), lockout %.1f s\n",
+           plant.getTankPressure(), minTank, lockoutTicks / 1000.0);
+    printf("Pump runtime: P1 %.1f min, P2 %.1f min\n",
+           compressor.getPump1RuntimeMs() / 60000.0, compressor.getPump2RuntimeMs() / 60000.0);
+    for (int i = 0; i < NUM_BAGS; i++) {
+        printf("%s: measured %.1f / target %.1f PSI (plant %.1f)\n",
+               bags[i].getName(), bags[i].getPressure(), bags[i].getTargetPressure(),
+               plant.getBagPressure(i));
+    }
+    return 0;
+}
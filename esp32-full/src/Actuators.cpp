@@ -0,0 +1,77 @@
+#include "Actuators.h"
+#include "Hal.h"
+#include "SolenoidGuard.h"
+
+Actuators actuators;
+
+Actuators::Actuators()
+    : desired(0),
+      committed(0),
+      guardedMask(0),
+      attachedMask(0),
+      motorMask(0),
+      motorHeld(false),
+      motorStartMs(0),
+      motorStarts(0),
+      deferredStarts(0) {
+}
+
+void Actuators::attach(uint8_t pin, bool guarded) {
+    uint64_t bit = (uint64_t)1 << pin;
+    desired &= ~bit;
+    committed &= ~bit;
+    if (guarded) guardedMask |= bit;
+    attachedMask |= bit;
+
+    // Latch the off level before enabling the driver so an active-LOW
+    // relay never sees a low pulse at boot
+    Hal::writePins(bit, RELAY_OFF);
+    pinMode(pin, OUTPUT);
+}
+
+void Actuators::attachMotor(uint8_t pin) {
+    attach(pin);
+    motorMask |= (uint64_t)1 << pin;
+}
+
+void Actuators::set(uint8_t pin, bool on) {
+    uint64_t bit = (uint64_t)1 << pin;
+    if (on) {
+        desired |= bit;
+    } else {
+        desired &= ~bit;
+    }
+}
+
+void Actuators::commit() {
+    uint64_t changed = desired ^ committed;
+    if (!changed) return;
+
+    // Break before make: close valves / stop pumps, then open the new ones
+    uint64_t releasing = changed & committed;
+    uint64_t energising = changed & desired;
+    bool anyGuarded = (desired & guardedMask) != 0;
+
+    // Motor inrush and solenoid coils don't land on the supply together:
+    // the motor waits one commit (once - a solenoid opening every commit
+    // must not starve it)
+    uint64_t starting = energising & motorMask;
+    if (starting) {
+        if ((energising & guardedMask) && !motorHeld) {
+            energising &= ~starting;
+            motorHeld = true;
+            deferredStarts++;
+        } else {
+            motorHeld = false;
+            motorStartMs = millis();
+            motorStarts += __builtin_popcountll(starting);
+        }
+    }
+
+    // Dead-man is running before any solenoid opens, stopped after the last closes
+    if (anyGuarded) solenoidGuard.arm(guardedMask);
+    if (releasing) Hal::writePins(releasing, RELAY_OFF);
+    if (energising) Hal::writePins(energising, RELAY_ON);
+    if (!anyGuarded) solenoidGuard.disarm();
+    committed = (committed & ~releasing) | energising;
+}
@@ -1,4 +1,5 @@
 #include "AirBag.h"
+#include "Actuators.h"
 
 AirBag::AirBag(uint8_t pressurePin, uint8_t inflatePin, uint8_t deflatePin, const char* name)
     : pressureSensorPin(pressurePin),
@@ -25,18 +26,15 @@ AirBag::AirBag(uint8_t pressurePin, uint8_t inflatePin, uint8_t deflatePin, cons
 }
 
 void AirBag::begin() {
-    pinMode(inflateSolenoidPin, OUTPUT);
-    pinMode(deflateSolenoidPin, OUTPUT);
-
-    // Ensure both solenoids are off at startup (valves closed, bag holds)
-    digitalWrite(inflateSolenoidPin, RELAY_OFF);
-    digitalWrite(deflateSolenoidPin, RELAY_OFF);
+    // Both solenoids off at startup (valves closed, bag holds)
+    actuators.attach(inflateSolenoidPin, true);
+    actuators.attach(deflateSolenoidPin, true);
     state = VALVE_HOLD;
 
     // Fill pressure buffer with initial readings
     for (int i = 0; i < PRESSURE_SAMPLES; i++) {
         pressureBuffer[i] = readPressure();
-        delay(PRESSURE_SAMPLE_DELAY);
+        delayMicroseconds(BOOT_SAMPLE_DELAY_US);
     }
     bufferFilled = true;
     bufferIndex = 0;
@@ -46,9 +44,12 @@ void AirBag::begin() {
 }
 
 void AirBag::update() {
-    // Add new reading to buffer
-    pressureBuffer[bufferIndex] = readPressure();
-    bufferIndex = (bufferIndex + 1) % PRESSURE_SAMPLES;
+    // Add new reading to buffer (none while a pump's inrush sags the
+    // sensor supply - the average carries on from the samples before it)
+    if (!actuators.isSettling()) {
+        pressureBuffer[bufferIndex] = readPressure();
+        bufferIndex = (bufferIndex + 1) % PRESSURE_SAMPLES;
+    }
 
     // Use smoothed reading
     currentPressure = readPressureSmoothed();
@@ -66,48 +67,8 @@ void AirBag::update() {
 }
 
 float AirBag::readPressure() {
-    if (demoMode) {
-        // Simulate pressure changes based on valve state
-        // Physics ported from frontend simulation, scaled for 100ms interval
-        float simPressure = currentPressure > 0 ? currentPressure : DEMO_BAG_PSI;
-
-        if (state == VALVE_INFLATE) {
-            // Differential pressure based fill (faster when tank >> bag)
-            float deltaP = max(0.0f, simTankPressure - simPressure);
-            if (deltaP > 1.0f) {
-                float fillSpeed = SIM_BAG_INFLATE_RATE * sqrt(deltaP);
-                simPressure += fillSpeed;
-            }
-            if (simPressure > MAX_BAG_PSI) simPressure = MAX_BAG_PSI;
-        } else if (state == VALVE_DEFLATE) {
-            // Dump to atmosphere - faster at higher pressure
-            float dumpSpeed = SIM_BAG_DEFLATE_RATE * sqrt(max(0.0f, simPressure));
-            simPressure -= dumpSpeed;
-            if (simPressure < MIN_BAG_PSI) simPressure = MIN_BAG_PSI;
-        }
-
-        // Apply simulated leak on this bag
-        if (simLeakTarget >= 0 && simLeakTarget <= 3) {
-            // Map bag name to index for comparison
-            int bagIdx = -1;
-            if (bagName[0] == 'F' && bagName[1] == 'L') bagIdx = 0;
-            else if (bagName[0] == 'F' && bagName[1] == 'R') bagIdx = 1;
-            else if (bagName[0] == 'R' && bagName[1] == 'L') bagIdx = 2;
-            else if (bagName[0] == 'R' && bagName[1] == 'R') bagIdx = 3;
-            if (bagIdx == simLeakTarget) {
-                simPressure -= simLeakRate;
-                if (simPressure < 0) simPressure = 0;
-            }
-        }
-
-        // Add realistic jitter
-        simPressure += (random(-SIM_JITTER_RANGE, SIM_JITTER_RANGE) / 10000.0f);
-
-        return simPressure;
-    }
-
     // ESP32: 12-bit ADC (0-4095), 3.3V reference
-    int rawValue = analogRead(pressureSensorPin);
+    int rawValue = Hal::readAdc(pressureSensorPin);
     float voltage = (rawValue / ADC_RESOLUTION) * ADC_REFERENCE_VOLTAGE;
 
     // Convert voltage to resistance using voltage divider formula
@@ -119,10 +80,7 @@ float AirBag::readPressure() {
 }
 
 float AirBag::readRawPressure() {
-    if (demoMode) {
-        return currentPressure; // In demo mode, raw = current
-    }
-    int rawValue = analogRead(pressureSensorPin);
+    int rawValue = Hal::readAdc(pressureSensorPin);
     float voltage = (rawValue / ADC_RESOLUTION) * ADC_REFERENCE_VOLTAGE;
     float resistance = resistanceFromVoltage(voltage);
     return resistanceToPsi(resistance);
@@ -195,8 +153,9 @@ void AirBag::inflate() {
     }
 
     // RideTech Big Red: Open inflate solenoid, close deflate
-    digitalWrite(deflateSolenoidPin, RELAY_OFF);  // Close deflate first
-    digitalWrite(inflateSolenoidPin, RELAY_ON);   // Open inflate
+    // (staged; the commit closes deflate before inflate opens)
+    actuators.set(deflateSolenoidPin, false);
+    actuators.set(inflateSolenoidPin, true);
 
     if (state != VALVE_INFLATE) {
         solenoidOnStartTime = millis();
@@ -213,9 +172,10 @@ void AirBag::deflate() {
         solenoidTimedOut = false; // Cooldown complete
     }
 
-    // RideTech Big Red: Close inflate solenoid, open deflate
-    digitalWrite(inflateSolenoidPin, RELAY_OFF);  // Close inflate first
-    digitalWrite(deflateSolenoidPin, RELAY_ON);   // Open deflate (dump)
+    // RideTech Big Red: Close inflate solenoid, open deflate (dump)
+    // (staged; the commit closes inflate before deflate opens)
+    actuators.set(inflateSolenoidPin, false);
+    actuators.set(deflateSolenoidPin, true);
 
     if (state != VALVE_DEFLATE) {
         solenoidOnStartTime = millis();
@@ -225,8 +185,8 @@ void AirBag::deflate() {
 
 void AirBag::hold() {
     // RideTech Big Red: Close both solenoids - bag holds pressure
-    digitalWrite(inflateSolenoidPin, RELAY_OFF);
-    digitalWrite(deflateSolenoidPin, RELAY_OFF);
+    actuators.set(inflateSolenoidPin, false);
+    actuators.set(deflateSolenoidPin, false);
     state = VALVE_HOLD;
     solenoidOnStartTime = 0;
 }
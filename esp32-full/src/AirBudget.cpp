@@ -0,0 +1,260 @@
+#include "AirBudget.h"
+
+AirBudget::AirBudget()
+    : finishedMoves(0),
+      heldSinceMs(0) {
+    memset(&prediction, 0, sizeof(prediction));
+    memset(&move, 0, sizeof(move));
+    move.state = AIR_MOVE_NONE;
+    for (int i = 0; i < NUM_BAGS; i++) {
+        bagVolumeL[i] = PLAN_BAG_VOLUME_L;
+        volumeFills[i] = 0;
+        cornerScf[i] = 0;
+        lastState[i] = VALVE_HOLD;
+        metering[i] = false;
+        settling[i] = false;
+        alone[i] = false;
+        startPsi[i] = 0;
+        startTank[i] = 0;
+        closedAtMs[i] = 0;
+    }
+}
+
+void AirBudget::update(const AirBag* bags, const DeadbandEstimator& deadband, float tankPressure, bool pumping) {
+    unsigned long now = millis();
+    for (int i = 0; i < NUM_BAGS; i++) {
+        meter(bags, i, tankPressure, pumping, now);
+    }
+    if (move.state == AIR_MOVE_RUNNING) {
+        track(bags, deadband, tankPressure, now);
+    }
+}
+
+float AirBudget::getTotalScf() const {
+    float total = 0;
+    for (int i = 0; i < NUM_BAGS; i++) {
+        total += cornerScf[i];
+    }
+    return total;
+}
+
+float AirBudget::getUsableScf(float tankPressure) const {
+    return toScf(PLAN_TANK_VOLUME_L, max(0.0f, tankPressure - (float)TANK_CUTOFF_PSI));
+}
+
+const char* AirBudget::stateName(AirMoveState state) {
+    switch (state) {
+        case AIR_MOVE_RUNNING:  return "running";
+        case AIR_MOVE_COMPLETE: return "complete";
+        case AIR_MOVE_SHORT:    return "short";
+        case AIR_MOVE_REPLACED: return "replaced";
+        default:                return "none";
+    }
+}
+
+// ============================================
+// PREDICTION
+// ============================================
+
+bool AirBudget::estimate(const AirBag* bags, const DeadbandEstimator& deadband, const TransitionPlanner& planner,
+                         uint8_t candidates, float tankPressure, bool pumpsAvailable, bool pumping,
+                         const float rampRates[NUM_BAGS]) {
+    float fromPsi[NUM_BAGS];
+    float toPsi[NUM_BAGS];
+    float tankPerBag[NUM_BAGS];
+    uint8_t corners = 0;
+    int count = 0;
+    for (int i = 0; i < NUM_BAGS; i++) {
+        fromPsi[i] = bags[i].getPressure();
+        toPsi[i] = bags[i].getTargetPressure();
+        tankPerBag[i] = bagVolumeL[i] / PLAN_TANK_VOLUME_L;
+        if ((candidates & (1 << i)) && abs(toPsi[i] - fromPsi[i]) > deadband.getBand(i)) {
+            corners |= (1 << i);
+            count++;
+        }
+    }
+    if (corners == 0) return false;
+    if (move.state == AIR_MOVE_RUNNING) finish(AIR_MOVE_REPLACED);
+
+    // Same pause rule the move will run with: the planner's stages for a
+    // coordinated move, the tank lockout for a single corner
+    bool coordinated = PLAN_ENABLED && count >= 2;
+    prediction = planner.predict(deadband, fromPsi, toPsi, corners, rampRates, tankPerBag,
+                                 tankPressure, pumpsAvailable, pumping, coordinated);
+
+    // The pumps would start during the move anyway: start them now, while
+    // the tank is still high enough to keep the corners moving
+    bool prestart = false;
+    if (AIR_PRESTART_ENABLED && pumpsAvailable && !pumping &&
+        prediction.tankEnd < AIR_PRESTART_BELOW_PSI) {
+        prediction = planner.predict(deadband, fromPsi, toPsi, corners, rampRates, tankPerBag,
+                                     tankPressure, pumpsAvailable, true, coordinated);
+        prestart = true;
+    }
+
+    AirEstimate& est = move.estimate;
+    est.corners = corners;
+    est.feasible = prediction.ms < PLAN_PREDICT_MAX_MS &&
+                   (!coordinated || prediction.longestPauseMs <= PLAN_STAGE_WAIT_MS);
+    est.prestart = prestart;
+    est.ms = prediction.ms;
+    est.tankStart = tankPressure;
+    est.tankEnd = prediction.tankEnd;
+    est.pauses = prediction.pauses;
+    est.scf = 0;
+    for (int i = 0; i < NUM_BAGS; i++) {
+        est.scf += toScf(bagVolumeL[i], prediction.bagPsi[i]);
+    }
+
+    move.state = AIR_MOVE_RUNNING;
+    move.startedMs = millis();
+    move.achievedMs = 0;
+    move.tankEnd = tankPressure;
+    move.scf = 0;
+    heldSinceMs = move.startedMs;
+
+    Serial.print("[AIR] ");
+    printCorners(bags, corners);
+    Serial.print(": ");
+    Serial.print(est.scf, 2);
+    Serial.print(" SCF of ");
+    Serial.print(getUsableScf(tankPressure), 2);
+    Serial.print(" usable, ");
+    if (est.feasible) {
+        Serial.print(est.ms / 1000.0, 1);
+        Serial.print(" s");
+    } else {
+        Serial.print("WON'T COMPLETE");
+    }
+    Serial.print(", tank ");
+    Serial.print(tankPressure, 0);
+    Serial.print(" -> ");
+    Serial.print(est.tankEnd, 0);
+    Serial.print(" PSI");
+    if (prestart) Serial.print(", pumps started");
+    Serial.println();
+    return true;
+}
+
+// ============================================
+// CONSUMPTION
+// ============================================
+
+// An inflate runs from the valve opening until AIR_SETTLE_MS after it
+// closes, so the coast is counted. A corner that reopens before then
+// (final-approach pulses) stays one inflate.
+void AirBudget::meter(const AirBag* bags, int i, float tankPressure, bool pumping, unsigned long now) {
+    ValveState state = bags[i].getState();
+    float psi = bags[i].getPressure();
+
+    // The volume observation needs the tank to feed this corner only (a
+    // corner dumping doesn't touch the tank)
+    if (metering[i] || settling[i]) {
+        if (pumping) alone[i] = false;
+        for (int j = 0; j < NUM_BAGS; j++) {
+            if (j != i && bags[j].isInflating()) alone[i] = false;
+        }
+    }
+
+    if (state != lastState[i]) {
+        if (state == VALVE_INFLATE) {
+            if (!settling[i]) {
+                startPsi[i] = psi;
+                startTank[i] = tankPressure;
+                alone[i] = !pumping;
+                for (int j = 0; j < NUM_BAGS; j++) {
+                    if (j != i && bags[j].isInflating()) alone[i] = false;
+                }
+            }
+            metering[i] = true;
+            settling[i] = false;
+        } else if (lastState[i] == VALVE_INFLATE) {
+            metering[i] = false;
+            settling[i] = true;
+            closedAtMs[i] = now;
+        } else if (settling[i]) {
+            // Dumping straight after: book what it has now
+            settling[i] = false;
+            book(i, psi - startPsi[i], startTank[i] - tankPressure);
+        }
+        lastState[i] = state;
+    }
+
+    if (settling[i] && now - closedAtMs[i] >= AIR_SETTLE_MS) {
+        settling[i] = false;
+        book(i, psi - startPsi[i], startTank[i] - tankPressure);
+    }
+}
+
+void AirBudget::book(int i, float bagRise, float tankDrop) {
+    if (bagRise <= 0) return;
+
+    if (alone[i] && bagRise >= AIR_LEARN_MIN_PSI && tankDrop > 0) {
+        float volume = constrain(tankDrop / bagRise * PLAN_TANK_VOLUME_L,
+                                 AIR_BAG_VOLUME_MIN_L, AIR_BAG_VOLUME_MAX_L);
+        bagVolumeL[i] += AIR_LEARN_GAIN * (volume - bagVolumeL[i]);
+        if (volumeFills[i] < 0xFFFF) volumeFills[i]++;
+    }
+
+    float scf = toScf(bagVolumeL[i], bagRise);
+    cornerScf[i] += scf;
+    if (move.state == AIR_MOVE_RUNNING && (move.estimate.corners & (1 << i))) {
+        move.scf += scf;
+    }
+}
+
+// The move is over once every corner holds on target with its last
+// inflate booked
+void AirBudget::track(const AirBag* bags, const DeadbandEstimator& deadband, float tankPressure,
+                      unsigned long now) {
+    move.tankEnd = tankPressure;
+    move.achievedMs = now - move.startedMs;
+
+    bool onTarget = true;
+    for (int i = 0; i < NUM_BAGS; i++) {
+        if (!(move.estimate.corners & (1 << i))) continue;
+        if (!bags[i].isHolding() || metering[i] || settling[i]) {
+            heldSinceMs = now;
+            return;
+        }
+        float error = abs(bags[i].getPressure() - bags[i].getTargetPressure());
+        if (error > deadband.getBand(i) + deadband.getReopen(i)) onTarget = false;
+    }
+
+    if (onTarget) {
+        finish(AIR_MOVE_COMPLETE);
+    } else if (now - heldSinceMs >= AIR_GIVE_UP_MS) {
+        finish(AIR_MOVE_SHORT);
+    }
+}
+
+void AirBudget::finish(AirMoveState state) {
+    move.state = state;
+    finishedMoves++;
+
+    Serial.print("[AIR] Move ");
+    Serial.print(stateName(state));
+    Serial.print(": ");
+    Serial.print(move.scf, 2);
+    Serial.print(" SCF in ");
+    Serial.print(move.achievedMs / 1000.0, 1);
+    Serial.print(" s, tank ");
+    Serial.print(move.tankEnd, 0);
+    Serial.print(" PSI (predicted ");
+    Serial.print(move.estimate.scf, 2);
+    Serial.print(" SCF, ");
+    Serial.print(move.estimate.ms / 1000.0, 1);
+    Serial.print(" s, ");
+    Serial.print(move.estimate.tankEnd, 0);
+    Serial.println(" PSI)");
+}
+
+void AirBudget::printCorners(const AirBag* bags, uint8_t corners) {
+    bool first = true;
+    for (int i = 0; i < NUM_BAGS; i++) {
+        if (!(corners & (1 << i))) continue;
+        if (!first) Serial.print("+");
+        Serial.print(bags[i].getName());
+        first = false;
+    }
+}
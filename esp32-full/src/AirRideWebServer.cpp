@@ -1,24 +1,28 @@
 #include "AirRideWebServer.h"
 #include "html_content.h"  // Auto-generated gzipped React UI
 #include "debug_html_content.h"  // Auto-generated gzipped debug console
+#include "TraceRecorder.h"
+#include "Diagnostics.h"
+#include "SolenoidGuard.h"
+#include "Actuators.h"
+#include "PowerManager.h"
 #include <sys/time.h>
 
-AirRideWebServer::AirRideWebServer(AirBag* b, Compressor* c, float* tp)
+AirRideWebServer::AirRideWebServer(AirBag* b, Compressor* c, RideController* rc)
     : bags(b),
       compressor(c),
-      tankPressure(tp),
+      controller(rc),
       server(80),
       wifiReady(false),
-      levelMode(LEVEL_OFF),
-      lastLevelAdjust(0),
-      tankLockout(false),
-      pumpEnabled(true),
       timeSynced(false),
       leakSnapshotValid(false),
       leakSnapshotEpoch(0),
       lastLeakSnapshotSave(0),
       tankMaintLastService(0),
-      tankMaintValid(false) {
+      tankMaintValid(false),
+      downloadKind(DOWNLOAD_NONE),
+      downloadOffset(0),
+      downloadSize(0) {
     // Initialize presets from defaults
     for (int p = 0; p < NUM_PRESETS; p++) {
         currentPresets[p][0] = DEFAULT_PRESETS[p].frontLeft;
@@ -28,17 +32,7 @@ AirRideWebServer::AirRideWebServer(AirBag* b, Compressor* c, float* tp)
     }
 }
 
-void AirRideWebServer::begin() {
-    Serial.print("Starting WiFi AP...");
-
-    // Configure ESP32 as Access Point
-    WiFi.mode(WIFI_AP);
-    WiFi.softAP(WIFI_SSID, WIFI_PASS, WIFI_CHANNEL, 0, MAX_WIFI_CLIENTS);
-
-    delay(100);
-
-    wifiReady = true;
-
+void AirRideWebServer::loadSettings() {
     // Load custom presets from EEPROM
     loadPresetsFromEEPROM();
 
@@ -50,6 +44,19 @@ void AirRideWebServer::begin() {
 
     // Load sensor calibration from EEPROM
     loadCalibrationFromEEPROM();
+}
+
+void AirRideWebServer::startAccessPoint() {
+    // Configure ESP32 as Access Point (softAP() returns once the AP is up)
+    WiFi.mode(WIFI_AP);
+    WiFi.softAP(WIFI_SSID, WIFI_PASS, WIFI_CHANNEL, 0, MAX_WIFI_CLIENTS);
+
+    wifiReady = true;
+}
+
+void AirRideWebServer::begin() {
+    Serial.print("Starting WiFi AP...");
+    startAccessPoint();
 
     // Setup routes
     server.on("/", HTTP_GET, [this]() { handleRoot(); });
@@ -66,9 +73,14 @@ void AirRideWebServer::begin() {
     server.on("/demo", HTTP_GET, [this]() { handleDemoToggle(); });
     server.on("/leak", HTTP_GET, [this]() { handleLeakStatus(); });
     server.on("/tank", HTTP_GET, [this]() { handleTankMaint(); });
+    server.on("/pump", HTTP_GET, [this]() { handlePumpHealth(); });
     server.on("/simleak", HTTP_GET, [this]() { handleSimLeak(); });
     server.on("/cal", HTTP_GET, [this]() { handleCalibration(); });
     server.on("/calreset", HTTP_GET, [this]() { handleCalibrationReset(); });
+    server.on("/trace", HTTP_GET, [this]() { handleTrace(); });
+    server.on("/diag", HTTP_GET, [this]() { handleDiag(); });
+    server.on("/coredump", HTTP_GET, [this]() { handleCoreDump(); });
+    server.on("/park", HTTP_GET, [this]() { handlePark(); });
     server.onNotFound([this]() { handleNotFound(); });
 
     server.begin();
@@ -86,16 +98,40 @@ void AirRideWebServer::update() {
     if (!wifiReady) return;
     server.handleClient();
 
-    // Update tank lockout state
-    updateTankLockout(*tankPressure);
-
-    // Update level mode
-    updateLevelMode();
+    // One chunk of a pending download per pass
+    if (downloadKind != DOWNLOAD_NONE) sendDownloadChunk();
 
     // Periodic leak snapshot save
     updateLeakSnapshot();
 }
 
+void AirRideWebServer::suspend() {
+    if (!wifiReady) return;
+
+    // Baseline for the leak checks made while parked
+    if (timeSynced) {
+        saveLeakSnapshot();
+    }
+
+    if (downloadKind != DOWNLOAD_NONE) endDownload("aborted (parking)");
+    server.close();
+    WiFi.softAPdisconnect(true);
+    WiFi.mode(WIFI_OFF);
+    wifiReady = false;
+    Serial.println("[WEB] WiFi AP off");
+}
+
+void AirRideWebServer::resume() {
+    if (wifiReady) return;
+    startAccessPoint();
+    server.begin();
+
+    // Keep the park baseline for a full interval so /leak can show it
+    lastLeakSnapshotSave = millis();
+    Serial.print("[WEB] WiFi AP back on: ");
+    Serial.println(WiFi.softAPIP());
+}
+
 void AirRideWebServer::handleRoot() {
     Serial.println("[WEB] GET / - Serving React UI (gzip, " + String(HTML_CONTENT_SIZE) + " bytes)");
     // Serve gzipped React UI from PROGMEM
@@ -113,7 +149,7 @@ void AirRideWebServer::handleDebug() {
 
 void AirRideWebServer::handleStatus() {
     String json = "{\"tank\":";
-    json += String(*tankPressure, 1);
+    json += String(controller->getTankPressure(), 1);
     json += ",\"bags\":[";
     for (int i = 0; i < NUM_BAGS; i++) {
         if (i > 0) json += ",";
@@ -129,6 +165,39 @@ void AirRideWebServer::handleStatus() {
         if (i > 0) json += ",";
         json += bags[i].isSolenoidTimedOut() ? "true" : "false";
     }
+
+    // Stance ramps: the setpoint each corner is following right now
+    const TrajectoryGenerator& trajectory = controller->getTrajectory();
+    json += "],\"setpoints\":[";
+    for (int i = 0; i < NUM_BAGS; i++) {
+        if (i > 0) json += ",";
+        json += String(trajectory.getSetpoint(i), 1);
+    }
+    json += "],\"ramps\":[";
+    for (int i = 0; i < NUM_BAGS; i++) {
+        if (i > 0) json += ",";
+        json += "\"";
+        json += trajectory.isRamping(i) ? TrajectoryGenerator::profileName(trajectory.getProfile(i)) : "";
+        json += "\"";
+    }
+
+    // Learned target band per corner and the sensor noise behind it
+    const DeadbandEstimator& deadband = controller->getDeadband();
+    json += "],\"bands\":[";
+    for (int i = 0; i < NUM_BAGS; i++) {
+        if (i > 0) json += ",";
+        json += String(deadband.getBand(i), 2);
+    }
+    json += "],\"noise\":[";
+    for (int i = 0; i < NUM_BAGS; i++) {
+        if (i > 0) json += ",";
+        json += String(deadband.getNoise(i), 2);
+    }
+    json += "],\"fillLeads\":[";
+    for (int i = 0; i < NUM_BAGS; i++) {
+        if (i > 0) json += ",";
+        json += String(controller->getFillLead(i), 2);
+    }
     json += "],\"pump\":\"";
     json += compressor->getModeString();
     json += " P1:";
@@ -140,14 +209,156 @@ void AirRideWebServer::handleStatus() {
     json += "h P2:";
     json += String(compressor->getPump2RuntimeHours(), 1);
     json += "h\",\"level\":";
-    json += String((int)levelMode);
+    json += String((int)controller->getLevelMode());
+
+    // Level controller: phase, worst relation error, pitch it holds
+    const LevelController& leveler = controller->getLeveler();
+    json += ",\"leveling\":{\"state\":\"";
+    json += LevelController::phaseName(leveler.getPhase());
+    json += "\",\"residual\":";
+    json += String(leveler.getResidual(), 1);
+    json += ",\"pitch\":";
+    json += String(leveler.getPitchTarget(), 1);
+    json += ",\"pitchHeld\":";
+    json += leveler.isPitchHeld() ? "true" : "false";
+    json += ",\"corrections\":";
+    json += String(leveler.getCorrections());
+    json += ",\"moves\":";
+    json += String(leveler.getCornerMoves());
+    json += "}";
     json += ",\"lockout\":";
-    json += tankLockout ? "true" : "false";
+    json += controller->isTankLockout() ? "true" : "false";
     json += ",\"pumpEnabled\":";
-    json += pumpEnabled ? "true" : "false";
+    json += controller->isPumpEnabled() ? "true" : "false";
     json += ",\"demo\":";
     json += demoMode ? "true" : "false";
 
+    // Coordinated preset move: progress, planned vs achieved
+    const TransitionPlanner& planner = controller->getPlanner();
+    const PlanReport& plan = planner.getReport();
+    json += ",\"plan\":{\"state\":\"";
+    json += TransitionPlanner::outcomeName(plan.outcome);
+    json += "\",\"staged\":";
+    json += planner.isStaged() ? "true" : "false";
+    json += ",\"progress\":";
+    json += String(planner.isActive() ? planner.getProgress() : (plan.outcome == PLAN_COMPLETE ? 1.0 : 0.0), 2);
+    json += ",\"plannedMs\":";
+    json += String(plan.plannedMs);
+    json += ",\"achievedMs\":";
+    json += String(plan.achievedMs);
+    json += ",\"tankPredicted\":";
+    json += String(plan.tankPredicted, 1);
+    json += ",\"tankEnd\":";
+    json += String(plan.tankEnd, 1);
+    json += ",\"pauses\":";
+    json += String(plan.stages);
+    json += ",\"spread\":";
+    json += String(plan.worstSpread, 2);
+    json += "}";
+
+    // Air budget: last move predicted vs drawn, volumes, totals
+    const AirBudget& air = controller->getAirBudget();
+    const AirMove& airMove = air.getMove();
+    json += ",\"air\":{\"state\":\"";
+    json += AirBudget::stateName(airMove.state);
+    json += "\",\"corners\":";
+    json += String(airMove.estimate.corners);
+    json += ",\"feasible\":";
+    json += airMove.estimate.feasible ? "true" : "false";
+    json += ",\"prestart\":";
+    json += airMove.estimate.prestart ? "true" : "false";
+    json += ",\"estScf\":";
+    json += String(airMove.estimate.scf, 3);
+    json += ",\"estMs\":";
+    json += String(airMove.estimate.ms);
+    json += ",\"estTank\":";
+    json += String(airMove.estimate.tankEnd, 1);
+    json += ",\"scf\":";
+    json += String(airMove.scf, 3);
+    json += ",\"ms\":";
+    json += String(airMove.achievedMs);
+    json += ",\"tank\":";
+    json += String(airMove.tankEnd, 1);
+    json += ",\"usable\":";
+    json += String(air.getUsableScf(controller->getTankPressure()), 3);
+    json += ",\"total\":";
+    json += String(air.getTotalScf(), 3);
+    json += ",\"cornerScf\":[";
+    for (int i = 0; i < NUM_BAGS; i++) {
+        if (i > 0) json += ",";
+        json += String(air.getCornerScf(i), 3);
+    }
+    json += "],\"bagL\":[";
+    for (int i = 0; i < NUM_BAGS; i++) {
+        if (i > 0) json += ",";
+        json += String(air.getBagVolumeL(i), 2);
+    }
+    json += "],\"tankL\":";
+    json += String(air.getTankVolumeL(), 1);
+    json += "}";
+
+    // Corners waiting out a tank lockout, in release order
+    const InflateQueue& queue = controller->getInflateQueue();
+    json += ",\"queue\":{\"queued\":";
+    json += String(queue.getQueued());
+    json += ",\"released\":";
+    json += String(queue.getReleased());
+    json += ",\"pumpsForced\":";
+    json += compressor->hasDemand() ? "true" : "false";
+    json += ",\"deferrals\":";
+    json += String(queue.getDeferrals());
+    json += ",\"priority\":[";
+    for (int i = 0; i < NUM_BAGS; i++) {
+        if (i > 0) json += ",";
+        json += String(InflateQueue::priorityOf(i));
+    }
+    json += "],\"waitMs\":[";
+    for (int i = 0; i < NUM_BAGS; i++) {
+        if (i > 0) json += ",";
+        json += String(queue.getWaitMs(i));
+    }
+    json += "],\"needPsi\":[";
+    for (int i = 0; i < NUM_BAGS; i++) {
+        if (i > 0) json += ",";
+        json += String(max(0.0f, queue.getNeedPsi(i)), 1);
+    }
+    json += "]}";
+
+    // Pump scheduling: starts, duty, heat estimate, rests, fill forecast
+    const PumpScheduler& sched = compressor->getScheduler();
+    json += ",\"pumps\":{\"starts\":[";
+    json += String(sched.getStarts(0));
+    json += ",";
+    json += String(sched.getStarts(1));
+    json += "],\"duty\":[";
+    json += String(sched.getDuty(0), 2);
+    json += ",";
+    json += String(sched.getDuty(1), 2);
+    json += "],\"heat\":[";
+    json += String(sched.getHeatC(0), 0);
+    json += ",";
+    json += String(sched.getHeatC(1), 0);
+    json += "],\"resting\":[";
+    json += sched.isResting(0) ? "true" : "false";
+    json += ",";
+    json += sched.isResting(1) ? "true" : "false";
+    json += "],\"timeToFullS\":";
+    float toFull = compressor->getTimeToFullS(controller->getTankPressure());
+    json += isnan(toFull) ? String("null") : String(toFull, 0);
+    json += ",\"forecastPsi\":";
+    json += String(sched.getForecastPsi(), 1);
+    json += ",\"relayStarts\":";
+    json += String(actuators.getMotorStarts());
+    json += ",\"startsAfterValves\":";
+    json += String(actuators.getDeferredStarts());
+    json += ",\"heldSamples\":";
+    json += String(controller->getHeldSamples());
+    json += ",\"health\":[";
+    json += String(compressor->getHealth().getScore(0));
+    json += ",";
+    json += String(compressor->getHealth().getScore(1));
+    json += "]}";
+
     // Current preset values (may be customized)
     json += ",\"presets\":[";
     for (int p = 0; p < NUM_PRESETS; p++) {
@@ -231,15 +442,9 @@ void AirRideWebServer::handleBag() {
         Serial.print(dir > 0 ? "INFLATE" : "DEFLATE");
 
         if (bagNum >= 0 && bagNum < NUM_BAGS) {
+            float current = bags[bagNum].getPressure();
             if (dir > 0) {
-                // Check tank lockout before inflating
-                if (!tankLockout) {
-                    bags[bagNum].inflate();
-                    // Move target ahead so updateTargetTracking doesn't fight manual control
-                    float current = bags[bagNum].getPressure();
-                    if (bags[bagNum].getTargetPressure() <= current) {
-                        bags[bagNum].setTargetPressure(MAX_BAG_PSI);
-                    }
+                if (controller->manualInflate(bagNum)) {
                     Serial.print(" cur=");
                     Serial.print(current, 1);
                     Serial.println(" OK");
@@ -247,12 +452,7 @@ void AirRideWebServer::handleBag() {
                     Serial.println(" BLOCKED (tank lockout)");
                 }
             } else {
-                bags[bagNum].deflate();
-                // Move target down so updateTargetTracking doesn't fight manual control
-                float current = bags[bagNum].getPressure();
-                if (bags[bagNum].getTargetPressure() >= current) {
-                    bags[bagNum].setTargetPressure(MIN_BAG_PSI);
-                }
+                controller->manualDeflate(bagNum);
                 Serial.print(" cur=");
                 Serial.print(current, 1);
                 Serial.println(" OK");
@@ -269,9 +469,8 @@ void AirRideWebServer::handleBagHold() {
     if (server.hasArg("n")) {
         int bagNum = server.arg("n").toInt();
         if (bagNum >= 0 && bagNum < NUM_BAGS) {
-            bags[bagNum].hold();
-            float lockedPsi = bags[bagNum].getPressure();
-            bags[bagNum].setTargetPressure(lockedPsi);
+            controller->holdBag(bagNum);
+            float lockedPsi = bags[bagNum].getTargetPressure();
             Serial.print("[WEB] /bh RELEASE bag=");
             Serial.print(bagNum);
             Serial.print(" locked at ");
@@ -282,37 +481,31 @@ void AirRideWebServer::handleBagHold() {
     handleStatus();
 }
 
+RampProfile AirRideWebServer::rampArg() {
+    // Optional &r=fast|comfort|show (or f/c/s, 0-2); anything else = default
+    RampProfile profile = (RampProfile)RAMP_DEFAULT_PROFILE;
+    if (server.hasArg("r")) {
+        TrajectoryGenerator::parseProfile(server.arg("r").c_str(), profile);
+    }
+    return profile;
+}
+
 void AirRideWebServer::handleBagTarget() {
-    // Set target pressure for a specific bag: /bt?n=<bag>&t=<psi>
+    // Set target pressure for a specific bag: /bt?n=<bag>&t=<psi>[&r=<ramp>]
     if (server.hasArg("n") && server.hasArg("t")) {
         int bagNum = server.arg("n").toInt();
         float targetPsi = server.arg("t").toFloat();
+        RampProfile profile = rampArg();
 
         Serial.print("[WEB] /bt TARGET bag=");
         Serial.print(bagNum);
         Serial.print(" target=");
         Serial.print(targetPsi, 1);
-        Serial.println(" PSI");
+        Serial.print(" PSI ramp=");
+        Serial.println(TrajectoryGenerator::profileName(profile));
 
-        if (bagNum >= 0 && bagNum < NUM_BAGS) {
-            // Clamp to safe range
-            if (targetPsi < MIN_BAG_PSI) targetPsi = MIN_BAG_PSI;
-            if (targetPsi > MAX_BAG_PSI) targetPsi = MAX_BAG_PSI;
-
-            bags[bagNum].setTargetPressure(targetPsi);
-
-            // Start moving to target
-            float current = bags[bagNum].getPressure();
-            if (current < targetPsi - 2.0) {
-                if (!tankLockout) {
-                    bags[bagNum].inflate();
-                }
-            } else if (current > targetPsi + 2.0) {
-                bags[bagNum].deflate();
-            } else {
-                bags[bagNum].hold();
-            }
-        }
+        // Clamped to the safe range by AirBag::setTargetPressure()
+        controller->setBagTarget(bagNum, targetPsi, profile);
     }
     handleStatus();
 }
@@ -320,6 +513,7 @@ void AirRideWebServer::handleBagTarget() {
 void AirRideWebServer::handlePreset() {
     if (server.hasArg("n")) {
         int presetNum = server.arg("n").toInt();
+        RampProfile profile = rampArg();
 
         if (presetNum >= 0 && presetNum < NUM_PRESETS) {
             Serial.print("[WEB] /p PRESET ");
@@ -333,9 +527,11 @@ void AirRideWebServer::handlePreset() {
             Serial.print(" RL=");
             Serial.print(currentPresets[presetNum][2], 0);
             Serial.print(" RR=");
-            Serial.println(currentPresets[presetNum][3], 0);
+            Serial.print(currentPresets[presetNum][3], 0);
+            Serial.print(" ramp=");
+            Serial.println(TrajectoryGenerator::profileName(profile));
 
-            applyPreset(presetNum);
+            applyPreset(presetNum, profile);
         }
     }
     handleStatus();
@@ -344,40 +540,40 @@ void AirRideWebServer::handlePreset() {
 void AirRideWebServer::handleSavePreset() {
     if (server.hasArg("n") && server.hasArg("fl") && server.hasArg("fr") && server.hasArg("rl") && server.hasArg("rr")) {
         int presetNum = server.arg("n").toInt();
-        float fl = server.arg("fl").toFloat();
-        float fr = server.arg("fr").toFloat();
-        float rl = server.arg("rl").toFloat();
-        float rr = server.arg("rr").toFloat();
-
-        if (presetNum >= 0 && presetNum < NUM_PRESETS) {
-            // Clamp values to safe range
-            fl = constrain(fl, MIN_BAG_PSI, MAX_BAG_PSI);
-            fr = constrain(fr, MIN_BAG_PSI, MAX_BAG_PSI);
-            rl = constrain(rl, MIN_BAG_PSI, MAX_BAG_PSI);
-            rr = constrain(rr, MIN_BAG_PSI, MAX_BAG_PSI);
-
-            currentPresets[presetNum][0] = fl;
-            currentPresets[presetNum][1] = fr;
-            currentPresets[presetNum][2] = rl;
-            currentPresets[presetNum][3] = rr;
-
-            savePresetToEEPROM(presetNum);
-
+        float psi[NUM_BAGS] = {
+            server.arg("fl").toFloat(),
+            server.arg("fr").toFloat(),
+            server.arg("rl").toFloat(),
+            server.arg("rr").toFloat()
+        };
+
+        if (savePreset(presetNum, psi)) {
             Serial.print("[WEB] /sp SAVE PRESET ");
             Serial.print(DEFAULT_PRESETS[presetNum].name);
             Serial.print(" FL=");
-            Serial.print(fl, 0);
+            Serial.print(currentPresets[presetNum][0], 0);
             Serial.print(" FR=");
-            Serial.print(fr, 0);
+            Serial.print(currentPresets[presetNum][1], 0);
             Serial.print(" RL=");
-            Serial.print(rl, 0);
+            Serial.print(currentPresets[presetNum][2], 0);
             Serial.print(" RR=");
-            Serial.println(rr, 0);
+            Serial.println(currentPresets[presetNum][3], 0);
         }
     }
     handleStatus();
 }
 
+bool AirRideWebServer::savePreset(int presetNum, const float psi[NUM_BAGS]) {
+    if (presetNum < 0 || presetNum >= NUM_PRESETS) return false;
+
+    // Clamp values to safe range
+    for (int i = 0; i < NUM_BAGS; i++) {
+        currentPresets[presetNum][i] = constrain(psi[i], MIN_BAG_PSI, MAX_BAG_PSI);
+    }
+    savePresetToEEPROM(presetNum);
+    return true;
+}
+
 void AirRideWebServer::savePresetToEEPROM(int presetNum) {
     if (presetNum < 0 || presetNum >= NUM_PRESETS) return;
 
@@ -476,53 +672,42 @@ void AirRideWebServer::handleLevel() {
         int mode = server.arg("m").toInt();
         const char* modeNames[] = {"OFF", "FRONT", "REAR", "ALL"};
         if (mode >= 0 && mode <= 3) {
-            levelMode = (LevelMode)mode;
+            controller->setLevelMode((LevelMode)mode);
             Serial.print("[WEB] /l LEVEL mode=");
             Serial.println(modeNames[mode]);
         }
     }
+    if (server.hasArg("p")) {
+        // Front-minus-rear pitch for LEVEL_ALL, "hold" keeps the stance's own
+        String pitch = server.arg("p");
+        bool hold = (pitch == "hold");
+        float psi = hold ? NAN : pitch.toFloat();
+        if (hold || abs(psi) <= MAX_BAG_PSI) {
+            controller->setLevelPitch(psi);
+            Serial.print("[WEB] /l LEVEL pitch=");
+            Serial.println(hold ? String("hold") : String(psi, 1));
+        }
+    }
     handleStatus();
 }
 
 void AirRideWebServer::handlePumpOverride() {
-    pumpEnabled = !pumpEnabled;
+    controller->setPumpEnabled(!controller->isPumpEnabled());
     Serial.print("[WEB] /po PUMP OVERRIDE ");
-    Serial.println(pumpEnabled ? "ENABLED" : "DISABLED");
-    if (!pumpEnabled) {
-        compressor->setMode(PUMP_OFF);
-    } else {
-        compressor->setMode(PUMP_AUTO);
-    }
+    Serial.println(controller->isPumpEnabled() ? "ENABLED" : "DISABLED");
     handleStatus();
 }
 
 void AirRideWebServer::handleDemoToggle() {
-    setDemoMode(!demoMode);
+    controller->setDemoMode(!demoMode);
     handleStatus();
 }
 
-void AirRideWebServer::applyPreset(int presetNum) {
+void AirRideWebServer::applyPreset(int presetNum, RampProfile profile) {
     if (presetNum < 0 || presetNum >= NUM_PRESETS) return;
 
-    bags[FRONT_LEFT].setTargetPressure(currentPresets[presetNum][0]);
-    bags[FRONT_RIGHT].setTargetPressure(currentPresets[presetNum][1]);
-    bags[REAR_LEFT].setTargetPressure(currentPresets[presetNum][2]);
-    bags[REAR_RIGHT].setTargetPressure(currentPresets[presetNum][3]);
-
-    // Start moving to targets
-    for (int i = 0; i < NUM_BAGS; i++) {
-        float current = bags[i].getPressure();
-        float target = bags[i].getTargetPressure();
-        if (current < target - 2.0) {
-            if (!tankLockout) {
-                bags[i].inflate();
-            }
-        } else if (current > target + 2.0) {
-            bags[i].deflate();
-        } else {
-            bags[i].hold();
-        }
-    }
+    // currentPresets rows are [FL, FR, RL, RR], matching bag indices
+    controller->applyTargets(currentPresets[presetNum], profile);
 }
 
 const char* AirRideWebServer::getPresetName(int presetNum) const {
@@ -534,25 +719,29 @@ const char* AirRideWebServer::getPresetName(int presetNum) const {
 
 void AirRideWebServer::handleTimeSync() {
     if (server.hasArg("t")) {
-        long epoch = server.arg("t").toInt();
-        if (epoch > 1600000000L) { // Sanity check: after ~Sep 2020
-            struct timeval tv;
-            tv.tv_sec = epoch;
-            tv.tv_usec = 0;
-            settimeofday(&tv, NULL);
-            timeSynced = true;
-
-            struct tm timeinfo;
-            localtime_r(&tv.tv_sec, &timeinfo);
-            char buf[32];
-            strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &timeinfo);
-            Serial.print("[WEB] /time synced from browser: ");
-            Serial.println(buf);
-        }
+        syncTime(server.arg("t").toInt());
     }
     server.send(200, "application/json", "{\"ok\":true}");
 }
 
+bool AirRideWebServer::syncTime(long epoch) {
+    if (epoch <= 1600000000L) return false; // Sanity check: after ~Sep 2020
+
+    struct timeval tv;
+    tv.tv_sec = epoch;
+    tv.tv_usec = 0;
+    settimeofday(&tv, NULL);
+    timeSynced = true;
+
+    struct tm timeinfo;
+    localtime_r(&tv.tv_sec, &timeinfo);
+    char buf[32];
+    strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &timeinfo);
+    Serial.print("[TIME] Clock synced: ");
+    Serial.println(buf);
+    return true;
+}
+
 // ============================================
 // LEAK MONITOR
 // ============================================
@@ -599,7 +788,7 @@ void AirRideWebServer::saveLeakSnapshot() {
     leakSnapshotPressures[1] = bags[FRONT_RIGHT].getPressure();
     leakSnapshotPressures[2] = bags[REAR_LEFT].getPressure();
     leakSnapshotPressures[3] = bags[REAR_RIGHT].getPressure();
-    leakSnapshotPressures[4] = *tankPressure;
+    leakSnapshotPressures[4] = controller->getTankPressure();
 
     EEPROM.write(EEPROM_ADDR_LEAK_FLAG, LEAK_SNAPSHOT_VALID);
     EEPROM.put(EEPROM_ADDR_LEAK_TIME, leakSnapshotEpoch);
@@ -635,7 +824,7 @@ void AirRideWebServer::updateLeakSnapshot() {
     }
 
     // Need at least one sensor with meaningful pressure
-    bool hasPressure = (*tankPressure > LEAK_MIN_SNAPSHOT_PSI);
+    bool hasPressure = (controller->getTankPressure() > LEAK_MIN_SNAPSHOT_PSI);
     if (!hasPressure) {
         for (int i = 0; i < NUM_BAGS; i++) {
             if (bags[i].getPressure() > LEAK_MIN_SNAPSHOT_PSI) {
@@ -649,13 +838,17 @@ void AirRideWebServer::updateLeakSnapshot() {
     saveLeakSnapshot();
 }
 
+void AirRideWebServer::resetLeakSnapshot() {
+    EEPROM.write(EEPROM_ADDR_LEAK_FLAG, 0);
+    EEPROM.commit();
+    leakSnapshotValid = false;
+    leakSnapshotEpoch = 0;
+}
+
 void AirRideWebServer::handleLeakStatus() {
     // Handle reset
     if (server.hasArg("reset") && server.arg("reset") == "1") {
-        EEPROM.write(EEPROM_ADDR_LEAK_FLAG, 0);
-        EEPROM.commit();
-        leakSnapshotValid = false;
-        leakSnapshotEpoch = 0;
+        resetLeakSnapshot();
         Serial.println("[WEB] /leak RESET — snapshot cleared");
         server.send(200, "application/json", "{\"valid\":false}");
         return;
@@ -672,11 +865,7 @@ void AirRideWebServer::handleLeakStatus() {
     float elapsedHours = elapsed / 3600.0;
 
     float current[5];
-    current[0] = bags[FRONT_LEFT].getPressure();
-    current[1] = bags[FRONT_RIGHT].getPressure();
-    current[2] = bags[REAR_LEFT].getPressure();
-    current[3] = bags[REAR_RIGHT].getPressure();
-    current[4] = *tankPressure;
+    readLeakSensors(current);
 
     String json = "{\"valid\":true,\"elapsed\":";
     json += String(elapsed);
@@ -704,24 +893,61 @@ void AirRideWebServer::handleLeakStatus() {
     json += "],\"status\":[";
     for (int i = 0; i < 5; i++) {
         if (i > 0) json += ",";
-        float drop = leakSnapshotPressures[i] - current[i];
-        float rate = (elapsedHours > 0.01) ? (drop / elapsedHours) : 0.0;
-        // Sensors that weren't pressurized are always "ok"
-        if (leakSnapshotPressures[i] < LEAK_MIN_SNAPSHOT_PSI) {
-            json += "0";
-        } else if (drop >= LEAK_ALERT_DROP_PSI && rate >= LEAK_ALERT_RATE_PSI_HR) {
-            json += "2"; // leak
-        } else if (drop >= LEAK_WARN_DROP_PSI && rate >= LEAK_WARN_RATE_PSI_HR) {
-            json += "1"; // warn
-        } else {
-            json += "0"; // ok
-        }
+        json += String(leakStatus(i, current[i], elapsedHours));
     }
     json += "]}";
 
     server.send(200, "application/json", json);
 }
 
+void AirRideWebServer::readLeakSensors(float current[NUM_BAGS + 1]) const {
+    current[0] = bags[FRONT_LEFT].getPressure();
+    current[1] = bags[FRONT_RIGHT].getPressure();
+    current[2] = bags[REAR_LEFT].getPressure();
+    current[3] = bags[REAR_RIGHT].getPressure();
+    current[4] = controller->getTankPressure();
+}
+
+int AirRideWebServer::leakStatus(int sensor, float current, float elapsedHours) const {
+    float drop = leakSnapshotPressures[sensor] - current;
+    float rate = (elapsedHours > 0.01) ? (drop / elapsedHours) : 0.0;
+    // Sensors that weren't pressurized are always "ok"
+    if (leakSnapshotPressures[sensor] < LEAK_MIN_SNAPSHOT_PSI) {
+        return 0;
+    } else if (drop >= LEAK_ALERT_DROP_PSI && rate >= LEAK_ALERT_RATE_PSI_HR) {
+        return 2; // leak
+    } else if (drop >= LEAK_WARN_DROP_PSI && rate >= LEAK_WARN_RATE_PSI_HR) {
+        return 1; // warn
+    }
+    return 0; // ok
+}
+
+int AirRideWebServer::checkLeaks() {
+    if (!leakSnapshotValid || !timeSynced) return -1;
+
+    long elapsed = (long)time(NULL) - (long)leakSnapshotEpoch;
+    float elapsedHours = (elapsed > 0 ? elapsed : 0) / 3600.0;
+
+    float current[NUM_BAGS + 1];
+    readLeakSensors(current);
+
+    int worst = 0;
+    for (int i = 0; i < NUM_BAGS + 1; i++) {
+        int status = leakStatus(i, current[i], elapsedHours);
+        if (status > 0) {
+            Serial.print(status == 2 ? "[LEAK] " : "[LEAK] Warning: ");
+            Serial.print(i < NUM_BAGS ? bags[i].getName() : "Tank");
+            Serial.print(" down ");
+            Serial.print(leakSnapshotPressures[i] - current[i], 1);
+            Serial.print(" PSI in ");
+            Serial.print(elapsedHours, 1);
+            Serial.println(" h");
+        }
+        if (status > worst) worst = status;
+    }
+    return worst;
+}
+
 // ============================================
 // TANK MAINTENANCE TIMER
 // ============================================
@@ -775,23 +1001,32 @@ int AirRideWebServer::getTankMaintDaysRemaining() const {
     return (int)(TANK_MAINT_INTERVAL_SEC - elapsed) / 86400;
 }
 
+bool AirRideWebServer::resetTankMaint() {
+    if (!timeSynced) return false;
+    saveTankMaintToEEPROM((uint32_t)time(NULL));
+    return true;
+}
+
+bool AirRideWebServer::setTankMaint(uint32_t epoch) {
+    if (epoch <= 1600000000UL) return false;
+    saveTankMaintToEEPROM(epoch);
+    return true;
+}
+
 void AirRideWebServer::handleTankMaint() {
     // Reset: mark current time as last service
     if (server.hasArg("reset") && server.arg("reset") == "1") {
-        if (!timeSynced) {
+        if (!resetTankMaint()) {
             server.send(200, "application/json", "{\"error\":\"Time not synced\"}");
             return;
         }
-        time_t now = time(NULL);
-        saveTankMaintToEEPROM((uint32_t)now);
         Serial.println("[WEB] /tank RESET — service complete");
     }
 
     // Set specific epoch (debug): /tank?set=<epoch>
     if (server.hasArg("set")) {
         uint32_t epoch = (uint32_t)server.arg("set").toInt();
-        if (epoch > 1600000000UL) {
-            saveTankMaintToEEPROM(epoch);
+        if (setTankMaint(epoch)) {
             Serial.print("[WEB] /tank SET epoch=");
             Serial.println(epoch);
         }
@@ -817,11 +1052,102 @@ void AirRideWebServer::handleTankMaint() {
     server.send(200, "application/json", json);
 }
 
+void AirRideWebServer::handlePumpHealth() {
+    // Service done on one pump: runtime, starts and as-new curve start over
+    if (server.hasArg("reset")) {
+        int pump = server.arg("reset").toInt();
+        if (pump == 1) compressor->resetPump1Runtime();
+        if (pump == 2) compressor->resetPump2Runtime();
+    }
+
+    const PumpHealth& health = compressor->getHealth();
+    String json = "{\"bandPsi\":";
+    json += String(PUMP_CURVE_BIN_PSI, 0);
+    json += ",\"maintenanceHours\":";
+    json += String(PUMP_MAINTENANCE_HOURS, 0);
+    json += ",\"overdueHours\":";
+    json += String(PUMP_OVERDUE_HOURS, 0);
+    json += ",\"servicePct\":";
+    json += String(PUMP_FLOW_SERVICE_PCT);
+    json += ",\"pumps\":[";
+    for (int p = 0; p < 2; p++) {
+        float hours = (p == 0) ? compressor->getPump1RuntimeHours() : compressor->getPump2RuntimeHours();
+        bool due = (p == 0) ? compressor->isPump1MaintenanceDue() : compressor->isPump2MaintenanceDue();
+        bool overdue = (p == 0) ? compressor->isPump1Overdue() : compressor->isPump2Overdue();
+        const PumpCurve& curve = health.getCurve(p);
+
+        if (p > 0) json += ",";
+        json += "{\"hours\":";
+        json += String(hours, 2);
+        json += ",\"maintenanceDue\":";
+        json += due ? "true" : "false";
+        json += ",\"overdue\":";
+        json += overdue ? "true" : "false";
+        json += ",\"starts\":";
+        json += String(compressor->getScheduler().getStarts(p));
+        json += ",\"flowPct\":";
+        json += String(health.getFlowPct(p));
+        json += ",\"score\":";
+        json += String(health.getScore(p));
+        json += ",\"degraded\":";
+        json += health.isDegraded(p) ? "true" : "false";
+        json += ",\"trendPctPerHour\":";
+        float trend = health.getTrendPctPerHour(p);
+        json += isnan(trend) ? String("null") : String(trend, 2);
+        json += ",\"serviceHours\":";
+        json += String(compressor->getServiceHours(p), 1);
+        json += ",\"serviceEpoch\":";
+        json += String(health.getServiceEpoch(p, hours));
+
+        // PSI/min per tank band (0 = not measured yet)
+        json += ",\"curve\":[";
+        for (int b = 0; b < PUMP_CURVE_BINS; b++) {
+            if (b > 0) json += ",";
+            json += String(curve.current[b], 1);
+        }
+        json += "],\"asNew\":[";
+        for (int b = 0; b < PUMP_CURVE_BINS; b++) {
+            if (b > 0) json += ",";
+            json += String(curve.fills[b] >= PUMP_CURVE_BASELINE_FILLS ? curve.baseline[b] : 0.0f, 1);
+        }
+        json += "],\"windows\":[";
+        for (int b = 0; b < PUMP_CURVE_BINS; b++) {
+            if (b > 0) json += ",";
+            json += String(curve.fills[b]);
+        }
+
+        PumpFlowRecord history[PUMP_HISTORY_SIZE];
+        int count = health.getHistory(p, history, PUMP_HISTORY_SIZE);
+        json += "],\"history\":[";
+        for (int i = 0; i < count; i++) {
+            if (i > 0) json += ",";
+            json += "{\"hours\":";
+            json += String(history[i].hoursX10 / 10.0, 1);
+            json += ",\"flowPct\":";
+            json += String(history[i].flowPct);
+            json += ",\"epoch\":";
+            json += String(history[i].epoch);
+            json += "}";
+        }
+        json += "]}";
+    }
+    json += "],\"timeSynced\":";
+    json += timeSynced ? "true" : "false";
+    json += "}";
+
+    server.send(200, "application/json", json);
+}
+
 void AirRideWebServer::handleSimLeak() {
     // Start simulated leak: /simleak?target=<0-4|random>  (0=FL,1=FR,2=RL,3=RR,4=tank)
     // Stop simulated leak:  /simleak?stop=1
     // Optional rate:        /simleak?target=2&rate=0.3
 
+    if (!Hal::SIMULATED) {
+        server.send(400, "application/json", "{\"error\":\"Simulation not available in this build\"}");
+        return;
+    }
+
     if (server.hasArg("stop") && server.arg("stop") == "1") {
         simLeakTarget = -1;
         Serial.println("[SIM] Leak simulation STOPPED");
@@ -907,14 +1233,8 @@ void AirRideWebServer::loadCalibrationFromEEPROM() {
             continue;
         }
 
-        if (i == 0) {
-            // Tank sensor
-            tankCalibration = cal;
-            tankCalibrated = (cal.offset != 0.0 || cal.gain != 1.0 || cal.refResistor != REFERENCE_RESISTOR);
-        } else {
-            // Bag sensor (index 1-4 maps to bags[0-3])
-            bags[i - 1].setCalibration(cal);
-        }
+        // Index 0 = tank, 1-4 maps to bags[0-3]
+        controller->setSensorCalibration(i, cal);
 
         Serial.print(sensorNames[i]);
         Serial.print("(o=");
@@ -1027,22 +1347,9 @@ void AirRideWebServer::handleCalibration() {
             changed = true;
         }
 
-        if (changed) {
-            if (!validateCalibration(cal)) {
-                server.send(400, "application/json", "{\"error\":\"Calibration out of bounds\"}");
-                return;
-            }
-
-            // Apply the calibration
-            if (sensor == 0) {
-                tankCalibration = cal;
-                tankCalibrated = (cal.offset != 0.0 || cal.gain != 1.0 || cal.refResistor != REFERENCE_RESISTOR);
-            } else {
-                bags[sensor - 1].setCalibration(cal);
-            }
-
-            // Save to EEPROM
-            saveCalibrationToEEPROM();
+        if (changed && !setCalibration(sensor, cal)) {
+            server.send(400, "application/json", "{\"error\":\"Calibration out of bounds\"}");
+            return;
         }
     }
 
@@ -1059,7 +1366,7 @@ void AirRideWebServer::handleCalibration() {
         if (i == 0) {
             cal = tankCalibration;
             isCal = tankCalibrated;
-            currentPsi = *tankPressure;
+            currentPsi = controller->getTankPressure();
         } else {
             cal = bags[i - 1].getCalibration();
             isCal = bags[i - 1].isCalibrated();
@@ -1085,116 +1392,261 @@ void AirRideWebServer::handleCalibration() {
     server.send(200, "application/json", json);
 }
 
-void AirRideWebServer::handleCalibrationReset() {
-    // Reset all sensors to factory defaults
-    // Optional: /calreset?s=<sensor> to reset single sensor
+bool AirRideWebServer::setCalibration(int sensor, const SensorCalibration& cal) {
+    if (sensor < 0 || sensor >= CAL_NUM_SENSORS || !validateCalibration(cal)) return false;
 
-    if (server.hasArg("s")) {
-        int sensor = server.arg("s").toInt();
-        if (sensor < 0 || sensor >= CAL_NUM_SENSORS) {
-            server.send(400, "application/json", "{\"error\":\"Invalid sensor (0-4)\"}");
-            return;
-        }
+    controller->setSensorCalibration(sensor, cal);
+    saveCalibrationToEEPROM();
+    return true;
+}
 
-        SensorCalibration defaults = { 0.0, 1.0, REFERENCE_RESISTOR };
-        if (sensor == 0) {
-            tankCalibration = defaults;
-            tankCalibrated = false;
-        } else {
-            bags[sensor - 1].setCalibration(defaults);
-        }
+bool AirRideWebServer::resetCalibration(int sensor) {
+    if (sensor < -1 || sensor >= CAL_NUM_SENSORS) return false;
 
+    SensorCalibration defaults = { 0.0, 1.0, REFERENCE_RESISTOR };
+    if (sensor >= 0) {
+        controller->setSensorCalibration(sensor, defaults);
         Serial.print("[CAL] Reset sensor ");
         Serial.println(sensor);
     } else {
-        // Reset all
-        SensorCalibration defaults = { 0.0, 1.0, REFERENCE_RESISTOR };
-        tankCalibration = defaults;
-        tankCalibrated = false;
-        for (int i = 0; i < NUM_BAGS; i++) {
-            bags[i].setCalibration(defaults);
+        for (int i = 0; i < CAL_NUM_SENSORS; i++) {
+            controller->setSensorCalibration(i, defaults);
         }
         Serial.println("[CAL] All sensors reset to factory defaults");
     }
-
     saveCalibrationToEEPROM();
-    handleCalibration(); // Return updated state
+    return true;
 }
 
-void AirRideWebServer::handleNotFound() {
-    Serial.print("[WEB] 404 Not Found: ");
-    Serial.println(server.uri());
-    server.send(404, "text/plain", "Not Found");
+void AirRideWebServer::handleCalibrationReset() {
+    // Reset all sensors to factory defaults
+    // Optional: /calreset?s=<sensor> to reset single sensor
+    int sensor = server.hasArg("s") ? server.arg("s").toInt() : -1;
+    if ((server.hasArg("s") && sensor < 0) || !resetCalibration(sensor)) {
+        server.send(400, "application/json", "{\"error\":\"Invalid sensor (0-4)\"}");
+        return;
+    }
+    handleCalibration(); // Return updated state
 }
 
-void AirRideWebServer::updateTankLockout(float tankPressure) {
-    // Hysteresis: lock out at TANK_CUTOFF_PSI, resume at TANK_RESUME_PSI
-    if (tankLockout) {
-        if (tankPressure >= TANK_RESUME_PSI) {
-            tankLockout = false;
-            Serial.println("Tank pressure restored - inflation enabled");
+void AirRideWebServer::handleTrace() {
+    // Restart from a snapshot: /trace?start=1
+    if (server.hasArg("start") && server.arg("start") == "1") {
+        if (!restartTrace()) {
+            server.send(409, "application/json", "{\"error\":\"Download in progress\"}");
+            return;
         }
+        server.send(200, "application/json", "{\"restarting\":true}");
+        return;
+    }
+
+    // Header + raw records; replay with the native replay tool
+    if (downloadKind != DOWNLOAD_NONE || controller->isTraceRestartPending()) {
+        server.send(409, "application/json", "{\"error\":\"Download or restart in progress\"}");
+        return;
+    }
+    TraceHeader header = traceRecorder.getHeader();
+    size_t bytes = header.count * sizeof(TraceRecord);
+
+    server.sendHeader("Content-Disposition", "attachment; filename=\"airride.trace\"");
+    server.setContentLength(sizeof(header) + bytes);
+    server.send(200, "application/octet-stream", "");
+    server.sendContent((const char*)&header, sizeof(header));
+
+    // Records already written never move: send the first count from update()
+    startDownload(DOWNLOAD_TRACE, bytes);
+}
+
+bool AirRideWebServer::restartTrace() {
+    // The download reads the buffer the restart clears
+    if (downloadKind == DOWNLOAD_TRACE) return false;
+    controller->requestTraceRestart();
+    Serial.println("[TRACE] Restart requested (next tick at rest)");
+    return true;
+}
+
+// ============================================
+// DOWNLOADS
+// ============================================
+// /trace and /coredump answer with the headers only and keep the client;
+// update() then writes one chunk per loop() pass. WiFiClient::write()
+// blocks until the stack takes the chunk, which on a weak link can be
+// seconds, so chunks are about one TCP segment and none is written while
+// a valve is open: the transfer pauses for a move and the solenoid
+// dead-man never waits on the radio.
+
+void AirRideWebServer::startDownload(DownloadKind kind, size_t size) {
+    downloadKind = kind;
+    downloadClient = server.client();
+    downloadOffset = 0;
+    downloadSize = size;
+    if (size == 0) endDownload("complete");
+}
+
+void AirRideWebServer::sendDownloadChunk() {
+    if (!downloadClient.connected()) {
+        endDownload("aborted (client gone)");
+        return;
+    }
+    if (controller->getValveBits() != 0) return;   // Resumes once the move is done
+
+    size_t len;
+    size_t written;
+    if (downloadKind == DOWNLOAD_TRACE) {
+        const uint8_t* data = (const uint8_t*)traceRecorder.getRecords();
+        len = min((size_t)TRACE_SEND_CHUNK, downloadSize - downloadOffset);
+        written = downloadClient.write(data + downloadOffset, len);
     } else {
-        if (tankPressure < TANK_CUTOFF_PSI) {
-            tankLockout = true;
-            // Stop all inflation
-            for (int i = 0; i < NUM_BAGS; i++) {
-                if (bags[i].isInflating()) {
-                    bags[i].hold();
-                }
-            }
-            Serial.println("Tank pressure low - inflation disabled");
+        static uint8_t chunk[DIAG_COREDUMP_CHUNK];
+        len = min((size_t)DIAG_COREDUMP_CHUNK, downloadSize - downloadOffset);
+        if (!diagnostics.readCoreDump(downloadOffset, chunk, len)) {
+            endDownload("aborted (flash read failed)");
+            return;
         }
+        written = downloadClient.write(chunk, len);
     }
+    if (written != len) {
+        endDownload("aborted (write failed)");
+        return;
+    }
+
+    downloadOffset += len;
+    if (downloadOffset >= downloadSize) endDownload("complete");
 }
 
-void AirRideWebServer::updateLevelMode() {
-    if (levelMode == LEVEL_OFF) return;
-
-    unsigned long currentTime = millis();
-    if (currentTime - lastLevelAdjust < LEVEL_ADJUST_STEP_MS) return;
-    lastLevelAdjust = currentTime;
-
-    float fl = bags[FRONT_LEFT].getPressure();
-    float fr = bags[FRONT_RIGHT].getPressure();
-    float rl = bags[REAR_LEFT].getPressure();
-    float rr = bags[REAR_RIGHT].getPressure();
-
-    switch (levelMode) {
-        case LEVEL_FRONT: {
-            // Match front left and right
-            float frontAvg = (fl + fr) / 2.0;
-            if (abs(fl - fr) > LEVEL_TOLERANCE_PSI) {
-                bags[FRONT_LEFT].setTargetPressure(frontAvg);
-                bags[FRONT_RIGHT].setTargetPressure(frontAvg);
-            }
-            break;
-        }
-        case LEVEL_REAR: {
-            // Match rear left and right
-            float rearAvg = (rl + rr) / 2.0;
-            if (abs(rl - rr) > LEVEL_TOLERANCE_PSI) {
-                bags[REAR_LEFT].setTargetPressure(rearAvg);
-                bags[REAR_RIGHT].setTargetPressure(rearAvg);
-            }
-            break;
-        }
-        case LEVEL_ALL: {
-            // Match front pair and rear pair
-            float frontAvg = (fl + fr) / 2.0;
-            float rearAvg = (rl + rr) / 2.0;
-            if (abs(fl - fr) > LEVEL_TOLERANCE_PSI) {
-                bags[FRONT_LEFT].setTargetPressure(frontAvg);
-                bags[FRONT_RIGHT].setTargetPressure(frontAvg);
-            }
-            if (abs(rl - rr) > LEVEL_TOLERANCE_PSI) {
-                bags[REAR_LEFT].setTargetPressure(rearAvg);
-                bags[REAR_RIGHT].setTargetPressure(rearAvg);
-            }
-            break;
-        }
-        default:
-            break;
+void AirRideWebServer::endDownload(const char* result) {
+    if (downloadKind == DOWNLOAD_TRACE) {
+        Serial.print("[TRACE] Sent ");
+        Serial.print((unsigned long)(downloadOffset / sizeof(TraceRecord)));
+        Serial.print(" records, ");
+    } else {
+        Serial.print("[DIAG] Sent core dump (");
+        Serial.print((unsigned long)downloadOffset);
+        Serial.print(" bytes), ");
+    }
+    Serial.println(result);
+
+    downloadClient.stop();
+    downloadClient = WiFiClient();
+    downloadKind = DOWNLOAD_NONE;
+}
+
+void AirRideWebServer::handleDiag() {
+    String json = "{\"boots\":";
+    json += String(diagnostics.getBootCount());
+    json += ",\"uptimeS\":";
+    json += String(millis() / 1000);
+    json += ",\"controlReadyMs\":";
+    json += String(diagnostics.getControlReadyMs());
+    json += ",\"bootCompleteMs\":";
+    json += String(diagnostics.getBootCompleteMs());
+
+    ResetRecord history[DIAG_HISTORY_SIZE];
+    int count = diagnostics.getResetHistory(history, DIAG_HISTORY_SIZE);
+    json += ",\"resets\":[";
+    for (int i = 0; i < count; i++) {
+        if (i > 0) json += ",";
+        json += "{\"boot\":";
+        json += String(history[i].boot);
+        json += ",\"reason\":\"";
+        json += Diagnostics::resetReasonName(history[i].reason);
+        json += "\",\"stage\":\"";
+        json += Diagnostics::stageName(history[i].stage);
+        json += "\",\"uptimeMin\":";
+        json += String(history[i].uptimeMin);
+        json += "}";
     }
+
+    json += "],\"stages\":{";
+    for (int i = STAGE_NONE + 1; i < NUM_LOOP_STAGES; i++) {
+        const StageStats& st = diagnostics.getStageStats(i);
+        if (i > STAGE_NONE + 1) json += ",";
+        json += "\"";
+        json += Diagnostics::stageName(i);
+        json += "\":{\"budgetMs\":";
+        json += String(Diagnostics::stageBudgetMs(i));
+        json += ",\"worstMs\":";
+        json += String(st.worstMs);
+        json += ",\"overruns\":";
+        json += String(st.overruns);
+        json += "}";
+    }
+
+    json += "},\"controlRate\":{\"current\":\"";
+    json += RideController::rateName(controller->getControlRate());
+    json += "\",\"intervalMs\":";
+    json += String(controller->getControlIntervalMs());
+    json += ",\"activeS\":";
+    json += String(controller->getTimeAtRateMs(RATE_ACTIVE) / 1000);
+    json += ",\"idleS\":";
+    json += String(controller->getTimeAtRateMs(RATE_IDLE) / 1000);
+    json += ",\"switches\":";
+    json += String(controller->getRateSwitches());
+    const PowerStats& ps = powerManager.getStats();
+    json += "},\"power\":{\"state\":\"";
+    json += powerManager.isParked() ? "parked" : "awake";
+    json += "\",\"currentMa\":";
+    json += String(powerManager.getCurrentMa(), 1);
+    json += ",\"parkInS\":";
+    json += String(powerManager.getIdleRemainingMs() / 1000);
+    json += ",\"parks\":";
+    json += String(ps.parks);
+    json += ",\"timerWakes\":";
+    json += String(ps.timerWakes);
+    json += ",\"buttonWakes\":";
+    json += String(ps.buttonWakes);
+    json += ",\"sleptS\":";
+    json += String(ps.sleptMs / 1000);
+    json += ",\"parkedMah\":";
+    json += String(powerManager.getParkedMah(), 2);
+    json += ",\"parkedAvgMa\":";
+    json += String(powerManager.getParkedAverageMa(), 2);
+    json += ",\"leakStatus\":";
+    json += String(ps.worstLeakStatus);
+    json += "},\"deadmanTrips\":";
+    json += String(solenoidGuard.getTripCount());
+    json += ",\"coreDump\":";
+    json += String((unsigned long)diagnostics.getCoreDumpSize());
+    json += "}";
+
+    server.send(200, "application/json", json);
 }
 
+void AirRideWebServer::handlePark() {
+    // Reply first: the AP goes down on the next loop()
+    server.send(200, "application/json", "{\"parking\":true}");
+    powerManager.requestPark("web");
+}
+
+void AirRideWebServer::handleCoreDump() {
+    if (downloadKind != DOWNLOAD_NONE) {
+        server.send(409, "application/json", "{\"error\":\"Download in progress\"}");
+        return;
+    }
+
+    // Erase after download: /coredump?erase=1
+    if (server.hasArg("erase") && server.arg("erase") == "1") {
+        bool ok = diagnostics.eraseCoreDump();
+        Serial.println(ok ? "[DIAG] Core dump erased" : "[DIAG] Core dump erase failed");
+        server.send(ok ? 200 : 500, "application/json", ok ? "{\"erased\":true}" : "{\"error\":\"Erase failed\"}");
+        return;
+    }
+
+    size_t size = diagnostics.getCoreDumpSize();
+    if (size == 0) {
+        server.send(404, "application/json", "{\"error\":\"No core dump stored\"}");
+        return;
+    }
+
+    // Raw partition image; coredump.sh symbolizes it against the build's ELF
+    server.sendHeader("Content-Disposition", "attachment; filename=\"airride.coredump\"");
+    server.setContentLength(size);
+    server.send(200, "application/octet-stream", "");
+    startDownload(DOWNLOAD_COREDUMP, size);
+}
+
+void AirRideWebServer::handleNotFound() {
+    Serial.print("[WEB] 404 Not Found: ");
+    Serial.println(server.uri());
+    server.send(404, "text/plain", "Not Found");
+}
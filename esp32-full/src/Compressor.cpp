@@ -1,5 +1,6 @@
 #include "Compressor.h"
 #include <EEPROM.h>
+#include "Actuators.h"
 
 Compressor::Compressor(uint8_t p1Pin, uint8_t p2Pin)
     : pump1Pin(p1Pin),
@@ -8,9 +9,12 @@ Compressor::Compressor(uint8_t p1Pin, uint8_t p2Pin)
       targetPressure(TANK_MAX_PSI),
       pump1On(false),
       pump2On(false),
-      alternatePump(false),
-      lastSwitchTime(0),
+      wantPump1(false),
+      wantPump2(false),
+      lastStartMs(0),
       filling(false),
+      demand(false),
+      tankDraw(false),
       pump1RuntimeMs(0),
       pump2RuntimeMs(0),
       lastRuntimeUpdate(0),
@@ -18,14 +22,14 @@ Compressor::Compressor(uint8_t p1Pin, uint8_t p2Pin)
 }
 
 void Compressor::begin() {
-    pinMode(pump1Pin, OUTPUT);
-    pinMode(pump2Pin, OUTPUT);
-
-    // Ensure pumps are off at startup
-    setPump1(false);
-    setPump2(false);
+    // Pumps off at startup
+    actuators.attachMotor(pump1Pin);
+    actuators.attachMotor(pump2Pin);
 
+    // Either pump may start straight away
     lastRuntimeUpdate = millis();
+    pumpChangedMs[0] = pumpChangedMs[1] = lastRuntimeUpdate - PUMP_MIN_OFF_MS;
+    lastStartMs = lastRuntimeUpdate - PUMP_START_SPACING_MS;
 
     // Load saved runtime from EEPROM
     loadRuntimeFromEEPROM();
@@ -61,6 +65,15 @@ void Compressor::update(float tankPressure) {
             break;
     }
 
+    // Relays follow within their timing; a manual mode or a full tank
+    // stops a pump without waiting out its minimum on time
+    applyPumps(currentMode != PUMP_AUTO || tankPressure >= TANK_MAX_PSI);
+
+    // Starts, heat and duty from the states just applied; fill rate
+    unsigned long runtimeMs[2] = { pump1RuntimeMs, pump2RuntimeMs };
+    scheduler.update(pump1On, pump2On);
+    health.update(tankPressure, pump1On, pump2On, tankDraw, runtimeMs);
+
     // Periodically save runtime to EEPROM (every 5 minutes)
     if (millis() - lastEEPROMSave > 300000) {
         saveRuntimeToEEPROM();
@@ -69,8 +82,6 @@ void Compressor::update(float tankPressure) {
 }
 
 void Compressor::runAutoMode(float tankPressure) {
-    unsigned long currentTime = millis();
-
     // Hysteresis: start filling when below TANK_MIN_PSI, stop at targetPressure
     // This prevents rapid on/off cycling when pressure hovers near the target
     if (tankPressure >= targetPressure) {
@@ -86,53 +97,61 @@ void Compressor::runAutoMode(float tankPressure) {
     }
 
     // Start a new fill cycle only when pressure drops below TANK_MIN_PSI
+    // (or when corners are waiting for air)
     if (!filling) {
-        if (tankPressure < TANK_MIN_PSI) {
+        if (demand) {
+            filling = true;
+            Serial.print("[PUMP] Corners waiting for air (");
+            Serial.print(tankPressure, 1);
+            Serial.println(" PSI) - starting fill cycle");
+        } else if (tankPressure < TANK_MIN_PSI) {
             filling = true;
             Serial.print("[PUMP] Tank below ");
             Serial.print(TANK_MIN_PSI, 0);
             Serial.print(" PSI (");
             Serial.print(tankPressure, 1);
             Serial.println(" PSI) - starting fill cycle");
+        } else if (scheduler.getForecastPsi() >= PUMP_FORECAST_MIN_PSI &&
+                   tankPressure - scheduler.getForecastPsi() < TANK_MIN_PSI) {
+            // The next move would take the tank below TANK_MIN_PSI: fill now
+            filling = true;
+            Serial.print("[PUMP] Pre-filling for the next move (expect -");
+            Serial.print(scheduler.getForecastPsi(), 0);
+            Serial.print(" PSI from ");
+            Serial.print(tankPressure, 1);
+            Serial.println(" PSI)");
         } else {
             // Between TANK_MIN_PSI and targetPressure, but not in a fill cycle
             // Don't start pumps — wait for pressure to drop below TANK_MIN_PSI
+            // (or for a move the forecast says the tank can't carry)
             setPump1(false);
             setPump2(false);
             return;
         }
     }
 
-    // Active fill cycle: choose pump strategy based on pressure
-    if (tankPressure <= PUMP_BOTH_ON_THRESHOLD) {
-        // Very low - run both pumps for maximum fill rate
-        if (!pump1On || !pump2On) {
-            Serial.print("[PUMP] Tank low (");
-            Serial.print(tankPressure, 1);
-            Serial.println(" PSI) - BOTH pumps ON");
-        }
-        setPump1(true);
-        setPump2(true);
-    } else {
-        // Above threshold - alternate single pump to reduce wear
-        if (currentTime - lastSwitchTime >= PUMP_SWITCH_INTERVAL) {
-            alternatePump = !alternatePump;
-            lastSwitchTime = currentTime;
-            Serial.print("[PUMP] Alternating to P");
-            Serial.print(alternatePump ? "2" : "1");
-            Serial.print(" (tank=");
-            Serial.print(tankPressure, 1);
-            Serial.println(" PSI)");
-        }
-
-        if (alternatePump) {
-            setPump1(false);
-            setPump2(true);
+    // Active fill cycle: both pumps when very low or corners are waiting,
+    // otherwise the least-worn one (resting pumps sit out either way)
+    int wanted = (tankPressure <= PUMP_BOTH_ON_THRESHOLD || (demand && QUEUE_BOTH_PUMPS)) ? 2 : 1;
+    uint8_t running = (wantPump1 ? 1 : 0) | (wantPump2 ? 2 : 0);
+    unsigned long runtimeMs[2] = { pump1RuntimeMs, pump2RuntimeMs };
+    uint8_t pumps = scheduler.choose(wanted, running, runtimeMs);
+    if (pumps != running) {
+        Serial.print(demand ? "[PUMP] Corners waiting (" : (wanted == 2 ? "[PUMP] Tank low (" : "[PUMP] Topping off ("));
+        Serial.print(tankPressure, 1);
+        Serial.print(" PSI) - ");
+        if (pumps == 3) {
+            Serial.println("BOTH pumps ON");
+        } else if (pumps == 0) {
+            Serial.println("both pumps resting");
         } else {
-            setPump1(true);
-            setPump2(false);
+            Serial.print("P");
+            Serial.print(pumps == 1 ? "1" : "2");
+            Serial.println(" (least worn)");
         }
     }
+    setPump1(pumps & 1);
+    setPump2(pumps & 2);
 }
 
 void Compressor::setMode(PumpMode mode) {
@@ -148,6 +167,33 @@ void Compressor::setMode(PumpMode mode) {
     currentMode = mode;
 }
 
+void Compressor::startFill() {
+    if (currentMode != PUMP_AUTO || filling) return;
+    filling = true;
+    Serial.println("[PUMP] Starting fill cycle ahead of a move");
+}
+
+// Both usable pumps up to PUMP_BOTH_ON_THRESHOLD (or all the way with
+// corners waiting), then the one auto mode keeps
+float Compressor::getTimeToFullS(float tankPressure) const {
+    if (tankPressure >= targetPressure) return 0;
+
+    unsigned long runtimeMs[2] = { pump1RuntimeMs, pump2RuntimeMs };
+    uint8_t running = (wantPump1 ? 1 : 0) | (wantPump2 ? 2 : 0);
+    uint8_t both = scheduler.choose(2, running, runtimeMs);
+    uint8_t one = scheduler.choose(1, running, runtimeMs);
+    if (both == 0) return NAN;
+
+    float split = (demand && QUEUE_BOTH_PUMPS) ? targetPressure
+                                               : min(targetPressure, (float)PUMP_BOTH_ON_THRESHOLD);
+    return health.fillSeconds(tankPressure, split, both) +
+           health.fillSeconds(max(tankPressure, split), targetPressure, one);
+}
+
+float Compressor::getServiceHours(int pump) const {
+    return health.getServiceHours(pump, (pump == 0 ? pump1RuntimeMs : pump2RuntimeMs) / 3600000.0);
+}
+
 void Compressor::setTargetPressure(float psi) {
     if (psi > TANK_MAX_PSI) psi = TANK_MAX_PSI;
     if (psi < TANK_MIN_PSI) psi = TANK_MIN_PSI;
@@ -155,21 +201,43 @@ void Compressor::setTargetPressure(float psi) {
 }
 
 void Compressor::setPump1(bool on) {
-    if (on != pump1On) {
-        Serial.print("[PUMP] P1 ");
-        Serial.println(on ? "ON" : "OFF");
-    }
-    pump1On = on;
-    digitalWrite(pump1Pin, on ? RELAY_ON : RELAY_OFF);
+    wantPump1 = on;
 }
 
 void Compressor::setPump2(bool on) {
-    if (on != pump2On) {
-        Serial.print("[PUMP] P2 ");
-        Serial.println(on ? "ON" : "OFF");
+    wantPump2 = on;
+}
+
+// ============================================
+// RELAY SEQUENCING
+// ============================================
+// The modes say which pumps should run; the relays get there one start
+// at a time, PUMP_START_SPACING_MS apart, without cycling faster than
+// PUMP_MIN_ON_MS / PUMP_MIN_OFF_MS allow. A pump held back stays wanted
+// and starts on a later update.
+void Compressor::applyPumps(bool stopNow) {
+    unsigned long now = millis();
+    bool want[2] = { wantPump1, wantPump2 };
+    bool* on[2] = { &pump1On, &pump2On };
+    const uint8_t pins[2] = { pump1Pin, pump2Pin };
+
+    for (int p = 0; p < 2; p++) {
+        unsigned long since = now - pumpChangedMs[p];
+        if (*on[p] && !want[p]) {
+            if (!stopNow && since < PUMP_MIN_ON_MS) continue;
+        } else if (!*on[p] && want[p]) {
+            if (since < PUMP_MIN_OFF_MS || now - lastStartMs < PUMP_START_SPACING_MS) continue;
+            lastStartMs = now;
+        } else {
+            continue;
+        }
+        *on[p] = want[p];
+        pumpChangedMs[p] = now;
+        actuators.set(pins[p], want[p]);
+        Serial.print("[PUMP] P");
+        Serial.print(p + 1);
+        Serial.println(want[p] ? " ON" : " OFF");
     }
-    pump2On = on;
-    digitalWrite(pump2Pin, on ? RELAY_ON : RELAY_OFF);
 }
 
 const char* Compressor::getModeString() const {
@@ -197,11 +265,24 @@ void Compressor::updateRuntime() {
 }
 
 void Compressor::loadRuntimeFromEEPROM() {
-    // Check if EEPROM has valid data
-    if (EEPROM.read(EEPROM_ADDR_MAGIC) == EEPROM_MAGIC) {
+    if (EEPROM.read(EEPROM_ADDR_PUMP_FLAG) == PUMP_HEALTH_VALID_FLAG) {
+        // Each pump's own runtime, starts and fill-rate history
+        for (int p = 0; p < 2; p++) {
+            float hours = 0;
+            uint32_t starts = 0;
+            PumpCurve curve;
+            EEPROM.get(EEPROM_ADDR_PUMP_RUNTIME + p * sizeof(float), hours);
+            EEPROM.get(EEPROM_ADDR_PUMP_STARTS + p * sizeof(uint32_t), starts);
+            EEPROM.get(EEPROM_ADDR_PUMP_CURVES + p * sizeof(PumpCurve), curve);
+            unsigned long ms = (isnan(hours) || hours < 0) ? 0 : (unsigned long)(hours * 3600000.0);
+            if (p == 0) pump1RuntimeMs = ms; else pump2RuntimeMs = ms;
+            scheduler.restoreStarts(p, starts);
+            health.load(p, curve);
+        }
+    } else if (EEPROM.read(EEPROM_ADDR_MAGIC) == EEPROM_MAGIC) {
+        // Older firmware kept only the total: split it once, per pump from now on
         float hours;
         EEPROM.get(EEPROM_ADDR_PUMP_HOURS, hours);
-        // Store total hours split evenly (simplified - could store both separately)
         pump1RuntimeMs = (unsigned long)(hours * 3600000.0 / 2.0);
         pump2RuntimeMs = (unsigned long)(hours * 3600000.0 / 2.0);
     }
@@ -210,17 +291,36 @@ void Compressor::loadRuntimeFromEEPROM() {
 void Compressor::saveRuntimeToEEPROM() {
     float totalHours = (pump1RuntimeMs + pump2RuntimeMs) / 3600000.0;
     EEPROM.put(EEPROM_ADDR_PUMP_HOURS, totalHours);
+
+    for (int p = 0; p < 2; p++) {
+        float hours = (p == 0 ? pump1RuntimeMs : pump2RuntimeMs) / 3600000.0;
+        EEPROM.put(EEPROM_ADDR_PUMP_RUNTIME + p * sizeof(float), hours);
+        EEPROM.put(EEPROM_ADDR_PUMP_STARTS + p * sizeof(uint32_t), scheduler.getStarts(p));
+        EEPROM.put(EEPROM_ADDR_PUMP_CURVES + p * sizeof(PumpCurve), health.getCurve(p));
+    }
+    EEPROM.write(EEPROM_ADDR_PUMP_FLAG, PUMP_HEALTH_VALID_FLAG);
     EEPROM.commit();
 }
 
+void Compressor::restoreRuntime(int pump, unsigned long runtimeMs, uint32_t starts) {
+    if (pump < 0 || pump > 1) return;
+    if (pump == 0) pump1RuntimeMs = runtimeMs; else pump2RuntimeMs = runtimeMs;
+    scheduler.restoreStarts(pump, starts);
+}
+
+// Service done: runtime, starts and the as-new curve start over
 void Compressor::resetPump1Runtime() {
     pump1RuntimeMs = 0;
+    scheduler.restoreStarts(0, 0);
+    health.reset(0);
     saveRuntimeToEEPROM();
     Serial.println("Pump 1 runtime reset - maintenance complete");
 }
 
 void Compressor::resetPump2Runtime() {
     pump2RuntimeMs = 0;
+    scheduler.restoreStarts(1, 0);
+    health.reset(1);
     saveRuntimeToEEPROM();
     Serial.println("Pump 2 runtime reset - maintenance complete");
 }
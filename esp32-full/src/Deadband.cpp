@@ -0,0 +1,111 @@
+#include "Deadband.h"
+
+DeadbandEstimator::DeadbandEstimator()
+    : quiet(false),
+      quietSinceMs(0) {
+    for (int i = 0; i < NUM_BAGS; i++) {
+        mean[i] = 0;
+        variance[i] = 0;
+        samples[i] = 0;
+        overshoot[i] = 0;
+        dropback[i] = 0;
+        lastState[i] = VALVE_HOLD;
+        closedDir[i] = 0;
+        closedPsi[i] = 0;
+        closedAtMs[i] = 0;
+        band[i] = TARGET_TOLERANCE_PSI;
+        reopen[i] = TARGET_REOPEN_HYSTERESIS_PSI;
+    }
+}
+
+void DeadbandEstimator::update(const AirBag* bags) {
+    unsigned long now = millis();
+    for (int i = 0; i < NUM_BAGS; i++) {
+        sampleResponse(bags[i], i, now);
+    }
+    sampleNoise(bags, now);
+    for (int i = 0; i < NUM_BAGS; i++) {
+        publish(bags[i], i);
+    }
+}
+
+// Only with every valve closed: a moving corner shifts load onto the
+// others, which would read as noise
+void DeadbandEstimator::sampleNoise(const AirBag* bags, unsigned long now) {
+    for (int i = 0; i < NUM_BAGS; i++) {
+        if (!bags[i].isHolding()) {
+            quiet = false;
+            quietSinceMs = now;
+            return;
+        }
+    }
+    if (now - quietSinceMs < DEADBAND_QUIET_MS) return;
+
+    for (int i = 0; i < NUM_BAGS; i++) {
+        float psi = bags[i].getPressure();
+        if (!quiet) {
+            // New quiet spell: the bags sit at new pressures
+            mean[i] = psi;
+            continue;
+        }
+        float dev = psi - mean[i];
+        mean[i] += DEADBAND_NOISE_ALPHA * dev;
+        variance[i] += DEADBAND_NOISE_ALPHA * (dev * dev - variance[i]);
+        if (samples[i] < DEADBAND_MIN_SAMPLES) samples[i]++;
+    }
+    quiet = true;
+}
+
+void DeadbandEstimator::sampleResponse(const AirBag& bag, int i, unsigned long now) {
+    ValveState state = bag.getState();
+    if (state != lastState[i]) {
+        closedDir[i] = 0;
+        if (state == VALVE_HOLD && !bag.isSolenoidTimedOut()) {
+            closedDir[i] = (lastState[i] == VALVE_INFLATE) ? 1 : -1;
+            closedPsi[i] = bag.getPressure();
+            closedAtMs[i] = now;
+        }
+        lastState[i] = state;
+        return;
+    }
+    if (closedDir[i] == 0 || now - closedAtMs[i] < DEADBAND_RESPONSE_SETTLE_MS) return;
+
+    float shift = (bag.getPressure() - closedPsi[i]) * closedDir[i];
+    overshoot[i] += DEADBAND_RESPONSE_ALPHA * (max(shift, 0.0f) - overshoot[i]);
+    dropback[i] += DEADBAND_RESPONSE_ALPHA * (max(-shift, 0.0f) - dropback[i]);
+    closedDir[i] = 0;
+}
+
+void DeadbandEstimator::publish(const AirBag& bag, int i) {
+    if (!isLearned(i)) return;
+
+    // Stopped at the near edge, the corner coasts on by the overshoot:
+    // the band must be wide enough that it lands inside. The reopen margin
+    // covers falling back plus noise at the edge.
+    float sigma = getNoise(i);
+    float wantBand = max(DEADBAND_OVERSHOOT_GAIN * overshoot[i], DEADBAND_BAND_SIGMAS * sigma);
+    float wantReopen = dropback[i] + DEADBAND_NOISE_SIGMAS * sigma;
+    wantBand = constrain(wantBand, DEADBAND_MIN_PSI, DEADBAND_MAX_PSI);
+    wantReopen = constrain(wantReopen, DEADBAND_REOPEN_MIN_PSI, DEADBAND_REOPEN_MAX_PSI);
+
+    if (abs(wantBand - band[i]) < DEADBAND_HYSTERESIS_PSI &&
+        abs(wantReopen - reopen[i]) < DEADBAND_HYSTERESIS_PSI) {
+        return;
+    }
+    band[i] = wantBand;
+    reopen[i] = wantReopen;
+
+    Serial.print("[BAND] ");
+    Serial.print(bag.getName());
+    Serial.print(" +/-");
+    Serial.print(band[i], 2);
+    Serial.print(" PSI, reopen +");
+    Serial.print(reopen[i], 2);
+    Serial.print(" (noise ");
+    Serial.print(sigma, 2);
+    Serial.print(", overshoot ");
+    Serial.print(overshoot[i], 2);
+    Serial.print(", dropback ");
+    Serial.print(dropback[i], 2);
+    Serial.println(")");
+}
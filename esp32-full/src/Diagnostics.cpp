@@ -0,0 +1,222 @@
+#include "Diagnostics.h"
+#include <EEPROM.h>
+
+#if !defined(AIRRIDE_NATIVE)
+#include <esp_attr.h>
+#include <esp_core_dump.h>
+#include <esp_partition.h>
+#include <esp_system.h>
+#else
+#define RTC_NOINIT_ATTR
+#endif
+
+Diagnostics diagnostics;
+
+// Survives panic/watchdog/software resets; garbage after power-on
+#define DIAG_RTC_MAGIC  0x44494147  // "DIAG"
+RTC_NOINIT_ATTR static uint32_t rtcMagic;
+RTC_NOINIT_ATTR static uint8_t rtcStage;
+RTC_NOINIT_ATTR static uint32_t rtcUptimeMin;
+
+Diagnostics::Diagnostics()
+    : bootCount(0),
+      currentStage(STAGE_NONE),
+      stageStartMs(0),
+      controlReadyMs(0),
+      bootCompleteMs(0) {
+    memset(&lastReset, 0, sizeof(lastReset));
+    memset(stats, 0, sizeof(stats));
+}
+
+void Diagnostics::begin() {
+#if defined(AIRRIDE_NATIVE)
+    uint8_t reason = 1; // Power-on
+#else
+    uint8_t reason = (uint8_t)esp_reset_reason();
+#endif
+
+    bool rtcValid = (rtcMagic == DIAG_RTC_MAGIC);
+    lastReset.reason = reason;
+    lastReset.stage = (rtcValid && rtcStage < NUM_LOOP_STAGES) ? rtcStage : (uint8_t)STAGE_NONE;
+    lastReset.uptimeMin = rtcValid ? (uint16_t)min(rtcUptimeMin, (uint32_t)0xFFFF) : 0;
+
+    rtcMagic = DIAG_RTC_MAGIC;
+    rtcStage = STAGE_NONE;
+    rtcUptimeMin = 0;
+
+    // Append to the EEPROM ring
+    uint8_t head = 0;
+    if (EEPROM.read(EEPROM_ADDR_DIAG_FLAG) == DIAG_VALID_FLAG) {
+        EEPROM.get(EEPROM_ADDR_DIAG_BOOTS, bootCount);
+        head = EEPROM.read(EEPROM_ADDR_DIAG_HEAD) % DIAG_HISTORY_SIZE;
+    } else {
+        ResetRecord empty;
+        memset(&empty, 0, sizeof(empty));
+        for (int i = 0; i < DIAG_HISTORY_SIZE; i++) {
+            EEPROM.put(EEPROM_ADDR_DIAG_HISTORY + i * sizeof(ResetRecord), empty);
+        }
+    }
+    bootCount++;
+    lastReset.boot = bootCount;
+
+    EEPROM.put(EEPROM_ADDR_DIAG_HISTORY + head * sizeof(ResetRecord), lastReset);
+    EEPROM.write(EEPROM_ADDR_DIAG_HEAD, (head + 1) % DIAG_HISTORY_SIZE);
+    EEPROM.put(EEPROM_ADDR_DIAG_BOOTS, bootCount);
+    EEPROM.write(EEPROM_ADDR_DIAG_FLAG, DIAG_VALID_FLAG);
+    EEPROM.commit();
+
+    Serial.print("[DIAG] Boot ");
+    Serial.print(bootCount);
+    Serial.print(", reset: ");
+    Serial.print(resetReasonName(reason));
+    if (lastReset.stage != STAGE_NONE) {
+        Serial.print(" during ");
+        Serial.print(stageName(lastReset.stage));
+    }
+    if (rtcValid) {
+        Serial.print(" after ");
+        Serial.print(lastReset.uptimeMin);
+        Serial.print(" min");
+    }
+    Serial.println();
+
+    size_t dumpSize = getCoreDumpSize();
+    if (dumpSize > 0) {
+        Serial.print("[DIAG] Core dump stored (");
+        Serial.print((unsigned long)dumpSize);
+        Serial.println(" bytes) - download with coredump.sh or GET /coredump");
+    }
+}
+
+void Diagnostics::stage(LoopStage next) {
+    unsigned long now = millis();
+
+    if (currentStage != STAGE_NONE) {
+        uint32_t elapsed = now - stageStartMs;
+        StageStats& s = stats[currentStage];
+        if (elapsed > s.worstMs) s.worstMs = elapsed;
+        if (elapsed > stageBudgetMs(currentStage)) {
+            s.overruns++;
+            Serial.print("[STALL] ");
+            Serial.print(stageName(currentStage));
+            Serial.print(" took ");
+            Serial.print(elapsed);
+            Serial.print(" ms (budget ");
+            Serial.print(stageBudgetMs(currentStage));
+            Serial.println(" ms)");
+        }
+    }
+
+    currentStage = next;
+    stageStartMs = now;
+    rtcStage = next;
+    rtcUptimeMin = now / 60000UL;
+}
+
+void Diagnostics::markControlReady() {
+    controlReadyMs = millis();
+    Serial.print("[BOOT] Control ready in ");
+    Serial.print(controlReadyMs);
+    Serial.println(" ms");
+}
+
+void Diagnostics::markBootComplete() {
+    bootCompleteMs = millis();
+    Serial.print("[BOOT] WiFi/OTA up in ");
+    Serial.print(bootCompleteMs);
+    Serial.println(" ms");
+}
+
+int Diagnostics::getResetHistory(ResetRecord* out, int max) const {
+    if (EEPROM.read(EEPROM_ADDR_DIAG_FLAG) != DIAG_VALID_FLAG) return 0;
+    uint8_t head = EEPROM.read(EEPROM_ADDR_DIAG_HEAD) % DIAG_HISTORY_SIZE;
+
+    int count = 0;
+    for (int i = 1; i <= DIAG_HISTORY_SIZE && count < max; i++) {
+        int slot = (head + DIAG_HISTORY_SIZE - i) % DIAG_HISTORY_SIZE;
+        ResetRecord r;
+        EEPROM.get(EEPROM_ADDR_DIAG_HISTORY + slot * sizeof(ResetRecord), r);
+        if (r.boot == 0) break; // Unused slot
+        out[count++] = r;
+    }
+    return count;
+}
+
+const char* Diagnostics::resetReasonName(uint8_t reason) {
+    // esp_reset_reason_t
+    switch (reason) {
+        case 1:  return "power-on";
+        case 2:  return "external pin";
+        case 3:  return "software";
+        case 4:  return "panic";
+        case 5:  return "interrupt watchdog";
+        case 6:  return "task watchdog";
+        case 7:  return "other watchdog";
+        case 8:  return "deep sleep";
+        case 9:  return "brownout";
+        case 10: return "SDIO";
+        default: return "unknown";
+    }
+}
+
+const char* Diagnostics::stageName(uint8_t stage) {
+    switch (stage) {
+        case STAGE_OTA:     return "ota";
+        case STAGE_WEB:     return "web";
+        case STAGE_CONTROL: return "control";
+        case STAGE_CONSOLE: return "console";
+        case STAGE_LINK:    return "link";
+        case STAGE_BOOT:    return "boot";
+        default:            return "none";
+    }
+}
+
+uint32_t Diagnostics::stageBudgetMs(uint8_t stage) {
+    switch (stage) {
+        case STAGE_OTA:     return DIAG_BUDGET_OTA_MS;
+        case STAGE_WEB:     return DIAG_BUDGET_WEB_MS;
+        case STAGE_CONTROL: return DIAG_BUDGET_CONTROL_MS;
+        case STAGE_CONSOLE: return DIAG_BUDGET_CONSOLE_MS;
+        case STAGE_LINK:    return DIAG_BUDGET_LINK_MS;
+        case STAGE_BOOT:    return DIAG_BUDGET_BOOT_MS;
+        default:            return 0xFFFFFFFF;
+    }
+}
+
+// ============================================
+// CORE DUMP
+// ============================================
+
+#if defined(AIRRIDE_NATIVE)
+
+size_t Diagnostics::getCoreDumpSize() const { return 0; }
+bool Diagnostics::readCoreDump(size_t, uint8_t*, size_t) const { return false; }
+bool Diagnostics::eraseCoreDump() { return false; }
+
+#else
+
+static const esp_partition_t* coreDumpPartition() {
+    return esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_COREDUMP, NULL);
+}
+
+size_t Diagnostics::getCoreDumpSize() const {
+    size_t address, size;
+    if (esp_core_dump_image_get(&address, &size) != ESP_OK) return 0;
+    return size;
+}
+
+bool Diagnostics::readCoreDump(size_t offset, uint8_t* buf, size_t length) const {
+    const esp_partition_t* part = coreDumpPartition();
+    size_t address, size;
+    if (!part || esp_core_dump_image_get(&address, &size) != ESP_OK) return false;
+    if (offset + length > size) return false;
+    return esp_partition_read(part, address - part->address + offset, buf, length) == ESP_OK;
+}
+
+bool Diagnostics::eraseCoreDump() {
+    const esp_partition_t* part = coreDumpPartition();
+    if (!part) return false;
+    return esp_partition_erase_range(part, 0, part->size) == ESP_OK;
+}
+
+#endif
@@ -0,0 +1,80 @@
+#include "FillSchedule.h"
+
+// Schedule points: tank minus bag pressure (PSI)
+const float FillSchedule::DELTA_PSI[FILL_SCHEDULE_POINTS] = { 15.0, 40.0, 70.0, 100.0, 130.0 };
+
+FillSchedule::FillSchedule() {
+    for (int i = 0; i < NUM_BAGS; i++) {
+        for (int p = 0; p < FILL_SCHEDULE_POINTS; p++) {
+            // Flow model: the reading trails the bag by about FILL_LATENCY_S
+            float seed = PLAN_INFLATE_K * sqrtf(DELTA_PSI[p]) * FILL_LATENCY_S;
+            lead[i][0][p] = seed;
+            lead[i][1][p] = seed;
+        }
+        fills[i] = 0;
+        lastState[i] = VALVE_HOLD;
+        openedAtMs[i] = 0;
+        coasting[i] = false;
+        coastPumping[i] = false;
+        closedPsi[i] = 0;
+        closedDeltaPsi[i] = 0;
+        closedAtMs[i] = 0;
+    }
+}
+
+// Lower schedule point and the weight of the one above it
+void FillSchedule::bracket(float deltaPsi, int& lo, float& weight) {
+    if (deltaPsi <= DELTA_PSI[0]) {
+        lo = 0;
+        weight = 0;
+        return;
+    }
+    for (lo = 0; lo < FILL_SCHEDULE_POINTS - 2; lo++) {
+        if (deltaPsi < DELTA_PSI[lo + 1]) break;
+    }
+    weight = constrain((deltaPsi - DELTA_PSI[lo]) / (DELTA_PSI[lo + 1] - DELTA_PSI[lo]), 0.0f, 1.0f);
+}
+
+float FillSchedule::getLead(int bag, float deltaPsi, bool pumping) const {
+    int lo;
+    float weight;
+    bracket(deltaPsi, lo, weight);
+    const float* row = lead[bag][pumping ? 1 : 0];
+    return row[lo] + weight * (row[lo + 1] - row[lo]);
+}
+
+void FillSchedule::update(const AirBag* bags, float tankPressure, bool pumping) {
+    unsigned long now = millis();
+    for (int i = 0; i < NUM_BAGS; i++) {
+        ValveState state = bags[i].getState();
+        float psi = bags[i].getPressure();
+
+        if (state != lastState[i]) {
+            // A long enough inflate just closed: watch the reading coast
+            coasting[i] = (lastState[i] == VALVE_INFLATE && state == VALVE_HOLD &&
+                           now - openedAtMs[i] >= FILL_LEARN_MIN_MS && !bags[i].isSolenoidTimedOut());
+            if (coasting[i]) {
+                closedPsi[i] = psi;
+                closedDeltaPsi[i] = tankPressure - psi;
+                coastPumping[i] = pumping;
+                closedAtMs[i] = now;
+            }
+            if (state == VALVE_INFLATE) openedAtMs[i] = now;
+            lastState[i] = state;
+            continue;
+        }
+        if (!coasting[i] || now - closedAtMs[i] < FILL_COAST_SETTLE_MS) continue;
+        coasting[i] = false;
+
+        // Blend the observed coast into the two bracketing points, each by
+        // how close the fill was to it
+        float coast = constrain(psi - closedPsi[i], 0.0f, FILL_LEAD_MAX_PSI);
+        int lo;
+        float weight;
+        bracket(closedDeltaPsi[i], lo, weight);
+        float* row = lead[i][coastPumping[i] ? 1 : 0];
+        row[lo] += FILL_LEARN_GAIN * (1.0f - weight) * (coast - row[lo]);
+        row[lo + 1] += FILL_LEARN_GAIN * weight * (coast - row[lo + 1]);
+        if (fills[i] < 0xFFFF) fills[i]++;
+    }
+}
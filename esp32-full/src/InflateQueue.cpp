@@ -0,0 +1,97 @@
+#include "InflateQueue.h"
+
+InflateQueue::InflateQueue()
+    : queued(0),
+      released(0),
+      deferrals(0) {
+    for (int i = 0; i < NUM_BAGS; i++) {
+        queuedAtMs[i] = 0;
+        need[i] = 0;
+    }
+}
+
+uint8_t InflateQueue::priorityOf(int bag) {
+    return (bag == REAR_LEFT || bag == REAR_RIGHT) ? QUEUE_PRIORITY_REAR : QUEUE_PRIORITY_FRONT;
+}
+
+unsigned long InflateQueue::getWaitMs(int bag) const {
+    return (queued & (1 << bag)) ? millis() - queuedAtMs[bag] : 0;
+}
+
+void InflateQueue::update(const AirBag* bags, const DeadbandEstimator& deadband, const AirBudget& budget,
+                          float tankPressure, bool lockout, uint8_t coordinated) {
+    unsigned long now = millis();
+    for (int i = 0; i < NUM_BAGS; i++) {
+        uint8_t bit = 1 << i;
+        need[i] = bags[i].getTargetPressure() - bags[i].getPressure();
+        bool wants = need[i] > deadband.getBand(i) + deadband.getReopen(i);
+
+        if ((queued & bit) && (!wants || bags[i].isSolenoidTimedOut())) {
+            // Arrived, or the target moved down: out of the queue
+            if (released & bit) {
+                Serial.print("[QUEUE] ");
+                Serial.print(bags[i].getName());
+                Serial.print(" resumed and done after ");
+                Serial.print((now - queuedAtMs[i]) / 1000.0, 1);
+                Serial.println(" s");
+            }
+            queued &= ~bit;
+            released &= ~bit;
+        } else if (!(queued & bit) && wants && lockout && !bags[i].isSolenoidTimedOut()) {
+            queued |= bit;
+            queuedAtMs[i] = now;
+            if (deferrals < 0xFFFFFFFF) deferrals++;
+            Serial.print("[QUEUE] ");
+            Serial.print(bags[i].getName());
+            Serial.print(" waits for the tank (+");
+            Serial.print(need[i], 1);
+            Serial.print(" PSI, priority ");
+            Serial.print(priorityOf(i));
+            Serial.println(")");
+        }
+    }
+
+    if (lockout) {
+        // Back in line: the order starts again once the tank recovers
+        released = 0;
+    } else if (queued & ~released) {
+        release(bags, budget, tankPressure, coordinated);
+    }
+}
+
+// Lowest priority level still waiting goes next, if the tank can carry it
+// on top of what the released corners still draw
+void InflateQueue::release(const AirBag* bags, const AirBudget& budget, float tankPressure,
+                           uint8_t coordinated) {
+    uint8_t waiting = queued & ~released;
+    int level = 255;
+    for (int i = 0; i < NUM_BAGS; i++) {
+        if (waiting & (1 << i)) level = min(level, (int)priorityOf(i));
+    }
+
+    float drawPsi = 0;
+    uint8_t next = waiting & coordinated;
+    for (int i = 0; i < NUM_BAGS; i++) {
+        uint8_t bit = 1 << i;
+        bool inFlight = released & bit;
+        if ((waiting & bit) && priorityOf(i) == level) next |= bit;
+        if (inFlight || (next & bit)) {
+            drawPsi += max(0.0f, need[i]) * budget.getBagVolumeL(i) / budget.getTankVolumeL();
+        }
+    }
+    if (released && !(next & coordinated) && tankPressure - drawPsi < QUEUE_RELEASE_FLOOR_PSI) return;
+
+    released |= next;
+    Serial.print("[QUEUE] Releasing");
+    for (int i = 0; i < NUM_BAGS; i++) {
+        if (next & (1 << i)) {
+            Serial.print(" ");
+            Serial.print(bags[i].getName());
+        }
+    }
+    Serial.print(" (tank ");
+    Serial.print(tankPressure, 0);
+    Serial.print(" PSI, ~");
+    Serial.print(tankPressure - drawPsi, 0);
+    Serial.println(" after)");
+}
@@ -0,0 +1,376 @@
+#include "LevelController.h"
+
+static const int MAX_RELATIONS = 3;
+
+// Corners a mode may move (bit n = bag n)
+static uint8_t cornersFor(LevelMode mode) {
+    switch (mode) {
+        case LEVEL_FRONT: return (1 << FRONT_LEFT) | (1 << FRONT_RIGHT);
+        case LEVEL_REAR:  return (1 << REAR_LEFT) | (1 << REAR_RIGHT);
+        case LEVEL_ALL:   return 0x0F;
+        default:          return 0;
+    }
+}
+
+static int countBits(uint8_t bits) {
+    int n = 0;
+    for (; bits; bits &= bits - 1) n++;
+    return n;
+}
+
+// Gaussian elimination with partial pivoting, n <= MAX_RELATIONS.
+// Solves a x = b in place (x returned in b); false if singular.
+static bool solveLinear(float a[MAX_RELATIONS][MAX_RELATIONS], float b[MAX_RELATIONS], int n) {
+    for (int c = 0; c < n; c++) {
+        int pivot = c;
+        for (int r = c + 1; r < n; r++) {
+            if (abs(a[r][c]) > abs(a[pivot][c])) pivot = r;
+        }
+        if (abs(a[pivot][c]) < 1e-4f) return false;
+        if (pivot != c) {
+            for (int k = 0; k < n; k++) {
+                float t = a[c][k]; a[c][k] = a[pivot][k]; a[pivot][k] = t;
+            }
+            float t = b[c]; b[c] = b[pivot]; b[pivot] = t;
+        }
+        for (int r = 0; r < n; r++) {
+            if (r == c) continue;
+            float f = a[r][c] / a[c][c];
+            for (int k = c; k < n; k++) a[r][k] -= f * a[c][k];
+            b[r] -= f * b[c];
+        }
+    }
+    for (int c = 0; c < n; c++) b[c] /= a[c][c];
+    return true;
+}
+
+LevelController::LevelController()
+    : pitchTarget(NAN),
+      heldPitch(0),
+      pitchHeld(true),
+      phase(LEVEL_IDLE),
+      movers(0),
+      phaseSinceMs(0),
+      lastCheckMs(0),
+      quietSinceMs(0),
+      residual(0),
+      corrections(0),
+      cornerMoves(0),
+      stepBag(-1),
+      restValid(false) {
+    for (int i = 0; i < NUM_BAGS; i++) {
+        bool front = (i == FRONT_LEFT || i == FRONT_RIGHT);
+        bool left = (i == FRONT_LEFT || i == REAR_LEFT);
+        for (int j = 0; j < NUM_BAGS; j++) {
+            bool jFront = (j == FRONT_LEFT || j == FRONT_RIGHT);
+            bool jLeft = (j == FRONT_LEFT || j == REAR_LEFT);
+            if (i == j)                               coupling[i][j] = 1.0;
+            else if (front == jFront)                 coupling[i][j] = LEVEL_COUPLING_SIDE;
+            else if (left == jLeft)                   coupling[i][j] = LEVEL_COUPLING_AXLE;
+            else                                      coupling[i][j] = LEVEL_COUPLING_DIAG;
+        }
+        reference[i] = 0;
+        stepStartPsi[i] = 0;
+        restPsi[i] = 0;
+    }
+}
+
+void LevelController::engage(const AirBag* bags) {
+    rebase(bags);
+    lastCheckMs = 0;
+}
+
+void LevelController::rebase(const AirBag* bags) {
+    for (int i = 0; i < NUM_BAGS; i++) {
+        float target = bags[i].getTargetPressure();
+        reference[i] = (target > 0) ? target : bags[i].getPressure();
+    }
+    heldPitch = (reference[FRONT_LEFT] + reference[FRONT_RIGHT] -
+                 reference[REAR_LEFT] - reference[REAR_RIGHT]) / 2.0;
+    phase = LEVEL_IDLE;
+    movers = 0;
+}
+
+void LevelController::setPitchTarget(float psi) {
+    pitchHeld = isnan(psi);
+    pitchTarget = psi;
+    phase = LEVEL_IDLE;     // Judge against the new pitch on the next check
+    movers = 0;
+}
+
+const char* LevelController::phaseName(LevelPhase phase) {
+    switch (phase) {
+        case LEVEL_IDLE:       return "idle";
+        case LEVEL_CORRECTING: return "correcting";
+        case LEVEL_SETTLING:   return "settling";
+        default:               return "?";
+    }
+}
+
+// ============================================
+// CONTROL
+// ============================================
+
+uint8_t LevelController::update(AirBag* bags, const DeadbandEstimator& deadband, LevelMode mode,
+                                bool mayCorrect, bool canInflate) {
+    unsigned long now = millis();
+    learn(bags, now);
+
+    if (mode == LEVEL_OFF || !mayCorrect) {
+        phase = LEVEL_IDLE;
+        movers = 0;
+        return 0;
+    }
+
+    float psi[NUM_BAGS];
+    for (int i = 0; i < NUM_BAGS; i++) {
+        psi[i] = bags[i].getPressure();
+    }
+
+    if (phase == LEVEL_CORRECTING) {
+        bool landed = true;
+        for (int i = 0; i < NUM_BAGS; i++) {
+            if ((movers & (1 << i)) && !bags[i].isHolding() && !bags[i].isSolenoidTimedOut()) landed = false;
+        }
+        if (landed || now - phaseSinceMs >= LEVEL_CORRECTION_TIMEOUT_MS) {
+            phase = LEVEL_SETTLING;
+            phaseSinceMs = now;
+        }
+        return 0;
+    }
+
+    if (phase == LEVEL_SETTLING) {
+        if (now - phaseSinceMs < LEVEL_SETTLE_MS) return 0;
+
+        // The correction aimed past each mover (tracking stops at the near
+        // edge of its band); re-centre the band on where the corners landed
+        uint8_t centred = 0;
+        uint8_t corners = cornersFor(mode);
+        for (int i = 0; i < NUM_BAGS; i++) {
+            if ((corners & (1 << i)) && psi[i] > 0) {
+                bags[i].setTargetPressure(psi[i]);
+                centred |= (1 << i);
+            }
+        }
+        phase = LEVEL_IDLE;
+        movers = 0;
+        return centred;
+    }
+
+    // Idle: judge level only once the car has been still a while
+    if (now - lastCheckMs < LEVEL_ADJUST_STEP_MS) return 0;
+    lastCheckMs = now;
+    if (stepBag >= 0 || now - quietSinceMs < LEVEL_SETTLE_MS) return 0;
+
+    float rows[MAX_RELATIONS][NUM_BAGS];
+    float error[MAX_RELATIONS];
+    int m = relations(mode, psi, rows, error);
+    bool level = true;
+    residual = 0;
+    for (int r = 0; r < m; r++) {
+        // Corners that can only hold to a wide band can't be levelled
+        // tighter, and reading noise alone mustn't look like a lean
+        float widest = 0;
+        float variance = 0;
+        for (int i = 0; i < NUM_BAGS; i++) {
+            if (rows[r][i] == 0) continue;
+            widest = max(widest, deadband.getBand(i));
+            float noise = rows[r][i] * deadband.getNoise(i);
+            variance += noise * noise;
+        }
+        float tolerance = max(LEVEL_TOLERANCE_PSI * widest / TARGET_TOLERANCE_PSI,
+                              DEADBAND_NOISE_SIGMAS * sqrtf(variance));
+        residual = max(residual, abs(error[r]));
+        if (abs(error[r]) > tolerance) level = false;
+    }
+    if (level) return 0;
+
+    float move[NUM_BAGS];
+    if (!plan(mode, psi, canInflate, move)) return 0;
+    return correct(bags, deadband, mode, psi, move);
+}
+
+// Level relations for a mode: rows . psi should equal the goal; error is
+// the difference
+int LevelController::relations(LevelMode mode, const float psi[NUM_BAGS],
+                               float rows[][NUM_BAGS], float error[]) const {
+    int m = 0;
+    memset(rows, 0, sizeof(float) * NUM_BAGS * MAX_RELATIONS);
+    if (mode == LEVEL_FRONT || mode == LEVEL_ALL) {
+        rows[m][FRONT_LEFT] = 1;
+        rows[m][FRONT_RIGHT] = -1;
+        error[m++] = psi[FRONT_LEFT] - psi[FRONT_RIGHT];
+    }
+    if (mode == LEVEL_REAR || mode == LEVEL_ALL) {
+        rows[m][REAR_LEFT] = 1;
+        rows[m][REAR_RIGHT] = -1;
+        error[m++] = psi[REAR_LEFT] - psi[REAR_RIGHT];
+    }
+    if (mode == LEVEL_ALL) {
+        rows[m][FRONT_LEFT] = rows[m][FRONT_RIGHT] = 0.5;
+        rows[m][REAR_LEFT] = rows[m][REAR_RIGHT] = -0.5;
+        error[m++] = (psi[FRONT_LEFT] + psi[FRONT_RIGHT] - psi[REAR_LEFT] - psi[REAR_RIGHT]) / 2.0 -
+                     getPitchTarget();
+    }
+    return m;
+}
+
+// Try every set of corners the mode may move, large enough to fix all m
+// relations. Through the coupling matrix, moving set S by u changes the
+// relations by M u (M = rows x coupling, S columns); the least-norm u with
+// M u = -error is u = M' (M M')^-1 (-error). Keep the cheapest plan: each
+// corner moved costs LEVEL_MOVE_COST_PSI plus its move plus how far it ends
+// up from the reference stance.
+bool LevelController::plan(LevelMode mode, const float psi[NUM_BAGS], bool canInflate,
+                           float move[NUM_BAGS]) const {
+    float rows[MAX_RELATIONS][NUM_BAGS];
+    float error[MAX_RELATIONS];
+    int m = relations(mode, psi, rows, error);
+    uint8_t corners = cornersFor(mode);
+
+    // Effect of each corner's own move on each relation
+    float effect[MAX_RELATIONS][NUM_BAGS];
+    for (int r = 0; r < m; r++) {
+        for (int j = 0; j < NUM_BAGS; j++) {
+            effect[r][j] = 0;
+            for (int i = 0; i < NUM_BAGS; i++) effect[r][j] += rows[r][i] * coupling[i][j];
+        }
+    }
+
+    float bestCost = INFINITY;
+    for (uint8_t set = 1; set <= 0x0F; set++) {
+        if ((set & ~corners) || countBits(set) < m) continue;
+
+        float gram[MAX_RELATIONS][MAX_RELATIONS];
+        float y[MAX_RELATIONS];
+        for (int r = 0; r < m; r++) {
+            for (int q = 0; q < m; q++) {
+                gram[r][q] = 0;
+                for (int j = 0; j < NUM_BAGS; j++) {
+                    if (set & (1 << j)) gram[r][q] += effect[r][j] * effect[q][j];
+                }
+            }
+            y[r] = -error[r];
+        }
+        if (!solveLinear(gram, y, m)) continue;
+
+        float u[NUM_BAGS];
+        float cost = 0;
+        bool usable = true;
+        for (int j = 0; j < NUM_BAGS && usable; j++) {
+            u[j] = 0;
+            if (!(set & (1 << j))) continue;
+            for (int r = 0; r < m; r++) u[j] += effect[r][j] * y[r];
+
+            float end = psi[j] + u[j];
+            if (abs(u[j]) < LEVEL_MIN_MOVE_PSI ||           // Smaller set does it
+                (u[j] > 0 && !canInflate) ||
+                end < MIN_BAG_PSI || end > MAX_BAG_PSI) {
+                usable = false;
+            }
+            cost += LEVEL_MOVE_COST_PSI + abs(u[j]) + abs(end - reference[j]);
+        }
+        if (usable && cost < bestCost) {
+            bestCost = cost;
+            memcpy(move, u, sizeof(u));
+        }
+    }
+    return bestCost < INFINITY;
+}
+
+uint8_t LevelController::correct(AirBag* bags, const DeadbandEstimator& deadband, LevelMode mode,
+                                 const float psi[NUM_BAGS], const float move[NUM_BAGS]) {
+    uint8_t corners = cornersFor(mode);
+    uint8_t retargeted = 0;
+    movers = 0;
+
+    Serial.print("[LEVEL] Correction");
+    for (int i = 0; i < NUM_BAGS; i++) {
+        // Where every corner should end up, load transfer included
+        float predicted = psi[i];
+        for (int j = 0; j < NUM_BAGS; j++) predicted += coupling[i][j] * move[j];
+
+        if (move[i] > 0) {
+            // Tracking carries an inflating corner to its target (less the
+            // predicted coast); a small move wouldn't reopen a holding
+            // valve, so start it here
+            bags[i].setTargetPressure(predicted);
+            bags[i].inflate();
+        } else if (move[i] < 0) {
+            // A dump closes at the near edge of the band
+            bags[i].setTargetPressure(predicted - deadband.getBand(i));
+        }
+        if (move[i] != 0) {
+            movers |= (1 << i);
+            retargeted |= (1 << i);
+            cornerMoves++;
+            Serial.print(" ");
+            Serial.print(bags[i].getName());
+            Serial.print(move[i] > 0 ? " +" : " ");
+            Serial.print(move[i], 1);
+        } else if ((corners & (1 << i)) || bags[i].getTargetPressure() > 0) {
+            bags[i].setTargetPressure(predicted);
+            retargeted |= (1 << i);
+        }
+    }
+    Serial.print(" (off by ");
+    Serial.print(residual, 1);
+    Serial.println(" PSI)");
+
+    corrections++;
+    phase = LEVEL_CORRECTING;
+    phaseSinceMs = millis();
+    return retargeted;
+}
+
+// ============================================
+// COUPLING LEARNING
+// ============================================
+
+// A step starts when one corner's valve opens while the rest hold and
+// ends once every valve has been closed for LEVEL_LEARN_SETTLE_MS (pulses
+// in between belong to the same step). Anything else moving spoils it.
+// The other corners' change per PSI of the mover's change is one
+// observation of that coupling column.
+void LevelController::learn(const AirBag* bags, unsigned long now) {
+    int moving = -1;
+    int count = 0;
+    for (int i = 0; i < NUM_BAGS; i++) {
+        if (!bags[i].isHolding()) {
+            moving = i;
+            count++;
+        }
+    }
+
+    if (count > 0) {
+        quietSinceMs = now;
+        if (count > 1 || (stepBag >= 0 && moving != stepBag)) {
+            stepBag = -1;
+            restValid = false;
+        } else if (stepBag < 0 && restValid) {
+            stepBag = moving;
+            memcpy(stepStartPsi, restPsi, sizeof(restPsi));
+            restValid = false;
+        }
+        return;
+    }
+    if (now - quietSinceMs < LEVEL_LEARN_SETTLE_MS) return;
+
+    if (stepBag >= 0) {
+        int j = stepBag;
+        float moved = bags[j].getPressure() - stepStartPsi[j];
+        if (abs(moved) >= LEVEL_LEARN_MIN_PSI) {
+            for (int i = 0; i < NUM_BAGS; i++) {
+                if (i == j) continue;
+                float observed = (bags[i].getPressure() - stepStartPsi[i]) / moved;
+                observed = constrain(observed, -LEVEL_COUPLING_MAX, LEVEL_COUPLING_MAX);
+                coupling[i][j] += LEVEL_LEARN_GAIN * (observed - coupling[i][j]);
+            }
+        }
+        stepBag = -1;
+    }
+
+    // The body has settled: a step starting now is measured from here
+    for (int i = 0; i < NUM_BAGS; i++) restPsi[i] = bags[i].getPressure();
+    restValid = true;
+}
@@ -0,0 +1,160 @@
+#include "LinkProtocol.h"
+#include <string.h>
+
+LinkPacket::LinkPacket(uint8_t t, uint8_t s)
+    : type(t),
+      seq(s),
+      length(0),
+      readPos(0) {
+}
+
+bool LinkPacket::putU8(uint8_t v) {
+    if (length + 1 > LINK_MAX_PAYLOAD) return false;
+    payload[length++] = v;
+    return true;
+}
+
+bool LinkPacket::putU16(uint16_t v) {
+    return putU8(v & 0xFF) && putU8(v >> 8);
+}
+
+bool LinkPacket::putU32(uint32_t v) {
+    return putU16(v & 0xFFFF) && putU16(v >> 16);
+}
+
+bool LinkPacket::putFloat(float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    return putU32(bits);
+}
+
+bool LinkPacket::getU8(uint8_t& v) {
+    if (readPos + 1 > length) return false;
+    v = payload[readPos++];
+    return true;
+}
+
+bool LinkPacket::getI8(int8_t& v) {
+    uint8_t u;
+    if (!getU8(u)) return false;
+    v = (int8_t)u;
+    return true;
+}
+
+bool LinkPacket::getU16(uint16_t& v) {
+    uint8_t lo, hi;
+    if (!getU8(lo) || !getU8(hi)) return false;
+    v = (uint16_t)(lo | (hi << 8));
+    return true;
+}
+
+bool LinkPacket::getU32(uint32_t& v) {
+    uint16_t lo, hi;
+    if (!getU16(lo) || !getU16(hi)) return false;
+    v = (uint32_t)lo | ((uint32_t)hi << 16);
+    return true;
+}
+
+bool LinkPacket::getFloat(float& v) {
+    uint32_t bits;
+    if (!getU32(bits)) return false;
+    memcpy(&v, &bits, sizeof(v));
+    return true;
+}
+
+void LinkPacket::putState(const LinkState& s) {
+    putU32(s.ms);
+    putU32(s.tickMs);
+    putFloat(s.tank);
+    for (int i = 0; i < 4; i++) putFloat(s.bags[i]);
+    for (int i = 0; i < 4; i++) putFloat(s.targets[i]);
+    putU8(s.valves);
+    putU8(s.pumps);
+    putU8(s.timeouts);
+    putU8(s.flags);
+    putU8(s.levelMode);
+    putU8(s.pumpMode);
+}
+
+bool LinkPacket::getState(LinkState& s) {
+    bool ok = getU32(s.ms) && getU32(s.tickMs) && getFloat(s.tank);
+    for (int i = 0; i < 4; i++) ok = ok && getFloat(s.bags[i]);
+    for (int i = 0; i < 4; i++) ok = ok && getFloat(s.targets[i]);
+    return ok && getU8(s.valves) && getU8(s.pumps) && getU8(s.timeouts) &&
+           getU8(s.flags) && getU8(s.levelMode) && getU8(s.pumpMode);
+}
+
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF)
+uint16_t linkCrc16(const uint8_t* data, size_t length) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+size_t linkEncode(const LinkPacket& packet, uint8_t* out) {
+    uint8_t raw[LINK_MAX_FRAME];
+    size_t rawLength = 0;
+    raw[rawLength++] = packet.type;
+    raw[rawLength++] = packet.seq;
+    memcpy(raw + rawLength, packet.payload, packet.length);
+    rawLength += packet.length;
+    uint16_t crc = linkCrc16(raw, rawLength);
+    raw[rawLength++] = crc & 0xFF;
+    raw[rawLength++] = crc >> 8;
+
+    // COBS: each code byte gives the distance to the next zero (or block end)
+    size_t n = 0;
+    out[n++] = 0x00;
+    size_t codePos = n++;
+    uint8_t code = 1;
+    for (size_t i = 0; i < rawLength; i++) {
+        if (raw[i] == 0) {
+            out[codePos] = code;
+            codePos = n++;
+            code = 1;
+        } else {
+            out[n++] = raw[i];
+            if (++code == 0xFF) {
+                out[codePos] = code;
+                codePos = n++;
+                code = 1;
+            }
+        }
+    }
+    out[codePos] = code;
+    out[n++] = 0x00;
+    return n;
+}
+
+bool linkDecode(const uint8_t* encoded, size_t length, LinkPacket& packet) {
+    uint8_t raw[LINK_MAX_FRAME];
+    size_t rawLength = 0;
+
+    size_t i = 0;
+    while (i < length) {
+        uint8_t code = encoded[i++];
+        if (code == 0) return false;
+        for (uint8_t j = 1; j < code; j++) {
+            if (i >= length || rawLength >= LINK_MAX_FRAME) return false;
+            raw[rawLength++] = encoded[i++];
+        }
+        if (code != 0xFF && i < length) {
+            if (rawLength >= LINK_MAX_FRAME) return false;
+            raw[rawLength++] = 0;
+        }
+    }
+
+    if (rawLength < 4) return false;
+    uint16_t crc = raw[rawLength - 2] | (raw[rawLength - 1] << 8);
+    if (linkCrc16(raw, rawLength - 2) != crc) return false;
+
+    packet = LinkPacket(raw[0], raw[1]);
+    packet.length = rawLength - 4;
+    memcpy(packet.payload, raw + 2, packet.length);
+    return true;
+}
@@ -0,0 +1,412 @@
+#include "PneumaticPlant.h"
+
+#if AIRRIDE_HAS_SIM_PLANT
+
+#if defined(AIRRIDE_HAL_SIM) || defined(AIRRIDE_HAL_BENCH)
+PneumaticPlant simPlant;
+#endif
+
+// Units: internal state is SI (kg, m^3, Pa absolute, K)
+static const float PA_PER_PSI = 6894.757f;
+static const float P_ATM = 101325.0f;
+static const float R_AIR = 287.05f;         // J/(kg K)
+static const float M3_PER_IN3 = 1.6387064e-5f;
+static const float M2_PER_IN2 = 6.4516e-4f;
+static const float M2_PER_MM2 = 1.0e-6f;
+static const float M3S_PER_CFM = 4.719474e-4f;
+static const float N_PER_LBF = 4.448222f;
+
+// Compressible orifice flow, gamma = 1.4
+static const float CRITICAL_RATIO = 0.5283f;   // Downstream/upstream ratio where flow chokes
+static const float CHOKED_K = 0.040418f;       // sqrt(g/R) * (2/(g+1))^((g+1)/(2(g-1)))
+static const float SUBSONIC_K = 0.024386f;     // 2g / (R (g-1))
+
+static const int BAG_SOLVE_ITERATIONS = 16;    // Bisection on the stroke: ~0.0001 in
+static const int WARP_SOLVE_ITERATIONS = 12;   // Regula falsi on the transferred load
+static const float WARP_SOLVE_TOLERANCE_LBF = 0.5;
+
+static const uint8_t INFLATE_PINS[NUM_BAGS] = {
+    FRONT_LEFT_INFLATE_PIN, FRONT_RIGHT_INFLATE_PIN, REAR_LEFT_INFLATE_PIN, REAR_RIGHT_INFLATE_PIN
+};
+static const uint8_t DEFLATE_PINS[NUM_BAGS] = {
+    FRONT_LEFT_DEFLATE_PIN, FRONT_RIGHT_DEFLATE_PIN, REAR_LEFT_DEFLATE_PIN, REAR_RIGHT_DEFLATE_PIN
+};
+static const uint8_t PRESSURE_PINS[NUM_BAGS] = {
+    FRONT_LEFT_PRESSURE_PIN, FRONT_RIGHT_PRESSURE_PIN, REAR_LEFT_PRESSURE_PIN, REAR_RIGHT_PRESSURE_PIN
+};
+
+// Mass flow (kg/s) through an orifice from pUp to pDown (absolute Pa)
+static float orificeFlow(float cdAmm2, float pUp, float pDown, float tUp) {
+    if (cdAmm2 <= 0 || pUp <= pDown) return 0;
+    float cdA = cdAmm2 * M2_PER_MM2;
+    float ratio = pDown / pUp;
+    if (ratio <= CRITICAL_RATIO) {
+        return cdA * pUp * CHOKED_K / sqrtf(tUp);
+    }
+    float psi = powf(ratio, 1.0f / 0.7f) - powf(ratio, 1.2f / 0.7f);  // r^(2/g) - r^((g+1)/g)
+    return cdA * pUp * sqrtf(SUBSONIC_K * max(0.0f, psi) / tUp);
+}
+
+// Gaussian sample (Box-Muller) from the Arduino PRNG
+static float gaussian() {
+    float u1 = random(1, 1000001) / 1000000.0f;
+    float u2 = random(0, 1000000) / 1000000.0f;
+    return sqrtf(-2.0f * logf(u1)) * cosf(2.0f * (float)M_PI * u2);
+}
+
+void PlantParams::setDefaults() {
+    tankVolumeL = PLANT_TANK_VOLUME_L;
+    ambientC = PLANT_AMBIENT_C;
+    for (int i = 0; i < NUM_BAGS; i++) {
+        bool front = (i == FRONT_LEFT || i == FRONT_RIGHT);
+        loadLbf[i] = front ? PLANT_FRONT_LOAD_LBF : PLANT_REAR_LOAD_LBF;
+        areaIn2[i] = front ? PLANT_FRONT_AREA_IN2 : PLANT_REAR_AREA_IN2;
+        inflateCdAmm2[i] = PLANT_INFLATE_CDA_MM2;
+        deflateCdAmm2[i] = PLANT_DEFLATE_CDA_MM2;
+    }
+    areaLoss = PLANT_BAG_AREA_LOSS;
+    minVolumeIn3 = PLANT_BAG_MIN_VOLUME_IN3;
+    strokeIn = PLANT_BAG_STROKE_IN;
+    warpLbfPerIn = PLANT_WARP_LBF_PER_IN;
+    groundTwistIn = 0;
+    pumpFreeCfm = PLANT_PUMP_FREE_CFM;
+    pumpMaxPsi = PLANT_PUMP_MAX_PSI;
+    pumpDischargeC = PLANT_PUMP_DISCHARGE_C;
+    tankCoolingS = PLANT_TANK_COOLING_S;
+    tankLeakCdAmm2 = PLANT_TANK_LEAK_CDA_MM2;
+    noisePsi = PLANT_SENSOR_NOISE_PSI;
+    inrushSagPsi = PLANT_INRUSH_SAG_PSI;
+    stepS = PLANT_STEP_MS / 1000.0f;
+}
+
+PneumaticPlant::PneumaticPlant()
+    : tankMassKg(0),
+      pump1On(false),
+      pump2On(false),
+      warpStale(false),
+      pendingSeconds(0) {
+    params.setDefaults();
+    resetStats();
+    tankTempK = ambientK();
+    for (int i = 0; i < NUM_BAGS; i++) {
+        inflateOpen[i] = false;
+        deflateOpen[i] = false;
+        warpLoadLbf[i] = 0;
+        setBagPressure(i, DEMO_BAG_PSI);
+    }
+    inrushLeftS[0] = inrushLeftS[1] = 0;
+    setTankPressure(DEMO_TANK_PSI);
+}
+
+void PneumaticPlant::seed(const float bagPressures[NUM_BAGS], float tankPressure) {
+    for (int i = 0; i < NUM_BAGS; i++) {
+        if (bagPressures[i] > 0) setBagPressure(i, bagPressures[i]);
+    }
+    if (tankPressure > 0) setTankPressure(tankPressure);
+}
+
+void PneumaticPlant::setParams(const PlantParams& p) {
+    float bagPsi[NUM_BAGS];
+    for (int i = 0; i < NUM_BAGS; i++) {
+        bagPsi[i] = getBagPressure(i);
+    }
+    float tankPsi = getTankPressure();
+
+    params = p;
+    if (params.stepS <= 0) params.stepS = PLANT_STEP_MS / 1000.0f;
+    warpStale = true;
+
+    for (int i = 0; i < NUM_BAGS; i++) {
+        setBagPressure(i, bagPsi[i]);
+    }
+    setTankPressure(tankPsi);
+}
+
+void PneumaticPlant::resetStats() {
+    memset(&stats, 0, sizeof(stats));
+}
+
+void PneumaticPlant::setAmbient(float celsius) {
+    // Bags follow ambient immediately, the tank cools/warms on its time constant
+    params.ambientC = celsius;
+    for (int i = 0; i < NUM_BAGS; i++) {
+        solveBag(i);
+    }
+}
+
+// ============================================
+// STATE
+// ============================================
+
+void PneumaticPlant::setBagPressure(int bag, float psi) {
+    if (psi < 0) psi = 0;
+
+    // Height where this pressure carries the load: A(h) = W / P
+    float heightIn = 0;
+    if (psi > 0) {
+        float neededIn2 = cornerLoadLbf(bag) / psi;
+        heightIn = (1.0f - neededIn2 / params.areaIn2[bag]) * params.strokeIn / params.areaLoss;
+        heightIn = constrain(heightIn, 0.0f, params.strokeIn);
+    }
+
+    bagHeightIn[bag] = heightIn;
+    bagVolumeM3[bag] = bagVolumeAt(bag, heightIn);
+    bagMassKg[bag] = (psi * PA_PER_PSI + P_ATM) * bagVolumeM3[bag] / (R_AIR * ambientK());
+    warpStale = true;       // The body settles on the next step
+}
+
+void PneumaticPlant::setTankPressure(float psi) {
+    if (psi < 0) psi = 0;
+    tankMassKg = (psi * PA_PER_PSI + P_ATM) * tankVolumeM3() / (R_AIR * tankTempK);
+}
+
+float PneumaticPlant::getBagPressure(int bag) const {
+    return max(0.0f, (bagAbsPa(bag) - P_ATM) / PA_PER_PSI);
+}
+
+float PneumaticPlant::getTankPressure() const {
+    return max(0.0f, (tankAbsPa() - P_ATM) / PA_PER_PSI);
+}
+
+float PneumaticPlant::getTankTemperature() const {
+    return tankTempK - 273.15f;
+}
+
+float PneumaticPlant::bagAbsPa(int bag) const {
+    return bagMassKg[bag] * R_AIR * ambientK() / bagVolumeM3[bag];
+}
+
+float PneumaticPlant::tankAbsPa() const {
+    return tankMassKg * R_AIR * tankTempK / tankVolumeM3();
+}
+
+// Volume grows with the integral of the (shrinking) effective area
+float PneumaticPlant::bagVolumeAt(int bag, float heightIn) const {
+    float swept = params.areaIn2[bag] * (heightIn - params.areaLoss * heightIn * heightIn / (2.0f * params.strokeIn));
+    return (params.minVolumeIn3 + swept) * M3_PER_IN3;
+}
+
+// Quasi-static suspension: find the height where bag force equals the
+// corner load. Force falls monotonically with height (pressure drops as
+// volume grows, effective area shrinks), so bisection always converges.
+void PneumaticPlant::solveBag(int bag) {
+    float mrt = bagMassKg[bag] * R_AIR * ambientK();
+    float loadN = cornerLoadLbf(bag) * N_PER_LBF;
+    float a0 = params.areaIn2[bag] * M2_PER_IN2;
+
+    // Net upward force at a given height
+    #define BAG_FORCE(h) ((mrt / bagVolumeAt(bag, h) - P_ATM) * a0 * (1.0f - params.areaLoss * (h) / params.strokeIn) - loadN)
+
+    float heightIn;
+    if (BAG_FORCE(0.0f) <= 0) {
+        heightIn = 0;                   // Sitting on the bump stop
+    } else if (BAG_FORCE(params.strokeIn) >= 0) {
+        heightIn = params.strokeIn;     // Topped out
+    } else {
+        float lo = 0, hi = params.strokeIn;
+        for (int n = 0; n < BAG_SOLVE_ITERATIONS; n++) {
+            float mid = 0.5f * (lo + hi);
+            if (BAG_FORCE(mid) > 0) lo = mid; else hi = mid;
+        }
+        heightIn = 0.5f * (lo + hi);
+    }
+    #undef BAG_FORCE
+
+    bagHeightIn[bag] = heightIn;
+    bagVolumeM3[bag] = bagVolumeAt(bag, heightIn);
+}
+
+// Three corners define the body plane; the fourth can only be off it by
+// twisting the body. Twist (FL and RR high against FR and RL, on the bags
+// or on the ground under the wheels) loads the high diagonal and unloads
+// the other, which is what pushes a levelled corner back out when its
+// neighbour moves. The transferred load T must equal the twist stiffness
+// times the twist it leaves; residual(T) rises monotonically with T (more
+// load squats the high diagonal), so regula falsi finds it in a few steps.
+void PneumaticPlant::solveWarp() {
+    float limit = params.loadLbf[0];
+    for (int i = 1; i < NUM_BAGS; i++) limit = min(limit, params.loadLbf[i]);
+    limit *= 0.9f;      // No corner ever goes light
+
+    float lo = -limit, hi = limit;
+    float fLo = warpResidual(lo), fHi = warpResidual(hi);
+    if (fLo >= 0 || fHi <= 0) {
+        warpResidual(fLo >= 0 ? lo : hi);   // Twist beyond what the loads can resist
+        return;
+    }
+    int side = 0;
+    for (int n = 0; n < WARP_SOLVE_ITERATIONS; n++) {
+        float t = (lo * fHi - hi * fLo) / (fHi - fLo);
+        float f = warpResidual(t);
+        if (abs(f) < WARP_SOLVE_TOLERANCE_LBF) return;
+        // Illinois: halve the stale end so the bracket keeps shrinking
+        if (f > 0) {
+            hi = t; fHi = f;
+            if (side == 1) fLo *= 0.5f;
+            side = 1;
+        } else {
+            lo = t; fLo = f;
+            if (side == -1) fHi *= 0.5f;
+            side = -1;
+        }
+    }
+}
+
+float PneumaticPlant::warpResidual(float twistLbf) {
+    static const float DIAGONAL[NUM_BAGS] = { 1, -1, -1, 1 };   // FL, FR, RL, RR
+    float twistIn = params.groundTwistIn;
+    for (int i = 0; i < NUM_BAGS; i++) {
+        warpLoadLbf[i] = DIAGONAL[i] * twistLbf;
+        solveBag(i);
+        twistIn += DIAGONAL[i] * bagHeightIn[i];
+    }
+    return twistLbf - params.warpLbfPerIn * twistIn;
+}
+
+// ============================================
+// I/O
+// ============================================
+
+void PneumaticPlant::writePin(uint8_t pin, uint8_t level) {
+    bool energized = (level == RELAY_ON);
+    for (int i = 0; i < NUM_BAGS; i++) {
+        if (pin == INFLATE_PINS[i]) {
+            if (inflateOpen[i] != energized) stats.valveTransitions++;
+            inflateOpen[i] = energized;
+        }
+        if (pin == DEFLATE_PINS[i]) {
+            if (deflateOpen[i] != energized) stats.valveTransitions++;
+            deflateOpen[i] = energized;
+        }
+    }
+    if (pin == PUMP_1_PIN) {
+        if (energized && !pump1On) inrushLeftS[0] = PLANT_INRUSH_MS / 1000.0f;
+        pump1On = energized;
+    }
+    if (pin == PUMP_2_PIN) {
+        if (energized && !pump2On) inrushLeftS[1] = PLANT_INRUSH_MS / 1000.0f;
+        pump2On = energized;
+    }
+}
+
+int PneumaticPlant::readAdc(uint8_t pin) {
+    float psi = 0;
+    if (pin == TANK_PRESSURE_PIN) {
+        psi = getTankPressure();
+    } else {
+        for (int i = 0; i < NUM_BAGS; i++) {
+            if (pin == PRESSURE_PINS[i]) psi = getBagPressure(i);
+        }
+    }
+    if (params.noisePsi > 0) {
+        psi += params.noisePsi * gaussian();
+    }
+    for (int p = 0; p < 2; p++) {
+        if (inrushLeftS[p] > 0) psi -= params.inrushSagPsi;
+    }
+    return psiToAdcCounts(psi);
+}
+
+// ============================================
+// PHYSICS
+// ============================================
+
+void PneumaticPlant::advance(float seconds) {
+    pendingSeconds += seconds;
+    while (pendingSeconds >= params.stepS) {
+        step(params.stepS);
+        pendingSeconds -= params.stepS;
+    }
+}
+
+void PneumaticPlant::step(float dt) {
+    float ambient = ambientK();
+    float tankV = tankVolumeM3();
+
+    for (int p = 0; p < 2; p++) {
+        inrushLeftS[p] = max(0.0f, inrushLeftS[p] - dt);
+    }
+
+    // Tank air cools toward ambient
+    tankTempK += (ambient - tankTempK) * dt / params.tankCoolingS;
+
+    // Pump delivery against back-pressure; hot discharge mixes into the tank
+    int pumps = (pump1On ? 1 : 0) + (pump2On ? 1 : 0);
+    stats.pumpOnS += pumps * dt;
+    if (pumps > 0) {
+        float cfm = params.pumpFreeCfm * (1.0f - getTankPressure() / params.pumpMaxPsi);
+        if (cfm > 0) {
+            float rhoAtm = P_ATM / (R_AIR * ambient);
+            float dm = pumps * cfm * M3S_PER_CFM * rhoAtm * dt;
+            float dischargeK = params.pumpDischargeC + 273.15f;
+            tankTempK = (tankMassKg * tankTempK + dm * dischargeK) / (tankMassKg + dm);
+            tankMassKg += dm;
+            stats.pumpedKg += dm;
+        }
+    }
+
+    // Tank leak to atmosphere (never below ambient pressure)
+    float tankPa = tankAbsPa();
+    float tankStiffness = R_AIR * tankTempK / tankV;    // Pa per kg
+    if (params.tankLeakCdAmm2 > 0 && tankPa > P_ATM) {
+        float dm = orificeFlow(params.tankLeakCdAmm2, tankPa, P_ATM, tankTempK) * dt;
+        tankMassKg -= min(dm, (tankPa - P_ATM) / tankStiffness);
+    }
+
+    bool massChanged = false;
+    for (int i = 0; i < NUM_BAGS; i++) {
+        float bagStiffness = R_AIR * ambient / bagVolumeM3[i];
+        float startMass = bagMassKg[i];
+        stats.solenoidOnS += ((inflateOpen[i] ? 1 : 0) + (deflateOpen[i] ? 1 : 0)) * dt;
+
+        // Tank -> bag. Each transfer is capped at the mass that would equalize
+        // the two pressures, so the explicit step cannot overshoot near balance.
+        if (inflateOpen[i]) {
+            float pTank = tankAbsPa();
+            float pBag = bagAbsPa(i);
+            if (pTank > pBag) {
+                float dm = orificeFlow(params.inflateCdAmm2[i], pTank, pBag, tankTempK) * dt;
+                dm = min(dm, (pTank - pBag) / (tankStiffness + bagStiffness));
+                tankMassKg -= dm;
+                bagMassKg[i] += dm;     // Bag air assumed at ambient temperature
+                stats.tankDrawnKg += dm;
+            }
+        }
+
+        // Bag -> atmosphere (both solenoids open vents the tank through the bag)
+        if (deflateOpen[i]) {
+            float pBag = bagAbsPa(i);
+            if (pBag > P_ATM) {
+                float dm = orificeFlow(params.deflateCdAmm2[i], pBag, P_ATM, ambient) * dt;
+                dm = min(dm, (pBag - P_ATM) / bagStiffness);
+                bagMassKg[i] -= dm;
+                stats.ventedKg += dm;
+            }
+        }
+
+        // Simulated leak on this bag (/simleak), rate in PSI per SIM_LEAK_TICK_MS
+        if (simLeakTarget == i) {
+            float dPa = simLeakRate * PA_PER_PSI * dt * (1000.0f / SIM_LEAK_TICK_MS);
+            float available = max(0.0f, bagAbsPa(i) - P_ATM);
+            bagMassKg[i] -= min(dPa, available) / bagStiffness;
+        }
+
+        if (bagMassKg[i] != startMass) {
+            solveBag(i);
+            massChanged = true;
+        }
+    }
+    if (params.warpLbfPerIn > 0 && (massChanged || warpStale)) {
+        solveWarp();
+        warpStale = false;
+    }
+
+    // Simulated leak on tank
+    if (simLeakTarget == 4) {
+        float dPa = simLeakRate * PA_PER_PSI * dt * (1000.0f / SIM_LEAK_TICK_MS);
+        float available = max(0.0f, tankAbsPa() - P_ATM);
+        tankMassKg -= min(dPa, available) / tankStiffness;
+    }
+}
+
+#endif // AIRRIDE_HAS_SIM_PLANT
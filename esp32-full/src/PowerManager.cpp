@@ -0,0 +1,180 @@
+#include "PowerManager.h"
+#include "Hal.h"
+#include "Actuators.h"
+
+#if !defined(AIRRIDE_NATIVE)
+#include <esp_sleep.h>
+#include <driver/gpio.h>
+#include <esp_task_wdt.h>
+#endif
+
+PowerManager powerManager;
+
+PowerManager::PowerManager()
+    : bags(NULL),
+      controller(NULL),
+      web(NULL),
+      state(POWER_AWAKE),
+      pendingPark(NULL),
+      parkedSince(0),
+      lastClientSeen(0),
+      awakeSince(0) {
+    memset(&stats, 0, sizeof(stats));
+    stats.worstLeakStatus = -1;
+}
+
+void PowerManager::begin(AirBag* b, RideController* rc, AirRideWebServer* w) {
+    bags = b;
+    controller = rc;
+    web = w;
+    lastClientSeen = millis();
+
+#if !defined(AIRRIDE_NATIVE)
+    pinMode(WAKE_BUTTON_PIN, INPUT_PULLUP);
+    gpio_wakeup_enable((gpio_num_t)WAKE_BUTTON_PIN, GPIO_INTR_LOW_LEVEL);
+    esp_sleep_enable_gpio_wakeup();
+    esp_sleep_enable_timer_wakeup((uint64_t)PARK_WAKE_INTERVAL_S * 1000000ULL);
+#endif
+}
+
+void PowerManager::update() {
+    if (!controller) return;
+
+    if (state == POWER_AWAKE) {
+        if (web->getClientCount() > 0) {
+            lastClientSeen = millis();
+        }
+        if (pendingPark) {
+            const char* reason = pendingPark;
+            pendingPark = NULL;
+            park(reason);
+        } else if (PARK_ENABLED && PARK_IDLE_MS > 0 && getIdleRemainingMs() == 0) {
+            park("idle");
+        }
+        return;
+    }
+
+    // Parked: sleep, then either a leak check or the end of the park
+    if (sleepUntilWake()) {
+        stats.timerWakes++;
+        sampleAndCheckLeaks();
+    } else {
+        stats.buttonWakes++;
+        wake("button");
+    }
+}
+
+void PowerManager::requestPark(const char* reason) {
+    pendingPark = reason;
+}
+
+void PowerManager::park(const char* reason) {
+    if (state == POWER_PARKED) return;
+
+    // The AP comes up from loop() after boot; parking before that would
+    // leave it half started
+    if (!web->isConnected()) {
+        Serial.println("[PARK] Not until WiFi is up");
+        return;
+    }
+
+    Serial.print("[PARK] Parking (");
+    Serial.print(reason);
+    Serial.print(") - leak check every ");
+    Serial.print(PARK_WAKE_INTERVAL_S);
+    Serial.print(" s, wake button GPIO ");
+    Serial.println(WAKE_BUTTON_PIN);
+
+    web->suspend();
+    controller->setParked(true);
+
+    state = POWER_PARKED;
+    parkedSince = millis();
+    awakeSince = parkedSince;
+    stats.parks++;
+    stats.worstLeakStatus = -1;
+
+    // Applies the pump stop before the first sleep
+    sampleAndCheckLeaks();
+}
+
+void PowerManager::wake(const char* reason) {
+    if (state != POWER_PARKED) return;
+    state = POWER_AWAKE;
+
+    controller->setParked(false);
+    web->resume();
+    lastClientSeen = millis();
+
+    Serial.print("[PARK] Awake (");
+    Serial.print(reason);
+    Serial.print(") after ");
+    Serial.print((millis() - parkedSince) / 60000UL);
+    Serial.print(" min, est. ");
+    Serial.print(getParkedAverageMa(), 2);
+    Serial.println(" mA average while parked");
+}
+
+bool PowerManager::sleepUntilWake() {
+    unsigned long start = millis();
+    stats.parkedAwakeMs += start - awakeSince;
+
+#if defined(AIRRIDE_NATIVE)
+    // Virtual clock: the plant keeps running while we "sleep"
+    delay(PARK_WAKE_INTERVAL_S * 1000UL);
+    bool timerWake = true;
+#else
+    Serial.flush();
+
+    // Relay levels survive light sleep only while held
+    uint64_t outputs = actuators.getAttachedMask();
+    forEachPin(outputs, [](uint8_t pin) { gpio_hold_en((gpio_num_t)pin); });
+    esp_light_sleep_start();
+    forEachPin(outputs, [](uint8_t pin) { gpio_hold_dis((gpio_num_t)pin); });
+
+    esp_task_wdt_reset();
+    bool timerWake = (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER);
+#endif
+
+    awakeSince = millis();
+    stats.sleptMs += awakeSince - start;
+    return timerWake;
+}
+
+void PowerManager::sampleAndCheckLeaks() {
+    // A fresh average of all five sensors, not one mixed with the
+    // previous wake's samples
+    for (int i = 0; i < PRESSURE_SAMPLES; i++) {
+        controller->tick();
+        delayMicroseconds(BOOT_SAMPLE_DELAY_US);
+    }
+
+    int status = web->checkLeaks();
+    if (status > stats.worstLeakStatus) {
+        stats.worstLeakStatus = status;
+    }
+}
+
+// ============================================
+// REPORTING
+// ============================================
+
+float PowerManager::getCurrentMa() const {
+    return state == POWER_PARKED ? POWER_SLEEP_MA : POWER_AWAKE_MA;
+}
+
+float PowerManager::getParkedMah() const {
+    return (stats.sleptMs * POWER_SLEEP_MA + stats.parkedAwakeMs * POWER_PARKED_WAKE_MA) / 3600000.0;
+}
+
+float PowerManager::getParkedAverageMa() const {
+    unsigned long total = stats.sleptMs + stats.parkedAwakeMs;
+    if (total == 0) return 0.0;
+    return getParkedMah() * 3600000.0 / total;
+}
+
+unsigned long PowerManager::getIdleRemainingMs() const {
+    if (!PARK_ENABLED || PARK_IDLE_MS == 0 || state == POWER_PARKED || !controller) return 0;
+    unsigned long idle = min(controller->getIdleMs(), millis() - lastClientSeen);
+    return idle >= PARK_IDLE_MS ? 0 : PARK_IDLE_MS - idle;
+}
@@ -0,0 +1,261 @@
+#include "PumpHealth.h"
+
+PumpHealth::PumpHealth()
+    : windowPump(-1),
+      windowStartMs(0),
+      windowStartPsi(0),
+      windowLastMs(0),
+      windowLastPsi(0) {
+    for (int p = 0; p < 2; p++) {
+        memset(&curves[p], 0, sizeof(PumpCurve));
+        degraded[p] = false;
+        pumpOnSinceMs[p] = 0;
+        wasOn[p] = false;
+    }
+}
+
+int PumpHealth::binOf(float tankPressure) {
+    return constrain((int)(tankPressure / PUMP_CURVE_BIN_PSI), 0, PUMP_CURVE_BINS - 1);
+}
+
+void PumpHealth::update(float tankPressure, bool pump1On, bool pump2On, bool tankDraw,
+                        const unsigned long runtimeMs[2]) {
+    unsigned long now = millis();
+    bool on[2] = { pump1On, pump2On };
+    for (int p = 0; p < 2; p++) {
+        if (on[p] && !wasOn[p]) pumpOnSinceMs[p] = now;
+        wasOn[p] = on[p];
+    }
+
+    // One pump filling on its own, past its start
+    int alone = -1;
+    if (on[0] != on[1] && !tankDraw) {
+        int p = on[0] ? 0 : 1;
+        if (now - pumpOnSinceMs[p] >= PUMP_CURVE_SETTLE_MS) alone = p;
+    }
+
+    if (windowPump >= 0 && alone != windowPump) {
+        closeWindow();      // Interrupted: up to the last clean sample
+    }
+    if (windowPump >= 0) {
+        windowLastMs = now;
+        windowLastPsi = tankPressure;
+        if (now - windowStartMs >= PUMP_CURVE_WINDOW_MS) closeWindow();
+    }
+    if (windowPump < 0 && alone >= 0) {
+        windowPump = alone;
+        windowStartMs = windowLastMs = now;
+        windowStartPsi = windowLastPsi = tankPressure;
+    }
+
+    // A flow record every PUMP_HISTORY_STEP_HOURS of each pump's runtime
+    for (int p = 0; p < 2; p++) {
+        if (getFlowPct(p) < 0) continue;
+        float hours = runtimeMs[p] / 3600000.0;
+        const PumpCurve& c = curves[p];
+        const PumpFlowRecord& newest = c.history[(c.historyHead + PUMP_HISTORY_SIZE - 1) % PUMP_HISTORY_SIZE];
+        if (newest.flowPct == 0 || hours - newest.hoursX10 / 10.0 >= PUMP_HISTORY_STEP_HOURS) {
+            record(p, hours);
+        }
+    }
+}
+
+void PumpHealth::closeWindow() {
+    int pump = windowPump;
+    windowPump = -1;
+
+    unsigned long ms = windowLastMs - windowStartMs;
+    float rise = windowLastPsi - windowStartPsi;
+    if (ms < PUMP_CURVE_MIN_WINDOW_MS || rise <= 0) return;
+    learn(pump, binOf((windowStartPsi + windowLastPsi) / 2), rise * 60000.0 / ms);
+}
+
+void PumpHealth::learn(int pump, int bin, float psiPerMin) {
+    PumpCurve& c = curves[pump];
+    if (c.fills[bin] < PUMP_CURVE_BASELINE_FILLS) {
+        // Still measuring the pump as new: plain average
+        c.fills[bin]++;
+        c.baseline[bin] += (psiPerMin - c.baseline[bin]) / c.fills[bin];
+        c.current[bin] = c.baseline[bin];
+        return;
+    }
+    if (c.fills[bin] < 255) c.fills[bin]++;
+    c.current[bin] += PUMP_CURVE_GAIN * (psiPerMin - c.current[bin]);
+
+    int flow = getFlowPct(pump);
+    if (!degraded[pump] && flow >= 0 && flow < PUMP_FLOW_SERVICE_PCT) {
+        degraded[pump] = true;
+        Serial.print("[PUMP] P");
+        Serial.print(pump + 1);
+        Serial.print(" fill rate down to ");
+        Serial.print(flow);
+        Serial.println("% of new - service the compressor");
+    }
+}
+
+void PumpHealth::record(int pump, float runtimeHours) {
+    PumpCurve& c = curves[pump];
+    PumpFlowRecord& r = c.history[c.historyHead];
+    time_t now = time(NULL);
+    r.epoch = (now > 1600000000L) ? (uint32_t)now : 0;   // Same sanity bound as /time
+    r.hoursX10 = (uint16_t)min(runtimeHours * 10.0f + 0.5f, 65535.0f);
+    r.flowPct = (uint8_t)constrain(getFlowPct(pump), 1, 255);
+    r.reserved = 0;
+    c.historyHead = (c.historyHead + 1) % PUMP_HISTORY_SIZE;
+
+    Serial.print("[PUMP] P");
+    Serial.print(pump + 1);
+    Serial.print(" at ");
+    Serial.print(runtimeHours, 1);
+    Serial.print(" h: fill rate ");
+    Serial.print(r.flowPct);
+    Serial.println("% of new");
+}
+
+// ============================================
+// CURVE
+// ============================================
+
+float PumpHealth::getRatePsiPerMin(int pump, float tankPressure) const {
+    int bin = binOf(tankPressure);
+    const PumpCurve& c = curves[pump];
+    return c.fills[bin] > 0 ? c.current[bin] : PLAN_PUMP_PSI_PER_S * 60.0f;
+}
+
+float PumpHealth::fillSeconds(float fromPsi, float toPsi, uint8_t pumps) const {
+    float seconds = 0;
+    float psi = fromPsi;
+    while (psi < toPsi) {
+        int bin = binOf(psi);
+        float end = (bin == PUMP_CURVE_BINS - 1) ? toPsi : min(toPsi, (bin + 1) * (float)PUMP_CURVE_BIN_PSI);
+        float rate = 0;
+        for (int p = 0; p < 2; p++) {
+            if (pumps & (1 << p)) rate += getRatePsiPerMin(p, psi);
+        }
+        if (rate <= 0) return NAN;
+        seconds += (end - psi) / rate * 60.0f;
+        psi = end;
+    }
+    return seconds;
+}
+
+// ============================================
+// HEALTH
+// ============================================
+
+int PumpHealth::getFlowPct(int pump) const {
+    const PumpCurve& c = curves[pump];
+    float sum = 0;
+    int bands = 0;
+    for (int b = 0; b < PUMP_CURVE_BINS; b++) {
+        if (c.fills[b] >= PUMP_CURVE_BASELINE_FILLS && c.baseline[b] > 0) {
+            sum += c.current[b] / c.baseline[b];
+            bands++;
+        }
+    }
+    return bands ? (int)(sum / bands * 100 + 0.5) : -1;
+}
+
+int PumpHealth::getScore(int pump) const {
+    int flow = getFlowPct(pump);
+    if (flow < 0) return -1;
+    return constrain((flow - PUMP_FLOW_FAIL_PCT) * 100 / (100 - PUMP_FLOW_FAIL_PCT), 0, 100);
+}
+
+bool PumpHealth::isDegraded(int pump) const {
+    return degraded[pump];
+}
+
+int PumpHealth::getHistory(int pump, PumpFlowRecord* out, int max) const {
+    const PumpCurve& c = curves[pump];
+    int count = 0;
+    for (int i = 1; i <= PUMP_HISTORY_SIZE && count < max; i++) {
+        const PumpFlowRecord& r = c.history[(c.historyHead + PUMP_HISTORY_SIZE - i) % PUMP_HISTORY_SIZE];
+        if (r.flowPct == 0) break;  // Unused slot
+        out[count++] = r;
+    }
+    return count;
+}
+
+// Least-squares slope of flow over runtime
+float PumpHealth::getTrendPctPerHour(int pump) const {
+    PumpFlowRecord r[PUMP_HISTORY_SIZE];
+    int n = getHistory(pump, r, PUMP_HISTORY_SIZE);
+    if (n < 3) return NAN;
+
+    float meanH = 0, meanF = 0;
+    for (int i = 0; i < n; i++) {
+        meanH += r[i].hoursX10 / 10.0f;
+        meanF += r[i].flowPct;
+    }
+    meanH /= n;
+    meanF /= n;
+    float sxx = 0, sxy = 0;
+    for (int i = 0; i < n; i++) {
+        float dh = r[i].hoursX10 / 10.0f - meanH;
+        sxx += dh * dh;
+        sxy += dh * (r[i].flowPct - meanF);
+    }
+    return (sxx > 0) ? sxy / sxx : NAN;
+}
+
+float PumpHealth::getServiceHours(int pump, float runtimeHours) const {
+    float due = PUMP_MAINTENANCE_HOURS;
+    int flow = getFlowPct(pump);
+    if (flow < 0) return due;
+    if (flow <= PUMP_FLOW_SERVICE_PCT) return min(due, runtimeHours);
+
+    float trend = getTrendPctPerHour(pump);
+    if (!isnan(trend) && trend < 0) {
+        due = min(due, runtimeHours + (flow - PUMP_FLOW_SERVICE_PCT) / -trend);
+    }
+    return due;
+}
+
+// Pump hours per calendar day from the oldest and newest records that
+// carry a wall clock, then the hours left at that rate
+long PumpHealth::getServiceEpoch(int pump, float runtimeHours) const {
+    time_t now = time(NULL);
+    if (now <= 1600000000L) return -1;
+
+    PumpFlowRecord r[PUMP_HISTORY_SIZE];
+    int n = getHistory(pump, r, PUMP_HISTORY_SIZE);
+    int newest = -1, oldest = -1;
+    for (int i = 0; i < n; i++) {
+        if (r[i].epoch == 0) continue;
+        if (newest < 0) newest = i;
+        oldest = i;
+    }
+    if (newest < 0) return -1;
+    float days = (r[newest].epoch - r[oldest].epoch) / 86400.0f;
+    float hours = (r[newest].hoursX10 - r[oldest].hoursX10) / 10.0f;
+    if (days < PUMP_USAGE_MIN_DAYS || hours <= 0) return -1;
+
+    float left = getServiceHours(pump, runtimeHours) - runtimeHours;
+    if (left <= 0) return (long)now;
+    return (long)now + (long)(left / (hours / days) * 86400.0f);
+}
+
+// ============================================
+// PERSISTENCE
+// ============================================
+
+void PumpHealth::reset(int pump) {
+    memset(&curves[pump], 0, sizeof(PumpCurve));
+    degraded[pump] = false;
+    if (windowPump == pump) windowPump = -1;
+}
+
+void PumpHealth::load(int pump, const PumpCurve& curve) {
+    for (int b = 0; b < PUMP_CURVE_BINS; b++) {
+        if (isnan(curve.baseline[b]) || isnan(curve.current[b]) ||
+            curve.baseline[b] < 0 || curve.current[b] < 0) {
+            reset(pump);
+            return;
+        }
+    }
+    curves[pump] = curve;
+    curves[pump].historyHead %= PUMP_HISTORY_SIZE;
+    int flow = getFlowPct(pump);
+    degraded[pump] = flow >= 0 && flow < PUMP_FLOW_SERVICE_PCT;
+}
@@ -0,0 +1,83 @@
+#include "PumpScheduler.h"
+
+PumpScheduler::PumpScheduler()
+    : lastUpdateMs(0),
+      forecastPsi(0),
+      forecastAtMs(0) {
+    for (int p = 0; p < 2; p++) {
+        starts[p] = 0;
+        heatC[p] = 0;
+        duty[p] = 0;
+        resting[p] = false;
+        wasOn[p] = false;
+    }
+}
+
+void PumpScheduler::update(bool pump1On, bool pump2On) {
+    unsigned long now = millis();
+    float dt = (now - lastUpdateMs) / 1000.0;
+    lastUpdateMs = now;
+
+    bool on[2] = { pump1On, pump2On };
+    for (int p = 0; p < 2; p++) {
+        if (on[p] && !wasOn[p] && starts[p] < 0xFFFFFFFF) starts[p]++;
+        wasOn[p] = on[p];
+
+        // First-order heating toward the running rise, cooling toward ambient
+        if (on[p]) {
+            heatC[p] += (PUMP_HEAT_RISE_C - heatC[p]) * min(1.0f, dt / (float)PUMP_HEAT_TAU_S);
+        } else {
+            heatC[p] -= heatC[p] * min(1.0f, dt / (float)PUMP_COOL_TAU_S);
+        }
+        duty[p] += ((on[p] ? 1.0f : 0.0f) - duty[p]) * min(1.0f, dt / (float)PUMP_DUTY_WINDOW_S);
+
+        if (!resting[p] && heatC[p] >= PUMP_HOT_C) {
+            resting[p] = true;
+            Serial.print("[PUMP] P");
+            Serial.print(p + 1);
+            Serial.print(" resting to cool (est. +");
+            Serial.print(heatC[p], 0);
+            Serial.print(" C, duty ");
+            Serial.print((int)(duty[p] * 100));
+            Serial.println("%)");
+        } else if (resting[p] && heatC[p] <= PUMP_RESUME_C) {
+            resting[p] = false;
+            Serial.print("[PUMP] P");
+            Serial.print(p + 1);
+            Serial.println(" cooled - available");
+        }
+    }
+}
+
+float PumpScheduler::wearHours(unsigned long runtimeMs, uint32_t starts) {
+    return runtimeMs / 3600000.0 + starts * PUMP_START_WEAR_HOURS;
+}
+
+uint8_t PumpScheduler::choose(int wanted, uint8_t running, const unsigned long runtimeMs[2]) const {
+    uint8_t usable = (resting[0] ? 0 : 1) | (resting[1] ? 0 : 2);
+    if (wanted >= 2) return usable;
+
+    // Keep a pump that is already running: a swap costs a start
+    uint8_t candidates = (running & usable) ? (running & usable) : usable;
+    if (candidates == 1 || candidates == 2 || candidates == 0) return candidates;
+    float wear1 = wearHours(runtimeMs[0], starts[0]);
+    float wear2 = wearHours(runtimeMs[1], starts[1]);
+    return (wear2 < wear1) ? 2 : 1;
+}
+
+// ============================================
+// DEMAND FORECAST
+// ============================================
+
+void PumpScheduler::noteDraw(float tankPsi) {
+    if (tankPsi < PUMP_FORECAST_MIN_PSI) return;   // Dumps and touch-ups
+    float current = getForecastPsi();
+    forecastPsi = (current > 0) ? current + PUMP_FORECAST_GAIN * (tankPsi - current) : tankPsi;
+    forecastAtMs = millis();
+}
+
+float PumpScheduler::getForecastPsi() const {
+    if (forecastPsi <= 0) return 0;
+    float ageS = (millis() - forecastAtMs) / 1000.0;
+    return forecastPsi * powf(0.5f, ageS / (float)PUMP_FORECAST_HALF_LIFE_S);
+}
@@ -0,0 +1,768 @@
+#include "RideController.h"
+#include "Hal.h"
+#include "TraceRecorder.h"
+#include "Actuators.h"
+#include "SolenoidGuard.h"
+#include <EEPROM.h>
+
+// Runtime demo mode state (toggled via /demo endpoint on bench builds)
+bool demoMode = Hal::SIMULATED; // Simulation builds start in demo mode
+
+// Simulated leak state (toggled via /simleak endpoint)
+int simLeakTarget = -1;         // -1=none, 0-3=bag index, 4=tank
+float simLeakRate = SIM_LEAK_RATE_PSI_TICK;
+
+// Tank sensor calibration (sensor index 0)
+SensorCalibration tankCalibration = { 0.0, 1.0, REFERENCE_RESISTOR };
+bool tankCalibrated = false;
+
+RideController::RideController(AirBag* b, Compressor* c)
+    : bags(b),
+      compressor(c),
+      airMovesSeen(0),
+      heldSamples(0),
+      targetsDirty(false),
+      targetsChangedMs(0),
+      valvesClosedMs(0),
+      tankPressure(0.0),
+      lastPressureRead(0),
+      controlRate(RATE_ACTIVE),
+      lastActivity(0),
+      rateSince(0),
+      rateSwitches(0),
+      tankBufferIndex(0),
+      tankBufferFilled(false),
+      levelMode(LEVEL_OFF),
+      tankLockout(false),
+      pumpEnabled(true),
+      parked(false),
+      telemetryEnabled(false),
+      traceRestartPending(false) {
+    for (int i = 0; i < PRESSURE_SAMPLES; i++) {
+        tankPressureBuffer[i] = 0.0;
+    }
+    for (int i = 0; i < NUM_CONTROL_RATES; i++) {
+        rateTimeMs[i] = 0;
+    }
+    for (int i = 0; i < NUM_BAGS; i++) {
+        commandedTargets[i] = 0;
+    }
+}
+
+void RideController::begin() {
+    // Fill tank pressure buffer
+    for (int i = 0; i < PRESSURE_SAMPLES; i++) {
+        tankPressureBuffer[i] = readTankPressure();
+        delayMicroseconds(BOOT_SAMPLE_DELAY_US);
+    }
+    tankBufferFilled = true;
+
+    // Initial tank reading
+    tankPressure = readTankPressureSmoothed();
+    updateTankLockout();
+
+    // Back to the last commanded stance (valves open now, not a tick later)
+    if (RESTORE_TARGETS_ON_BOOT) {
+        restoreTargets();
+    }
+
+    // Start fast (restored targets may be moving) and tick on the next update()
+    controlRate = RATE_ACTIVE;
+    rateSince = millis();
+    noteActivity();
+    valvesClosedMs = millis();
+    lastPressureRead = millis() - CONTROL_INTERVAL_IDLE_MS;
+}
+
+bool RideController::update() {
+    unsigned long currentTime = millis();
+    updateControlRate(currentTime);
+
+    // Read pressures at the current rate
+    if (currentTime - lastPressureRead >= getControlIntervalMs()) {
+        lastPressureRead = currentTime;
+        tick();
+        return true;
+    }
+    return false;
+}
+
+// ============================================
+// CONTROL RATE
+// ============================================
+
+void RideController::updateControlRate(unsigned long now) {
+    ControlRate rate = (now - lastActivity < CONTROL_ACTIVE_HOLD_MS) ? RATE_ACTIVE : RATE_IDLE;
+    if (rate == controlRate) return;
+
+    rateTimeMs[controlRate] += now - rateSince;
+    rateSince = now;
+    controlRate = rate;
+    rateSwitches++;
+
+    Serial.print("[RATE] ");
+    Serial.print(rateName(rate));
+    Serial.print(" (");
+    Serial.print(getControlIntervalMs());
+    Serial.println(" ms ticks)");
+}
+
+unsigned long RideController::getControlIntervalMs() const {
+    return controlRate == RATE_ACTIVE ? CONTROL_INTERVAL_ACTIVE_MS : CONTROL_INTERVAL_IDLE_MS;
+}
+
+unsigned long RideController::getTimeAtRateMs(ControlRate rate) const {
+    unsigned long t = rateTimeMs[rate];
+    if (rate == controlRate) t += millis() - rateSince;
+    return t;
+}
+
+const char* RideController::rateName(ControlRate rate) {
+    return rate == RATE_ACTIVE ? "active" : "idle";
+}
+
+void RideController::tick() {
+    // Restart at rest: the snapshot then carries no valve or pump timing
+    if (traceRestartPending && getValveBits() == 0 && !compressor->isRunning() && !compressor->isFilling()) {
+        traceRestartPending = false;
+        restartTrace();
+    }
+    traceRecorder.recordTick();
+
+    // Bring the simulated plant up to date (no-op on real hardware)
+    Hal::sync();
+
+    // Dead-man fired while the loop was stalled: the valves are already
+    // shut, so bring the bag states in line before tracking decides again
+    if (solenoidGuard.checkTripped()) {
+        Serial.print("[SAFETY] Control loop stalled > ");
+        Serial.print(SOLENOID_GUARD_MS);
+        Serial.print(" ms - dead-man closed all solenoids (trip ");
+        Serial.print(solenoidGuard.getTripCount());
+        Serial.println(")");
+        actuators.markGuardedReleased();
+        for (int i = 0; i < NUM_BAGS; i++) {
+            bags[i].hold();
+        }
+    }
+
+    // Update tank pressure (smoothed), holding samples through pump inrush
+    if (actuators.isSettling()) {
+        if (heldSamples < 0xFFFFFFFF) heldSamples++;
+    } else {
+        tankPressureBuffer[tankBufferIndex] = readTankPressure();
+        tankBufferIndex = (tankBufferIndex + 1) % PRESSURE_SAMPLES;
+    }
+    tankPressure = readTankPressureSmoothed();
+
+    // Update tank lockout state
+    updateTankLockout();
+
+    // Update compressor (handles pump logic automatically)
+    // Only run pump logic if pumps are enabled via override toggle
+    if (!pumpEnabled || parked) {
+        compressor->setMode(PUMP_OFF);
+    }
+    bool inflating = false;
+    for (int i = 0; i < NUM_BAGS; i++) {
+        if (bags[i].isInflating()) inflating = true;
+    }
+    compressor->setTankDraw(inflating);
+    compressor->update(tankPressure);
+
+    // Update all bags (reads pressure, enforces safety limits, checks timeouts)
+    for (int i = 0; i < NUM_BAGS; i++) {
+        bags[i].update();
+    }
+    deadband.update(bags);
+    fillSchedule.update(bags, tankPressure, compressor->isRunning());
+    airBudget.update(bags, deadband, tankPressure, compressor->isRunning());
+    if (airBudget.getFinishedMoves() != airMovesSeen) {
+        // What the move drew tells the compressor what the next one may need
+        airMovesSeen = airBudget.getFinishedMoves();
+        compressor->noteDraw(AirBudget::toTankPsi(airBudget.getMove().scf));
+    }
+
+    // Corners starved by a lockout wait in line; the pumps run for them
+    uint8_t coordinated = 0;
+    for (int i = 0; i < NUM_BAGS; i++) {
+        if (planner.isMoving(i)) coordinated |= (1 << i);
+    }
+    inflateQueue.update(bags, deadband, airBudget, tankPressure, tankLockout, coordinated);
+    compressor->setDemand(!inflateQueue.isEmpty());
+
+    // Learns flow rates; during a preset move, decides which corners wait
+    planner.update(bags, deadband, tankPressure);
+    trajectory.update();
+
+    // Level mode adjusts targets, tracking then drives the valves
+    // (parked: bags just hold, the leak check wants to see any drop;
+    // a coordinated move or a ramp owns the targets until it finishes)
+    updateLevelMode();
+    if (!parked) {
+        // Auto-adjust bags toward target pressure (for presets)
+        updateTargetTracking();
+    }
+
+    // Every valve and pump decided this tick switches at once
+    actuators.commit();
+    solenoidGuard.feed();
+
+    // Air moving keeps the fast rate (see updateControlRate)
+    if (getValveBits() != 0 || getPumpBits() != 0) {
+        noteActivity();
+    }
+    updateSavedTargets(millis());
+
+    if (telemetryEnabled) {
+        char row[TELEMETRY_ROW_SIZE];
+        formatTelemetry(row, sizeof(row));
+        Serial.println(row);
+    }
+}
+
+// ============================================
+// COMMANDS
+// ============================================
+
+void RideController::setBagTarget(int bagNum, float psi, RampProfile profile) {
+    if (bagNum < 0 || bagNum >= NUM_BAGS) return;
+    if (profile < 0 || profile >= NUM_RAMP_PROFILES) profile = (RampProfile)RAMP_DEFAULT_PROFILE;
+    traceRecorder.recordCommand(TRACE_CMD_SET_TARGET, bagNum | (profile << 8), &psi, 1);
+    noteActivity();
+    planner.release(bagNum);
+
+    bags[bagNum].setTargetPressure(psi);
+    trajectory.start(bags[bagNum], bagNum, deadband, profile);
+    leveler.rebase(bags);
+
+    float rampRates[NUM_BAGS] = {0};
+    if (trajectory.isRamping(bagNum)) rampRates[bagNum] = trajectory.getMaxRate(bagNum);
+    estimateAir(1 << bagNum, rampRates);
+
+    // Start moving to target
+    moveTowardTarget(bagNum);
+    actuators.commit();
+    saveTargets();
+}
+
+void RideController::applyTargets(const float targets[NUM_BAGS], RampProfile profile) {
+    if (profile < 0 || profile >= NUM_RAMP_PROFILES) profile = (RampProfile)RAMP_DEFAULT_PROFILE;
+    traceRecorder.recordCommand(TRACE_CMD_APPLY_TARGETS, profile, targets, NUM_BAGS);
+    noteActivity();
+
+    for (int i = 0; i < NUM_BAGS; i++) {
+        bags[i].setTargetPressure(targets[i]);
+    }
+    trajectory.startAll(bags, deadband, profile);
+    leveler.rebase(bags);
+
+    float rampRates[NUM_BAGS];
+    for (int i = 0; i < NUM_BAGS; i++) {
+        rampRates[i] = trajectory.isRamping(i) ? trajectory.getMaxRate(i) : 0;
+    }
+    estimateAir((1 << NUM_BAGS) - 1, rampRates);
+    if (PLAN_ENABLED) {
+        planner.start(bags, deadband, tankPressure, airBudget.getPrediction());
+    }
+
+    // Start moving to targets - all corners switch together
+    for (int i = 0; i < NUM_BAGS; i++) {
+        if (planner.mayMove(i)) {
+            moveTowardTarget(i);
+        } else {
+            bags[i].hold();
+        }
+    }
+    actuators.commit();
+    saveTargets();
+}
+
+// Before the valves open: will the tank carry the move, and should the
+// pumps start with it
+void RideController::estimateAir(uint8_t corners, const float rampRates[NUM_BAGS]) {
+    if (airBudget.estimate(bags, deadband, planner, corners, tankPressure,
+                           pumpEnabled && !parked, compressor->isRunning(), rampRates) &&
+        airBudget.getEstimate().prestart) {
+        compressor->startFill();
+    }
+}
+
+bool RideController::manualInflate(int bagNum) {
+    if (bagNum < 0 || bagNum >= NUM_BAGS) return false;
+    traceRecorder.recordCommand(TRACE_CMD_INFLATE, bagNum);
+    noteActivity();
+    planner.release(bagNum);
+    trajectory.release(bagNum);
+
+    // Check tank lockout before inflating
+    if (tankLockout) return false;
+
+    bags[bagNum].inflate();
+    actuators.commit();
+    // Move target ahead so updateTargetTracking doesn't fight manual control
+    if (bags[bagNum].getTargetPressure() <= bags[bagNum].getPressure()) {
+        bags[bagNum].setTargetPressure(MAX_BAG_PSI);
+    }
+    return true;
+}
+
+void RideController::manualDeflate(int bagNum) {
+    if (bagNum < 0 || bagNum >= NUM_BAGS) return;
+    traceRecorder.recordCommand(TRACE_CMD_DEFLATE, bagNum);
+    noteActivity();
+    planner.release(bagNum);
+    trajectory.release(bagNum);
+
+    bags[bagNum].deflate();
+    actuators.commit();
+    // Move target down so updateTargetTracking doesn't fight manual control
+    if (bags[bagNum].getTargetPressure() >= bags[bagNum].getPressure()) {
+        bags[bagNum].setTargetPressure(MIN_BAG_PSI);
+    }
+}
+
+void RideController::holdBag(int bagNum) {
+    if (bagNum < 0 || bagNum >= NUM_BAGS) return;
+    traceRecorder.recordCommand(TRACE_CMD_HOLD, bagNum);
+    noteActivity();
+    planner.release(bagNum);
+    trajectory.release(bagNum);
+
+    bags[bagNum].hold();
+    actuators.commit();
+    bags[bagNum].setTargetPressure(bags[bagNum].getPressure());
+    leveler.rebase(bags);
+    saveTargets();
+}
+
+void RideController::stopAll() {
+    traceRecorder.recordCommand(TRACE_CMD_STOP_ALL, 0);
+    noteActivity();
+    planner.cancel("stop");
+    for (int i = 0; i < NUM_BAGS; i++) {
+        trajectory.release(i);
+        bags[i].hold();
+    }
+    actuators.commit();
+}
+
+void RideController::setLevelMode(LevelMode mode) {
+    traceRecorder.recordCommand(TRACE_CMD_LEVEL_MODE, mode);
+    noteActivity();
+    if (mode != levelMode) {
+        leveler.engage(bags);
+    }
+    levelMode = mode;
+}
+
+void RideController::setLevelPitch(float psi) {
+    traceRecorder.recordCommand(TRACE_CMD_LEVEL_PITCH, 0, &psi, 1);
+    noteActivity();
+    leveler.setPitchTarget(psi);
+}
+
+void RideController::setPumpEnabled(bool enabled) {
+    traceRecorder.recordCommand(TRACE_CMD_PUMP_ENABLED, enabled ? 1 : 0);
+    noteActivity();
+    pumpEnabled = enabled;
+    compressor->setMode(enabled ? PUMP_AUTO : PUMP_OFF);
+}
+
+void RideController::setPumpMode(PumpMode mode) {
+    traceRecorder.recordCommand(TRACE_CMD_PUMP_MODE, mode);
+    noteActivity();
+    compressor->setMode(mode);
+}
+
+void RideController::setTankTarget(float psi) {
+    traceRecorder.recordCommand(TRACE_CMD_TANK_TARGET, 0, &psi, 1);
+    noteActivity();
+    compressor->setTargetPressure(psi);
+}
+
+void RideController::setParked(bool enabled) {
+    if (enabled == parked) return;
+    traceRecorder.recordCommand(TRACE_CMD_PARKED, enabled ? 1 : 0);
+    parked = enabled;
+
+    if (parked) {
+        planner.cancel("parked");
+        for (int i = 0; i < NUM_BAGS; i++) {
+            trajectory.release(i);
+            bags[i].hold();
+        }
+        compressor->setMode(PUMP_OFF);
+    } else {
+        // Manual pump overrides don't survive a park
+        compressor->setMode(pumpEnabled ? PUMP_AUTO : PUMP_OFF);
+        noteActivity();
+    }
+    actuators.commit();
+}
+
+void RideController::setSensorCalibration(int sensor, const SensorCalibration& cal) {
+    if (sensor < 0 || sensor > NUM_BAGS) return;
+    float args[3] = { cal.offset, cal.gain, cal.refResistor };
+    traceRecorder.recordCommand(TRACE_CMD_CALIBRATION, sensor, args, 3);
+
+    if (sensor == 0) {
+        tankCalibration = cal;
+        tankCalibrated = (cal.offset != 0.0 || cal.gain != 1.0 || cal.refResistor != REFERENCE_RESISTOR);
+    } else {
+        bags[sensor - 1].setCalibration(cal);
+    }
+}
+
+void RideController::setDemoMode(bool enabled) {
+#if defined(AIRRIDE_HAL_BENCH)
+    if (enabled && !demoMode) {
+        // Entering demo mode: initialize sim state from current readings
+        float bagPressures[NUM_BAGS];
+        for (int i = 0; i < NUM_BAGS; i++) {
+            bagPressures[i] = bags[i].getPressure();
+        }
+        simPlant.seed(bagPressures, tankPressure);
+    }
+    demoMode = enabled;
+#else
+    // Fixed at compile time - see Hal.h
+    if (enabled != demoMode) {
+        Serial.println("[DEMO] Simulation mode is fixed in this build");
+        return;
+    }
+#endif
+    Serial.print("[DEMO] Simulation mode ");
+    Serial.println(enabled ? "ENABLED" : "DISABLED");
+}
+
+// Everything replay can't rebuild from the commands that follow, as the
+// commands that set it
+void RideController::restartTrace() {
+    traceRecorder.restart();
+
+    for (int s = 0; s <= NUM_BAGS; s++) {
+        const SensorCalibration& cal = (s == 0) ? tankCalibration : bags[s - 1].getCalibration();
+        float args[3] = { cal.offset, cal.gain, cal.refResistor };
+        traceRecorder.recordCommand(TRACE_CMD_CALIBRATION, s, args, 3);
+    }
+    float targets[NUM_BAGS];
+    for (int i = 0; i < NUM_BAGS; i++) {
+        targets[i] = bags[i].getTargetPressure();
+    }
+    traceRecorder.recordCommand(TRACE_CMD_TARGETS, 0, targets, NUM_BAGS);
+
+    float tankTarget = compressor->getTargetPressure();
+    traceRecorder.recordCommand(TRACE_CMD_TANK_TARGET, 0, &tankTarget, 1);
+    traceRecorder.recordCommand(TRACE_CMD_PUMP_ENABLED, pumpEnabled ? 1 : 0);
+    traceRecorder.recordCommand(TRACE_CMD_PUMP_MODE, compressor->getMode());
+    traceRecorder.recordCommand(TRACE_CMD_LEVEL_MODE, levelMode);
+    float pitch = leveler.isPitchHeld() ? NAN : leveler.getPitchTarget();
+    traceRecorder.recordCommand(TRACE_CMD_LEVEL_PITCH, 0, &pitch, 1);
+    traceRecorder.recordCommand(TRACE_CMD_PARKED, parked ? 1 : 0);
+
+    for (int p = 0; p < 2; p++) {
+        uint32_t counts[2] = {
+            (uint32_t)(p == 0 ? compressor->getPump1RuntimeMs() : compressor->getPump2RuntimeMs()),
+            compressor->getScheduler().getStarts(p)
+        };
+        float args[2];
+        memcpy(args, counts, sizeof(args));
+        traceRecorder.recordCommand(TRACE_CMD_PUMP_RUNTIME, p, args, 2);
+    }
+    Serial.println("[TRACE] Restarted from a controller snapshot");
+}
+
+uint8_t RideController::getValveBits() const {
+    uint8_t valves = 0;
+    for (int i = 0; i < NUM_BAGS; i++) {
+        if (bags[i].isInflating()) valves |= (1 << (2 * i));
+        if (bags[i].isDeflating()) valves |= (1 << (2 * i + 1));
+    }
+    return valves;
+}
+
+unsigned long RideController::getValveRestMs() const {
+    return getValveBits() != 0 ? 0 : millis() - valvesClosedMs;
+}
+
+uint8_t RideController::getPumpBits() const {
+    return (compressor->isPump1Running() ? 1 : 0) | (compressor->isPump2Running() ? 2 : 0);
+}
+
+int RideController::formatTelemetry(char* buf, size_t size) const {
+    return snprintf(buf, size, "%lu,%.2f,%.2f,%.2f,%.2f,%.2f,%u,%u",
+                    millis(), tankPressure,
+                    bags[FRONT_LEFT].getPressure(), bags[FRONT_RIGHT].getPressure(),
+                    bags[REAR_LEFT].getPressure(), bags[REAR_RIGHT].getPressure(),
+                    getValveBits(), getPumpBits());
+}
+
+void RideController::moveTowardTarget(int bagNum) {
+    // A ramp starts at the current pressure: the next tick opens the valve
+    // once the setpoint has moved off
+    if (trajectory.isRamping(bagNum)) return;
+
+    float current = bags[bagNum].getPressure();
+    float target = bags[bagNum].getTargetPressure();
+    float band = deadband.getBand(bagNum);
+    if (current < target - band) {
+        if (mayInflate(bagNum)) {
+            bags[bagNum].inflate();
+        }
+    } else if (current > target + band) {
+        bags[bagNum].deflate();
+    } else {
+        bags[bagNum].hold();
+    }
+}
+
+// ============================================
+// TARGET PERSISTENCE
+// ============================================
+
+bool RideController::restoreTargets() {
+    if (EEPROM.read(EEPROM_ADDR_TARGETS_FLAG) != TARGETS_VALID_FLAG) return false;
+
+    float targets[NUM_BAGS];
+    for (int i = 0; i < NUM_BAGS; i++) {
+        EEPROM.get(EEPROM_ADDR_TARGETS + i * sizeof(float), targets[i]);
+        if (isnan(targets[i]) || targets[i] < MIN_BAG_PSI || targets[i] > MAX_BAG_PSI) return false;
+    }
+
+    // Issued as a command so the session trace replays it; straight back
+    // to the stance whatever the default ramp
+    applyTargets(targets, RAMP_FAST);
+
+    Serial.print("[BOOT] Restored targets:");
+    for (int i = 0; i < NUM_BAGS; i++) {
+        Serial.print(" ");
+        Serial.print(bags[i].getName());
+        Serial.print("=");
+        Serial.print(targets[i], 1);
+    }
+    Serial.println(tankLockout ? " (tank lockout - inflation waits)" : "");
+    return true;
+}
+
+// Only commanded targets land here (not manual-button extremes or level
+// trims). Commands just note them: the flash write blocks for a sector
+// erase, so it waits for the tick once the targets have stopped changing
+// and every valve has been closed for TARGET_SAVE_SETTLE_MS.
+void RideController::saveTargets() {
+    for (int i = 0; i < NUM_BAGS; i++) {
+        commandedTargets[i] = bags[i].getTargetPressure();
+    }
+    targetsDirty = true;
+    targetsChangedMs = millis();
+}
+
+void RideController::updateSavedTargets(unsigned long now) {
+    if (getValveBits() != 0) valvesClosedMs = now;
+    if (!targetsDirty || now - targetsChangedMs < TARGET_SAVE_SETTLE_MS ||
+        now - valvesClosedMs < TARGET_SAVE_SETTLE_MS) {
+        return;
+    }
+    targetsDirty = false;
+
+    // Skip the flash write when nothing moved meaningfully
+    bool valid = EEPROM.read(EEPROM_ADDR_TARGETS_FLAG) == TARGETS_VALID_FLAG;
+    bool changed = !valid;
+    for (int i = 0; i < NUM_BAGS && !changed; i++) {
+        float saved;
+        EEPROM.get(EEPROM_ADDR_TARGETS + i * sizeof(float), saved);
+        changed = isnan(saved) || abs(saved - commandedTargets[i]) >= TARGET_SAVE_DELTA_PSI;
+    }
+    if (!changed) return;
+
+    for (int i = 0; i < NUM_BAGS; i++) {
+        EEPROM.put(EEPROM_ADDR_TARGETS + i * sizeof(float), commandedTargets[i]);
+    }
+    EEPROM.write(EEPROM_ADDR_TARGETS_FLAG, TARGETS_VALID_FLAG);
+    EEPROM.commit();
+}
+
+// ============================================
+// TANK SENSOR
+// ============================================
+
+float RideController::readTankPressure() {
+    // ESP32: 12-bit ADC, 3.3V reference
+    int rawValue = Hal::readAdc(TANK_PRESSURE_PIN);
+    float voltage = (rawValue / ADC_RESOLUTION) * ADC_REFERENCE_VOLTAGE;
+
+    // Convert voltage to resistance (VDO resistance-based sensor)
+    // Uses per-sensor calibrated reference resistor value
+    float resistance;
+    if (voltage >= ADC_REFERENCE_VOLTAGE - 0.01) {
+        resistance = SENSOR_MAX_OHMS;
+    } else if (voltage <= 0.01) {
+        resistance = SENSOR_MIN_OHMS;
+    } else {
+        resistance = tankCalibration.refResistor * voltage / (ADC_REFERENCE_VOLTAGE - voltage);
+    }
+
+    // Clamp and convert resistance to PSI
+    if (resistance < SENSOR_MIN_OHMS) resistance = SENSOR_MIN_OHMS;
+    if (resistance > SENSOR_MAX_OHMS) resistance = SENSOR_MAX_OHMS;
+
+    float rawPsi = ((resistance - SENSOR_MIN_OHMS) / (SENSOR_MAX_OHMS - SENSOR_MIN_OHMS)) * SENSOR_MAX_PSI;
+
+    // Apply calibration: correctedPsi = (rawPsi * gain) + offset
+    return (rawPsi * tankCalibration.gain) + tankCalibration.offset;
+}
+
+float RideController::readTankPressureSmoothed() {
+    float sum = 0.0;
+    int count = tankBufferFilled ? PRESSURE_SAMPLES : tankBufferIndex;
+
+    if (count == 0) {
+        return readTankPressure();
+    }
+
+    for (int i = 0; i < count; i++) {
+        sum += tankPressureBuffer[i];
+    }
+    return sum / count;
+}
+
+// ============================================
+// CONTROL LOOPS
+// ============================================
+
+void RideController::updateTankLockout() {
+    // Hysteresis: lock out at TANK_CUTOFF_PSI, resume at TANK_RESUME_PSI
+    if (tankLockout) {
+        if (tankPressure >= TANK_RESUME_PSI) {
+            tankLockout = false;
+            Serial.println("Tank pressure restored - inflation enabled");
+        }
+    } else {
+        if (tankPressure < TANK_CUTOFF_PSI) {
+            tankLockout = true;
+            // Stop all inflation
+            for (int i = 0; i < NUM_BAGS; i++) {
+                if (bags[i].isInflating()) {
+                    bags[i].hold();
+                }
+            }
+            Serial.println("Tank pressure low - inflation disabled");
+        }
+    }
+}
+
+void RideController::updateLevelMode() {
+    // Runs every tick even when off: the leveler learns the coupling
+    // between corners from every single-corner move
+    bool ramping = false;
+    for (int i = 0; i < NUM_BAGS; i++) {
+        if (trajectory.isRamping(i)) ramping = true;
+    }
+    bool mayCorrect = !parked && !planner.isActive() && !ramping;
+
+    uint8_t retargeted = leveler.update(bags, deadband, levelMode, mayCorrect,
+                                       !tankLockout && inflateQueue.isEmpty());
+    for (int i = 0; i < NUM_BAGS; i++) {
+        // Level corrections are steps: no ramp, no final-approach pulsing
+        if (retargeted & (1 << i)) trajectory.release(i);
+    }
+}
+
+void RideController::updateTargetTracking() {
+    // Auto-adjust bags toward their target pressure
+    // This enables preset functionality
+    for (int i = 0; i < NUM_BAGS; i++) {
+        float current = bags[i].getPressure();
+        float target = bags[i].getTargetPressure();
+
+        // A holding bag needs a little more error to reopen, so noise at
+        // the band edge doesn't turn into chatter (both learned per corner)
+        float tolerance = deadband.getBand(i);
+        if (bags[i].isHolding()) tolerance += deadband.getReopen(i);
+
+        // Skip if solenoid is timed out
+        if (bags[i].isSolenoidTimedOut()) {
+            continue;
+        }
+
+        // Coordinated move: this corner is ahead of the others, or the
+        // move is paused for the tank
+        if (!planner.mayMove(i)) {
+            if (!bags[i].isHolding()) {
+                bags[i].hold();
+            }
+            continue;
+        }
+
+        // Ramping: follow the moving setpoint rather than the final target
+        if (trajectory.isRamping(i)) {
+            followSetpoint(i);
+            continue;
+        }
+
+        // An inflating corner closes early by the coast the fill schedule
+        // predicts for this tank, so it lands on target rather than past
+        // it at a full tank or short at a low one. The lead is kept inside
+        // the reopen margin so the corner doesn't refill while it coasts.
+        float lowEdge = target - tolerance;
+        if (bags[i].isInflating()) {
+            float lead = min(getFillLead(i), tolerance + deadband.getReopen(i) / 2);
+            lowEdge = target - lead;
+        }
+
+        // Only auto-adjust if we have a meaningful target set (a planned
+        // corner waiting on the others may be holding on its way to 0)
+        if (target > 0 || bags[i].isInflating() || bags[i].isDeflating() || planner.isMoving(i)) {
+            if ((current < target - tolerance || current > target + tolerance) &&
+                !trajectory.pulseAllows(i, target - current)) {
+                // Final approach: closed part of the pulse
+                if (!bags[i].isHolding()) {
+                    bags[i].hold();
+                }
+            } else if (current < lowEdge) {
+                if (!bags[i].isInflating() && mayInflate(i)) {
+                    bags[i].inflate();
+                }
+            } else if (current > target + tolerance) {
+                if (!bags[i].isDeflating()) {
+                    bags[i].deflate();
+                }
+            } else {
+                // At target - hold
+                if (!bags[i].isHolding()) {
+                    bags[i].hold();
+                }
+            }
+        }
+    }
+}
+
+float RideController::getFillLead(int bagNum) const {
+    return fillSchedule.getLead(bagNum, tankPressure - bags[bagNum].getPressure(), compressor->isRunning());
+}
+
+// Duty-cycles the valve to keep the bag within RAMP_FOLLOW_BAND_PSI behind
+// its ramp setpoint. A bag that gets ahead just waits: a rising ramp never
+// dumps and a falling one never fills.
+void RideController::followSetpoint(int bagNum) {
+    AirBag& bag = bags[bagNum];
+    float current = bag.getPressure();
+    float setpoint = trajectory.getSetpoint(bagNum);
+    bool rising = bag.getTargetPressure() > setpoint;
+
+    if (rising) {
+        if (current < setpoint - RAMP_FOLLOW_BAND_PSI) {
+            if (!bag.isInflating() && mayInflate(bagNum)) bag.inflate();
+        } else if (current >= setpoint + RAMP_FOLLOW_LEAD_PSI && !bag.isHolding()) {
+            bag.hold();
+        }
+        if (bag.isDeflating()) bag.hold();
+    } else {
+        if (current > setpoint + RAMP_FOLLOW_BAND_PSI) {
+            if (!bag.isDeflating()) bag.deflate();
+        } else if (current <= setpoint - RAMP_FOLLOW_LEAD_PSI && !bag.isHolding()) {
+            bag.hold();
+        }
+        if (bag.isInflating()) bag.hold();
+    }
+}
@@ -0,0 +1,122 @@
+#include "SerialConsole.h"
+
+SerialConsole::SerialConsole(const ConsoleCommand* cmds, int count)
+    : commands(cmds),
+      numCommands(count),
+      lineLength(0),
+      overflow(false),
+      frameHandler(NULL),
+      frameLength(0),
+      frameByteMs(0),
+      inFrame(false) {
+}
+
+void SerialConsole::poll() {
+    // Nothing more of the frame is coming (host killed mid-frame, or a
+    // stray 0x00 from the terminal or a USB attach): back to text
+    if (inFrame && Serial.available() == 0 && millis() - frameByteMs >= LINK_FRAME_GAP_MS) {
+        if (frameLength > 0) Serial.println("Incomplete link frame - dropped");
+        inFrame = false;
+        frameLength = 0;
+    }
+
+    for (int n = 0; n < SERIAL_POLL_MAX_BYTES && Serial.available() > 0; n++) {
+        uint8_t b = (uint8_t)Serial.read();
+
+        if (b == 0x00 && frameHandler) {
+            // Delimiter: opens a frame, or closes the one in progress
+            if (inFrame && frameLength > 0) {
+                frameHandler(frame, frameLength);
+                inFrame = false;
+            } else {
+                inFrame = true;
+                frameByteMs = millis();
+            }
+            frameLength = 0;
+        } else if (inFrame) {
+            handleFrameByte(b);
+        } else {
+            handleText((char)b);
+        }
+    }
+}
+
+void SerialConsole::handleFrameByte(uint8_t b) {
+    frameByteMs = millis();
+    if (frameLength < (int)sizeof(frame)) {
+        frame[frameLength++] = b;
+        return;
+    }
+
+    // Longer than any frame: text after a stray 0x00, or a garbled frame
+    // whose closing delimiter will open the next one
+    Serial.println("Link frame too long - dropped");
+    inFrame = false;
+    frameLength = 0;
+    handleText((char)b);
+}
+
+void SerialConsole::handleText(char c) {
+    if (c == '\n' || c == '\r') {
+        if (overflow) {
+            Serial.print("Line too long (max ");
+            Serial.print(SERIAL_LINE_SIZE - 1);
+            Serial.println(" chars) - ignored");
+        } else if (lineLength > 0) {
+            line[lineLength] = '\0';
+            runLine();
+        }
+        lineLength = 0;
+        overflow = false;
+    } else if (overflow) {
+        return;
+    } else if (lineLength < SERIAL_LINE_SIZE - 1) {
+        line[lineLength++] = c;
+    } else {
+        overflow = true;
+    }
+}
+
+void SerialConsole::runLine() {
+    // Split in place on ';' and whitespace
+    char* p = line;
+    while (*p) {
+        while (*p == ';' || *p == ' ' || *p == '\t') p++;
+        if (!*p) break;
+
+        char* token = p;
+        while (*p && *p != ';' && *p != ' ' && *p != '\t') p++;
+        if (*p) *p++ = '\0';
+        dispatch(token);
+    }
+}
+
+void SerialConsole::dispatch(const char* token) {
+    const ConsoleCommand* best = NULL;
+    size_t bestLength = 0;
+
+    for (int i = 0; i < numCommands; i++) {
+        size_t length = strlen(commands[i].name);
+        if (length > bestLength && strncasecmp(token, commands[i].name, length) == 0) {
+            best = &commands[i];
+            bestLength = length;
+        }
+    }
+
+    if (!best) {
+        Serial.print("Unknown command '");
+        Serial.print(token);
+        Serial.println("' (? for help)");
+        return;
+    }
+    best->handler(token + bestLength);
+}
+
+bool SerialConsole::parseInt(const char* arg, int minValue, int maxValue, int& value) {
+    if (!*arg) return false;
+    char* end;
+    long v = strtol(arg, &end, 10);
+    if (*end != '\0' || v < minValue || v > maxValue) return false;
+    value = (int)v;
+    return true;
+}
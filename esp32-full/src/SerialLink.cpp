@@ -0,0 +1,241 @@
+#include "SerialLink.h"
+#include "Hal.h"
+#include "PowerManager.h"
+
+SerialLink::SerialLink(AirBag* b, Compressor* c, RideController* rc, AirRideWebServer* w)
+    : bags(b),
+      compressor(c),
+      controller(rc),
+      web(w),
+      streamIntervalMs(0),
+      lastStream(0),
+      streamSeq(0) {
+}
+
+void SerialLink::handleFrame(const uint8_t* encoded, size_t length) {
+    LinkPacket request;
+    if (!linkDecode(encoded, length, request)) {
+        sendAck(0, 0, LINK_BAD_FRAME);
+        return;
+    }
+
+    if (request.type == LINK_GET_STATE) {
+        sendState(LINK_STATE, request.seq);
+        return;
+    }
+    sendAck(request.type, request.seq, execute(request));
+}
+
+void SerialLink::update() {
+    if (streamIntervalMs == 0) return;
+
+    unsigned long now = millis();
+    if (now - lastStream < streamIntervalMs) return;
+    lastStream = now;
+    sendState(LINK_STATE_STREAM, streamSeq++);
+}
+
+// ============================================
+// REQUESTS
+// ============================================
+
+// Optional trailing ramp profile; requests from older clients end without one
+static bool getRamp(LinkPacket& req, RampProfile& ramp) {
+    ramp = (RampProfile)RAMP_DEFAULT_PROFILE;
+    if (req.atEnd()) return true;
+    uint8_t p;
+    if (!req.getU8(p) || !req.atEnd() || p >= NUM_RAMP_PROFILES) return false;
+    ramp = (RampProfile)p;
+    return true;
+}
+
+LinkStatus SerialLink::execute(LinkPacket& req) {
+    uint8_t bag, index, enabled;
+    RampProfile ramp;
+    int8_t direction;
+    uint16_t interval;
+    uint32_t epoch;
+    float psi;
+
+    switch (req.type) {
+        case LINK_PING:
+            return req.atEnd() ? LINK_OK : LINK_BAD_ARGUMENT;
+
+        case LINK_BAG_MOVE:
+            if (!req.getU8(bag) || !req.getI8(direction) || !req.atEnd() || bag >= NUM_BAGS) {
+                return LINK_BAD_ARGUMENT;
+            }
+            if (direction > 0) {
+                return controller->manualInflate(bag) ? LINK_OK : LINK_REJECTED;
+            }
+            controller->manualDeflate(bag);
+            return LINK_OK;
+
+        case LINK_BAG_HOLD:
+            if (!req.getU8(bag) || !req.atEnd() || bag >= NUM_BAGS) return LINK_BAD_ARGUMENT;
+            controller->holdBag(bag);
+            return LINK_OK;
+
+        case LINK_BAG_TARGET:
+            if (!req.getU8(bag) || !req.getFloat(psi) || bag >= NUM_BAGS || isnan(psi)) {
+                return LINK_BAD_ARGUMENT;
+            }
+            if (!getRamp(req, ramp)) return LINK_BAD_ARGUMENT;
+            controller->setBagTarget(bag, psi, ramp);    // Clamped by AirBag
+            return LINK_OK;
+
+        case LINK_STOP_ALL:
+            if (!req.atEnd()) return LINK_BAD_ARGUMENT;
+            controller->stopAll();
+            return LINK_OK;
+
+        case LINK_PRESET_APPLY:
+            if (!req.getU8(index) || index >= NUM_PRESETS || !getRamp(req, ramp)) return LINK_BAD_ARGUMENT;
+            web->applyPreset(index, ramp);
+            return LINK_OK;
+
+        case LINK_PRESET_SAVE: {
+            float preset[NUM_BAGS];
+            bool ok = req.getU8(index);
+            for (int i = 0; i < NUM_BAGS; i++) ok = ok && req.getFloat(preset[i]) && !isnan(preset[i]);
+            if (!ok || !req.atEnd()) return LINK_BAD_ARGUMENT;
+            return web->savePreset(index, preset) ? LINK_OK : LINK_BAD_ARGUMENT;
+        }
+
+        case LINK_LEVEL_MODE:
+            if (!req.getU8(index) || !req.atEnd() || index > LEVEL_ALL) return LINK_BAD_ARGUMENT;
+            controller->setLevelMode((LevelMode)index);
+            return LINK_OK;
+
+        case LINK_PUMP_ENABLE:
+            if (!req.getU8(enabled) || !req.atEnd() || enabled > 1) return LINK_BAD_ARGUMENT;
+            controller->setPumpEnabled(enabled);
+            return LINK_OK;
+
+        case LINK_PUMP_MODE:
+            if (!req.getU8(index) || !req.atEnd() || index > PUMP_2_ONLY) return LINK_BAD_ARGUMENT;
+            controller->setPumpMode((PumpMode)index);
+            return LINK_OK;
+
+        case LINK_TANK_TARGET:
+            if (!req.getFloat(psi) || !req.atEnd() || !(psi > 0 && psi <= SENSOR_MAX_PSI)) {
+                return LINK_BAD_ARGUMENT;
+            }
+            controller->setTankTarget(psi);
+            return LINK_OK;
+
+        case LINK_TIME_SYNC:
+            if (!req.getU32(epoch) || !req.atEnd()) return LINK_BAD_ARGUMENT;
+            return web->syncTime((long)epoch) ? LINK_OK : LINK_BAD_ARGUMENT;
+
+        case LINK_DEMO_MODE:
+            if (!req.getU8(enabled) || !req.atEnd() || enabled > 1) return LINK_BAD_ARGUMENT;
+            if (!Hal::SIMULATED && enabled) return LINK_UNSUPPORTED;
+            controller->setDemoMode(enabled);
+            return LINK_OK;
+
+        case LINK_LEAK_RESET:
+            if (!req.atEnd()) return LINK_BAD_ARGUMENT;
+            web->resetLeakSnapshot();
+            return LINK_OK;
+
+        case LINK_TANK_MAINT:
+            if (!req.getU32(epoch) || !req.atEnd()) return LINK_BAD_ARGUMENT;
+            if (epoch == 0) return web->resetTankMaint() ? LINK_OK : LINK_REJECTED;
+            return web->setTankMaint(epoch) ? LINK_OK : LINK_BAD_ARGUMENT;
+
+        case LINK_CAL_SET: {
+            SensorCalibration cal;
+            if (!req.getU8(index) || !req.getFloat(cal.offset) || !req.getFloat(cal.gain) ||
+                !req.getFloat(cal.refResistor) || !req.atEnd()) {
+                return LINK_BAD_ARGUMENT;
+            }
+            return web->setCalibration(index, cal) ? LINK_OK : LINK_BAD_ARGUMENT;
+        }
+
+        case LINK_CAL_RESET:
+            if (!req.getU8(index) || !req.atEnd()) return LINK_BAD_ARGUMENT;
+            return web->resetCalibration(index == 0xFF ? -1 : index) ? LINK_OK : LINK_BAD_ARGUMENT;
+
+        case LINK_SIM_LEAK:
+            if (!req.getI8(direction) || !req.getFloat(psi) || !req.atEnd() ||
+                direction < -1 || direction > NUM_BAGS || isnan(psi) || psi < 0) {
+                return LINK_BAD_ARGUMENT;
+            }
+            if (!Hal::SIMULATED) return LINK_UNSUPPORTED;
+            simLeakTarget = direction;
+            simLeakRate = psi > 0 ? psi : SIM_LEAK_RATE_PSI_TICK;
+            return LINK_OK;
+
+        case LINK_STREAM:
+            if (!req.getU16(interval) || !req.atEnd()) return LINK_BAD_ARGUMENT;
+            if (interval != 0 && interval < LINK_STREAM_MIN_MS) return LINK_BAD_ARGUMENT;
+            streamIntervalMs = interval;
+            lastStream = millis() - interval;   // First frame on the next update()
+            return LINK_OK;
+
+        case LINK_PARK:
+            if (!req.atEnd()) return LINK_BAD_ARGUMENT;
+            powerManager.requestPark("link");   // ACK goes out before the AP drops
+            return LINK_OK;
+
+        case LINK_LEVEL_PITCH:
+            if (!req.getFloat(psi) || !req.atEnd() || (!isnan(psi) && abs(psi) > MAX_BAG_PSI)) {
+                return LINK_BAD_ARGUMENT;
+            }
+            controller->setLevelPitch(psi);
+            return LINK_OK;
+
+        case LINK_TRACE_RESTART:
+            if (!req.atEnd()) return LINK_BAD_ARGUMENT;
+            return web->restartTrace() ? LINK_OK : LINK_REJECTED;
+
+        default:
+            return LINK_UNSUPPORTED;
+    }
+}
+
+// ============================================
+// RESPONSES
+// ============================================
+
+void SerialLink::fillState(LinkState& s) const {
+    s.ms = millis();
+    s.tickMs = controller->getLastTickMs();
+    s.tank = controller->getTankPressure();
+    s.timeouts = 0;
+    for (int i = 0; i < NUM_BAGS; i++) {
+        s.bags[i] = bags[i].getPressure();
+        s.targets[i] = bags[i].getTargetPressure();
+        if (bags[i].isSolenoidTimedOut()) s.timeouts |= (1 << i);
+    }
+    s.valves = controller->getValveBits();
+    s.pumps = controller->getPumpBits();
+    s.flags = (controller->isTankLockout() ? LINK_STATE_LOCKOUT : 0) |
+              (controller->isPumpEnabled() ? LINK_STATE_PUMP_ENABLED : 0) |
+              (demoMode ? LINK_STATE_DEMO : 0) |
+              (web->isTimeSynced() ? LINK_STATE_TIME_SYNCED : 0);
+    s.levelMode = controller->getLevelMode();
+    s.pumpMode = compressor->getMode();
+}
+
+void SerialLink::sendState(uint8_t type, uint8_t seq) {
+    LinkState state;
+    fillState(state);
+    LinkPacket packet(type, seq);
+    packet.putState(state);
+    send(packet);
+}
+
+void SerialLink::sendAck(uint8_t type, uint8_t seq, LinkStatus status) {
+    LinkPacket packet(LINK_ACK, seq);
+    packet.putU8(type);
+    packet.putU8(status);
+    send(packet);
+}
+
+void SerialLink::send(const LinkPacket& packet) {
+    uint8_t wire[LINK_MAX_WIRE];
+    size_t length = linkEncode(packet, wire);
+    Serial.write(wire, length);
+}
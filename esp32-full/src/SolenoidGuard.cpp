@@ -0,0 +1,99 @@
+#include "SolenoidGuard.h"
+#include "Hal.h"
+
+SolenoidGuard solenoidGuard;
+
+#if !defined(AIRRIDE_NATIVE)
+// Shared with the ISR; written only while the timer is stopped
+static hw_timer_t* guardTimer = NULL;
+static volatile uint32_t guardMaskLow = 0;
+static volatile uint32_t guardMaskHigh = 0;
+static volatile bool guardTripped = false;
+
+// Release every guarded relay with direct register writes (no flash access)
+static void IRAM_ATTR onGuardDeadline() {
+#if RELAY_ACTIVE_LOW
+    REG_WRITE(GPIO_OUT_W1TS_REG, guardMaskLow);
+    REG_WRITE(GPIO_OUT1_W1TS_REG, guardMaskHigh);
+#else
+    REG_WRITE(GPIO_OUT_W1TC_REG, guardMaskLow);
+    REG_WRITE(GPIO_OUT1_W1TC_REG, guardMaskHigh);
+#endif
+    guardTripped = true;
+}
+#endif
+
+SolenoidGuard::SolenoidGuard()
+    : armed(false),
+      tripCount(0),
+      mask(0) {
+#if defined(AIRRIDE_NATIVE)
+    deadline = 0;
+#endif
+}
+
+void SolenoidGuard::begin() {
+#if !defined(AIRRIDE_NATIVE)
+    // 80 MHz APB / 80 = 1 us per count; one-shot alarm
+    guardTimer = timerBegin(SOLENOID_GUARD_TIMER, 80, true);
+    timerAttachInterrupt(guardTimer, &onGuardDeadline, true);
+    timerAlarmWrite(guardTimer, SOLENOID_GUARD_MS * 1000UL, false);
+#endif
+    Serial.print("Solenoid dead-man: ");
+    Serial.print(SOLENOID_GUARD_MS);
+    Serial.println(" ms");
+}
+
+void SolenoidGuard::arm(uint64_t solenoidMask) {
+#if defined(AIRRIDE_NATIVE)
+    if (armed) return;
+#else
+    // Tripped but not handled yet: the one-shot alarm is spent
+    if (armed && !guardTripped) return;
+#endif
+    armed = true;
+    mask = solenoidMask;
+#if defined(AIRRIDE_NATIVE)
+    deadline = millis() + SOLENOID_GUARD_MS;
+#else
+    if (!guardTimer) return;
+    guardMaskLow = (uint32_t)solenoidMask;
+    guardMaskHigh = (uint32_t)(solenoidMask >> 32);
+    timerWrite(guardTimer, 0);
+    timerAlarmEnable(guardTimer);
+#endif
+}
+
+void SolenoidGuard::disarm() {
+    if (!armed) return;
+    armed = false;
+#if !defined(AIRRIDE_NATIVE)
+    if (guardTimer) timerAlarmDisable(guardTimer);
+#endif
+}
+
+void SolenoidGuard::feed() {
+    if (!armed) return;
+#if defined(AIRRIDE_NATIVE)
+    deadline = millis() + SOLENOID_GUARD_MS;
+#else
+    if (guardTimer) timerWrite(guardTimer, 0);
+#endif
+}
+
+bool SolenoidGuard::checkTripped() {
+#if defined(AIRRIDE_NATIVE)
+    if (!armed || (long)(millis() - deadline) < 0) return false;
+#else
+    if (!guardTripped) return false;
+    guardTripped = false;
+    if (guardTimer) timerAlarmDisable(guardTimer);
+#endif
+    // The ISR released the pins, but a command since then may have opened
+    // one again: the caller marks every guarded output released, so make
+    // that true
+    Hal::writePins(mask, RELAY_OFF);
+    armed = false;
+    tripCount++;
+    return true;
+}
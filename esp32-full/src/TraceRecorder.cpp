@@ -0,0 +1,51 @@
+#include "TraceRecorder.h"
+
+TraceRecorder traceRecorder;
+
+TraceRecorder::TraceRecorder()
+    : count(0),
+      active(false),
+      full(false) {
+}
+
+void TraceRecorder::begin() {
+    count = 0;
+    full = false;
+    active = true;
+    append(TRACE_BOOT, 0, (uint16_t)millis());
+}
+
+void TraceRecorder::restart() {
+    count = 0;
+    full = false;
+    active = true;
+    append(TRACE_SNAPSHOT, 0, (uint16_t)millis());
+}
+
+void TraceRecorder::recordTick() {
+    append(TRACE_TICK, 0, (uint16_t)millis());
+}
+
+void TraceRecorder::recordCommand(TraceCommand cmd, uint16_t value, const float* args, int argCount) {
+    if (!active) return;
+
+    // Commands change millis()-based state (solenoid timers), so stamp them
+    append(TRACE_TIME, 0, (uint16_t)millis());
+    append(TRACE_COMMAND, cmd, value);
+    for (int i = 0; i < argCount; i++) {
+        uint32_t bits;
+        memcpy(&bits, &args[i], sizeof(bits));
+        append(TRACE_ARG, i, (uint16_t)(bits >> 16));
+        append(TRACE_ARG, i, (uint16_t)(bits & 0xFFFF));
+    }
+}
+
+TraceHeader TraceRecorder::getHeader() const {
+    TraceHeader h;
+    memcpy(h.magic, TRACE_MAGIC, 4);
+    h.version = TRACE_VERSION;
+    h.recordSize = sizeof(TraceRecord);
+    h.count = count;
+    h.flags = full ? TRACE_FLAG_FULL : 0;
+    return h;
+}
@@ -0,0 +1,129 @@
+#include "Trajectory.h"
+#include <ctype.h>
+
+TrajectoryGenerator::TrajectoryGenerator()
+    : lastUpdate(0) {
+    for (int i = 0; i < NUM_BAGS; i++) {
+        ramping[i] = false;
+        setpoint[i] = 0;
+        goal[i] = 0;
+        rate[i] = 0;
+        maxRate[i] = 0;
+        accel[i] = 0;
+        profile[i] = RAMP_FAST;
+    }
+}
+
+void TrajectoryGenerator::start(const AirBag& bag, int bagNum, const DeadbandEstimator& deadband, RampProfile p) {
+    if (bagNum < 0 || bagNum >= NUM_BAGS) return;
+    begin(bagNum, bag.getPressure(), bag.getTargetPressure(), deadband.getBand(bagNum), p, 1.0);
+}
+
+void TrajectoryGenerator::startAll(const AirBag* bags, const DeadbandEstimator& deadband, RampProfile p) {
+    float longest = 0;
+    for (int i = 0; i < NUM_BAGS; i++) {
+        longest = max(longest, abs(bags[i].getTargetPressure() - bags[i].getPressure()));
+    }
+    for (int i = 0; i < NUM_BAGS; i++) {
+        float travel = abs(bags[i].getTargetPressure() - bags[i].getPressure());
+        float scale = (longest > 0) ? travel / longest : 1.0;
+        begin(i, bags[i].getPressure(), bags[i].getTargetPressure(), deadband.getBand(i), p, scale);
+    }
+}
+
+// Scaling both the slope and the acceleration by travel keeps the ramp
+// shape identical in normalized time, so scaled corners stay in step
+void TrajectoryGenerator::begin(int bagNum, float from, float to, float band, RampProfile p, float scale) {
+    const RampProfileDef& def = RAMP_PROFILES[p];
+    profile[bagNum] = p;
+    goal[bagNum] = to;
+    rate[bagNum] = 0;
+    maxRate[bagNum] = def.ratePsiS * scale;
+    accel[bagNum] = def.accelPsiS2 * scale;
+
+    if (def.ratePsiS <= 0 || abs(to - from) <= band) {
+        // Step: tracking drives straight at the target
+        ramping[bagNum] = false;
+        setpoint[bagNum] = to;
+        return;
+    }
+    // update() runs every tick, but the last one may be an idle tick ago
+    // (or none yet at boot): the first step integrates from here
+    bool anyRamping = false;
+    for (int i = 0; i < NUM_BAGS; i++) anyRamping |= ramping[i];
+    if (!anyRamping) lastUpdate = millis();
+
+    ramping[bagNum] = true;
+    setpoint[bagNum] = from;
+}
+
+void TrajectoryGenerator::release(int bagNum) {
+    if (bagNum < 0 || bagNum >= NUM_BAGS) return;
+    ramping[bagNum] = false;
+    rate[bagNum] = 0;
+    profile[bagNum] = RAMP_FAST;
+}
+
+void TrajectoryGenerator::update() {
+    unsigned long now = millis();
+    // A stalled loop must not skip the ease-in in one step
+    float dt = min((now - lastUpdate) / 1000.0f, CONTROL_INTERVAL_IDLE_MS / 1000.0f);
+    lastUpdate = now;
+
+    for (int i = 0; i < NUM_BAGS; i++) {
+        if (!ramping[i]) {
+            setpoint[i] = goal[i];
+            continue;
+        }
+
+        float remaining = goal[i] - setpoint[i];
+        float dir = (remaining > 0) ? 1.0 : -1.0;
+
+        // Fastest slope that can still ease to a stop at the goal
+        float wanted = maxRate[i];
+        if (accel[i] > 0) {
+            wanted = min(wanted, sqrtf(2.0f * accel[i] * abs(remaining)));
+        }
+        wanted *= dir;
+
+        if (accel[i] > 0) {
+            float step = accel[i] * dt;
+            rate[i] = constrain(wanted, rate[i] - step, rate[i] + step);
+        } else {
+            rate[i] = wanted;
+        }
+
+        setpoint[i] += rate[i] * dt;
+        if ((goal[i] - setpoint[i]) * dir <= 0 || abs(goal[i] - setpoint[i]) < 0.05) {
+            setpoint[i] = goal[i];
+            rate[i] = 0;
+            ramping[i] = false;
+        }
+    }
+}
+
+bool TrajectoryGenerator::pulseAllows(int bagNum, float errorPsi) const {
+    float zone = RAMP_PROFILES[profile[bagNum]].pulseZonePsi;
+    if (zone <= 0 || abs(errorPsi) > zone) return true;
+
+    // Shared phase: every pulsing corner switches on the same ticks
+    return (millis() % (RAMP_PULSE_ON_MS + RAMP_PULSE_OFF_MS)) < RAMP_PULSE_ON_MS;
+}
+
+const char* TrajectoryGenerator::profileName(RampProfile p) {
+    return (p >= 0 && p < NUM_RAMP_PROFILES) ? RAMP_PROFILES[p].name : "?";
+}
+
+bool TrajectoryGenerator::parseProfile(const char* text, RampProfile& p) {
+    if (!text || !*text) return false;
+    for (int i = 0; i < NUM_RAMP_PROFILES; i++) {
+        const char* name = RAMP_PROFILES[i].name;
+        bool letter = (text[1] == '\0' && tolower(text[0]) == name[0]);
+        bool index = (text[1] == '\0' && text[0] == '0' + i);
+        if (letter || index || strcasecmp(text, name) == 0) {
+            p = (RampProfile)i;
+            return true;
+        }
+    }
+    return false;
+}
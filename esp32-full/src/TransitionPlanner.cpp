@@ -0,0 +1,371 @@
+#include "TransitionPlanner.h"
+
+TransitionPlanner::TransitionPlanner()
+    : active(false),
+      staged(false),
+      corners(0),
+      done(0),
+      gates(0),
+      waiting(0),
+      minProgress(0),
+      lastProgress(0),
+      lastProgressMs(0),
+      stagedSinceMs(0) {
+    memset(&report, 0, sizeof(report));
+    report.outcome = PLAN_NONE;
+    for (int i = 0; i < NUM_BAGS; i++) {
+        startPsi[i] = 0;
+        goalPsi[i] = 0;
+        inflateK[i] = PLAN_INFLATE_K;
+        deflateK[i] = PLAN_DEFLATE_K;
+        segState[i] = VALVE_HOLD;
+        segStartMs[i] = 0;
+        segStartPsi[i] = 0;
+        segStartTank[i] = 0;
+    }
+}
+
+bool TransitionPlanner::start(const AirBag* bags, const DeadbandEstimator& deadband,
+                              float tankPressure, const MovePrediction& prediction) {
+    if (active) finish(PLAN_CANCELLED, "replaced");
+
+    corners = 0;
+    int count = 0;
+    for (int i = 0; i < NUM_BAGS; i++) {
+        startPsi[i] = bags[i].getPressure();
+        goalPsi[i] = bags[i].getTargetPressure();
+        if (abs(goalPsi[i] - startPsi[i]) > deadband.getBand(i)) {
+            corners |= (1 << i);
+            count++;
+        }
+    }
+    if (count < 2) return false;
+
+    unsigned long now = millis();
+    active = true;
+    staged = false;
+    done = 0;
+    waiting = 0;
+    gates = corners;
+    minProgress = 0;
+    lastProgress = 0;
+    lastProgressMs = now;
+
+    memset(&report, 0, sizeof(report));
+    report.outcome = PLAN_RUNNING;
+    report.corners = corners;
+    report.startedMs = now;
+    report.tankStart = tankPressure;
+    report.tankEnd = tankPressure;
+    report.plannedMs = prediction.ms;
+    report.tankPredicted = prediction.tankEnd;
+    report.airPsi = prediction.airPsi;
+    report.stagesPredicted = prediction.pauses;
+
+    Serial.print("[PLAN] ");
+    Serial.print(count);
+    Serial.print(" corners, planned ");
+    Serial.print(report.plannedMs / 1000.0, 1);
+    Serial.print(" s, tank ");
+    Serial.print(tankPressure, 0);
+    Serial.print(" -> ");
+    Serial.print(report.tankPredicted, 0);
+    Serial.print(" PSI");
+    if (report.stagesPredicted > 0) {
+        Serial.print(", ");
+        Serial.print(report.stagesPredicted);
+        Serial.print(" pause(s) for the pumps");
+    }
+    if (report.plannedMs >= PLAN_PREDICT_MAX_MS) {
+        Serial.print(" (tank can't reach every target)");
+    }
+    Serial.println();
+
+    // Staged from the start if the tank is already at the floor
+    step(bags, deadband, tankPressure, now);
+    return true;
+}
+
+void TransitionPlanner::update(const AirBag* bags, const DeadbandEstimator& deadband,
+                               float tankPressure) {
+    unsigned long now = millis();
+    learn(bags, tankPressure, now);
+    if (active) {
+        step(bags, deadband, tankPressure, now);
+    }
+}
+
+void TransitionPlanner::release(int bag) {
+    if (!active || bag < 0 || bag >= NUM_BAGS) return;
+    uint8_t bit = 1 << bag;
+    corners &= ~bit;
+    done &= ~bit;
+    if (corners == 0) {
+        finish(PLAN_CANCELLED, "taken over");
+    }
+}
+
+void TransitionPlanner::cancel(const char* reason) {
+    if (active) finish(PLAN_CANCELLED, reason);
+}
+
+const char* TransitionPlanner::outcomeName(PlanOutcome outcome) {
+    switch (outcome) {
+        case PLAN_RUNNING:   return "running";
+        case PLAN_COMPLETE:  return "complete";
+        case PLAN_CANCELLED: return "cancelled";
+        case PLAN_STALLED:   return "stalled";
+        default:             return "none";
+    }
+}
+
+float TransitionPlanner::progressOf(int bag, float psi) const {
+    float travel = goalPsi[bag] - startPsi[bag];
+    return constrain((psi - startPsi[bag]) / travel, 0.0f, 1.0f);
+}
+
+// ============================================
+// EXECUTION
+// ============================================
+
+void TransitionPlanner::step(const AirBag* bags, const DeadbandEstimator& deadband,
+                             float tankPressure, unsigned long now) {
+    report.tankEnd = tankPressure;
+    report.achievedMs = now - report.startedMs;
+
+    float minP = 1.0;
+    float maxP = 0.0;
+    bool inflating = false;
+    for (int i = 0; i < NUM_BAGS; i++) {
+        uint8_t bit = 1 << i;
+        if (!(corners & bit)) continue;
+
+        if (bags[i].isSolenoidTimedOut()) {
+            finish(PLAN_STALLED, "solenoid timeout");
+            return;
+        }
+
+        // Done once inside the band, or once tracking let it settle just
+        // outside (a holding bag only reopens past the reopen hysteresis)
+        float psi = bags[i].getPressure();
+        float error = abs(psi - goalPsi[i]);
+        float band = deadband.getBand(i);
+        if (error <= band ||
+            (error <= band + deadband.getReopen(i) &&
+             bags[i].isHolding() && (gates & bit))) {
+            done |= bit;
+        }
+        float progress = progressOf(i, psi);
+        maxP = max(maxP, progress);
+        if (!(done & bit)) {
+            minP = min(minP, progress);
+            if (goalPsi[i] > psi) inflating = true;
+        }
+    }
+
+    if (done == corners) {
+        finish(PLAN_COMPLETE, NULL);
+        return;
+    }
+    minProgress = minP;
+    report.worstSpread = max(report.worstSpread, maxP - minP);
+
+    // Stage: pause inflation before the tank reaches lockout, continue
+    // once the pumps have caught up (same hysteresis shape as the lockout)
+    if (!staged && inflating && tankPressure <= PLAN_STAGE_FLOOR_PSI) {
+        staged = true;
+        stagedSinceMs = now;
+        report.stages++;
+        Serial.print("[PLAN] Paused at ");
+        Serial.print((int)(minP * 100));
+        Serial.print("% - tank ");
+        Serial.print(tankPressure, 0);
+        Serial.print(" PSI, continuing at ");
+        Serial.println(PLAN_STAGE_RESUME_PSI, 0);
+    } else if (staged && (tankPressure >= PLAN_STAGE_RESUME_PSI || !inflating)) {
+        staged = false;
+        lastProgressMs = now;
+        Serial.println("[PLAN] Tank recovered - continuing");
+    }
+
+    if (staged) {
+        if (now - stagedSinceMs > PLAN_STAGE_WAIT_MS) {
+            finish(PLAN_STALLED, "tank did not recover");
+        } else {
+            gates = done;
+        }
+        return;
+    }
+
+    if (minP > lastProgress + 0.01) {
+        lastProgress = minP;
+        lastProgressMs = now;
+    } else if (now - lastProgressMs > PLAN_STALL_MS) {
+        finish(PLAN_STALLED, "no progress");
+        return;
+    }
+
+    // Corners ahead of the slowest wait for it; finished corners are left
+    // to normal target tracking
+    gates = done;
+    for (int i = 0; i < NUM_BAGS; i++) {
+        uint8_t bit = 1 << i;
+        if (!(corners & bit) || (done & bit)) continue;
+
+        float progress = progressOf(i, bags[i].getPressure());
+        if (waiting & bit) {
+            if (progress <= minP + PLAN_SYNC_RESUME) waiting &= ~bit;
+        } else if (progress > minP + PLAN_SYNC_LEAD) {
+            waiting |= bit;
+        }
+        if (!(waiting & bit)) gates |= bit;
+    }
+}
+
+void TransitionPlanner::finish(PlanOutcome outcome, const char* reason) {
+    active = false;
+    staged = false;
+    report.outcome = outcome;
+
+    Serial.print("[PLAN] ");
+    if (outcome == PLAN_COMPLETE) {
+        Serial.print("Complete");
+    } else {
+        Serial.print(outcome == PLAN_STALLED ? "Stalled (" : "Cancelled (");
+        Serial.print(reason);
+        Serial.print(")");
+    }
+    Serial.print(" after ");
+    Serial.print(report.achievedMs / 1000.0, 1);
+    Serial.print(" s (planned ");
+    Serial.print(report.plannedMs / 1000.0, 1);
+    Serial.print(" s), tank ");
+    Serial.print(report.tankStart, 0);
+    Serial.print(" -> ");
+    Serial.print(report.tankEnd, 0);
+    Serial.print(" PSI (predicted ");
+    Serial.print(report.tankPredicted, 0);
+    Serial.print("), worst spread ");
+    Serial.print((int)(report.worstSpread * 100));
+    Serial.println("%");
+}
+
+// ============================================
+// PREDICTION
+// ============================================
+
+// Steps the flow model with the same staging rule the execution uses. The
+// sync holds are left out: they don't change when the slowest corner
+// finishes, and the slowest corner sets the completion time.
+MovePrediction TransitionPlanner::predict(const DeadbandEstimator& deadband,
+                                          const float fromPsi[NUM_BAGS], const float toPsi[NUM_BAGS],
+                                          uint8_t moving, const float rampRates[NUM_BAGS],
+                                          const float tankPerBag[NUM_BAGS], float tankPressure,
+                                          bool pumpsAvailable, bool fillNow, bool coordinated) const {
+    MovePrediction out;
+    memset(&out, 0, sizeof(out));
+
+    float psi[NUM_BAGS];
+    for (int i = 0; i < NUM_BAGS; i++) {
+        psi[i] = fromPsi[i];
+    }
+    float floor = coordinated ? PLAN_STAGE_FLOOR_PSI : TANK_CUTOFF_PSI;
+    float tank = tankPressure;
+    float dt = PLAN_PREDICT_STEP_MS / 1000.0;
+    uint8_t left = moving;
+    bool paused = false;
+    bool filling = pumpsAvailable && fillNow;
+    unsigned long pausedAt = 0;
+    unsigned long t = 0;
+
+    while (left && t < PLAN_PREDICT_MAX_MS) {
+        bool inflating = false;
+        for (int i = 0; i < NUM_BAGS; i++) {
+            if ((left & (1 << i)) && toPsi[i] > psi[i]) inflating = true;
+        }
+        if (!paused && inflating && tank <= floor) {
+            paused = true;
+            pausedAt = t;
+            out.pauses++;
+        } else if (paused && (tank >= PLAN_STAGE_RESUME_PSI || !inflating)) {
+            paused = false;
+        }
+        if (paused) out.longestPauseMs = max(out.longestPauseMs, t - pausedAt);
+
+        float moved = 0;
+        for (int i = 0; i < NUM_BAGS && !paused; i++) {
+            uint8_t bit = 1 << i;
+            if (!(left & bit)) continue;
+            // Valve flow, or the ramp slope if that is slower
+            bool up = toPsi[i] > psi[i];
+            float flow = up ? inflateK[i] * sqrtf(max(0.0f, tank - psi[i])) : deflateK[i] * sqrtf(max(0.0f, psi[i]));
+            if (rampRates[i] > 0) flow = min(flow, rampRates[i]);
+            float dp = min(flow * dt, abs(toPsi[i] - psi[i]));
+            if (up) {
+                psi[i] += dp;
+                tank -= dp * tankPerBag[i];
+                out.airPsi += dp * tankPerBag[i];
+                out.bagPsi[i] += dp;
+            } else {
+                psi[i] -= dp;
+            }
+            moved += dp;
+            if (abs(psi[i] - toPsi[i]) <= deadband.getBand(i)) left &= ~bit;
+        }
+
+        // Compressor auto mode: fill from TANK_MIN_PSI to TANK_MAX_PSI
+        if (pumpsAvailable) {
+            if (tank < TANK_MIN_PSI) filling = true;
+            if (tank >= TANK_MAX_PSI) filling = false;
+            if (filling) {
+                int pumps = (tank < PUMP_BOTH_ON_THRESHOLD) ? 2 : 1;
+                tank += pumps * PLAN_PUMP_PSI_PER_S * dt;
+            }
+        }
+        t += PLAN_PREDICT_STEP_MS;
+
+        // Nothing left that can change: the tank can't reach the targets
+        if (!filling && (paused || moved < 0.0001f)) {
+            t = PLAN_PREDICT_MAX_MS;
+        }
+    }
+
+    out.ms = t;
+    out.tankEnd = tank;
+    return out;
+}
+
+// ============================================
+// FLOW LEARNING
+// ============================================
+
+// Each continuous inflate or dump gives one observation. Inverting
+// rate = k * sqrt(dP) over the segment (tank taken as its average):
+//   inflate: k = 2 (sqrt(T - p0) - sqrt(T - p1)) / t
+//   dump:    k = 2 (sqrt(p0) - sqrt(p1)) / t
+void TransitionPlanner::learn(const AirBag* bags, float tankPressure, unsigned long now) {
+    for (int i = 0; i < NUM_BAGS; i++) {
+        ValveState state = bags[i].getState();
+        if (state == segState[i]) continue;
+
+        float psi = bags[i].getPressure();
+        unsigned long durationMs = now - segStartMs[i];
+        if (segState[i] != VALVE_HOLD && durationMs >= PLAN_LEARN_MIN_MS &&
+            abs(psi - segStartPsi[i]) >= PLAN_LEARN_MIN_PSI) {
+            float seconds = durationMs / 1000.0;
+            if (segState[i] == VALVE_INFLATE) {
+                float tank = (segStartTank[i] + tankPressure) / 2.0;
+                float k = 2.0 * (sqrtf(max(0.0f, tank - segStartPsi[i])) - sqrtf(max(0.0f, tank - psi))) / seconds;
+                if (k > 0) inflateK[i] += PLAN_LEARN_GAIN * (k - inflateK[i]);
+            } else {
+                float k = 2.0 * (sqrtf(max(0.0f, segStartPsi[i])) - sqrtf(max(0.0f, psi))) / seconds;
+                if (k > 0) deflateK[i] += PLAN_LEARN_GAIN * (k - deflateK[i]);
+            }
+        }
+
+        segState[i] = state;
+        segStartMs[i] = now;
+        segStartPsi[i] = psi;
+        segStartTank[i] = tankPressure;
+    }
+}
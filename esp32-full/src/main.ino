@@ -6,13 +6,18 @@
  * - Hold buttons for continuous inflate/deflate
  * - Target PSI display
  * - Saveable presets (EEPROM)
- * - Level mode (auto-match left/right)
+ * - Level mode (cross-coupled, learns how the corners load each other)
  * - Watchdog timer
  * - Solenoid timeout protection
- * - Pressure smoothing
+ * - Pressure smoothing, per-corner deadband learned from sensor noise
  * - OTA firmware updates
- * - Pump runtime tracking
- * - Tank lockout with hysteresis
+ * - Pump runtime tracking, least-worn pump first, thermal rests, pre-fill
+ * - Pump health: fill-rate curve per pump, wear trend, projected service
+ * - Tank lockout with hysteresis, starved corners queued and resumed rear first
+ * - Inflate close scheduled on tank pressure (learned coast per corner)
+ * - Coordinated preset moves (corners in step, staged for the tank)
+ * - Air budget: every move predicted (time, tank left, SCF) before it runs
+ * - Parked low-power mode with leak checks
  *
  * ESP32 with built-in WiFi - no shield required!
  */
@@ -25,7 +30,14 @@
 #include "config.h"
 #include "AirBag.h"
 #include "Compressor.h"
+#include "RideController.h"
 #include "AirRideWebServer.h"
+#include "TraceRecorder.h"
+#include "SolenoidGuard.h"
+#include "Diagnostics.h"
+#include "PowerManager.h"
+#include "SerialConsole.h"
+#include "SerialLink.h"
 
 // ============================================
 // GLOBAL OBJECTS
@@ -41,52 +53,33 @@ AirBag bags[NUM_BAGS] = {
 
 Compressor compressor(PUMP_1_PIN, PUMP_2_PIN);
 
-float tankPressure = 0.0;
+RideController controller(bags, &compressor);
 
-// Runtime demo mode state (toggled via /demo endpoint)
-bool demoMode = true;           // Start in demo mode for bench testing
-float simTankPressure = DEMO_TANK_PSI;
+AirRideWebServer webServer(bags, &compressor, &controller);
 
-// Simulated leak state (toggled via /simleak endpoint)
-int simLeakTarget = -1;         // -1=none, 0-3=bag index, 4=tank
-float simLeakRate = SIM_LEAK_RATE_PSI_TICK;
+// Serial console: command table is with the handlers below
+extern const ConsoleCommand SERIAL_COMMANDS[];
+extern const int NUM_SERIAL_COMMANDS;
+SerialConsole console(SERIAL_COMMANDS, NUM_SERIAL_COMMANDS);
 
-void setDemoMode(bool enabled) {
-    if (enabled && !demoMode) {
-        // Entering demo mode: initialize sim state from current readings
-        simTankPressure = tankPressure > 0 ? tankPressure : DEMO_TANK_PSI;
-    }
-    demoMode = enabled;
-    Serial.print("[DEMO] Simulation mode ");
-    Serial.println(enabled ? "ENABLED" : "DISABLED");
-}
+// Binary link for host tooling (frames share the console port)
+SerialLink serialLink(bags, &compressor, &controller, &webServer);
 
-AirRideWebServer webServer(bags, &compressor, &tankPressure);
-
-unsigned long lastPressureRead = 0;
+// Bring-up that doesn't gate control: finished from loop() after setup()
+enum BootStage { BOOT_WIFI, BOOT_OTA, BOOT_BANNER, BOOT_DONE };
+BootStage bootStage = BOOT_WIFI;
 
 // ============================================
 // FUNCTION PROTOTYPES
 // ============================================
 
-float readTankPressure();
-float readTankPressureSmoothed();
-void updateTargetTracking();
 void printStatus();
 void printHelp();
-void processSerialCommand();
 void stopAllBags();
 void setupOTA();
 void setupWatchdog();
-
-// Tank pressure smoothing
-float tankPressureBuffer[PRESSURE_SAMPLES];
-int tankBufferIndex = 0;
-bool tankBufferFilled = false;
-
-// Tank sensor calibration (sensor index 0)
-SensorCalibration tankCalibration = { 0.0, 1.0, REFERENCE_RESISTOR };
-bool tankCalibrated = false;
+void onLinkFrame(const uint8_t* encoded, size_t length);
+void runBootStage();
 
 // ============================================
 // SETUP
@@ -94,7 +87,6 @@ bool tankCalibrated = false;
 
 void setup() {
     Serial.begin(SERIAL_BAUD_RATE);
-    delay(1000); // Give serial time to connect
 
     Serial.println("====================================");
     Serial.println("Air Ride Controller v3.0 (ESP32 ADV)");
@@ -105,6 +97,21 @@ void setup() {
     EEPROM.begin(EEPROM_SIZE);
     Serial.println("EEPROM initialized");
 
+    // Reset reason, boot count and any stored core dump
+    diagnostics.begin();
+
+    // Record the session from here on (download via /trace)
+    traceRecorder.begin();
+
+    // Solenoid dead-man timer (armed by the first valve that opens)
+    solenoidGuard.begin();
+
+    // Watchdog before anything that could hang
+    setupWatchdog();
+
+    // Presets, leak snapshot, tank service date and calibration
+    webServer.loadSettings();
+
     // Initialize all air bags
     for (int i = 0; i < NUM_BAGS; i++) {
         bags[i].begin();
@@ -115,47 +122,17 @@ void setup() {
     compressor.begin();
     Serial.println("Compressor initialized");
 
-    // Initialize WiFi web server
-    webServer.begin();
+    // Fill tank pressure buffer, restore the last targets, first tick next loop()
+    controller.begin();
 
-    // Setup OTA updates
-    setupOTA();
+    // Binary link frames arrive through the console's reader
+    console.setFrameHandler(onLinkFrame);
 
-    // Setup watchdog timer
-    setupWatchdog();
+    // Auto-park countdown and wake button
+    powerManager.begin(bags, &controller, &webServer);
 
-    // Fill tank pressure buffer
-    for (int i = 0; i < PRESSURE_SAMPLES; i++) {
-        tankPressureBuffer[i] = readTankPressure();
-        delay(PRESSURE_SAMPLE_DELAY);
-    }
-    tankBufferFilled = true;
-
-    // Initial tank reading
-    tankPressure = readTankPressureSmoothed();
-
-    // Check for maintenance warnings
-    if (compressor.isMaintenanceDue()) {
-        Serial.println("************************************");
-        if (compressor.isPump1Overdue()) {
-            Serial.println("WARNING: Pump 1 maintenance OVERDUE!");
-        } else if (compressor.isPump1MaintenanceDue()) {
-            Serial.println("NOTICE: Pump 1 maintenance due");
-        }
-        if (compressor.isPump2Overdue()) {
-            Serial.println("WARNING: Pump 2 maintenance OVERDUE!");
-        } else if (compressor.isPump2MaintenanceDue()) {
-            Serial.println("NOTICE: Pump 2 maintenance due");
-        }
-        Serial.println("Use MR1 or MR2 to reset after service");
-        Serial.println("************************************");
-    }
-
-    Serial.println("====================================");
-    Serial.print("Demo/Simulation Mode: ");
-    Serial.println(demoMode ? "ENABLED" : "DISABLED");
-    Serial.println("System Ready");
-    printHelp();
+    // WiFi, OTA and the banner follow from loop() (see runBootStage)
+    diagnostics.markControlReady();
 }
 
 // ============================================
@@ -163,47 +140,94 @@ void setup() {
 // ============================================
 
 void loop() {
-    unsigned long currentTime = millis();
-
     // Reset watchdog
     esp_task_wdt_reset();
 
-    // Handle OTA updates
-    ArduinoOTA.handle();
+    // Each stage is timed against its DIAG_BUDGET_*_MS (see Diagnostics.h)
 
-    // Handle WiFi clients
-    webServer.update();
+    // Sense, pumps, lockout, level mode and target tracking at the control rate
+    diagnostics.stage(STAGE_CONTROL);
+    controller.update();
 
-    // Read pressures at defined interval
-    if (currentTime - lastPressureRead >= PRESSURE_READ_INTERVAL) {
-        lastPressureRead = currentTime;
+    // Serial console and binary link (return immediately on partial input)
+    diagnostics.stage(STAGE_CONSOLE);
+    console.poll();
+    diagnostics.stage(STAGE_LINK);
+    serialLink.update();
 
-        // Update tank pressure (smoothed)
-        tankPressureBuffer[tankBufferIndex] = readTankPressure();
-        tankBufferIndex = (tankBufferIndex + 1) % PRESSURE_SAMPLES;
-        tankPressure = readTankPressureSmoothed();
+    if (bootStage != BOOT_DONE) {
+        // One deferred bring-up step per pass, so control keeps its cadence
+        diagnostics.stage(STAGE_BOOT);
+        runBootStage();
+    } else {
+        // Handle OTA updates
+        diagnostics.stage(STAGE_OTA);
+        ArduinoOTA.handle();
 
-        // Update compressor (handles pump logic automatically)
-        // Only run pump logic if pumps are enabled via override toggle
-        if (webServer.isPumpEnabled()) {
-            compressor.update(tankPressure);
-        } else {
-            compressor.setMode(PUMP_OFF);
-            compressor.update(tankPressure);
-        }
+        // Handle WiFi clients
+        diagnostics.stage(STAGE_WEB);
+        webServer.update();
+    }
 
-        // Update all bags (reads pressure, enforces safety limits, checks timeouts)
-        for (int i = 0; i < NUM_BAGS; i++) {
-            bags[i].update();
-        }
+    diagnostics.stage(STAGE_NONE);
+
+    // Parked: light-sleeps here until the next leak check or the wake button
+    powerManager.update();
+}
 
-        // Auto-adjust bags toward target pressure (for presets)
-        updateTargetTracking();
+// ============================================
+// DEFERRED BOOT
+// ============================================
+
+void runBootStage() {
+    // softAP and mDNS bring-up block past the dead-man window: never with a
+    // valve open, and not before the restored stance has finished moving
+    if (bootStage != BOOT_BANNER && controller.getValveRestMs() < BOOT_BRINGUP_REST_MS) {
+        return;
     }
 
-    // Process any serial commands
-    if (Serial.available()) {
-        processSerialCommand();
+    switch (bootStage) {
+        case BOOT_WIFI:
+            // Initialize WiFi web server
+            webServer.begin();
+            bootStage = BOOT_OTA;
+            break;
+
+        case BOOT_OTA:
+            // Setup OTA updates
+            setupOTA();
+            bootStage = BOOT_BANNER;
+            break;
+
+        case BOOT_BANNER:
+            // Check for maintenance warnings
+            if (compressor.isMaintenanceDue()) {
+                Serial.println("************************************");
+                if (compressor.isPump1Overdue()) {
+                    Serial.println("WARNING: Pump 1 maintenance OVERDUE!");
+                } else if (compressor.isPump1MaintenanceDue()) {
+                    Serial.println("NOTICE: Pump 1 maintenance due");
+                }
+                if (compressor.isPump2Overdue()) {
+                    Serial.println("WARNING: Pump 2 maintenance OVERDUE!");
+                } else if (compressor.isPump2MaintenanceDue()) {
+                    Serial.println("NOTICE: Pump 2 maintenance due");
+                }
+                Serial.println("Use MR1 or MR2 to reset after service");
+                Serial.println("************************************");
+            }
+
+            Serial.println("====================================");
+            Serial.print("Demo/Simulation Mode: ");
+            Serial.println(demoMode ? "ENABLED" : "DISABLED");
+            Serial.println("System Ready");
+            printHelp();
+            diagnostics.markBootComplete();
+            bootStage = BOOT_DONE;
+            break;
+
+        case BOOT_DONE:
+            break;
     }
 }
 
@@ -217,10 +241,8 @@ void setupOTA() {
 
     ArduinoOTA.onStart([]() {
         // Stop all solenoids before OTA update
-        for (int i = 0; i < NUM_BAGS; i++) {
-            bags[i].hold();
-        }
-        compressor.setMode(PUMP_OFF);
+        controller.stopAll();
+        controller.setPumpMode(PUMP_OFF);
         Serial.println("OTA Update starting...");
     });
 
@@ -254,123 +276,14 @@ void setupWatchdog() {
     Serial.println("s timeout)");
 }
 
-float readTankPressure() {
-    if (demoMode) {
-        // Simulate tank physics (ported from frontend simulation)
-
-        // Natural tank decay (slow leak)
-        simTankPressure -= SIM_TANK_DECAY_RATE;
-
-        // Pump fill - when compressor is running, tank fills up
-        if (compressor.isRunning()) {
-            float efficiency = max(0.3f, 1.0f - (simTankPressure / 200.0f));
-            float pumpCount = (compressor.isPump1Running() && compressor.isPump2Running()) ? 2.0f : 1.0f;
-            float fillRate = SIM_PUMP_FILL_RATE * efficiency * pumpCount;
-            simTankPressure += fillRate;
-        }
-
-        // Tank drain from active bag inflation
-        for (int i = 0; i < NUM_BAGS; i++) {
-            if (bags[i].isInflating()) {
-                float deltaP = max(0.0f, simTankPressure - bags[i].getPressure());
-                float drainRate = SIM_BAG_TANK_DRAIN * sqrt(deltaP);
-                simTankPressure -= drainRate;
-            }
-        }
-
-        // Apply simulated leak on tank
-        if (simLeakTarget == 4) {
-            simTankPressure -= simLeakRate;
-        }
-
-        // Clamp to valid range
-        if (simTankPressure < 0) simTankPressure = 0;
-        if (simTankPressure > SENSOR_MAX_PSI) simTankPressure = SENSOR_MAX_PSI;
-
-        return simTankPressure;
-    }
-
-    // ESP32: 12-bit ADC, 3.3V reference
-    int rawValue = analogRead(TANK_PRESSURE_PIN);
-    float voltage = (rawValue / ADC_RESOLUTION) * ADC_REFERENCE_VOLTAGE;
-
-    // Convert voltage to resistance (VDO resistance-based sensor)
-    // Uses per-sensor calibrated reference resistor value
-    float resistance;
-    if (voltage >= ADC_REFERENCE_VOLTAGE - 0.01) {
-        resistance = SENSOR_MAX_OHMS;
-    } else if (voltage <= 0.01) {
-        resistance = SENSOR_MIN_OHMS;
-    } else {
-        resistance = tankCalibration.refResistor * voltage / (ADC_REFERENCE_VOLTAGE - voltage);
-    }
-
-    // Clamp and convert resistance to PSI
-    if (resistance < SENSOR_MIN_OHMS) resistance = SENSOR_MIN_OHMS;
-    if (resistance > SENSOR_MAX_OHMS) resistance = SENSOR_MAX_OHMS;
-
-    float rawPsi = ((resistance - SENSOR_MIN_OHMS) / (SENSOR_MAX_OHMS - SENSOR_MIN_OHMS)) * SENSOR_MAX_PSI;
-
-    // Apply calibration: correctedPsi = (rawPsi * gain) + offset
-    return (rawPsi * tankCalibration.gain) + tankCalibration.offset;
-}
-
-float readTankPressureSmoothed() {
-    float sum = 0.0;
-    int count = tankBufferFilled ? PRESSURE_SAMPLES : tankBufferIndex;
-
-    if (count == 0) {
-        return readTankPressure();
-    }
-
-    for (int i = 0; i < count; i++) {
-        sum += tankPressureBuffer[i];
-    }
-    return sum / count;
-}
-
-void updateTargetTracking() {
-    // Auto-adjust bags toward their target pressure
-    // This enables preset functionality
-    const float tolerance = 2.0;
-
-    for (int i = 0; i < NUM_BAGS; i++) {
-        float current = bags[i].getPressure();
-        float target = bags[i].getTargetPressure();
-
-        // Skip if solenoid is timed out
-        if (bags[i].isSolenoidTimedOut()) {
-            continue;
-        }
-
-        // Only auto-adjust if we have a meaningful target set
-        if (target > 0 || bags[i].isInflating() || bags[i].isDeflating()) {
-            if (current < target - tolerance) {
-                if (!bags[i].isInflating() && !webServer.isTankLockout()) {
-                    bags[i].inflate();
-                }
-            } else if (current > target + tolerance) {
-                if (!bags[i].isDeflating()) {
-                    bags[i].deflate();
-                }
-            } else {
-                // At target - hold
-                if (!bags[i].isHolding()) {
-                    bags[i].hold();
-                }
-            }
-        }
-    }
-}
-
 void printStatus() {
     Serial.println("========== STATUS ==========");
 
     // Tank and compressor status
     Serial.print("Tank: ");
-    Serial.print(tankPressure, 1);
+    Serial.print(controller.getTankPressure(), 1);
     Serial.print(" PSI");
-    if (webServer.isTankLockout()) {
+    if (controller.isTankLockout()) {
         Serial.print(" [LOCKOUT]");
     }
     Serial.print(" | Pumps: ");
@@ -403,6 +316,50 @@ void printStatus() {
         Serial.println();
     }
 
+    // Pump health: fill rate vs new, when service is due
+    const PumpHealth& health = compressor.getHealth();
+    Serial.print("Pump Health:");
+    for (int p = 0; p < 2; p++) {
+        Serial.print(p == 0 ? " P1 " : " | P2 ");
+        if (health.getFlowPct(p) < 0) {
+            Serial.print("learning");
+        } else {
+            Serial.print(health.getFlowPct(p));
+            Serial.print("% flow, score ");
+            Serial.print(health.getScore(p));
+            if (health.isDegraded(p)) Serial.print(" [SERVICE]");
+        }
+        Serial.print(", service at ");
+        Serial.print(compressor.getServiceHours(p), 0);
+        Serial.print("h");
+    }
+    Serial.println();
+
+    // Pump scheduling
+    const PumpScheduler& sched = compressor.getScheduler();
+    Serial.print("Pump Sched: ");
+    for (int p = 0; p < 2; p++) {
+        Serial.print(p == 0 ? "P1 " : " | P2 ");
+        Serial.print(sched.getStarts(p));
+        Serial.print(" starts, ");
+        Serial.print((int)(sched.getDuty(p) * 100));
+        Serial.print("% duty, +");
+        Serial.print(sched.getHeatC(p), 0);
+        Serial.print(" C");
+        if (sched.isResting(p)) Serial.print(" [RESTING]");
+    }
+    float toFull = compressor.getTimeToFullS(controller.getTankPressure());
+    Serial.print(" | full in ");
+    if (isnan(toFull)) {
+        Serial.print("--");
+    } else {
+        Serial.print(toFull, 0);
+        Serial.print(" s");
+    }
+    Serial.print(", next move ~");
+    Serial.print(sched.getForecastPsi(), 0);
+    Serial.println(" PSI");
+
     // WiFi status
     Serial.print("WiFi: ");
     if (webServer.isConnected()) {
@@ -414,12 +371,127 @@ void printStatus() {
 
     // Level mode
     Serial.print("Level Mode: ");
-    switch (webServer.getLevelMode()) {
-        case LEVEL_OFF:   Serial.println("OFF"); break;
-        case LEVEL_FRONT: Serial.println("FRONT"); break;
-        case LEVEL_REAR:  Serial.println("REAR"); break;
-        case LEVEL_ALL:   Serial.println("ALL"); break;
+    switch (controller.getLevelMode()) {
+        case LEVEL_OFF:   Serial.print("OFF"); break;
+        case LEVEL_FRONT: Serial.print("FRONT"); break;
+        case LEVEL_REAR:  Serial.print("REAR"); break;
+        case LEVEL_ALL:   Serial.print("ALL"); break;
+    }
+    const LevelController& leveler = controller.getLeveler();
+    if (controller.getLevelMode() != LEVEL_OFF) {
+        Serial.print(" (");
+        Serial.print(LevelController::phaseName(leveler.getPhase()));
+        Serial.print(", off by ");
+        Serial.print(leveler.getResidual(), 1);
+        Serial.print(" PSI)");
+    }
+    Serial.print(" pitch ");
+    Serial.print(leveler.getPitchTarget(), 1);
+    Serial.print(leveler.isPitchHeld() ? " (held)" : "");
+    Serial.print(", ");
+    Serial.print(leveler.getCorrections());
+    Serial.print(" corrections / ");
+    Serial.print(leveler.getCornerMoves());
+    Serial.println(" corner moves");
+
+    // Control rate and time spent at each
+    Serial.print("Control Rate: ");
+    Serial.print(RideController::rateName(controller.getControlRate()));
+    Serial.print(" (");
+    Serial.print(controller.getControlIntervalMs());
+    Serial.print(" ms) | active ");
+    Serial.print(controller.getTimeAtRateMs(RATE_ACTIVE) / 1000.0, 1);
+    Serial.print("s, idle ");
+    Serial.print(controller.getTimeAtRateMs(RATE_IDLE) / 1000.0, 1);
+    Serial.println("s");
+
+    // Last coordinated preset move
+    const PlanReport& plan = controller.getPlanner().getReport();
+    Serial.print("Transition: ");
+    Serial.print(TransitionPlanner::outcomeName(plan.outcome));
+    if (plan.outcome != PLAN_NONE) {
+        if (controller.getPlanner().isStaged()) Serial.print(" (waiting for tank)");
+        Serial.print(" | planned ");
+        Serial.print(plan.plannedMs / 1000.0, 1);
+        Serial.print("s, took ");
+        Serial.print(plan.achievedMs / 1000.0, 1);
+        Serial.print("s | tank ");
+        Serial.print(plan.tankStart, 0);
+        Serial.print(" -> ");
+        Serial.print(plan.tankEnd, 0);
+        Serial.print(" (predicted ");
+        Serial.print(plan.tankPredicted, 0);
+        Serial.print(") | pauses ");
+        Serial.print(plan.stages);
+        Serial.print(" | spread ");
+        Serial.print((int)(plan.worstSpread * 100));
+        Serial.print("%");
     }
+    Serial.println();
+
+    // Air budget: last move predicted vs drawn
+    const AirBudget& air = controller.getAirBudget();
+    const AirMove& airMove = air.getMove();
+    Serial.print("Air: ");
+    Serial.print(AirBudget::stateName(airMove.state));
+    if (airMove.state != AIR_MOVE_NONE) {
+        if (!airMove.estimate.feasible) Serial.print(" (predicted short)");
+        if (airMove.estimate.prestart) Serial.print(" (pumps pre-started)");
+        Serial.print(" | ");
+        Serial.print(airMove.scf, 2);
+        Serial.print(" SCF in ");
+        Serial.print(airMove.achievedMs / 1000.0, 1);
+        Serial.print("s, predicted ");
+        Serial.print(airMove.estimate.scf, 2);
+        Serial.print(" SCF in ");
+        Serial.print(airMove.estimate.ms / 1000.0, 1);
+        Serial.print("s | tank ");
+        Serial.print(airMove.tankEnd, 0);
+        Serial.print(" (predicted ");
+        Serial.print(airMove.estimate.tankEnd, 0);
+        Serial.print(")");
+    }
+    Serial.print(" | ");
+    Serial.print(air.getUsableScf(controller.getTankPressure()), 2);
+    Serial.print(" SCF usable, ");
+    Serial.print(air.getTotalScf(), 2);
+    Serial.println(" SCF used since boot");
+
+    // Corners waiting out a tank lockout
+    const InflateQueue& queue = controller.getInflateQueue();
+    if (!queue.isEmpty()) {
+        Serial.print("Inflate Queue:");
+        for (int i = 0; i < NUM_BAGS; i++) {
+            if (!(queue.getQueued() & (1 << i))) continue;
+            Serial.print(" ");
+            Serial.print(bags[i].getName());
+            Serial.print((queue.getReleased() & (1 << i)) ? " filling" : " waiting");
+            Serial.print(" +");
+            Serial.print(queue.getNeedPsi(i), 0);
+            Serial.print(" PSI (");
+            Serial.print(queue.getWaitMs(i) / 1000);
+            Serial.print("s)");
+        }
+        Serial.println();
+    }
+
+    // Parked mode and estimated draw
+    const PowerStats& ps = powerManager.getStats();
+    Serial.print("Power: ~");
+    Serial.print(powerManager.getCurrentMa(), 0);
+    Serial.print(" mA, park in ");
+    Serial.print(powerManager.getIdleRemainingMs() / 60000UL);
+    Serial.print(" min | parks ");
+    Serial.print(ps.parks);
+    Serial.print(", wakes ");
+    Serial.print(ps.timerWakes);
+    Serial.print(" timer / ");
+    Serial.print(ps.buttonWakes);
+    Serial.print(" button, ");
+    Serial.print(powerManager.getParkedMah(), 1);
+    Serial.print(" mAh parked (avg ");
+    Serial.print(powerManager.getParkedAverageMa(), 2);
+    Serial.println(" mA)");
 
     Serial.println("----------------------------");
 
@@ -430,7 +502,9 @@ void printStatus() {
         Serial.print(bags[i].getPressure(), 1);
         Serial.print("/");
         Serial.print(bags[i].getTargetPressure(), 0);
-        Serial.print(" PSI");
+        Serial.print(" PSI +/-");
+        Serial.print(controller.getDeadband().getBand(i), 1);
+        if (!controller.getDeadband().isLearned(i)) Serial.print("?");
 
         if (bags[i].isSolenoidTimedOut()) {
             Serial.print(" [TIMEOUT]");
@@ -441,22 +515,33 @@ void printStatus() {
         } else {
             Serial.print(" [hold]");
         }
+        if (controller.getTrajectory().isRamping(i)) {
+            Serial.print(" ramp ");
+            Serial.print(TrajectoryGenerator::profileName(controller.getTrajectory().getProfile(i)));
+            Serial.print(" @ ");
+            Serial.print(controller.getTrajectory().getSetpoint(i), 1);
+        }
         Serial.println();
     }
     Serial.println("============================");
 }
 
 void printHelp() {
-    Serial.println("--- Commands ---");
+    Serial.println("--- Commands (end with Enter, batch with ';' e.g. R1;L3) ---");
     Serial.println("Bags:    I0-I3=inflate, D0-D3=deflate, H0-H3=hold, S=stop all");
     Serial.println("         T0###=set bag target (e.g. T080=FL to 80 PSI)");
     Serial.println("         (0=FL, 1=FR, 2=RL, 3=RR)");
     Serial.println("Presets: R0=Lay, R1=Cruise, R2=Max");
+    Serial.println("Ramps:   add F=fast, C=comfort, S=show to R/T (e.g. R1S, T080F)");
     Serial.println("Pumps:   PA=auto, PO=off, PB=both, P1=pump1, P2=pump2");
     Serial.println("         PE=enable/disable toggle, PT###=set target PSI");
     Serial.println("Level:   L0=off, L1=front, L2=rear, L3=all");
+    Serial.println("         LP###=front-rear pitch PSI for L3 (e.g. LP30), LP=hold stance pitch");
     Serial.println("Maint:   MR1=reset pump1, MR2=reset pump2 (after service)");
     Serial.println("Status:  ?=help, P=print status");
+    Serial.println("Log:     G=toggle CSV telemetry (ms,tank,fl,fr,rl,rr,valves,pumps)");
+    Serial.println("         TR=restart session trace (GET /trace) from a snapshot");
+    Serial.println("Power:   Z=park now (sleep + leak checks; wake button to end)");
     Serial.print("WiFi: Connect to '");
     Serial.print(WIFI_SSID);
     Serial.print("' password '");
@@ -468,238 +553,250 @@ void printHelp() {
     Serial.println("----------------");
 }
 
-void processSerialCommand() {
-    char cmd = Serial.read();
-
-    switch (cmd) {
-        case 'I':
-        case 'i': {
-            while (!Serial.available()) { delay(1); }
-            int bagNum = Serial.read() - '0';
-            if (bagNum >= 0 && bagNum < NUM_BAGS) {
-                if (!webServer.isTankLockout()) {
-                    bags[bagNum].inflate();
-                    Serial.print("Inflating ");
-                    Serial.println(bags[bagNum].getName());
-                } else {
-                    Serial.println("Cannot inflate - tank pressure too low");
-                }
-            }
-            break;
-        }
+// ============================================
+// SERIAL COMMANDS
+// ============================================
+// Handlers get the rest of the token after the command name,
+// e.g. "T080" -> cmdBagTarget("080"). Lines are read by SerialConsole.
 
-        case 'D':
-        case 'd': {
-            while (!Serial.available()) { delay(1); }
-            int bagNum = Serial.read() - '0';
-            if (bagNum >= 0 && bagNum < NUM_BAGS) {
-                bags[bagNum].deflate();
-                Serial.print("Deflating ");
-                Serial.println(bags[bagNum].getName());
-            }
-            break;
-        }
+static bool parseBag(const char* arg, int& bagNum) {
+    if (SerialConsole::parseInt(arg, 0, NUM_BAGS - 1, bagNum)) return true;
+    Serial.println("Invalid bag (0=FL, 1=FR, 2=RL, 3=RR)");
+    return false;
+}
 
-        case 'H':
-        case 'h': {
-            while (!Serial.available()) { delay(1); }
-            int bagNum = Serial.read() - '0';
-            if (bagNum >= 0 && bagNum < NUM_BAGS) {
-                bags[bagNum].hold();
-                Serial.print("Holding ");
-                Serial.println(bags[bagNum].getName());
-            }
-            break;
-        }
+static void cmdInflate(const char* arg) {
+    int bagNum;
+    if (!parseBag(arg, bagNum)) return;
+    if (controller.manualInflate(bagNum)) {
+        Serial.print("Inflating ");
+        Serial.println(bags[bagNum].getName());
+    } else {
+        Serial.println("Cannot inflate - tank pressure too low");
+    }
+}
 
-        case 'S':
-        case 's':
-            stopAllBags();
-            Serial.println("All bags stopped");
-            break;
+static void cmdDeflate(const char* arg) {
+    int bagNum;
+    if (!parseBag(arg, bagNum)) return;
+    controller.manualDeflate(bagNum);
+    Serial.print("Deflating ");
+    Serial.println(bags[bagNum].getName());
+}
 
-        case 'L':
-        case 'l': {
-            while (!Serial.available()) { delay(1); }
-            int mode = Serial.read() - '0';
-            if (mode >= 0 && mode <= 3) {
-                webServer.setLevelMode((LevelMode)mode);
-                Serial.print("Level mode: ");
-                switch (mode) {
-                    case 0: Serial.println("OFF"); break;
-                    case 1: Serial.println("FRONT"); break;
-                    case 2: Serial.println("REAR"); break;
-                    case 3: Serial.println("ALL"); break;
-                }
-            }
-            break;
-        }
+static void cmdHold(const char* arg) {
+    int bagNum;
+    if (!parseBag(arg, bagNum)) return;
+    controller.holdBag(bagNum);
+    Serial.print("Holding ");
+    Serial.println(bags[bagNum].getName());
+}
 
-        case 'M':
-        case 'm': {
-            // Maintenance reset: MR1 or MR2
-            while (!Serial.available()) { delay(1); }
-            char subCmd = Serial.read();
-            if (subCmd == 'R' || subCmd == 'r') {
-                while (!Serial.available()) { delay(1); }
-                char pumpNum = Serial.read();
-                if (pumpNum == '1') {
-                    compressor.resetPump1Runtime();
-                } else if (pumpNum == '2') {
-                    compressor.resetPump2Runtime();
-                } else {
-                    Serial.println("Use MR1 or MR2 to reset pump maintenance");
-                }
-            }
-            break;
-        }
+static void cmdStop(const char* arg) {
+    stopAllBags();
+    Serial.println("All bags stopped");
+}
 
-        case 'P':
-        case 'p': {
-            delay(10);
-            if (Serial.available()) {
-                char subCmd = Serial.read();
-                switch (subCmd) {
-                    case 'A':
-                    case 'a':
-                        compressor.setMode(PUMP_AUTO);
-                        Serial.println("Pumps: AUTO mode");
-                        break;
-                    case 'O':
-                    case 'o':
-                        compressor.setMode(PUMP_OFF);
-                        Serial.println("Pumps: OFF (manual override)");
-                        break;
-                    case 'B':
-                    case 'b':
-                        compressor.setMode(PUMP_BOTH_ON);
-                        Serial.println("Pumps: BOTH ON (manual override)");
-                        break;
-                    case '1':
-                        compressor.setMode(PUMP_1_ONLY);
-                        Serial.println("Pumps: PUMP 1 only (manual override)");
-                        break;
-                    case '2':
-                        compressor.setMode(PUMP_2_ONLY);
-                        Serial.println("Pumps: PUMP 2 only (manual override)");
-                        break;
-                    case 'E':
-                    case 'e': {
-                        bool newState = !webServer.isPumpEnabled();
-                        webServer.setPumpEnabled(newState);
-                        if (!newState) {
-                            compressor.setMode(PUMP_OFF);
-                        } else {
-                            compressor.setMode(PUMP_AUTO);
-                        }
-                        Serial.print("Pumps: ");
-                        Serial.println(newState ? "ENABLED" : "DISABLED");
-                        break;
-                    }
-                    case 'T':
-                    case 't': {
-                        int psi = 0;
-                        while (Serial.available()) {
-                            char c = Serial.peek();
-                            if (c >= '0' && c <= '9') {
-                                psi = psi * 10 + (Serial.read() - '0');
-                            } else {
-                                break;
-                            }
-                        }
-                        if (psi > 0) {
-                            compressor.setTargetPressure((float)psi);
-                            Serial.print("Tank target set to ");
-                            Serial.print(psi);
-                            Serial.println(" PSI");
-                        }
-                        break;
-                    }
-                    default:
-                        printStatus();
-                        break;
-                }
-            } else {
-                printStatus();
-            }
-            break;
-        }
+static void cmdLevel(const char* arg) {
+    int mode;
+    if (!SerialConsole::parseInt(arg, LEVEL_OFF, LEVEL_ALL, mode)) {
+        Serial.println("Invalid level mode (0=off, 1=front, 2=rear, 3=all)");
+        return;
+    }
+    controller.setLevelMode((LevelMode)mode);
+    Serial.print("Level mode: ");
+    switch (mode) {
+        case LEVEL_OFF:   Serial.println("OFF"); break;
+        case LEVEL_FRONT: Serial.println("FRONT"); break;
+        case LEVEL_REAR:  Serial.println("REAR"); break;
+        case LEVEL_ALL:   Serial.println("ALL"); break;
+    }
+}
 
-        case 'T':
-        case 't': {
-            // Set bag target: T<bag><psi> e.g. T080 = bag 0 target 80 PSI
-            while (!Serial.available()) { delay(1); }
-            int bagNum = Serial.read() - '0';
-            if (bagNum >= 0 && bagNum < NUM_BAGS) {
-                int psi = 0;
-                delay(10); // Wait for digits
-                while (Serial.available()) {
-                    char c = Serial.peek();
-                    if (c >= '0' && c <= '9') {
-                        psi = psi * 10 + (Serial.read() - '0');
-                    } else {
-                        break;
-                    }
-                }
-                if (psi >= (int)MIN_BAG_PSI && psi <= (int)MAX_BAG_PSI) {
-                    bags[bagNum].setTargetPressure((float)psi);
-                    // Start moving to target
-                    float current = bags[bagNum].getPressure();
-                    if (current < psi - 2.0) {
-                        if (!webServer.isTankLockout()) {
-                            bags[bagNum].inflate();
-                        }
-                    } else if (current > psi + 2.0) {
-                        bags[bagNum].deflate();
-                    } else {
-                        bags[bagNum].hold();
-                    }
-                    Serial.print(bags[bagNum].getName());
-                    Serial.print(" target set to ");
-                    Serial.print(psi);
-                    Serial.println(" PSI");
-                } else {
-                    Serial.print("Invalid PSI (0-");
-                    Serial.print((int)MAX_BAG_PSI);
-                    Serial.println(")");
-                }
-            } else {
-                Serial.println("Invalid bag (0=FL, 1=FR, 2=RL, 3=RR)");
-            }
-            break;
-        }
+static void cmdLevelPitch(const char* arg) {
+    // LP<psi> sets the pitch LEVEL_ALL holds, bare LP keeps the stance's own
+    if (!*arg) {
+        controller.setLevelPitch(NAN);
+        Serial.println("Level pitch: hold stance");
+        return;
+    }
+    int psi;
+    if (!SerialConsole::parseInt(arg, -(int)MAX_BAG_PSI, (int)MAX_BAG_PSI, psi)) {
+        Serial.println("Invalid pitch (front minus rear PSI, e.g. LP30)");
+        return;
+    }
+    controller.setLevelPitch(psi);
+    Serial.print("Level pitch: ");
+    Serial.print(psi);
+    Serial.println(" PSI front over rear");
+}
 
-        case 'R':
-        case 'r': {
-            // Apply preset: R0=Lay, R1=Cruise, R2=Max
-            while (!Serial.available()) { delay(1); }
-            int presetNum = Serial.read() - '0';
-            if (presetNum >= 0 && presetNum < NUM_PRESETS) {
-                webServer.applyPreset(presetNum);
-                Serial.print("Preset ");
-                Serial.print(webServer.getPresetName(presetNum));
-                Serial.println(" applied");
-            } else {
-                Serial.println("Invalid preset (0=Lay, 1=Cruise, 2=Max)");
-            }
-            break;
-        }
+static void cmdMaintReset(const char* arg) {
+    // MR1 / MR2: reset pump maintenance after service
+    if (strcmp(arg, "1") == 0) {
+        compressor.resetPump1Runtime();
+    } else if (strcmp(arg, "2") == 0) {
+        compressor.resetPump2Runtime();
+    } else {
+        Serial.println("Use MR1 or MR2 to reset pump maintenance");
+    }
+}
 
-        case '?':
-            printHelp();
-            break;
+static void cmdStatus(const char* arg) {
+    if (*arg) {
+        Serial.println("Unknown pump command (PA, PO, PB, P1, P2, PE, PT###)");
+        return;
+    }
+    printStatus();
+}
 
-        case '\n':
-        case '\r':
-            break;
+static void setPumps(const char* arg, PumpMode mode, const char* message) {
+    controller.setPumpMode(mode);
+    Serial.println(message);
+}
 
-        default:
-            break;
+static void cmdPumpAuto(const char* arg) { setPumps(arg, PUMP_AUTO, "Pumps: AUTO mode"); }
+static void cmdPumpOff(const char* arg)  { setPumps(arg, PUMP_OFF, "Pumps: OFF (manual override)"); }
+static void cmdPumpBoth(const char* arg) { setPumps(arg, PUMP_BOTH_ON, "Pumps: BOTH ON (manual override)"); }
+static void cmdPump1(const char* arg)    { setPumps(arg, PUMP_1_ONLY, "Pumps: PUMP 1 only (manual override)"); }
+static void cmdPump2(const char* arg)    { setPumps(arg, PUMP_2_ONLY, "Pumps: PUMP 2 only (manual override)"); }
+
+static void cmdPumpEnable(const char* arg) {
+    bool newState = !controller.isPumpEnabled();
+    controller.setPumpEnabled(newState);
+    Serial.print("Pumps: ");
+    Serial.println(newState ? "ENABLED" : "DISABLED");
+}
+
+static void cmdTankTarget(const char* arg) {
+    int psi;
+    if (!SerialConsole::parseInt(arg, 1, (int)SENSOR_MAX_PSI, psi)) {
+        Serial.println("Usage: PT### (tank target PSI)");
+        return;
     }
+    controller.setTankTarget((float)psi);
+    Serial.print("Tank target set to ");
+    Serial.print(psi);
+    Serial.println(" PSI");
 }
 
-void stopAllBags() {
-    for (int i = 0; i < NUM_BAGS; i++) {
-        bags[i].hold();
+// Optional trailing ramp letter (F=fast, C=comfort, S=show), e.g. R1S.
+// Copies arg without it into buf; the default profile if there is none.
+static bool splitRamp(const char* arg, char* buf, size_t len, RampProfile& profile) {
+    profile = (RampProfile)RAMP_DEFAULT_PROFILE;
+    strncpy(buf, arg, len - 1);
+    buf[len - 1] = '\0';
+    size_t n = strlen(buf);
+    if (n == 0 || (buf[n - 1] >= '0' && buf[n - 1] <= '9')) return true;
+    if (!TrajectoryGenerator::parseProfile(&buf[n - 1], profile)) {
+        Serial.println("Invalid ramp (F=fast, C=comfort, S=show)");
+        return false;
+    }
+    buf[n - 1] = '\0';
+    return true;
+}
+
+static void cmdBagTarget(const char* arg) {
+    // T<bag><psi>[ramp], e.g. T080 = bag 0 target 80 PSI, T080S = slowly
+    char buf[12];
+    RampProfile profile;
+    if (!splitRamp(arg, buf, sizeof(buf), profile)) return;
+
+    char bagArg[2] = { buf[0], '\0' };
+    int bagNum;
+    if (!parseBag(bagArg, bagNum)) return;
+
+    int psi;
+    if (!SerialConsole::parseInt(buf + 1, (int)MIN_BAG_PSI, (int)MAX_BAG_PSI, psi)) {
+        Serial.print("Invalid PSI (0-");
+        Serial.print((int)MAX_BAG_PSI);
+        Serial.println(")");
+        return;
     }
+    controller.setBagTarget(bagNum, (float)psi, profile);
+    Serial.print(bags[bagNum].getName());
+    Serial.print(" target set to ");
+    Serial.print(psi);
+    Serial.print(" PSI (");
+    Serial.print(TrajectoryGenerator::profileName(profile));
+    Serial.println(")");
+}
+
+static void cmdPreset(const char* arg) {
+    // R0=Lay, R1=Cruise, R2=Max, optional ramp letter (R1S = Cruise, show ramp)
+    char buf[8];
+    RampProfile profile;
+    if (!splitRamp(arg, buf, sizeof(buf), profile)) return;
+
+    int presetNum;
+    if (!SerialConsole::parseInt(buf, 0, NUM_PRESETS - 1, presetNum)) {
+        Serial.println("Invalid preset (0=Lay, 1=Cruise, 2=Max)");
+        return;
+    }
+    webServer.applyPreset(presetNum, profile);
+    Serial.print("Preset ");
+    Serial.print(webServer.getPresetName(presetNum));
+    Serial.print(" applied (");
+    Serial.print(TrajectoryGenerator::profileName(profile));
+    Serial.println(")");
+}
+
+static void cmdTelemetry(const char* arg) {
+    // Telemetry rows for fitting the simulated plant (native fit_plant tool)
+    bool enabled = !controller.isTelemetryEnabled();
+    if (enabled) {
+        Serial.println("ms,tank,fl,fr,rl,rr,valves,pumps");
+    }
+    controller.setTelemetry(enabled);
+    if (!enabled) {
+        Serial.println("Telemetry: OFF");
+    }
+}
+
+static void cmdPark(const char* arg) {
+    powerManager.requestPark("serial");
+}
+
+static void cmdTraceRestart(const char* arg) {
+    if (!webServer.restartTrace()) {
+        Serial.println("Trace download in progress - try again when it ends");
+    }
+}
+
+static void cmdHelp(const char* arg) {
+    printHelp();
+}
+
+const ConsoleCommand SERIAL_COMMANDS[] = {
+    {"I",  cmdInflate},
+    {"D",  cmdDeflate},
+    {"H",  cmdHold},
+    {"S",  cmdStop},
+    {"T",  cmdBagTarget},
+    {"TR", cmdTraceRestart},
+    {"R",  cmdPreset},
+    {"L",  cmdLevel},
+    {"LP", cmdLevelPitch},
+    {"MR", cmdMaintReset},
+    {"P",  cmdStatus},
+    {"PA", cmdPumpAuto},
+    {"PO", cmdPumpOff},
+    {"PB", cmdPumpBoth},
+    {"P1", cmdPump1},
+    {"P2", cmdPump2},
+    {"PE", cmdPumpEnable},
+    {"PT", cmdTankTarget},
+    {"G",  cmdTelemetry},
+    {"Z",  cmdPark},
+    {"?",  cmdHelp}
+};
+
+const int NUM_SERIAL_COMMANDS = sizeof(SERIAL_COMMANDS) / sizeof(SERIAL_COMMANDS[0]);
+
+void onLinkFrame(const uint8_t* encoded, size_t length) {
+    serialLink.handleFrame(encoded, length);
+}
+
+void stopAllBags() {
+    controller.stopAll();
 }